@@ -30,8 +30,12 @@
 #include <cppual/meta_string>
 #include <cppual/memory_allocator>
 
+#include <functional>
+#include <algorithm>
 #include <utility>
+#include <limits>
 #include <vector>
+#include <span>
 
 // ====================================================
 
@@ -44,11 +48,193 @@ concept index_map_key = integer<T>;
 
 // ====================================================
 
-template <index_map_key K, non_void V, allocator_like A = memory::allocator<std::pair<K, V>>>
+//! search layout of the keys
+enum class index_layout : u8
+{
+    sorted   , //! binary search over the sorted pairs
+    eytzinger  //! cache line sized key blocks in Eytzinger order (eytzinger_index)
+};
+
+// ====================================================
+
+//! static search tree over sorted integer keys (B-tree blocks numbered in
+//! Eytzinger order). every node is a single cache line of keys & node k has
+//! its children at k * (B + 1) + 1 ... k * (B + 1) + B + 1, so a lookup loads
+//! one line per level instead of one per probe & the in-node comparison is a
+//! branchless count the compiler vectorizes. the positions in the sorted
+//! sequence are kept in a separate array that is only read once per lookup
+template <index_map_key K, allocator_like A = memory::allocator<K>>
+class eytzinger_index
+{
+public:
+    typedef eytzinger_index<K, A> self_type ;
+    typedef remove_cref_t<K>      key_type  ;
+    typedef std::size_t           size_type ;
+    typedef size_type const       const_size;
+
+    inline constexpr static const_size npos       = static_cast<size_type> (-1);
+    inline constexpr static const_size line_size  = 64;
+    inline constexpr static const_size block_size = std::max (line_size / sizeof (key_type), size_type (2));
+
+    //! lookups advanced together by lower_bound_many
+    inline constexpr static const_size batch_size = 16;
+
+    struct alignas (64) block //! line_size
+    {
+        key_type keys[block_size];
+    };
+
+    typedef std::allocator_traits<A>::template rebind_alloc<block>     block_allocator;
+    typedef std::allocator_traits<A>::template rebind_alloc<size_type> index_allocator;
+
+    eytzinger_index (A const& gAtor = A ())
+    : _M_gBlocks (block_allocator (gAtor))
+    , _M_gIndex  (index_allocator (gAtor))
+    , _M_uSize   ()
+    { }
+
+    constexpr size_type size () const noexcept
+    { return _M_uSize; }
+
+    constexpr bool empty () const noexcept
+    { return !_M_uSize; }
+
+    constexpr void clear () noexcept
+    {
+        _M_gBlocks.clear ();
+        _M_gIndex .clear ();
+
+        _M_uSize = size_type ();
+    }
+
+    //! lay out n keys sorted in ascending order, proj extracts the key of an element
+    template <std::random_access_iterator Iterator, typename Proj = std::identity>
+    void build (Iterator gFirst, size_type n, Proj proj = Proj ())
+    {
+        auto const uBlocks = (n + block_size - 1) / block_size;
+
+        _M_gBlocks.assign (uBlocks, block ());
+        _M_gIndex .assign (uBlocks * block_size, n);
+
+        _M_uSize = n;
+
+        auto uNext = size_type ();
+
+        fill (0, gFirst, proj, uNext);
+    }
+
+    //! position of the first key not less than key or size () when there's none
+    size_type lower_bound (key_type key) const noexcept
+    {
+        auto uFound = npos;
+
+        for (auto k = size_type (); k < _M_gBlocks.size (); )
+        {
+            auto const uSlot = count_less (_M_gBlocks[k], key);
+
+            if (uSlot < block_size) uFound = k * block_size + uSlot;
+
+            k = child (k, uSlot);
+        }
+
+        return uFound != npos ? _M_gIndex[uFound] : _M_uSize;
+    }
+
+    //! lower_bound of every key, the searches of a batch descend together
+    //! & prefetch their next nodes to overlap the cache misses
+    void lower_bound_many (std::span<key_type const> gKeys, std::span<size_type> gOut) const noexcept
+    {
+        for (auto uBase = size_type (); uBase < gKeys.size (); uBase += batch_size)
+        {
+            auto const uCount = std::min (batch_size, gKeys.size () - uBase);
+
+            size_type uNode [batch_size];
+            size_type uFound[batch_size];
+
+            for (auto i = size_type (); i < uCount; ++i)
+            {
+                uNode [i] = size_type ();
+                uFound[i] = npos;
+            }
+
+            for (auto bActive = !_M_gBlocks.empty (); bActive; )
+            {
+                bActive = false;
+
+                for (auto i = size_type (); i < uCount; ++i)
+                {
+                    if (uNode[i] >= _M_gBlocks.size ()) continue;
+
+                    auto const uSlot = count_less (_M_gBlocks[uNode[i]], gKeys[uBase + i]);
+
+                    if (uSlot < block_size) uFound[i] = uNode[i] * block_size + uSlot;
+
+                    if ((uNode[i] = child (uNode[i], uSlot)) < _M_gBlocks.size ())
+                    {
+                        PREFETCH (&_M_gBlocks[uNode[i]]);
+                        bActive = true;
+                    }
+                }
+            }
+
+            for (auto i = size_type (); i < uCount; ++i)
+            {
+                gOut[uBase + i] = uFound[i] != npos ? _M_gIndex[uFound[i]] : _M_uSize;
+            }
+        }
+    }
+
+private:
+    constexpr static size_type child (size_type k, size_type uSlot) noexcept
+    { return k * (block_size + 1) + uSlot + 1; }
+
+    //! no early exit -> vectorized compare & add
+    constexpr static size_type count_less (block const& gBlock, key_type key) noexcept
+    {
+        auto uCount = size_type ();
+
+        for (auto i = size_type (); i < block_size; ++i) uCount += gBlock.keys[i] < key;
+        return uCount;
+    }
+
+    //! in-order traversal handing out the sorted keys, the slots left
+    //! at the end are padded with the largest key & point to size ()
+    template <typename Iterator, typename Proj>
+    void fill (size_type k, Iterator gFirst, Proj& proj, size_type& uNext)
+    {
+        if (k >= _M_gBlocks.size ()) return;
+
+        for (auto i = size_type (); i < block_size; ++i)
+        {
+            fill (child (k, i), gFirst, proj, uNext);
+
+            if (uNext < _M_uSize)
+            {
+                _M_gBlocks[k].keys[i]         = std::invoke (proj, gFirst[static_cast<std::ptrdiff_t> (uNext)]);
+                _M_gIndex[k * block_size + i] = uNext++;
+            }
+            else _M_gBlocks[k].keys[i] = std::numeric_limits<key_type>::max ();
+        }
+
+        fill (child (k, block_size), gFirst, proj, uNext);
+    }
+
+private:
+    std::vector<block, block_allocator>     _M_gBlocks;
+    std::vector<size_type, index_allocator> _M_gIndex ;
+    size_type                               _M_uSize  ;
+};
+
+// ====================================================
+
+template <index_map_key K,
+          non_void      V,
+          allocator_like A = memory::allocator<std::pair<K, V>>,
+          index_layout   L = index_layout::sorted>
 class dyn_index_map : public std::vector<std::pair<K, V>, A>
 {
 public:
-    typedef dyn_index_map<K, V, A>                self_type             ;
+    typedef dyn_index_map<K, V, A, L>             self_type             ;
     typedef std::vector<std::pair<K, V>, A>       base_type             ;
     typedef remove_cref_t<K>                      key_type              ;
     typedef key_type const                        const_key             ;
@@ -79,7 +265,6 @@ public:
     // ====================================================
 
     using base_type::base_type;
-    using base_type::operator=;
     using base_type::get_allocator;
     using base_type::size;
     using base_type::capacity;
@@ -97,17 +282,96 @@ public:
     using base_type::crend;
     using base_type::reserve;
     using base_type::max_size;
-    using base_type::clear;
-    using base_type::swap;
-    using base_type::erase;
-    using base_type::assign;
 
     constexpr dyn_index_map (size_type n = 10, allocator_type const& ator = allocator_type ())
     : base_type (n, ator)
     { }
 
+    constexpr self_type& operator = (base_type const& gObj)
+    {
+        base_type::operator = (gObj);
+        invalidate_index ();
+        return *this;
+    }
+
+    constexpr self_type& operator = (base_type&& gObj)
+    {
+        base_type::operator = (std::move (gObj));
+        invalidate_index ();
+        return *this;
+    }
+
+    constexpr self_type& operator = (std::initializer_list<value_type> gList)
+    {
+        base_type::operator = (gList);
+        invalidate_index ();
+        return *this;
+    }
+
+    template <typename... Args>
+    constexpr void assign (Args&&... args)
+    {
+        base_type::assign (std::forward<Args> (args)...);
+        invalidate_index ();
+    }
+
+    constexpr iterator erase (const_iterator pos)
+    {
+        invalidate_index ();
+        return base_type::erase (pos);
+    }
+
+    constexpr iterator erase (const_iterator first, const_iterator last)
+    {
+        invalidate_index ();
+        return base_type::erase (first, last);
+    }
+
+    constexpr void clear () noexcept
+    {
+        base_type::clear ();
+        invalidate_index ();
+    }
+
+    constexpr void swap (base_type& gObj) noexcept
+    {
+        base_type::swap (gObj);
+        invalidate_index ();
+    }
+
+    //! the search layouts describe the swapped pairs
+    constexpr void swap (self_type& gObj) noexcept
+    {
+        base_type::swap (gObj);
+        std::swap (_M_gIndex, gObj._M_gIndex);
+    }
+
+    //! replace the contents with the pairs sorted by key & lay out the keys for searching
+    template <std::ranges::input_range R> requires std::ranges::common_range<R>
+    void build (R&& sorted)
+    {
+        base_type::assign (std::ranges::begin (sorted), std::ranges::end (sorted));
+        rebuild_index ();
+    }
+
+    //! has to be called after the pairs were replaced, erased or their keys were
+    //! changed through the iterators. the mutators drop the search layout, a key
+    //! written through an iterator is caught by the lookups which then fall back
+    //! to binary search until the index is rebuilt
+    void rebuild_index ()
+    {
+        if constexpr (L == index_layout::eytzinger)
+        {
+            _M_gIndex.build (cbegin (), size (), &value_type::first);
+        }
+    }
+
     iterator lower_bound (key_type key);
     const_iterator lower_bound (key_type key) const;
+
+    //! an iterator to the pair of every key or end () for the missing ones
+    template <std::output_iterator<const_iterator> Iterator>
+    Iterator find_many (std::span<key_type const> gKeys, Iterator gOut) const;
     template <unsigned_integer Key>
     iterator lower_bound (Key x);
     template <unsigned_integer Key>
@@ -289,6 +553,13 @@ public:
         return (*this)[name].first == char_hash (name);
     }
 
+    //! whether the lookups go through the search layout
+    constexpr bool is_indexed () const noexcept
+    {
+        if constexpr (L == index_layout::eytzinger) return _M_gIndex.size () == size ();
+        else return false;
+    }
+
     template <size_type K_>
     consteval size_type get_index () const noexcept
     { return K_ % size (); }
@@ -309,10 +580,103 @@ public:
 
     constexpr size_type get_index (size_type k) const noexcept
     { return k % size (); }
+
+private:
+    struct no_index { };
+
+    typedef typename std::allocator_traits<A>::template rebind_alloc<key_type> key_allocator;
+
+    typedef std::conditional_t<L == index_layout::eytzinger,
+                               eytzinger_index<key_type, key_allocator>,
+                               no_index> index_type;
+
+    //! a position found by the search layout is the lower bound of key if it's
+    //! the lower bound of its neighbours, which holds while the keys are sorted
+    constexpr bool is_lower_bound (size_type uPos, key_type key) const noexcept
+    {
+        return (uPos == size () || !(cbegin ()[static_cast<difference_type> (uPos)].first < key)) &&
+               (uPos == 0       ||   cbegin ()[static_cast<difference_type> (uPos) - 1].first < key);
+    }
+
+    constexpr void invalidate_index () noexcept
+    {
+        if constexpr (L == index_layout::eytzinger) _M_gIndex.clear ();
+    }
+
+private:
+    [[no_unique_address]] index_type _M_gIndex;
 };
 
 // ====================================================
 
+template <index_map_key K, non_void V, allocator_like A, index_layout L>
+typename dyn_index_map<K, V, A, L>::iterator
+dyn_index_map<K, V, A, L>::lower_bound (key_type key)
+{
+    if constexpr (L == index_layout::eytzinger)
+    {
+        if (is_indexed ())
+        {
+            auto const uPos = _M_gIndex.lower_bound (key);
+
+            if (is_lower_bound (uPos, key)) return begin () + static_cast<difference_type> (uPos);
+        }
+    }
+
+    return std::lower_bound (begin (), end (), key, [] (const_reference val, key_type k)
+    { return val.first < k; });
+}
+
+template <index_map_key K, non_void V, allocator_like A, index_layout L>
+typename dyn_index_map<K, V, A, L>::const_iterator
+dyn_index_map<K, V, A, L>::lower_bound (key_type key) const
+{
+    if constexpr (L == index_layout::eytzinger)
+    {
+        if (is_indexed ())
+        {
+            auto const uPos = _M_gIndex.lower_bound (key);
+
+            if (is_lower_bound (uPos, key)) return cbegin () + static_cast<difference_type> (uPos);
+        }
+    }
+
+    return std::lower_bound (cbegin (), cend (), key, [] (const_reference val, key_type k)
+    { return val.first < k; });
+}
+
+template <index_map_key K, non_void V, allocator_like A, index_layout L>
+template <std::output_iterator<typename dyn_index_map<K, V, A, L>::const_iterator> Iterator>
+Iterator dyn_index_map<K, V, A, L>::find_many (std::span<key_type const> gKeys, Iterator gOut) const
+{
+    //! positions of a chunk of keys at a time
+    constexpr size_type const chunk_size = 256;
+
+    size_type uPos[chunk_size];
+
+    for (auto uBase = size_type (); uBase < gKeys.size (); uBase += chunk_size)
+    {
+        auto const gChunk = gKeys.subspan (uBase, std::min (chunk_size, gKeys.size () - uBase));
+
+        if constexpr (L == index_layout::eytzinger)
+        {
+            if (is_indexed ()) _M_gIndex.lower_bound_many (gChunk, std::span<size_type> (uPos, gChunk.size ()));
+        }
+
+        for (auto i = size_type (); i < gChunk.size (); ++i, ++gOut)
+        {
+            auto const it = is_indexed () && is_lower_bound (uPos[i], gChunk[i]) ?
+                            cbegin () + static_cast<difference_type> (uPos[i]) : lower_bound (gChunk[i]);
+
+            *gOut = it != cend () && it->first == gChunk[i] ? it : cend ();
+        }
+    }
+
+    return gOut;
+}
+
+// ====================================================
+
 } // cppual
 
 // ====================================================
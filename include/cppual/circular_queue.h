@@ -32,8 +32,10 @@
 #include <atomic>
 #include <memory>
 #include <cstring>
+#include <span>
 #include <iterator>
 #include <algorithm>
+#include <ranges>
 #include <type_traits>
 
 namespace cppual {
@@ -55,8 +57,8 @@ public:
     typedef traits_type::allocator_type           allocator_type        ;
     typedef remove_cref_t<T>                      value_type            ;
     typedef value_type const                      const_value           ;
-    typedef value_type *                          pointer               ;
-    typedef value_type const*                     const_pointer         ;
+    typedef traits_type::pointer                  pointer               ;
+    typedef traits_type::const_pointer            const_pointer         ;
     typedef value_type &                          reference             ;
     typedef value_type const&                     const_reference       ;
     typedef traits_type::size_type                size_type             ;
@@ -69,6 +71,10 @@ public:
     typedef std::pair<pointer, size_type>         array_range           ;
     typedef std::pair<const_pointer, size_type>   const_array_range     ;
     typedef std::pair<iterator, bool>             iterator_pair         ;
+    typedef std::span<value_type>                 span_type             ;
+    typedef std::span<value_type const>           const_span_type       ;
+    typedef std::pair<span_type, span_type>       span_pair             ;
+    typedef std::pair<const_span_type, const_span_type> const_span_pair ;
 
     inline constexpr static size_type const npos = size_type (-1);
 
@@ -164,18 +170,18 @@ public:
     }
 
     constexpr circular_queue (self_type const& gObj)
-    : allocator_type (gObj.allocator_type::select_on_container_copy_construction ())
+    : allocator_type (traits_type::select_on_container_copy_construction (gObj))
     , _M_pArray      (!gObj.empty () ? allocator_type::allocate (gObj.size ()) : pointer ())
-    , _M_beginPos    (_M_pArray && !gObj.empty () ? _M_pArray : pointer ())
-    , _M_endPos      (_M_pArray && !gObj.empty () ? _M_pArray + (gObj.size () - 1) : pointer ())
+    , _M_beginPos    ()
+    , _M_endPos      ()
     , _M_uCapacity   (_M_pArray && !gObj.empty () ? gObj.size () : size_type ())
     {
         if (!gObj.empty () && !_M_pArray) throw std::bad_alloc ();
 
-        for (iterator it = gObj.begin (), dst_it = begin (); it != gObj.end (); ++it, ++dst_it)
-        {
-            allocator_type::construct (&(*dst_it), *it);
-        }
+        auto const gSpans = gObj.as_spans ();
+
+        append_span (gSpans.first );
+        append_span (gSpans.second);
     }
 
     constexpr circular_queue (self_type&& gObj) noexcept
@@ -266,6 +272,88 @@ public:
                     const_array_range ();
     }
 
+    //! the queued elements as (at most) two contiguous segments in order
+    constexpr span_pair as_spans () noexcept
+    {
+        auto const gOne = array_one ();
+        auto const gTwo = array_two ();
+
+        return span_pair (span_type (std::to_address (gOne.first), gOne.second),
+                          span_type (std::to_address (gTwo.first), gTwo.second));
+    }
+
+    constexpr const_span_pair as_spans () const noexcept
+    {
+        auto const gOne = array_one ();
+        auto const gTwo = array_two ();
+
+        return const_span_pair (const_span_type (std::to_address (gOne.first), gOne.second),
+                                const_span_type (std::to_address (gTwo.first), gTwo.second));
+    }
+
+    //! reserves once & copies (moves from rvalue ranges) whole segments,
+    //! contiguous ranges of trivially copyable elements with memcpy
+    template <std::ranges::input_range R>
+    constexpr void append_range (R&& rg)
+    {
+        typedef std::ranges::range_value_t<R> range_value;
+
+        if constexpr (std::ranges::contiguous_range<R> && std::ranges::sized_range<R> &&
+                      std::is_same_v<remove_cref_t<range_value>, value_type>)
+        {
+            typedef std::conditional_t<std::is_lvalue_reference_v<R> ||
+                                       std::is_const_v<std::remove_reference_t<std::ranges::range_reference_t<R>>>,
+                                       value_type const, value_type> src_value;
+
+            reserve (size () + static_cast<size_type> (std::ranges::size (rg)));
+            append_span (std::span<src_value> (std::ranges::data (rg), std::ranges::size (rg)));
+        }
+        else
+        {
+            if constexpr (std::ranges::forward_range<R>)
+            {
+                reserve (size () + static_cast<size_type> (std::ranges::distance (rg)));
+            }
+
+            for (auto&& val : rg) emplace_back (std::forward<decltype (val)> (val));
+        }
+    }
+
+    //! destroy the first n elements segment by segment & return how many were erased
+    constexpr size_type erase_front (size_type n)
+    {
+        if ((n = std::min (n, size ())) == 0) return 0;
+
+        if constexpr (!std::is_trivially_destructible_v<value_type>)
+        {
+            auto const gSpans = as_spans ();
+            auto const uOne   = std::min (n, gSpans.first.size ());
+
+            for (auto i = size_type (); i < uOne    ; ++i) traits_type::destroy (*this, gSpans.first .data () + i);
+            for (auto i = size_type (); i < n - uOne; ++i) traits_type::destroy (*this, gSpans.second.data () + i);
+        }
+
+        if (n == size ()) invalidate_pos ();
+        else _M_beginPos = _M_pArray + static_cast<difference_type> (index_to_subscript (n));
+
+        return n;
+    }
+
+    //! move up to n elements from the front to gOut & erase them
+    template <std::output_iterator<value_type> Iterator>
+    constexpr Iterator pop_front (Iterator gOut, size_type n)
+    {
+        auto const gSpans = as_spans ();
+        auto const uOne   = std::min (n, gSpans.first.size ());
+        auto const uTwo   = std::min (n - uOne, gSpans.second.size ());
+
+        gOut = std::move (gSpans.first .data (), gSpans.first .data () + uOne, gOut);
+        gOut = std::move (gSpans.second.data (), gSpans.second.data () + uTwo, gOut);
+
+        erase_front (uOne + uTwo);
+        return gOut;
+    }
+
     constexpr size_type size () const noexcept
     {
         return !empty () && capacity () ?
@@ -319,7 +407,7 @@ public:
         if (empty ()) set_first_pos ();
         else _M_beginPos = normalize (--_M_beginPos);
 
-        traits_type::construct (*this, _M_beginPos, std::forward<Args> (args)...);
+        traits_type::construct (*this, std::to_address (_M_beginPos), std::forward<Args> (args)...);
 
         return std::pair (begin (), true);
     }
@@ -337,7 +425,7 @@ public:
         if (empty ()) set_first_pos ();
         else _M_endPos = normalize (++_M_endPos);
 
-        traits_type::construct (*this, _M_endPos, std::forward<Args> (args)...);
+        traits_type::construct (*this, std::to_address (_M_endPos), std::forward<Args> (args)...);
 
         return iterator_pair (iterator (*this, empty () ? 0 : size () - 1), true);
     }
@@ -367,7 +455,7 @@ private:
     constexpr void _pop_front ()
     {
         // ++front--
-        traits_type::destroy (*this, _M_beginPos);
+        traits_type::destroy (*this, std::to_address (_M_beginPos));
 
         if (size () == 1) invalidate_pos ();
         else _M_beginPos = normalize (++_M_beginPos);
@@ -376,7 +464,7 @@ private:
     constexpr void _pop_back ()
     {
         // --back++
-        traits_type::destroy (*this, _M_endPos);
+        traits_type::destroy (*this, std::to_address (_M_endPos));
 
         if (size () == 1) invalidate_pos ();
         else _M_endPos = normalize (--_M_endPos);
@@ -395,6 +483,70 @@ private:
                     pointer ();
     }
 
+    //! memmove for trivially copyable elements, false for the rest
+    constexpr static bool shift_bytes (value_type* pDst, value_type const* pSrc, size_type n) noexcept
+    {
+        if constexpr (std::is_trivially_copyable_v<value_type>)
+        {
+            std::memmove (pDst, pSrc, n * sizeof (value_type));
+            return true;
+        }
+        else return false;
+    }
+
+    //! the uninitialized storage after the back in order
+    constexpr span_pair free_spans () noexcept
+    {
+        auto const pArray = std::to_address (_M_pArray);
+
+        if (empty ()) return span_pair (span_type (pArray, capacity ()), span_type ());
+
+        auto const uBegin = index_to_subscript (0);
+        auto const uTail  = index_to_subscript (size () - 1) + 1;
+
+        return is_linearized () ?
+                    span_pair (span_type (pArray + uTail, capacity () - uTail), span_type (pArray, uBegin)) :
+                    span_pair (span_type (pArray + uTail, uBegin - uTail), span_type ());
+    }
+
+    //! construct the elements of gSrc after the back (the storage has to be reserved).
+    //! moves unless U is const, trivially copyable elements are copied with memcpy
+    template <typename U>
+    constexpr void append_span (std::span<U> gSrc)
+    {
+        if (gSrc.empty ()) return;
+
+        auto const gFree = free_spans ();
+        auto       uDone = size_type ();
+
+        for (auto gDst : { gFree.first, gFree.second })
+        {
+            auto const uCount = std::min (gDst.size (), gSrc.size () - uDone);
+
+            if constexpr (std::is_trivially_copyable_v<value_type>)
+            {
+                if (uCount) std::memcpy (gDst.data (), gSrc.data () + uDone, uCount * sizeof (value_type));
+            }
+            else for (auto i = size_type (); i < uCount; ++i)
+            {
+                if constexpr (std::is_const_v<U>) traits_type::construct (*this, gDst.data () + i, gSrc[uDone + i]);
+                else traits_type::construct (*this, gDst.data () + i, std::move (gSrc[uDone + i]));
+            }
+
+            uDone += uCount;
+        }
+
+        if (empty ())
+        {
+            set_first_pos ();
+            _M_endPos = _M_pArray + static_cast<difference_type> (gSrc.size () - 1);
+        }
+        else
+        {
+            _M_endPos = _M_pArray + static_cast<difference_type> (index_to_subscript (size () - 1 + gSrc.size ()));
+        }
+    }
+
     constexpr size_type index_to_subscript (size_type uIdx) const noexcept
     {
         return !empty () && capacity () ?
@@ -458,9 +610,34 @@ void circular_queue<T, A, false>::resize (size_type uNewCapacity)
 {
     if (capacity () >= uNewCapacity) return;
 
-    self_type gObj (uNewCapacity, *this);
+    //! linearized trivially copyable elements are grown in place
+    //! when the allocator can extend the storage without a copy
+    if constexpr (std::is_trivially_copyable_v<value_type> &&
+                  requires (allocator_type& ator, pointer p, size_type n) { ator.reallocate (p, n, n); })
+    {
+        if (_M_pArray && is_linearized ())
+        {
+            auto const uBegin = empty () ? difference_type () : _M_beginPos - _M_pArray;
+            auto const uEnd   = empty () ? difference_type () : _M_endPos   - _M_pArray;
+
+            _M_pArray    = allocator_type::reallocate (_M_pArray, _M_uCapacity, uNewCapacity);
+            _M_uCapacity = uNewCapacity;
+
+            if (!empty ())
+            {
+                _M_beginPos = _M_pArray + uBegin;
+                _M_endPos   = _M_pArray + uEnd  ;
+            }
+
+            return;
+        }
+    }
 
-    for (auto it = begin (); it != end (); ++it) gObj.push_back (std::move (*it));
+    self_type  gObj   (uNewCapacity, *this);
+    auto const gSpans = as_spans ();
+
+    gObj.append_span (gSpans.first );
+    gObj.append_span (gSpans.second);
 
     swap (gObj);
 }
@@ -471,25 +648,35 @@ void circular_queue<T, A, false>::erase (const_iterator gIt)
     if (empty () || gIt < cbegin () || cend () <= gIt)
         throw std::out_of_range ("iterator is out of range!");
 
-    if (&(*gIt) == _M_beginPos) _pop_front ();
-    else if (&(*gIt) == _M_endPos) _pop_back ();
+    if (&(*gIt) == std::to_address (_M_beginPos)) _pop_front ();
+    else if (&(*gIt) == std::to_address (_M_endPos)) _pop_back ();
     else
     {
-        iterator it (gIt);
+        iterator   it     (gIt);
+        auto const uIdx   = static_cast<size_type> (it - begin ());
+        auto const uSub   = index_to_subscript (uIdx);
+        auto const pArray = std::to_address (_M_pArray);
 
+        //! trivially copyable elements within a single segment are shifted with memmove
         if (end () - it <= it - begin ())
         {
-            std::move (it + 1, end (), it);
+            auto const bShifted = uSub <= index_to_subscript (size () - 1) &&
+                                  shift_bytes (pArray + uSub, pArray + uSub + 1, size () - 1 - uIdx);
+
+            if (!bShifted) std::move (it + 1, end (), it);
 
-            traits_type::destroy (*this, _M_endPos);
+            traits_type::destroy (*this, std::to_address (_M_endPos));
 
             _M_endPos = normalize (--_M_endPos);
         }
         else
         {
-            std::move_backward (begin (), it, it + 1);
+            auto const uFirst   = index_to_subscript (0);
+            auto const bShifted = uFirst <= uSub && shift_bytes (pArray + uFirst + 1, pArray + uFirst, uIdx);
+
+            if (!bShifted) std::move_backward (begin (), it, it + 1);
 
-            traits_type::destroy (*this, _M_beginPos);
+            traits_type::destroy (*this, std::to_address (_M_beginPos));
 
             _M_beginPos = normalize (++_M_beginPos);
         }
@@ -510,8 +697,13 @@ void circular_queue<T, A, false>::dispose ()
 
 // ====================================================
 
-//! [UNFINISHED] feature complete lock-free multi-producer/multi-consumer bidirectional queue
-//! ex. game messaging queue
+//! bounded lock-free multi-producer/multi-consumer queue (Vyukov).
+//! every cell carries a sequence number telling producers & consumers
+//! whether it's free for the current lap, so the only contended words are
+//! the enqueue & dequeue positions that live on separate cache lines.
+//! the try_ functions never block, the others claim a position & wait on
+//! the cell's sequence with std::atomic::wait. the capacity is rounded up
+//! to a power of 2. ex. feeding worker threads
 template <non_void T, allocator_like A>
 class SHARED_API circular_queue <T, A, true> : private A, public non_copyable
 {
@@ -529,96 +721,375 @@ public:
     typedef value_type const*            const_pointer  ;
     typedef value_type &                 reference      ;
     typedef value_type const&            const_reference;
-    typedef std::atomic_size_t           atomic_size    ;
     typedef traits_type::size_type       size_type      ;
     typedef traits_type::size_type const const_size     ;
-    typedef traits_type::difference_type ifference_type ;
+    typedef traits_type::difference_type difference_type;
+    typedef std::atomic<size_type>       atomic_size    ;
+
+    inline constexpr static size_type const npos            = size_type (-1);
+    inline constexpr static size_type const cache_line_size = 64;
+
+    //! NOT thread safe -> the ring has to be allocated with reserve before use
+    constexpr circular_queue (allocator_type const& gAtor = allocator_type ()) noexcept
+    : allocator_type  (gAtor)
+    , _M_pCells       ()
+    , _M_uMask        ()
+    , _M_uEnqueuePos  ()
+    , _M_uDequeuePos  ()
+    { }
 
-    inline constexpr static size_type const npos = size_type (-1);
+    circular_queue (size_type uCapacity, allocator_type const& gAtor = allocator_type ())
+    : circular_queue (gAtor)
+    { reserve (uCapacity); }
 
-    circular_queue () noexcept;
+    ~circular_queue ()
+    { dispose (); }
 
-    void reserve (size_type);
-    void reserve_unsafe (size_type);
-    bool push_back (const_reference);
-    bool bounded_push_back (const_reference);
-    bool unsynchronized_push_back (const_reference);
-    bool pop_front (reference);
-    bool unsynchronized_pop_front (reference);
+    //! NOT thread safe -> grow the ring & keep the queued elements in order
+    void reserve (size_type uCapacity);
 
-    constexpr size_type size () const noexcept
+    constexpr size_type capacity () const noexcept
+    { return _M_pCells ? _M_uMask + 1 : size_type (); }
+
+    //! approximate while other threads push & pop
+    size_type size () const noexcept
     {
-        const_size uBeginPos = _M_beginPos.load (std::memory_order_relaxed);
-        const_size uEndPos   = _M_endPos  .load (std::memory_order_relaxed);
+        auto const uDequeuePos = _M_uDequeuePos.load (std::memory_order_acquire);
+        auto const uEnqueuePos = _M_uEnqueuePos.load (std::memory_order_acquire);
 
-        return ((uEndPos - uBeginPos) + capacity ()) % capacity ();
+        //! blocked consumers can claim positions ahead of the producers
+        return uEnqueuePos > uDequeuePos ? std::min (uEnqueuePos - uDequeuePos, capacity ()) : size_type ();
     }
 
-    constexpr bool is_linearized () const noexcept
+    bool empty () const noexcept
+    { return !size (); }
+
+    bool full () const noexcept
+    { return size () == capacity (); }
+
+    constexpr allocator_type get_allocator () const noexcept
+    { return *this; }
+
+    constexpr bool is_lock_free () const noexcept
+    { return atomic_size::is_always_lock_free; }
+
+    template <typename... Args>
+    bool try_emplace_back (Args&&... args)
     {
-        return _M_beginPos.load (std::memory_order_relaxed) <=
-               _M_endPos  .load (std::memory_order_relaxed);
+        auto uPos = _M_uEnqueuePos.load (std::memory_order_relaxed);
+
+        for (;;)
+        {
+            auto const iDiff = static_cast<difference_type> (cell_at (uPos).sequence.load (std::memory_order_acquire) - uPos);
+
+            if (!iDiff)
+            {
+                if (_M_uEnqueuePos.compare_exchange_weak (uPos, uPos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (iDiff < 0) return false; //! full
+            else uPos = _M_uEnqueuePos.load (std::memory_order_relaxed);
+        }
+
+        publish (uPos, std::forward<Args> (args)...);
+        return true;
     }
 
-    constexpr size_type capacity () noexcept
-    { return _M_uCapacity; }
+    //! claim a position & wait for its cell to be released by the consumer of the previous lap
+    template <typename... Args>
+    void emplace_back (Args&&... args)
+    {
+        auto const uPos = _M_uEnqueuePos.fetch_add (1, std::memory_order_relaxed);
 
-    bool is_lock_free () const noexcept
-    { return _M_endPos.is_lock_free () and _M_beginPos.is_lock_free (); }
+        wait_for (cell_at (uPos), uPos);
+        publish  (uPos, std::forward<Args> (args)...);
+    }
 
-    constexpr bool empty () const noexcept
-    { return _M_beginPos == _M_endPos; }
+    bool try_push_back (const_reference val) { return try_emplace_back (val); }
+    bool try_push_back (value_type&&    val) { return try_emplace_back (std::move (val)); }
+    void push_back     (const_reference val) { emplace_back (val); }
+    void push_back     (value_type&&    val) { emplace_back (std::move (val)); }
 
-    constexpr bool full () const noexcept
-    { return ((_M_endPos.load () + 1) % capacity ()) == _M_beginPos.load (); }
+    bool try_pop_front (reference val)
+    {
+        auto uPos = _M_uDequeuePos.load (std::memory_order_relaxed);
 
-    template <typename F>
-    constexpr bool consume_one (F& fn)
+        for (;;)
+        {
+            auto const iDiff = static_cast<difference_type> (cell_at (uPos).sequence.load (std::memory_order_acquire) - (uPos + 1));
+
+            if (!iDiff)
+            {
+                if (_M_uDequeuePos.compare_exchange_weak (uPos, uPos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (iDiff < 0) return false; //! empty
+            else uPos = _M_uDequeuePos.load (std::memory_order_relaxed);
+        }
+
+        consume (uPos, val);
+        return true;
+    }
+
+    //! claim a position & wait for its element to be published
+    void pop_front (reference val)
     {
-        value_type element;
-        bool       success = pop_front (element);
+        auto const uPos = _M_uDequeuePos.fetch_add (1, std::memory_order_relaxed);
 
-        if (success) fn (element);
-        return success;
+        wait_for (cell_at (uPos), uPos + 1);
+        consume  (uPos, val);
+    }
+
+    //! claim up to n consecutive free cells with a single CAS
+    template <std::input_iterator Iterator>
+    size_type try_push_n (Iterator gFirst, size_type n)
+    { return push_claimed (gFirst, n); }
+
+    //! claim up to n consecutive published cells with a single CAS
+    template <std::output_iterator<value_type> Iterator>
+    size_type try_pop_n (Iterator gOut, size_type n)
+    { return pop_claimed (gOut, n); }
+
+    //! push the batch & block for the elements that don't fit
+    template <std::input_iterator Iterator>
+    void push_n (Iterator gFirst, size_type n)
+    {
+        auto const uCount = push_claimed (gFirst, n);
+
+        for (auto i = uCount; i < n; ++i, ++gFirst) emplace_back (*gFirst);
+    }
+
+    //! pop the batch & block until n elements have been popped
+    template <std::output_iterator<value_type> Iterator>
+    void pop_n (Iterator gOut, size_type n)
+    {
+        auto const uCount = pop_claimed (gOut, n);
+
+        for (auto i = uCount; i < n; ++i, ++gOut)
+        {
+            value_type val;
+
+            pop_front (val);
+            *gOut = std::move (val);
+        }
     }
 
     template <typename F>
-    constexpr bool consume_one (F const& fn)
+    constexpr bool consume_one (F&& fn)
     {
         value_type element;
-        bool       success = pop_front (element);
+        bool       success = try_pop_front (element);
 
         if (success) fn (element);
         return success;
     }
 
     template <typename F>
-    constexpr size_type consume_all (F& fn)
+    constexpr size_type consume_all (F&& fn)
     {
         size_type element_count = 0;
 
-        for (value_type element; pop_front (element); ++element_count) fn (element);
+        for (value_type element; try_pop_front (element); ++element_count) fn (element);
         return element_count;
     }
 
-    template <typename F>
-    constexpr size_type consume_all (F const& fn)
+private:
+    struct cell
     {
-        size_type element_count = 0;
+        atomic_size sequence;
+        alignas (value_type) byte storage[sizeof (value_type)];
 
-        for (value_type element; pop_front (element); ++element_count) fn (element);
-        return element_count;
+        constexpr pointer value () noexcept
+        { return std::launder (reinterpret_cast<pointer> (storage)); }
+    };
+
+    typedef traits_type::template rebind_alloc <cell> cell_allocator;
+    typedef std::allocator_traits<cell_allocator>      cell_traits   ;
+    typedef cell_traits::pointer                       cell_pointer  ;
+
+    constexpr cell& cell_at (size_type uPos) const noexcept
+    { return _M_pCells[static_cast<difference_type> (uPos & _M_uMask)]; }
+
+    static void wait_for (cell& gCell, size_type uSequence) noexcept
+    {
+        for (auto uSeq = gCell.sequence.load (std::memory_order_acquire); uSeq != uSequence;
+                  uSeq = gCell.sequence.load (std::memory_order_acquire))
+        {
+            gCell.sequence.wait (uSeq, std::memory_order_acquire);
+        }
     }
 
+    template <typename... Args>
+    void publish (size_type uPos, Args&&... args)
+    {
+        auto& gCell = cell_at (uPos);
+
+        new (gCell.storage) value_type (std::forward<Args> (args)...);
+
+        gCell.sequence.store (uPos + 1, std::memory_order_release);
+        gCell.sequence.notify_all ();
+    }
+
+    value_type consume_move (size_type uPos)
+    {
+        auto& gCell = cell_at (uPos);
+        auto  val   = std::move (*gCell.value ());
+
+        gCell.value ()->~value_type ();
+
+        //! free for the producer of the next lap
+        gCell.sequence.store (uPos + _M_uMask + 1, std::memory_order_release);
+        gCell.sequence.notify_all ();
+
+        return val;
+    }
+
+    void consume (size_type uPos, reference val)
+    { val = consume_move (uPos); }
+
+    //! advances gFirst past the pushed elements
+    template <typename Iterator>
+    size_type push_claimed (Iterator& gFirst, size_type n)
+    {
+        size_type  uPos   { };
+        auto const uCount = claim (_M_uEnqueuePos, 0, n, uPos);
+
+        for (auto i = size_type (); i < uCount; ++i, ++gFirst) publish (uPos + i, *gFirst);
+        return uCount;
+    }
+
+    //! advances gOut past the popped elements
+    template <typename Iterator>
+    size_type pop_claimed (Iterator& gOut, size_type n)
+    {
+        size_type  uPos   { };
+        auto const uCount = claim (_M_uDequeuePos, 1, n, uPos);
+
+        for (auto i = size_type (); i < uCount; ++i, ++gOut)
+        {
+            value_type val (consume_move (uPos + i));
+            *gOut = std::move (val);
+        }
+
+        return uCount;
+    }
+
+    //! claim the longest run (up to n) of cells ready for the position (offset 0 for
+    //! producers, 1 for consumers) & return its first position in uFirst
+    size_type claim (atomic_size& gPos, size_type uOffset, size_type n, size_type& uFirst)
+    {
+        auto uPos = gPos.load (std::memory_order_relaxed);
+
+        while (n)
+        {
+            auto uCount = size_type ();
+
+            while (uCount < n && uCount <= _M_uMask &&
+                   cell_at (uPos + uCount).sequence.load (std::memory_order_acquire) == uPos + uCount + uOffset)
+                ++uCount;
+
+            if (!uCount)
+            {
+                auto const iDiff = static_cast<difference_type> (cell_at (uPos).sequence.load (std::memory_order_acquire) -
+                                                                 (uPos + uOffset));
+
+                if (iDiff < 0) return 0; //! full or empty
+                uPos = gPos.load (std::memory_order_relaxed);
+                continue;
+            }
+
+            if (gPos.compare_exchange_weak (uPos, uPos + uCount, std::memory_order_relaxed))
+            {
+                uFirst = uPos;
+                return uCount;
+            }
+        }
+
+        return 0;
+    }
+
+    void dispose () noexcept;
+
 private:
-    pointer     _M_pArray;
-    atomic_size _M_beginPos, _M_endPos;
-    size_type   _M_uCapacity;
+    cell_pointer                     _M_pCells     ;
+    size_type                        _M_uMask      ;
+    alignas (cache_line_size) atomic_size _M_uEnqueuePos;
+    alignas (cache_line_size) atomic_size _M_uDequeuePos;
 };
 
 // ====================================================
 
-//! [UNFINISHED] lock-free circular queue (1 producer / 1 consumer)
+template <non_void T, allocator_like A>
+void circular_queue<T, A, true>::reserve (size_type uCapacity)
+{
+    if (uCapacity <= capacity ()) return;
+
+    //! power of 2 -> the position maps to its cell with a mask
+    auto uNewCapacity = size_type (2);
+
+    while (uNewCapacity < uCapacity) uNewCapacity <<= 1;
+
+    cell_allocator gAtor (static_cast<allocator_type&> (*this));
+
+    auto const pCells = cell_traits::allocate (gAtor, uNewCapacity);
+    auto const uCount = size ();
+    auto const uFirst = _M_uDequeuePos.load (std::memory_order_relaxed);
+
+    for (auto i = size_type (); i < uNewCapacity; ++i)
+    {
+        new (&pCells[static_cast<difference_type> (i)].sequence) atomic_size (i);
+    }
+
+    for (auto i = size_type (); i < uCount; ++i)
+    {
+        auto& gCell = pCells[static_cast<difference_type> (i)];
+
+        new (gCell.storage) value_type (consume_move (uFirst + i));
+        gCell.sequence.store (i + 1, std::memory_order_relaxed);
+    }
+
+    dispose ();
+
+    _M_pCells = pCells;
+    _M_uMask  = uNewCapacity - 1;
+
+    _M_uEnqueuePos.store (uCount, std::memory_order_relaxed);
+    _M_uDequeuePos.store (size_type (), std::memory_order_relaxed);
+}
+
+template <non_void T, allocator_like A>
+void circular_queue<T, A, true>::dispose () noexcept
+{
+    if (!_M_pCells) return;
+
+    auto const uEnd = _M_uEnqueuePos.load (std::memory_order_relaxed);
+
+    for (auto uPos = _M_uDequeuePos.load (std::memory_order_relaxed); uPos < uEnd; ++uPos)
+    {
+        auto& gCell = cell_at (uPos);
+
+        if (gCell.sequence.load (std::memory_order_relaxed) == uPos + 1) gCell.value ()->~value_type ();
+    }
+
+    for (auto i = size_type (); i <= _M_uMask; ++i)
+    {
+        _M_pCells[static_cast<difference_type> (i)].sequence.~atomic_size ();
+    }
+
+    cell_allocator gAtor (static_cast<allocator_type&> (*this));
+
+    cell_traits::deallocate (gAtor, _M_pCells, _M_uMask + 1);
+
+    _M_pCells = cell_pointer ();
+    _M_uMask  = size_type ();
+}
+
+// ====================================================
+
+//! wait-free circular queue (1 producer / 1 consumer).
+//! the positions only grow & each one lives on the cache line of the thread
+//! that writes it, next to that thread's cached copy of the opposite position,
+//! so the other side's line is only touched when the cached copy runs out.
+//! whole batches are transferred with reserve_write/commit_write on the
+//! producer side & read_span/release on the consumer side.
 //! ex. sufficient for event handling
 template <non_void T, std::size_t N>
 class SHARED_API uniform_queue : public non_copyable
@@ -627,121 +1098,216 @@ public:
     static_assert (!std::is_void_v              <T>, "T is void");
     static_assert ( std::is_move_constructible_v<T>, "T is not move constructible!");
     static_assert ( std::is_move_assignable_v   <T>, "T is not move assignable!");
+    static_assert ( N > 0                          , "the capacity can't be 0!");
+
+    typedef uniform_queue<T, N>       self_type      ;
+    typedef remove_cref_t<T>          value_type     ;
+    typedef value_type const          const_value    ;
+    typedef value_type *              pointer        ;
+    typedef value_type const*         const_pointer  ;
+    typedef value_type &              reference      ;
+    typedef value_type const&         const_reference;
+    typedef decltype (N)              size_type      ;
+    typedef size_type const           const_size     ;
+    typedef std::ptrdiff_t            difference_type;
+    typedef std::atomic<size_type>    atomic_size    ;
+    typedef std::span<value_type>     span_type      ;
+
+    inline constexpr static size_type const npos            = size_type (-1);
+    inline constexpr static size_type const cache_line_size = 64;
 
-    typedef uniform_queue<T, N> self_type      ;
-    typedef remove_cref_t<T>    value_type     ;
-    typedef value_type const    const_value    ;
-    typedef value_type *        pointer        ;
-    typedef value_type const*   const_pointer  ;
-    typedef value_type &        reference      ;
-    typedef value_type const&   const_reference;
-    typedef decltype (N)        size_type      ;
-    typedef size_type const     const_size     ;
-    typedef std::ptrdiff_t      difference_type;
-
-    inline constexpr static size_type const npos = size_type (-1);
+    constexpr uniform_queue () noexcept
+    : _M_uWritePos   ()
+    , _M_uReadCache  ()
+    , _M_uReadPos    ()
+    , _M_uWriteCache ()
+    { }
 
-    constexpr size_type size () const noexcept
+    //! the elements that don't fit are ignored
+    template <std::input_iterator Iterator>
+    uniform_queue (Iterator gBegin, Iterator gEnd)
+    : uniform_queue ()
     {
-        const_size uBeginPos = _M_uReadPos.load  (std::memory_order_relaxed);
-        const_size uEndPos   = _M_uWritePos.load (std::memory_order_relaxed);
-
-        return ((uEndPos - uBeginPos) + capacity()) % capacity();
+        for (; gBegin != gEnd && try_push_back (*gBegin); ++gBegin) ;
     }
 
-    constexpr bool is_linearized () const noexcept
+    ~uniform_queue ()
     {
-        return _M_uReadPos .load (std::memory_order_relaxed) <=
-               _M_uWritePos.load (std::memory_order_relaxed);
+        for (auto uPos = _M_uReadPos.load (std::memory_order_relaxed),
+                  uEnd = _M_uWritePos.load (std::memory_order_relaxed); uPos != uEnd; ++uPos)
+        {
+            std::destroy_at (at (uPos));
+        }
     }
 
     consteval static size_type capacity () noexcept
     { return N; }
 
-    constexpr bool is_lock_free () const noexcept
-    { return _M_uWritePos.is_lock_free () and _M_uReadPos.is_lock_free (); }
+    //! exact from either side, approximate from any other thread
+    constexpr size_type size () const noexcept
+    {
+        const_size uBeginPos = _M_uReadPos.load  (std::memory_order_acquire);
+        const_size uEndPos   = _M_uWritePos.load (std::memory_order_acquire);
+
+        return uEndPos - uBeginPos;
+    }
 
     constexpr bool empty () const noexcept
-    { return _M_uReadPos == _M_uWritePos; }
+    { return !size (); }
 
     constexpr bool full () const noexcept
-    { return ((_M_uWritePos.load () + 1) % capacity ()) == _M_uReadPos.load (); }
+    { return size () == capacity (); }
 
-    constexpr void push_back (value_type const& value)
-    { push_back (const_cast<value_type&> (value)); }
+    //! the queued elements are contiguous & a single read_span returns them all
+    constexpr bool is_linearized () const noexcept
+    { return _M_uReadPos.load (std::memory_order_relaxed) % N + size () <= N; }
 
-    constexpr void emplace_back (value_type const& value)
-    { push_back (const_cast<value_type&> (value)); }
+    constexpr bool is_lock_free () const noexcept
+    { return atomic_size::is_always_lock_free; }
 
-    constexpr void emplace_back (value_type&& value)
-    { push_back (std::forward<value_type> (value)); }
+    // ====================================================
+    // producer
 
     template <typename... Args>
-    constexpr void emplace_back (Args&&... args)
-    { push_back (std::forward<Args> (args)...); }
+    bool try_emplace_back (Args&&... args)
+    {
+        const_size uWritePos = _M_uWritePos.load (std::memory_order_relaxed);
 
-    constexpr uniform_queue () noexcept
-    : _M_uReadPos (), _M_uWritePos ()
-    { }
+        if (!writable (uWritePos, 1)) return false; //! full
 
-    template <typename Iterator>
-    constexpr uniform_queue (InputIteratorType<Iterator> gBegin, InputIteratorType<Iterator> gEnd) noexcept
-    : _M_uReadPos  ()
-    , _M_uWritePos (size_type (gEnd - gBegin) > N ? N : size_type (gEnd - gBegin))
-    { std::copy (gBegin, gBegin + _M_uWritePos, _M_Array); }
+        new (at (uWritePos)) value_type (std::forward<Args> (args)...);
+
+        _M_uWritePos.store (uWritePos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push_back (const_reference value) { return try_emplace_back (value); }
+    bool try_push_back (value_type&&    value) { return try_emplace_back (std::move (value)); }
+
+    template <typename... Args>
+    bool emplace_back (Args&&... args)
+    { return try_emplace_back (std::forward<Args> (args)...); }
+
+    bool push_back (const_reference value) { return try_emplace_back (value); }
+    bool push_back (value_type&&    value) { return try_emplace_back (std::move (value)); }
 
-    void push_back (value_type&& value)
+    //! contiguous uninitialized storage for up to n elements (shorter at the
+    //! end of the ring or when the queue is nearly full, empty when full).
+    //! the elements have to be constructed in place before commit_write
+    span_type reserve_write (size_type n = npos) noexcept
     {
-        const_size uCurWrite  = _M_uWritePos.load (std::memory_order_relaxed);
-        const_size uNextWrite = next (uCurWrite);
+        const_size uWritePos = _M_uWritePos.load (std::memory_order_relaxed);
 
-        if (uNextWrite != _M_uReadPos.load (std::memory_order_acq_rel))
-        {
-            new (&_M_Array[uCurWrite]) T (std::forward<value_type> (value));
-            _M_uWritePos = uNextWrite;
-        }
-        else _M_Array[uCurWrite] = std::forward<value_type> (value);
+        if (!writable (uWritePos, 1)) return span_type ();
+
+        const_size uIdx = uWritePos % N;
+
+        return span_type (reinterpret_cast<pointer> (_M_Storage) + uIdx,
+                          std::min ({ n, N - uIdx, N - (uWritePos - _M_uReadCache) }));
     }
 
-    template <typename... Args>
-    void push_back (Args&&... args)
+    //! publish n elements constructed in the span returned by reserve_write
+    void commit_write (size_type n) noexcept
     {
-        const_size uCurWrite  = _M_uWritePos.load (std::memory_order_relaxed);
-        const_size uNextWrite = next (uCurWrite);
+        _M_uWritePos.store (_M_uWritePos.load (std::memory_order_relaxed) + n, std::memory_order_release);
+    }
 
-        if (uNextWrite != _M_uReadPos.load (std::memory_order_acq_rel))
-        {
-            new (&_M_Array[uCurWrite]) T (std::forward<Args> (args)...);
-            _M_uWritePos = uNextWrite;
-        }
-        else
+    // ====================================================
+    // consumer
+
+    bool pop_front (reference elem)
+    {
+        const_size uReadPos = _M_uReadPos.load (std::memory_order_relaxed);
+
+        if (!readable (uReadPos)) return false; //! empty
+
+        auto const pElem = at (uReadPos);
+
+        elem = std::move (*pElem);
+        std::destroy_at (pElem);
+
+        _M_uReadPos.store (uReadPos + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! the oldest element or nullptr when empty
+    pointer front () noexcept
+    {
+        const_size uReadPos = _M_uReadPos.load (std::memory_order_relaxed);
+
+        return readable (uReadPos) ? at (uReadPos) : nullptr;
+    }
+
+    //! contiguous published elements from the front (up to the end of the ring)
+    span_type read_span () noexcept
+    {
+        const_size uReadPos = _M_uReadPos.load (std::memory_order_relaxed);
+
+        if (!readable (uReadPos)) return span_type ();
+
+        const_size uIdx = uReadPos % N;
+
+        return span_type (at (uReadPos), std::min (_M_uWriteCache - uReadPos, N - uIdx));
+    }
+
+    //! destroy the first n elements returned by read_span & free their cells
+    void release (size_type n) noexcept
+    {
+        const_size uReadPos = _M_uReadPos.load (std::memory_order_relaxed);
+
+        for (auto i = size_type (); i < n; ++i) std::destroy_at (at (uReadPos + i));
+
+        _M_uReadPos.store (uReadPos + n, std::memory_order_release);
+    }
+
+    template <typename F>
+    size_type consume_all (F&& fn)
+    {
+        size_type uCount = 0;
+
+        for (auto gSpan = read_span (); !gSpan.empty (); gSpan = read_span ())
         {
-            _M_Array[uCurWrite].~value_type ();
-            new (&_M_Array[uCurWrite]) T (std::forward<Args> (args)...);
+            for (auto& elem : gSpan) fn (elem);
+
+            release (gSpan.size ());
+            uCount += gSpan.size ();
         }
+
+        return uCount;
     }
 
-    bool pop_front (T& elem)
+private:
+    pointer at (size_type uPos) noexcept
+    { return std::launder (reinterpret_cast<pointer> (_M_Storage) + uPos % N); }
+
+    //! refresh the cached read position only when it says there's no room
+    bool writable (size_type uWritePos, size_type n) noexcept
     {
-        const_size uCurRead = _M_uReadPos.load (std::memory_order_relaxed);
+        if (uWritePos - _M_uReadCache + n <= N) return true;
 
-        if (uCurRead == _M_uWritePos.load (std::memory_order_acq_rel))
-            return false; // empty
+        _M_uReadCache = _M_uReadPos.load (std::memory_order_acquire);
+        return uWritePos - _M_uReadCache + n <= N;
+    }
 
-        elem = _M_Array[uCurRead];
-        _M_Array[uCurRead].~value_type ();
+    //! refresh the cached write position only when it says there's nothing to read
+    bool readable (size_type uReadPos) noexcept
+    {
+        if (uReadPos != _M_uWriteCache) return true;
 
-        _M_uReadPos = next (uCurRead);
-        return true;
+        _M_uWriteCache = _M_uWritePos.load (std::memory_order_acquire);
+        return uReadPos != _M_uWriteCache;
     }
 
 private:
-    consteval static size_type next (size_type uIdx) noexcept
-    { return ++uIdx % N; }
+    //! written by the producer
+    alignas (cache_line_size) atomic_size _M_uWritePos  ;
+    size_type                             _M_uReadCache ;
 
-private:
-    std::atomic_size_t _M_uReadPos, _M_uWritePos;
-    T                  _M_Array[capacity ()];
+    //! written by the consumer
+    alignas (cache_line_size) atomic_size _M_uReadPos   ;
+    size_type                             _M_uWriteCache;
+
+    alignas (cache_line_size) alignas (value_type) byte _M_Storage[N * sizeof (value_type)];
 };
 
 // ====================================================
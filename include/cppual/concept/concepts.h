@@ -66,6 +66,9 @@ class memory_resource;
 //! redefined polymorphic memory allocator
 template <non_void> class allocator;
 
+//! offset pointer allocator for inter-process shared memory
+template <non_void> class shared_allocator;
+
 } //! namespace cppual::memory
 
 // ====================================================
@@ -1208,6 +1211,10 @@ template <non_void T>
 struct is_allocator_helper <memory::allocator<T>> : public std::true_type
 { typedef memory::allocator<T> type; };
 
+template <non_void T>
+struct is_allocator_helper <memory::shared_allocator<T>> : public std::true_type
+{ typedef memory::shared_allocator<T> type; };
+
 template <non_void T>
 struct is_allocator_helper <std::allocator<T>> : public std::true_type
 { typedef std::allocator<T> type; };
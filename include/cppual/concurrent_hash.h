@@ -0,0 +1,414 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPUAL_CONCURRENT_HASH_H_
+#define CPPUAL_CONCURRENT_HASH_H_
+#ifdef __cplusplus
+
+#include <cppual/flat_hash>
+#include <cppual/noncopyable>
+
+#include <shared_mutex>
+#include <optional>
+#include <limits>
+#include <array>
+#include <mutex>
+#include <bit>
+
+// ====================================================
+
+namespace cppual {
+
+// ====================================================
+
+/**
+ ** @brief hash table shared between threads. the keys are split over N shards by
+ ** the top bits of their hash & every shard is a flat_hash_table behind its own
+ ** reader/writer lock on its own cache line, so lookups of different keys take
+ ** different locks & scale with the reader threads instead of queuing on one
+ ** mutex. the key is hashed once for both the shard & the slot.
+ ** references never leave the lock: find returns a copy of the value, visit runs
+ ** a function on the element while its shard is locked & for_each locks the
+ ** shards one at a time, so it is not a snapshot of the whole table.
+ ** the functions passed to visit, emplace_or_visit, erase_if & for_each must not
+ ** call back into the same table
+ **/
+template <non_void K, typename V, structure Hash, structure Pred, allocator_like A, std::size_t N = 64>
+class SHARED_API concurrent_hash_table : private Hash, public non_copyable
+{
+public:
+    typedef flat_hash_table<K, V, Hash, Pred, A>          table_type    ;
+    typedef concurrent_hash_table<K, V, Hash, Pred, A, N> self_type     ;
+    typedef table_type::key_type                          key_type      ;
+    typedef table_type::mapped_type                       mapped_type   ;
+    typedef table_type::value_type                        value_type    ;
+    typedef table_type::size_type                         size_type     ;
+    typedef table_type::hasher                            hasher        ;
+    typedef table_type::key_equal                         key_equal     ;
+    typedef table_type::allocator_type                    allocator_type;
+    typedef std::shared_mutex                             mutex_type    ;
+    typedef std::shared_lock<mutex_type>                  read_lock     ;
+    typedef std::unique_lock<mutex_type>                  write_lock    ;
+
+    inline constexpr static cbool           is_set          = table_type::is_set;
+    inline constexpr static size_type const shard_count     = N ;
+    inline constexpr static size_type const cache_line_size = 64;
+
+    template <typename Q>
+    inline constexpr static cbool is_lookup_key = table_type::template is_lookup_key<Q>;
+
+    static_assert (N && std::has_single_bit (N), "the shard count must be a power of 2!");
+
+    // ====================================================
+
+    concurrent_hash_table ()
+    : concurrent_hash_table (size_type ())
+    { }
+
+    explicit concurrent_hash_table (size_type             uBuckets,
+                                    hasher         const& gHash  = hasher         (),
+                                    key_equal      const& gEqual = key_equal      (),
+                                    allocator_type const& gAtor  = allocator_type ())
+    : hasher    (gHash)
+    , _M_gShards()
+    {
+        for (auto& gShard : _M_gShards)
+        {
+            gShard.table = table_type ((uBuckets + N - 1) / N, gHash, gEqual, gAtor);
+        }
+    }
+
+    explicit concurrent_hash_table (allocator_type const& gAtor)
+    : concurrent_hash_table (size_type (), hasher (), key_equal (), gAtor)
+    { }
+
+    concurrent_hash_table (std::initializer_list<value_type> list,
+                           allocator_type const&             gAtor = allocator_type ())
+    : concurrent_hash_table (list.size (), hasher (), key_equal (), gAtor)
+    { for (auto const& val : list) insert (val); }
+
+    // ====================================================
+
+    //! the sum of the shard sizes, exact only while no thread is writing
+    size_type size () const
+    {
+        size_type uSize = size_type ();
+
+        for (auto const& gShard : _M_gShards)
+        {
+            read_lock gLock (gShard.mutex);
+
+            uSize += gShard.table.size ();
+        }
+
+        return uSize;
+    }
+
+    bool empty () const
+    { return !size (); }
+
+    allocator_type get_allocator () const
+    { return _M_gShards.front ().table.get_allocator (); }
+
+    hasher hash_function () const
+    { return static_cast<hasher const&> (*this); }
+
+    void reserve (size_type n)
+    {
+        for (auto& gShard : _M_gShards)
+        {
+            write_lock gLock (gShard.mutex);
+
+            gShard.table.reserve ((n + N - 1) / N);
+        }
+    }
+
+    void clear ()
+    {
+        for (auto& gShard : _M_gShards)
+        {
+            write_lock gLock (gShard.mutex);
+
+            gShard.table.clear ();
+        }
+    }
+
+    // ====================================================
+
+    template <typename Q> requires is_lookup_key<Q>
+    bool contains (Q const& key) const
+    {
+        auto const  uHash  = hash_of (key);
+        auto const& gShard = shard_of (uHash);
+        read_lock   gLock (gShard.mutex);
+
+        return gShard.table.find_index (key, uHash) != table_type::npos;
+    }
+
+    bool contains (key_type const& key) const
+    { return contains<key_type> (key); }
+
+    template <typename Q> requires is_lookup_key<Q>
+    size_type count (Q const& key) const
+    { return contains (key); }
+
+    //! a copy of the mapped value, the element may be gone by the time it is used
+    template <typename Q> requires (!is_set && is_lookup_key<Q>)
+    std::optional<mapped_type> find (Q const& key) const
+    {
+        auto const  uHash  = hash_of (key);
+        auto const& gShard = shard_of (uHash);
+        read_lock   gLock (gShard.mutex);
+
+        auto const uIdx = gShard.table.find_index (key, uHash);
+
+        if (uIdx == table_type::npos) return std::nullopt;
+        return gShard.table._M_pSlots[uIdx].second;
+    }
+
+    std::optional<mapped_type> find (key_type const& key) const requires (!is_set)
+    { return find<key_type> (key); }
+
+    //! calls fn (value_type const&) under the shared lock of the shard
+    template <typename Q, typename Fn> requires is_lookup_key<Q>
+    bool visit (Q const& key, Fn&& fn) const
+    {
+        auto const  uHash  = hash_of (key);
+        auto const& gShard = shard_of (uHash);
+        read_lock   gLock (gShard.mutex);
+
+        auto const uIdx = gShard.table.find_index (key, uHash);
+
+        if (uIdx == table_type::npos) return false;
+
+        std::forward<Fn> (fn) (static_cast<value_type const&> (gShard.table._M_pSlots[uIdx]));
+        return true;
+    }
+
+    //! calls fn (value_type&) under the exclusive lock of the shard
+    template <typename Q, typename Fn> requires is_lookup_key<Q>
+    bool visit (Q const& key, Fn&& fn)
+    {
+        auto const uHash  = hash_of (key);
+        auto&      gShard = shard_of (uHash);
+        write_lock gLock (gShard.mutex);
+
+        auto const uIdx = gShard.table.find_index (key, uHash);
+
+        if (uIdx == table_type::npos) return false;
+
+        std::forward<Fn> (fn) (gShard.table._M_pSlots[uIdx]);
+        return true;
+    }
+
+    // ====================================================
+
+    //! true when the value was inserted, false when the key was already there
+    bool insert (value_type const& val)
+    { return emplace_key (table_type::key_of (val), val); }
+
+    bool insert (value_type&& val)
+    { return emplace_key (table_type::key_of (val), std::move (val)); }
+
+    template <std::input_iterator Iterator>
+    void insert (Iterator gFirst, Iterator gLast)
+    { for (; gFirst != gLast; ++gFirst) insert (*gFirst); }
+
+    //! the value is constructed outside of the lock, prefer try_emplace for maps
+    template <typename... Args>
+    bool emplace (Args&&... args)
+    {
+        value_type val (std::forward<Args> (args)...);
+
+        return emplace_key (table_type::key_of (val), std::move (val));
+    }
+
+    template <typename Q, typename... Args> requires (!is_set && std::is_constructible_v<key_type, Q&&>)
+    bool try_emplace (Q&& key, Args&&... args)
+    {
+        return emplace_key (key,
+                            std::piecewise_construct,
+                            std::forward_as_tuple (std::forward<Q> (key)),
+                            std::forward_as_tuple (std::forward<Args> (args)...));
+    }
+
+    //! true when the value was inserted, false when it was assigned
+    template <typename Q, typename M> requires (!is_set && std::is_constructible_v<key_type, Q&&>)
+    bool insert_or_assign (Q&& key, M&& obj)
+    {
+        auto const uHash  = hash_of (key);
+        auto&      gShard = shard_of (uHash);
+        write_lock gLock (gShard.mutex);
+
+        auto const uIdx = gShard.table.find_index (key, uHash);
+
+        if (uIdx != table_type::npos)
+        {
+            gShard.table._M_pSlots[uIdx].second = std::forward<M> (obj);
+            return false;
+        }
+
+        gShard.table.emplace_hashed (key, uHash,
+                                     std::piecewise_construct,
+                                     std::forward_as_tuple (std::forward<Q> (key)),
+                                     std::forward_as_tuple (std::forward<M> (obj)));
+        return true;
+    }
+
+    //! inserts the value or calls fn (value_type&) on the existing one in a
+    //! single exclusive lock (counters, reference counts, last seen times)
+    template <typename Q, typename Fn, typename... Args>
+    requires (!is_set && std::is_constructible_v<key_type, Q&&>)
+    bool emplace_or_visit (Q&& key, Fn&& fn, Args&&... args)
+    {
+        auto const uHash  = hash_of (key);
+        auto&      gShard = shard_of (uHash);
+        write_lock gLock (gShard.mutex);
+
+        auto const uIdx = gShard.table.find_index (key, uHash);
+
+        if (uIdx != table_type::npos)
+        {
+            std::forward<Fn> (fn) (gShard.table._M_pSlots[uIdx]);
+            return false;
+        }
+
+        gShard.table.emplace_hashed (key, uHash,
+                                     std::piecewise_construct,
+                                     std::forward_as_tuple (std::forward<Q> (key)),
+                                     std::forward_as_tuple (std::forward<Args> (args)...));
+        return true;
+    }
+
+    // ====================================================
+
+    template <typename Q> requires is_lookup_key<Q>
+    size_type erase (Q const& key)
+    {
+        auto const uHash  = hash_of (key);
+        auto&      gShard = shard_of (uHash);
+        write_lock gLock (gShard.mutex);
+
+        auto const uIdx = gShard.table.find_index (key, uHash);
+
+        if (uIdx == table_type::npos) return 0;
+
+        gShard.table.erase_at (uIdx);
+        return 1;
+    }
+
+    size_type erase (key_type const& key)
+    { return erase<key_type> (key); }
+
+    //! erases every element for which pred (value_type const&) is true
+    template <typename Predicate>
+    size_type erase_if (Predicate pred)
+    {
+        size_type uCount = size_type ();
+
+        for (auto& gShard : _M_gShards)
+        {
+            write_lock gLock (gShard.mutex);
+
+            for (auto it = gShard.table.begin (); it != gShard.table.end (); )
+            {
+                if (pred (static_cast<value_type const&> (*it)))
+                {
+                    it = gShard.table.erase (it);
+                    ++uCount;
+                }
+                else ++it;
+            }
+        }
+
+        return uCount;
+    }
+
+    //! calls fn (value_type const&) for every element, one shard at a time
+    template <typename Fn>
+    void for_each (Fn fn) const
+    {
+        for (auto const& gShard : _M_gShards)
+        {
+            read_lock gLock (gShard.mutex);
+
+            for (auto const& val : gShard.table) fn (val);
+        }
+    }
+
+    //! calls fn (value_type&) for every element, one shard at a time
+    template <typename Fn>
+    void for_each (Fn fn)
+    {
+        for (auto& gShard : _M_gShards)
+        {
+            write_lock gLock (gShard.mutex);
+
+            for (auto& val : gShard.table) fn (val);
+        }
+    }
+
+private:
+    inline constexpr static size_type const shard_bits = static_cast<size_type> (std::countr_zero (N));
+
+    //! the lock & the table header of a shard share a line of their own
+    struct alignas (cache_line_size) shard
+    {
+        mutable mutex_type mutex;
+        table_type         table;
+    };
+
+    template <typename Q>
+    size_type hash_of (Q const& key) const noexcept
+    { return table_type::mix (static_cast<hasher const&> (*this) (key)); }
+
+    //! the top bits pick the shard, the slot inside of it comes from the low bits
+    shard& shard_of (size_type uHash) noexcept
+    {
+        if constexpr (!shard_bits) return _M_gShards.front ();
+        else return _M_gShards[uHash >> (std::numeric_limits<size_type>::digits - shard_bits)];
+    }
+
+    shard const& shard_of (size_type uHash) const noexcept
+    { return const_cast<self_type&> (*this).shard_of (uHash); }
+
+    template <typename Q, typename... Args>
+    bool emplace_key (Q const& key, Args&&... args)
+    {
+        auto const uHash  = hash_of (key);
+        auto&      gShard = shard_of (uHash);
+        write_lock gLock (gShard.mutex);
+
+        return gShard.table.emplace_hashed (key, uHash, std::forward<Args> (args)...).second;
+    }
+
+private:
+    std::array<shard, N> _M_gShards;
+};
+
+// ====================================================
+
+} // namespace cppual
+
+// ====================================================
+
+#endif // __cplusplus
+#endif // CPPUAL_CONCURRENT_HASH_H_
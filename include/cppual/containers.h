@@ -24,6 +24,9 @@
 #ifdef __cplusplus
 
 #include <cppual/memory_allocator>
+#include <cppual/flat_hash>
+#include <cppual/concurrent_hash>
+#include <cppual/small_vector>
 
 #include <unordered_map>
 #include <unordered_set>
@@ -77,6 +80,24 @@ template <non_void T, structure Hash = std::hash<T>, structure Pred = std::equal
 using unordered_multiset =
 std::unordered_multiset<T, Hash, Pred, memory::allocator<T>>;
 
+//! open addressing (swiss table) map, string keys can be looked up by any string view
+template <non_void K, non_void V, structure Hash = flat_hash<K>, structure Pred = flat_equal<K>>
+using flat_hash_map =
+flat_hash_table<K, V, Hash, Pred, memory::allocator<std::pair<K const, V>>>;
+
+template <non_void T, structure Hash = flat_hash<T>, structure Pred = flat_equal<T>>
+using flat_hash_set =
+flat_hash_table<T, void, Hash, Pred, memory::allocator<T>>;
+
+//! flat_hash_map split into shards with a reader/writer lock each, for tables shared between threads
+template <non_void K, non_void V, structure Hash = flat_hash<K>, structure Pred = flat_equal<K>, std::size_t N = 64>
+using concurrent_hash_map =
+concurrent_hash_table<K, V, Hash, Pred, memory::allocator<std::pair<K const, V>>, N>;
+
+template <non_void T, structure Hash = flat_hash<T>, structure Pred = flat_equal<T>, std::size_t N = 64>
+using concurrent_hash_set =
+concurrent_hash_table<T, void, Hash, Pred, memory::allocator<T>, N>;
+
 template <non_void K, non_void V, structure Compare = std::less<K>>
 using map =
 std::map<K, V, Compare, memory::allocator<std::pair<K const, V>>>;
@@ -178,6 +178,7 @@
 #undef DEPRECATED
 #undef FORCEINLINE
 #undef DECLSPEC_ALIGN
+#undef PREFETCH
 
 #if defined (_MSC_VER) and (_MSC_VER > 1300) // vc++ 2005
 #
@@ -187,6 +188,7 @@
 #   define DEPRECATED(msg)
 #   define FORCEINLINE __forceinline
 #   define DECLSPEC_ALIGN(x) __declspec(align(x))
+#   define PREFETCH(x) ((void) (x))
 #   if !defined (STDCALL) and !defined (FASTCALL) and !defined (CDECL)
 #       define STDCALL __stdcall
 #       define FASTCALL __fastcall
@@ -200,6 +202,7 @@
 #   define DEPRECATED(msg) __attribute__((deprecated(msg)))
 #   define FORCEINLINE inline __attribute__((always_inline))
 #   define DECLSPEC_ALIGN(x) __attribute__((aligned(x)))
+#   define PREFETCH(x) __builtin_prefetch (x)
 #   if !defined (STDCALL) and !defined (FASTCALL) and !defined (CDECL)
 #       if defined (__WIN64__) or defined(__WIN32__)
 #           define STDCALL  __stdcall
@@ -219,6 +222,7 @@
 #   define DEPRECATED(msg)
 #   define FORCEINLINE inline
 #   define DECLSPEC_ALIGN(x) alignas(x)
+#   define PREFETCH(x) ((void) (x))
 #   if !defined (STDCALL) and !defined (FASTCALL) and !defined (CDECL)
 #       define STDCALL
 #       define FASTCALL
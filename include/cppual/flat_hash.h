@@ -0,0 +1,934 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPUAL_FLAT_HASH_H_
+#define CPPUAL_FLAT_HASH_H_
+#ifdef __cplusplus
+
+#include <cppual/memory_allocator>
+#include <cppual/concepts>
+#include <cppual/types>
+
+#include <initializer_list>
+#include <string_view>
+#include <functional>
+#include <stdexcept>
+#include <iterator>
+#include <utility>
+#include <memory>
+#include <string>
+#include <bit>
+
+#if defined (__SSE2__) or defined (_M_X64) or (defined (_M_IX86_FP) and _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define CPPUAL_FLAT_HASH_SSE2
+#endif
+
+// ====================================================
+
+namespace cppual {
+
+// ====================================================
+
+//! hashes every string of C as a view, so string_view, fstring_view & c string
+//! lookups in a table with string keys don't construct a temporary key
+template <symbolic_char C>
+struct string_view_hash
+{
+    typedef void is_transparent;
+
+    constexpr std::size_t operator () (std::basic_string_view<C> str) const noexcept
+    { return std::hash<std::basic_string_view<C>> () (str); }
+};
+
+template <symbolic_char C>
+struct string_view_equal
+{
+    typedef void is_transparent;
+
+    constexpr bool operator () (std::basic_string_view<C> lh, std::basic_string_view<C> rh) const noexcept
+    { return lh == rh; }
+};
+
+// ====================================================
+
+//! default hash & key equality of the flat tables
+template <typename T>
+struct flat_hash : public std::hash<T>
+{ };
+
+template <typename T>
+struct flat_equal : public std::equal_to<T>
+{ };
+
+template <symbolic_char C, typename Traits, typename A>
+struct flat_hash <std::basic_string<C, Traits, A>> : public string_view_hash<C>
+{ };
+
+template <symbolic_char C, typename Traits, typename A>
+struct flat_equal <std::basic_string<C, Traits, A>> : public string_view_equal<C>
+{ };
+
+template <symbolic_char C, typename Traits>
+struct flat_hash <std::basic_string_view<C, Traits>> : public string_view_hash<C>
+{ };
+
+template <symbolic_char C, typename Traits>
+struct flat_equal <std::basic_string_view<C, Traits>> : public string_view_equal<C>
+{ };
+
+//! cow_string & its views
+template <typename T> requires requires { typename T::std_string_view; }
+struct flat_hash <T> : public string_view_hash<typename T::value_type>
+{ };
+
+template <typename T> requires requires { typename T::std_string_view; }
+struct flat_equal <T> : public string_view_equal<typename T::value_type>
+{ };
+
+// ====================================================
+
+/**
+ ** @brief open addressing hash table with the slots in a single array & one
+ ** control byte per slot (swiss table). a full slot stores the low 7 bits
+ ** of its hash in the control byte, so a lookup compares a whole group of
+ ** control bytes at once (16 with SSE2, 8 with plain 64 bit arithmetic)
+ ** & only touches the slots whose bits match. the groups are probed in
+ ** triangular steps & the table grows at 7/8 load.
+ ** V = void makes it a set. lookups accept any key type when both Hash &
+ ** Pred are transparent. use it through flat_hash_map & flat_hash_set
+ **/
+template <non_void K, typename V, structure Hash, structure Pred, allocator_like A>
+class SHARED_API flat_hash_table : private Hash, private Pred
+{
+public:
+    inline constexpr static cbool is_set = std::is_void_v<V>;
+
+    typedef flat_hash_table<K, V, Hash, Pred, A>                                self_type      ;
+    typedef K                                                                   key_type       ;
+    typedef std::conditional_t<is_set, K, V>                                    mapped_type    ;
+    typedef std::conditional_t<is_set, K, std::pair<K const, mapped_type>>      value_type     ;
+    typedef value_type &                                                        reference      ;
+    typedef value_type const&                                                   const_reference;
+    typedef value_type *                                                        pointer        ;
+    typedef value_type const*                                                   const_pointer  ;
+    typedef std::size_t                                                         size_type      ;
+    typedef size_type const                                                     const_size     ;
+    typedef std::ptrdiff_t                                                      difference_type;
+    typedef Hash                                                                hasher         ;
+    typedef Pred                                                                key_equal      ;
+    typedef std::allocator_traits<A>::template rebind_alloc<value_type>         allocator_type ;
+    typedef std::allocator_traits<allocator_type>                               traits_type    ;
+    typedef i8                                                                  ctrl_type      ;
+
+    inline constexpr static const_size npos = static_cast<size_type> (-1);
+
+    template <typename Q>
+    inline constexpr static cbool is_lookup_key = std::is_convertible_v<Q const&, key_type const&> ||
+                                                  (requires { typename Hash::is_transparent; } &&
+                                                   requires { typename Pred::is_transparent; });
+
+private:
+    //! control byte values, a full slot holds 0 ... 127
+    inline constexpr static ctrl_type const empty_ctrl   = -128;
+    inline constexpr static ctrl_type const deleted_ctrl = -2  ;
+
+    typedef std::allocator_traits<A>::template rebind_alloc<ctrl_type> ctrl_allocator;
+    typedef std::allocator_traits<ctrl_allocator>                      ctrl_traits   ;
+
+    //! the positions matching a group query, lowest first
+    struct match_mask
+    {
+        u64      bits ;
+        unsigned shift; //! log2 of the bits per control byte
+
+        constexpr explicit operator bool () const noexcept
+        { return bits; }
+
+        constexpr size_type lowest () const noexcept
+        { return static_cast<size_type> (std::countr_zero (bits)) >> shift; }
+
+        constexpr void clear_lowest () noexcept
+        { bits &= bits - 1; }
+    };
+
+#   ifdef CPPUAL_FLAT_HASH_SSE2
+
+    struct group
+    {
+        inline constexpr static const_size width = 16;
+
+        __m128i ctrl;
+
+        explicit group (ctrl_type const* pCtrl) noexcept
+        : ctrl (_mm_loadu_si128 (reinterpret_cast<__m128i const*> (pCtrl)))
+        { }
+
+        match_mask match (ctrl_type h2) const noexcept
+        { return { bitmask (_mm_cmpeq_epi8 (_mm_set1_epi8 (h2), ctrl)), 0 }; }
+
+        match_mask match_empty () const noexcept
+        { return { bitmask (_mm_cmpeq_epi8 (_mm_set1_epi8 (empty_ctrl), ctrl)), 0 }; }
+
+        //! empty (-128) & deleted (-2) are the only values below -1
+        match_mask match_free () const noexcept
+        { return { bitmask (_mm_cmpgt_epi8 (_mm_set1_epi8 (-1), ctrl)), 0 }; }
+
+        static u64 bitmask (__m128i mask) noexcept
+        { return static_cast<u64> (static_cast<u16> (_mm_movemask_epi8 (mask))); }
+    };
+
+#   else
+
+    //! 8 control bytes compared at once in a 64 bit word. match can report a full
+    //! slot next to a real match as a false positive, the key comparison sorts it out
+    struct group
+    {
+        inline constexpr static const_size width = 8;
+        inline constexpr static u64  const lsbs  = 0x0101010101010101ULL;
+        inline constexpr static u64  const msbs  = 0x8080808080808080ULL;
+
+        u64 ctrl;
+
+        explicit group (ctrl_type const* pCtrl) noexcept
+        : ctrl ()
+        {
+            for (auto i = 0U; i < width; ++i) ctrl |= u64 (static_cast<u8> (pCtrl[i])) << (i * 8);
+        }
+
+        match_mask match (ctrl_type h2) const noexcept
+        {
+            auto const x = ctrl ^ (lsbs * static_cast<u8> (h2));
+            return { (x - lsbs) & ~x & msbs, 3 };
+        }
+
+        //! the sign bit without bit 6 -> empty (0b10000000)
+        match_mask match_empty () const noexcept
+        { return { ctrl & ~(ctrl << 6) & msbs, 3 }; }
+
+        //! the sign bit without bit 0 -> empty & deleted (0b11111110)
+        match_mask match_free () const noexcept
+        { return { ctrl & ~(ctrl << 7) & msbs, 3 }; }
+    };
+
+#   endif
+
+    //! visits the groups starting at hash in triangular steps, which covers
+    //! every group once as long as the capacity is a power of 2
+    struct probe_seq
+    {
+        size_type mask ;
+        size_type pos  ;
+        size_type index;
+
+        constexpr probe_seq (size_type h1, size_type uMask) noexcept
+        : mask (uMask), pos (h1 & uMask), index ()
+        { }
+
+        constexpr size_type offset (size_type i) const noexcept
+        { return (pos + i) & mask; }
+
+        constexpr void next () noexcept
+        {
+            index += group::width;
+            pos    = (pos + index) & mask;
+        }
+    };
+
+public:
+    template <bool Const>
+    class basic_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag                                   iterator_category;
+        typedef flat_hash_table::value_type                                 value_type       ;
+        typedef flat_hash_table::difference_type                            difference_type  ;
+        typedef std::conditional_t<Const, value_type const*, value_type*>   pointer          ;
+        typedef std::conditional_t<Const, value_type const&, value_type&>   reference        ;
+
+        constexpr basic_iterator () noexcept = default;
+
+        //! iterator -> const_iterator
+        template <bool C> requires (Const && !C)
+        constexpr basic_iterator (basic_iterator<C> const& it) noexcept
+        : _M_pCtrl (it._M_pCtrl), _M_pSlot (it._M_pSlot), _M_pEnd (it._M_pEnd)
+        { }
+
+        constexpr reference operator *  () const noexcept { return *_M_pSlot; }
+        constexpr pointer   operator -> () const noexcept { return  _M_pSlot; }
+
+        constexpr basic_iterator& operator ++ () noexcept
+        {
+            ++_M_pCtrl;
+            ++_M_pSlot;
+
+            skip_free ();
+            return *this;
+        }
+
+        constexpr basic_iterator operator ++ (int) noexcept
+        {
+            auto it = *this;
+
+            ++(*this);
+            return it;
+        }
+
+        friend constexpr bool operator == (basic_iterator const& lh, basic_iterator const& rh) noexcept
+        { return lh._M_pCtrl == rh._M_pCtrl; }
+
+    private:
+        constexpr basic_iterator (ctrl_type const* pCtrl, pointer pSlot, ctrl_type const* pEnd) noexcept
+        : _M_pCtrl (pCtrl), _M_pSlot (pSlot), _M_pEnd (pEnd)
+        { skip_free (); }
+
+        constexpr void skip_free () noexcept
+        {
+            while (_M_pCtrl != _M_pEnd && *_M_pCtrl < 0)
+            {
+                ++_M_pCtrl;
+                ++_M_pSlot;
+            }
+        }
+
+    private:
+        ctrl_type const* _M_pCtrl { };
+        pointer          _M_pSlot { };
+        ctrl_type const* _M_pEnd  { };
+
+        friend class flat_hash_table;
+        friend class basic_iterator<!Const>;
+    };
+
+    typedef basic_iterator<false>       iterator      ;
+    typedef basic_iterator<true >       const_iterator;
+    typedef std::pair<iterator, bool>   iterator_pair ;
+
+    // ====================================================
+
+    flat_hash_table () noexcept (std::is_nothrow_default_constructible_v<allocator_type>)
+    : flat_hash_table (size_type ())
+    { }
+
+    explicit flat_hash_table (size_type             uBuckets,
+                              hasher         const& gHash  = hasher         (),
+                              key_equal      const& gEqual = key_equal      (),
+                              allocator_type const& gAtor  = allocator_type ())
+    : hasher        (gHash )
+    , key_equal     (gEqual)
+    , _M_gAtor      (gAtor )
+    , _M_pCtrl      ()
+    , _M_pSlots     ()
+    , _M_uCapacity  ()
+    , _M_uSize      ()
+    , _M_uGrowthLeft()
+    { if (uBuckets) reserve (uBuckets); }
+
+    explicit flat_hash_table (allocator_type const& gAtor)
+    : flat_hash_table (size_type (), hasher (), key_equal (), gAtor)
+    { }
+
+    flat_hash_table (std::initializer_list<value_type> list,
+                     allocator_type const&             gAtor = allocator_type ())
+    : flat_hash_table (list.size (), hasher (), key_equal (), gAtor)
+    { for (auto const& val : list) insert (val); }
+
+    flat_hash_table (self_type const& gObj)
+    : hasher        (gObj)
+    , key_equal     (gObj)
+    , _M_gAtor      (traits_type::select_on_container_copy_construction (gObj._M_gAtor))
+    , _M_pCtrl      ()
+    , _M_pSlots     ()
+    , _M_uCapacity  ()
+    , _M_uSize      ()
+    , _M_uGrowthLeft()
+    {
+        reserve (gObj.size ());
+
+        for (auto const& val : gObj) insert (val);
+    }
+
+    flat_hash_table (self_type&& gObj) noexcept
+    : hasher        (std::move (static_cast<hasher&> (gObj)))
+    , key_equal     (std::move (static_cast<key_equal&> (gObj)))
+    , _M_gAtor      (std::move (gObj._M_gAtor))
+    , _M_pCtrl      (gObj._M_pCtrl      )
+    , _M_pSlots     (gObj._M_pSlots     )
+    , _M_uCapacity  (gObj._M_uCapacity  )
+    , _M_uSize      (gObj._M_uSize      )
+    , _M_uGrowthLeft(gObj._M_uGrowthLeft)
+    {
+        gObj._M_pCtrl      = nullptr;
+        gObj._M_pSlots     = nullptr;
+        gObj._M_uCapacity  = gObj._M_uSize = gObj._M_uGrowthLeft = size_type ();
+    }
+
+    ~flat_hash_table ()
+    { dispose (); }
+
+    self_type& operator = (self_type const& gObj)
+    {
+        if (this != &gObj)
+        {
+            self_type gCopy (gObj);
+
+            swap (gCopy);
+        }
+
+        return *this;
+    }
+
+    self_type& operator = (self_type&& gObj) noexcept
+    {
+        if (this != &gObj)
+        {
+            dispose ();
+
+            self_type gTmp (std::move (gObj));
+
+            swap (gTmp);
+        }
+
+        return *this;
+    }
+
+    // ====================================================
+
+    constexpr iterator begin () noexcept
+    { return iterator (_M_pCtrl, _M_pSlots, _M_pCtrl + _M_uCapacity); }
+
+    constexpr const_iterator begin () const noexcept
+    { return const_iterator (_M_pCtrl, _M_pSlots, _M_pCtrl + _M_uCapacity); }
+
+    constexpr const_iterator cbegin () const noexcept
+    { return begin (); }
+
+    constexpr iterator end () noexcept
+    { return iterator (_M_pCtrl + _M_uCapacity, _M_pSlots + _M_uCapacity, _M_pCtrl + _M_uCapacity); }
+
+    constexpr const_iterator end () const noexcept
+    { return const_iterator (_M_pCtrl + _M_uCapacity, _M_pSlots + _M_uCapacity, _M_pCtrl + _M_uCapacity); }
+
+    constexpr const_iterator cend () const noexcept
+    { return end (); }
+
+    constexpr size_type size () const noexcept
+    { return _M_uSize; }
+
+    constexpr bool empty () const noexcept
+    { return !_M_uSize; }
+
+    constexpr size_type capacity () const noexcept
+    { return _M_uCapacity; }
+
+    constexpr size_type bucket_count () const noexcept
+    { return _M_uCapacity; }
+
+    constexpr float load_factor () const noexcept
+    { return _M_uCapacity ? static_cast<float> (_M_uSize) / static_cast<float> (_M_uCapacity) : 0.f; }
+
+    consteval static float max_load_factor () noexcept
+    { return 7.f / 8.f; }
+
+    constexpr allocator_type get_allocator () const noexcept
+    { return _M_gAtor; }
+
+    constexpr hasher hash_function () const
+    { return *this; }
+
+    constexpr key_equal key_eq () const
+    { return *this; }
+
+    //! room for n elements without growing
+    void reserve (size_type n)
+    {
+        if (n <= _M_uSize + _M_uGrowthLeft) return;
+
+        resize (capacity_for (n));
+    }
+
+    void rehash (size_type n)
+    { resize (capacity_for (std::max (n, _M_uSize))); }
+
+    void clear () noexcept
+    {
+        if (!_M_uCapacity) return;
+
+        destroy_slots ();
+        reset_ctrl    ();
+    }
+
+    void swap (self_type& gObj) noexcept
+    {
+        using std::swap;
+
+        swap (static_cast<hasher&>    (*this), static_cast<hasher&>    (gObj));
+        swap (static_cast<key_equal&> (*this), static_cast<key_equal&> (gObj));
+
+        if constexpr (traits_type::propagate_on_container_swap::value) swap (_M_gAtor, gObj._M_gAtor);
+
+        swap (_M_pCtrl      , gObj._M_pCtrl      );
+        swap (_M_pSlots     , gObj._M_pSlots     );
+        swap (_M_uCapacity  , gObj._M_uCapacity  );
+        swap (_M_uSize      , gObj._M_uSize      );
+        swap (_M_uGrowthLeft, gObj._M_uGrowthLeft);
+    }
+
+    // ====================================================
+
+    template <typename Q> requires is_lookup_key<Q>
+    iterator find (Q const& key) noexcept
+    {
+        auto const uIdx = find_index (key);
+
+        return uIdx != npos ? iterator_at (uIdx) : end ();
+    }
+
+    template <typename Q> requires is_lookup_key<Q>
+    const_iterator find (Q const& key) const noexcept
+    {
+        auto const uIdx = find_index (key);
+
+        return uIdx != npos ? const_iterator (iterator_at (uIdx)) : end ();
+    }
+
+    iterator find (key_type const& key) noexcept
+    { return find<key_type> (key); }
+
+    const_iterator find (key_type const& key) const noexcept
+    { return find<key_type> (key); }
+
+    template <typename Q> requires is_lookup_key<Q>
+    bool contains (Q const& key) const noexcept
+    { return find_index (key) != npos; }
+
+    bool contains (key_type const& key) const noexcept
+    { return find_index (key) != npos; }
+
+    template <typename Q> requires is_lookup_key<Q>
+    size_type count (Q const& key) const noexcept
+    { return contains (key); }
+
+    size_type count (key_type const& key) const noexcept
+    { return contains (key); }
+
+    // ====================================================
+
+    iterator_pair insert (value_type const& val)
+    { return emplace_key (key_of (val), val); }
+
+    iterator_pair insert (value_type&& val)
+    { return emplace_key (key_of (val), std::move (val)); }
+
+    template <std::input_iterator Iterator>
+    void insert (Iterator gFirst, Iterator gLast)
+    {
+        if constexpr (std::forward_iterator<Iterator>)
+        {
+            reserve (_M_uSize + static_cast<size_type> (std::distance (gFirst, gLast)));
+        }
+
+        for (; gFirst != gLast; ++gFirst) insert (*gFirst);
+    }
+
+    void insert (std::initializer_list<value_type> list)
+    { insert (list.begin (), list.end ()); }
+
+    //! the value is constructed before the lookup, prefer try_emplace for maps
+    template <typename... Args>
+    iterator_pair emplace (Args&&... args)
+    {
+        value_type val (std::forward<Args> (args)...);
+
+        return emplace_key (key_of (val), std::move (val));
+    }
+
+    template <typename Q, typename... Args> requires (!is_set && std::is_constructible_v<key_type, Q&&>)
+    iterator_pair try_emplace (Q&& key, Args&&... args)
+    {
+        return emplace_key (key,
+                            std::piecewise_construct,
+                            std::forward_as_tuple (std::forward<Q> (key)),
+                            std::forward_as_tuple (std::forward<Args> (args)...));
+    }
+
+    template <typename Q, typename M> requires (!is_set && std::is_constructible_v<key_type, Q&&>)
+    iterator_pair insert_or_assign (Q&& key, M&& obj)
+    {
+        auto gRet = try_emplace (std::forward<Q> (key), std::forward<M> (obj));
+
+        if (!gRet.second) gRet.first->second = std::forward<M> (obj);
+        return gRet;
+    }
+
+    template <typename Q> requires (!is_set && std::is_constructible_v<key_type, Q&&>)
+    mapped_type& operator [] (Q&& key)
+    { return try_emplace (std::forward<Q> (key)).first->second; }
+
+    mapped_type& operator [] (key_type const& key) requires (!is_set)
+    { return try_emplace (key).first->second; }
+
+    template <typename Q> requires (!is_set && is_lookup_key<Q>)
+    mapped_type& at (Q const& key)
+    {
+        auto const uIdx = find_index (key);
+
+        if (uIdx == npos) throw std::out_of_range ("key not found!");
+        return _M_pSlots[uIdx].second;
+    }
+
+    template <typename Q> requires (!is_set && is_lookup_key<Q>)
+    mapped_type const& at (Q const& key) const
+    {
+        auto const uIdx = find_index (key);
+
+        if (uIdx == npos) throw std::out_of_range ("key not found!");
+        return _M_pSlots[uIdx].second;
+    }
+
+    // ====================================================
+
+    template <typename Q> requires is_lookup_key<Q>
+    size_type erase (Q const& key)
+    {
+        auto const uIdx = find_index (key);
+
+        if (uIdx == npos) return 0;
+
+        erase_at (uIdx);
+        return 1;
+    }
+
+    size_type erase (key_type const& key)
+    { return erase<key_type> (key); }
+
+    iterator erase (const_iterator it)
+    {
+        auto const uIdx = static_cast<size_type> (it._M_pCtrl - _M_pCtrl);
+
+        erase_at (uIdx);
+        return iterator_at (uIdx + 1);
+    }
+
+    iterator erase (iterator it)
+    { return erase (const_iterator (it)); }
+
+    // ====================================================
+
+    friend bool operator == (self_type const& lh, self_type const& rh)
+    {
+        if (lh.size () != rh.size ()) return false;
+
+        for (auto const& val : lh)
+        {
+            auto const it = rh.find (key_of (val));
+
+            if (it == rh.end ()) return false;
+            if constexpr (!is_set) if (!(it->second == val.second)) return false;
+        }
+
+        return true;
+    }
+
+private:
+    //! the shards are looked up with a hash computed once by the concurrent table
+    template <non_void, typename, structure, structure, allocator_like, std::size_t>
+    friend class concurrent_hash_table;
+
+    constexpr static key_type const& key_of (value_type const& val) noexcept
+    {
+        if constexpr (is_set) return val;
+        else return val.first;
+    }
+
+    //! spread weak hashes (std::hash of integers is the identity) over all bits
+    constexpr static size_type mix (size_type uHash) noexcept
+    {
+        auto h = static_cast<u64> (uHash);
+
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+
+        return static_cast<size_type> (h);
+    }
+
+    constexpr static size_type h1 (size_type uHash) noexcept
+    { return uHash >> 7; }
+
+    constexpr static ctrl_type h2 (size_type uHash) noexcept
+    { return static_cast<ctrl_type> (uHash & 0x7f); }
+
+    //! power of 2 holding n elements under the maximum load
+    constexpr static size_type capacity_for (size_type n) noexcept
+    {
+        auto uCapacity = group::width;
+
+        while (uCapacity - uCapacity / 8 < n) uCapacity <<= 1;
+        return uCapacity;
+    }
+
+    template <typename Q>
+    size_type hash_of (Q const& key) const noexcept
+    { return mix (static_cast<hasher const&> (*this) (key)); }
+
+    template <typename Q>
+    bool equals (Q const& key, size_type uIdx) const noexcept
+    { return static_cast<key_equal const&> (*this) (key_of (_M_pSlots[uIdx]), key); }
+
+    iterator iterator_at (size_type uIdx) const noexcept
+    {
+        return iterator (_M_pCtrl + uIdx,
+                         const_cast<pointer> (_M_pSlots + uIdx),
+                         _M_pCtrl + _M_uCapacity);
+    }
+
+    template <typename Q>
+    size_type find_index (Q const& key) const noexcept
+    { return _M_uSize ? find_index (key, hash_of (key)) : npos; }
+
+    template <typename Q>
+    size_type find_index (Q const& key, size_type uHash) const noexcept
+    {
+        if (!_M_uSize) return npos;
+
+        for (probe_seq seq (h1 (uHash), _M_uCapacity - 1); ; seq.next ())
+        {
+            group const gGroup (_M_pCtrl + seq.pos);
+
+            for (auto gMatch = gGroup.match (h2 (uHash)); gMatch; gMatch.clear_lowest ())
+            {
+                auto const uIdx = seq.offset (gMatch.lowest ());
+
+                if (equals (key, uIdx)) return uIdx;
+            }
+
+            if (gGroup.match_empty ()) return npos;
+        }
+    }
+
+    //! first empty or deleted slot on the probe sequence of the hash
+    size_type find_free (size_type uHash) const noexcept
+    {
+        for (probe_seq seq (h1 (uHash), _M_uCapacity - 1); ; seq.next ())
+        {
+            auto const gFree = group (_M_pCtrl + seq.pos).match_free ();
+
+            if (gFree) return seq.offset (gFree.lowest ());
+        }
+    }
+
+    //! the tail mirrors the first group so any position can load a whole group
+    void set_ctrl (size_type uIdx, ctrl_type uCtrl) noexcept
+    {
+        _M_pCtrl[uIdx] = uCtrl;
+
+        if (uIdx < group::width) _M_pCtrl[_M_uCapacity + uIdx] = uCtrl;
+    }
+
+    template <typename Q, typename... Args>
+    iterator_pair emplace_key (Q const& key, Args&&... args)
+    { return emplace_hashed (key, hash_of (key), std::forward<Args> (args)...); }
+
+    template <typename Q, typename... Args>
+    iterator_pair emplace_hashed (Q const& key, size_type uHash, Args&&... args)
+    {
+        auto const uFound = find_index (key, uHash);
+
+        if (uFound != npos) return iterator_pair (iterator_at (uFound), false);
+
+        if (!_M_uGrowthLeft) grow ();
+
+        auto const uIdx = find_free (uHash);
+
+        traits_type::construct (_M_gAtor, _M_pSlots + uIdx, std::forward<Args> (args)...);
+
+        //! deleted slots were already counted as used
+        if (_M_pCtrl[uIdx] == empty_ctrl) --_M_uGrowthLeft;
+
+        set_ctrl (uIdx, h2 (uHash));
+        ++_M_uSize;
+
+        return iterator_pair (iterator_at (uIdx), true);
+    }
+
+    void erase_at (size_type uIdx) noexcept
+    {
+        traits_type::destroy (_M_gAtor, _M_pSlots + uIdx);
+
+        //! a tombstone keeps the probe sequences going through the slot intact
+        set_ctrl (uIdx, deleted_ctrl);
+        --_M_uSize;
+    }
+
+    //! drop the tombstones in place while the elements fill at most 25/32 of the slots,
+    //! which still frees enough of them to keep the inserts amortized. double otherwise
+    void grow ()
+    {
+        if (_M_uCapacity && _M_uSize * 32 <= _M_uCapacity * 25) drop_deleted ();
+        else resize (_M_uCapacity ? _M_uCapacity * 2 : group::width);
+    }
+
+    //! group of a position on the probe sequence of the hash
+    size_type probe_group (size_type uHash, size_type uIdx) const noexcept
+    { return ((uIdx - h1 (uHash)) & (_M_uCapacity - 1)) / group::width; }
+
+    //! rehash in place without reallocating. every full slot is marked deleted & every
+    //! free one empty, then each marked element moves to the first free slot of its
+    //! probe sequence. it stays put when that slot is in its current group, goes to an
+    //! empty slot or swaps with a still marked element that is placed next
+    void drop_deleted ()
+    {
+        for (auto i = size_type (); i < _M_uCapacity; ++i)
+            _M_pCtrl[i] = _M_pCtrl[i] < 0 ? empty_ctrl : deleted_ctrl;
+
+        std::copy_n (_M_pCtrl, group::width, _M_pCtrl + _M_uCapacity);
+
+        alignas (value_type) u8 pTmp[sizeof (value_type)];
+
+        auto const pSwap = reinterpret_cast<pointer> (pTmp);
+
+        for (auto i = size_type (); i < _M_uCapacity; ++i)
+        {
+            if (_M_pCtrl[i] != deleted_ctrl) continue;
+
+            auto const uHash = hash_of (key_of (_M_pSlots[i]));
+            auto const uIdx  = find_free (uHash);
+
+            if (probe_group (uHash, uIdx) == probe_group (uHash, i))
+            {
+                set_ctrl (i, h2 (uHash));
+                continue;
+            }
+
+            if (_M_pCtrl[uIdx] == empty_ctrl)
+            {
+                traits_type::construct (_M_gAtor, _M_pSlots + uIdx, std::move (_M_pSlots[i]));
+                traits_type::destroy   (_M_gAtor, _M_pSlots + i);
+
+                set_ctrl (uIdx, h2 (uHash));
+                set_ctrl (i   , empty_ctrl  );
+                continue;
+            }
+
+            //! the element of the target slot still has to be placed, it takes this slot
+            traits_type::construct (_M_gAtor, pSwap         , std::move (_M_pSlots[i]   ));
+            traits_type::destroy   (_M_gAtor, _M_pSlots + i);
+            traits_type::construct (_M_gAtor, _M_pSlots + i , std::move (_M_pSlots[uIdx]));
+            traits_type::destroy   (_M_gAtor, _M_pSlots + uIdx);
+            traits_type::construct (_M_gAtor, _M_pSlots + uIdx, std::move (*pSwap));
+            traits_type::destroy   (_M_gAtor, pSwap);
+
+            set_ctrl (uIdx, h2 (uHash));
+            --i;
+        }
+
+        _M_uGrowthLeft = _M_uCapacity - _M_uCapacity / 8 - _M_uSize;
+    }
+
+    void resize (size_type uNewCapacity)
+    {
+        ctrl_allocator gCtrlAtor (_M_gAtor);
+
+        auto const pOldCtrl     = _M_pCtrl    ;
+        auto const pOldSlots    = _M_pSlots   ;
+        auto const uOldCapacity = _M_uCapacity;
+
+        _M_pCtrl     = ctrl_traits::allocate (gCtrlAtor, uNewCapacity + group::width);
+        _M_pSlots    = traits_type::allocate (_M_gAtor , uNewCapacity);
+        _M_uCapacity = uNewCapacity;
+
+        reset_ctrl ();
+
+        for (auto i = size_type (); i < uOldCapacity; ++i)
+        {
+            if (pOldCtrl[i] < 0) continue;
+
+            auto const uHash = hash_of (key_of (pOldSlots[i]));
+            auto const uIdx  = find_free (uHash);
+
+            traits_type::construct (_M_gAtor, _M_pSlots + uIdx, std::move (pOldSlots[i]));
+            traits_type::destroy   (_M_gAtor, pOldSlots + i);
+
+            set_ctrl (uIdx, h2 (uHash));
+            ++_M_uSize;
+            --_M_uGrowthLeft;
+        }
+
+        if (uOldCapacity)
+        {
+            ctrl_traits::deallocate (gCtrlAtor, pOldCtrl , uOldCapacity + group::width);
+            traits_type::deallocate (_M_gAtor , pOldSlots, uOldCapacity);
+        }
+    }
+
+    void reset_ctrl () noexcept
+    {
+        std::fill_n (_M_pCtrl, _M_uCapacity + group::width, empty_ctrl);
+
+        _M_uSize       = size_type ();
+        _M_uGrowthLeft = _M_uCapacity - _M_uCapacity / 8;
+    }
+
+    void destroy_slots () noexcept
+    {
+        if constexpr (!std::is_trivially_destructible_v<value_type>)
+        {
+            for (auto i = size_type (); i < _M_uCapacity; ++i)
+            {
+                if (_M_pCtrl[i] >= 0) traits_type::destroy (_M_gAtor, _M_pSlots + i);
+            }
+        }
+    }
+
+    void dispose () noexcept
+    {
+        if (!_M_uCapacity) return;
+
+        destroy_slots ();
+
+        ctrl_allocator gCtrlAtor (_M_gAtor);
+
+        ctrl_traits::deallocate (gCtrlAtor, _M_pCtrl , _M_uCapacity + group::width);
+        traits_type::deallocate (_M_gAtor , _M_pSlots, _M_uCapacity);
+
+        _M_pCtrl     = nullptr;
+        _M_pSlots    = nullptr;
+        _M_uCapacity = _M_uSize = _M_uGrowthLeft = size_type ();
+    }
+
+private:
+    [[no_unique_address]] allocator_type _M_gAtor      ;
+    ctrl_type*                           _M_pCtrl      ;
+    pointer                              _M_pSlots     ;
+    size_type                            _M_uCapacity  ;
+    size_type                            _M_uSize      ;
+    size_type                            _M_uGrowthLeft;
+};
+
+// ====================================================
+
+} // namespace cppual
+
+// ====================================================
+
+#endif // __cplusplus
+#endif // CPPUAL_FLAT_HASH_H_
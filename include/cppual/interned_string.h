@@ -0,0 +1,247 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPUAL_INTERNED_STRING_H_
+#define CPPUAL_INTERNED_STRING_H_
+#ifdef __cplusplus
+
+#include <cppual/memory_allocator>
+#include <cppual/noncopyable>
+#include <cppual/flat_hash>
+#include <cppual/string>
+#include <cppual/types>
+
+#include <shared_mutex>
+#include <string_view>
+#include <functional>
+#include <vector>
+
+// ====================================================
+
+namespace cppual {
+
+// ====================================================
+
+class intern_pool;
+
+// ====================================================
+
+/**
+ ** @brief handle of a string interned by an intern_pool. the characters, their
+ ** hash & the atom are stored once in the arena of the pool & never move, so
+ ** the handle is a single pointer, equality is an integer compare & hashing
+ ** reads the precomputed hash. handles of different pools are never equal.
+ ** the default constructed handle is the empty string with atom 0
+ **/
+class SHARED_API interned_string
+{
+public:
+    typedef interned_string   self_type    ;
+    typedef u32               atom_type    ;
+    typedef std::size_t       size_type    ;
+    typedef char              value_type   ;
+    typedef value_type const* const_pointer;
+    typedef fstring_view      string_view  ;
+
+    //! allocated in the arena of the pool, the characters follow it
+    struct entry
+    {
+        const_pointer str   ;
+        size_type     length;
+        size_type     hash  ;
+        atom_type     atom  ;
+    };
+
+    //! the hash of the characters, the same for every pool
+    inline static size_type hash_of (string_view const& str) noexcept
+    { return std::hash<std::string_view> () (std::string_view (str.data (), str.length ())); }
+
+    constexpr interned_string () noexcept = default;
+
+    //! interns the characters in the pool, an existing atom is reused
+    interned_string (string_view const& str, intern_pool& pool);
+    interned_string (string_view const& str);
+
+    interned_string (const_pointer str)
+    : interned_string (string_view (str))
+    { }
+
+    template <structure E, allocator_or_void A>
+    interned_string (cow_string<value_type, E, A> const& str)
+    : interned_string (string_view (str.data (), str.length ()))
+    { }
+
+    template <structure E, allocator_or_void A>
+    interned_string (cow_string<value_type, E, A> const& str, intern_pool& pool)
+    : interned_string (string_view (str.data (), str.length ()), pool)
+    { }
+
+    constexpr atom_type     atom   () const noexcept { return _M_pEntry ? _M_pEntry->atom   : atom_type (); }
+    constexpr const_pointer c_str  () const noexcept { return _M_pEntry ? _M_pEntry->str    : ""          ; }
+    constexpr const_pointer data   () const noexcept { return c_str ()                                    ; }
+    constexpr size_type     length () const noexcept { return _M_pEntry ? _M_pEntry->length : size_type (); }
+    constexpr size_type     size   () const noexcept { return length ()                                   ; }
+    constexpr bool          empty  () const noexcept { return !_M_pEntry                                  ; }
+
+    inline size_type hash () const noexcept
+    { return _M_pEntry ? _M_pEntry->hash : hash_of (string_view ("", 0)); }
+
+    constexpr string_view view () const noexcept
+    { return string_view (c_str (), length ()); }
+
+    constexpr operator string_view () const noexcept
+    { return view (); }
+
+    friend constexpr bool operator == (self_type const& lh, self_type const& rh) noexcept
+    { return lh._M_pEntry == rh._M_pEntry; }
+
+    friend constexpr bool operator != (self_type const& lh, self_type const& rh) noexcept
+    { return lh._M_pEntry != rh._M_pEntry; }
+
+private:
+    constexpr explicit interned_string (entry const* pEntry) noexcept
+    : _M_pEntry (pEntry)
+    { }
+
+    friend class intern_pool;
+
+private:
+    entry const* _M_pEntry { };
+};
+
+// ====================================================
+
+/**
+ ** @brief maps the contents of strings to stable 32 bit atoms. every distinct
+ ** string is copied once into the memory resource of the pool (an arena fits
+ ** best) & stays there until the pool is destroyed. lookups take a shared lock,
+ ** only the first insertion of a string takes the exclusive one.
+ ** global () is the pool of the process used by the interned_string
+ ** constructors without a pool
+ **/
+class SHARED_API intern_pool : public non_copyable
+{
+public:
+    typedef intern_pool                  self_type    ;
+    typedef interned_string              value_type   ;
+    typedef interned_string::atom_type   atom_type    ;
+    typedef interned_string::size_type   size_type    ;
+    typedef interned_string::string_view string_view  ;
+    typedef interned_string::entry       entry_type   ;
+    typedef memory::memory_resource      resource_type;
+    typedef std::shared_mutex            mutex_type   ;
+    typedef std::shared_lock<mutex_type> read_lock    ;
+    typedef std::unique_lock<mutex_type> write_lock   ;
+
+    intern_pool (resource_type& rc = memory::get_default_resource ());
+    ~intern_pool ();
+
+    static self_type& global ();
+
+    //! the atom of the string, the characters are copied on the first call
+    value_type intern (string_view const& str);
+
+    //! the atom of the string if it was interned already, the empty string otherwise
+    value_type find (string_view const& str) const;
+
+    //! the interned string of the atom, the empty string for unknown atoms
+    value_type at (atom_type uAtom) const;
+
+    size_type size () const;
+
+    constexpr resource_type& resource () const noexcept
+    { return *_M_pRc; }
+
+private:
+    //! the index hashes the stored hash of an entry & a string lookup
+    struct entry_hash
+    {
+        typedef void is_transparent;
+
+        inline size_type operator () (entry_type const* pEntry) const noexcept
+        { return pEntry->hash; }
+
+        inline size_type operator () (string_view const& str) const noexcept
+        { return interned_string::hash_of (str); }
+    };
+
+    struct entry_equal
+    {
+        typedef void is_transparent;
+
+        constexpr bool operator () (entry_type const* lh, entry_type const* rh) const noexcept
+        { return lh == rh; }
+
+        inline bool operator () (entry_type const* lh, string_view const& rh) const noexcept
+        { return string_view (lh->str, lh->length) == rh; }
+
+        inline bool operator () (string_view const& lh, entry_type const* rh) const noexcept
+        { return (*this) (rh, lh); }
+    };
+
+    typedef memory::allocator<entry_type const*> allocator_type;
+
+    typedef flat_hash_table<entry_type const*, void, entry_hash, entry_equal, allocator_type>
+    index_type;
+
+    typedef std::vector<entry_type const*, allocator_type> atom_vector;
+
+    resource_type*     _M_pRc   ;
+    mutable mutex_type _M_gMutex;
+    index_type         _M_gIndex;
+    atom_vector        _M_gAtoms;
+};
+
+// ====================================================
+
+inline interned_string::interned_string (string_view const& str, intern_pool& pool)
+: interned_string (pool.intern (str))
+{ }
+
+inline interned_string::interned_string (string_view const& str)
+: interned_string (intern_pool::global ().intern (str))
+{ }
+
+// ====================================================
+
+} // namespace cppual
+
+// ====================================================
+
+namespace std {
+
+// ====================================================
+
+template <>
+struct hash <cppual::interned_string>
+{
+    inline std::size_t operator () (cppual::interned_string const& str) const noexcept
+    { return str.hash (); }
+};
+
+// ====================================================
+
+} // namespace std
+
+// ====================================================
+
+#endif // __cplusplus
+#endif // CPPUAL_INTERNED_STRING_H_
@@ -0,0 +1,142 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPUAL_MEMORY_ADAPTOR_H_
+#define CPPUAL_MEMORY_ADAPTOR_H_
+#ifdef __cplusplus
+
+#include <cppual/memory_allocator>
+
+#include <new>
+#include <utility>
+#include <stdexcept>
+
+// =========================================================
+
+namespace cppual::memory {
+
+// =========================================================
+
+//! merges several fixed arenas (memory_resource instances with a known address range)
+//! into one logical resource. allocations go to the arena that served the last one
+//! and spill over to the next arena when it's full, deallocations find their arena
+//! with a bounded binary search over the address ranges sorted at attach time.
+class SHARED_API memory_resource_adaptor final : public memory_resource
+{
+public:
+    //! maximum number of arenas
+    inline constexpr static const_size max_arenas = 32;
+
+    memory_resource_adaptor  () noexcept;
+    memory_resource_adaptor  (memory_resource& rc) noexcept;
+    ~memory_resource_adaptor ();
+
+    memory_resource_adaptor (memory_resource_adaptor const&) = delete;
+    memory_resource_adaptor& operator = (memory_resource_adaptor const&) = delete;
+
+    //! append an arena that manages the memory range [begin, begin + size).
+    //! the arena is NOT owned and has to outlive the adaptor
+    void attach (memory_resource& rc, pointer begin, size_type size);
+
+    //! construct an owned arena over a buffer of size bytes acquired from the owner
+    //! ex. emplace<stacked_resource> (size) or emplace<heap_resource> (size, heap_strategy::tlsf)
+    template <typename Arena, typename... Args>
+    Arena& emplace (size_type size, Args&&... args)
+    {
+        if (_M_uCount == max_arenas) throw std::length_error ("too many arenas!");
+
+        auto const pBuffer = _M_gOwner.allocate (size, max_align);
+        void*      pArena  = nullptr;
+
+        try
+        {
+            pArena = _M_gOwner.allocate (sizeof (Arena), alignof (Arena));
+
+            auto& gArena = *new (pArena) Arena (pBuffer, size, std::forward<Args> (args)...);
+
+            insert ({ &gArena, static_cast<math_pointer> (pBuffer),
+                      static_cast<math_pointer> (pBuffer) + size, sizeof (Arena), alignof (Arena) });
+
+            return gArena;
+        }
+        catch (...)
+        {
+            if (pArena) _M_gOwner.deallocate (pArena, sizeof (Arena), alignof (Arena));
+            _M_gOwner.deallocate (pBuffer, size, max_align);
+            throw;
+        }
+    }
+
+    //! the arena that owns the pointer or null
+    memory_resource* find (const_pointer p) const noexcept;
+
+    constexpr size_type arena_count () const noexcept { return _M_uCount; }
+
+    constexpr base_reference arena (size_type idx) noexcept
+    { return *_M_gArenas[idx].rc; }
+
+    constexpr base_const_reference arena (size_type idx) const noexcept
+    { return *_M_gArenas[idx].rc; }
+
+    //! largest block that fits in any arena
+    size_type max_size () const;
+
+    //! sum of the arena capacities
+    size_type capacity () const;
+
+    constexpr base_reference       owner ()       noexcept { return _M_gOwner; }
+    constexpr base_const_reference owner () const noexcept { return _M_gOwner; }
+
+private:
+    struct arena_range
+    {
+        base_pointer rc         ;
+        math_pointer begin      ;
+        math_pointer end        ;
+        size_type    owned_size ;
+        align_type   owned_align;
+    };
+
+    void insert (arena_range const& range);
+
+    void* do_allocate   (size_type size, align_type align);
+    void* do_reallocate (pointer p, size_type old_size, size_type size, align_type align);
+    void  do_deallocate (pointer p, size_type size, align_type align);
+
+    constexpr bool do_is_equal (abs_base_type const& gObj) const noexcept
+    { return this == &gObj; }
+
+private:
+    memory_resource& _M_gOwner             ;
+    arena_range      _M_gArenas[max_arenas];
+    u8               _M_uOrder [max_arenas];
+    size_type        _M_uCount             ;
+    size_type        _M_uCurrent           ;
+};
+
+// =========================================================
+
+} // namespace Memory
+
+// =========================================================
+
+#endif // __cplusplus
+#endif // CPPUAL_MEMORY_ADAPTOR_H_
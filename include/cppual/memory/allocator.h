@@ -314,17 +314,14 @@ public:
     /**
      ** @brief get the memory_resource used by the allocator.
      ** if no resource is set, the default thread resource is used.
-     ** the resource is cached after the first call.
+     ** every instance caches its own resource after the first call.
      ** this way the default constructor can be consteval.
      **
      ** @return resource_pointer
      **/
     inline resource_reference resource () const noexcept
     {
-        static thread_local resource_reference unused_rc = init_resource ();
-
-        UNUSED (unused_rc);
-        return *_M_pRc;
+        return init_resource ();
     }
 
     constexpr pointer allocate (size_type n = 1)
@@ -0,0 +1,112 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPUAL_MEMORY_CACHING_H_
+#define CPPUAL_MEMORY_CACHING_H_
+#ifdef __cplusplus
+
+#include <cppual/memory_allocator>
+
+#include <mutex>
+
+// =========================================================
+
+namespace cppual::memory {
+
+// =========================================================
+
+//! per-thread magazine cache in front of any memory_resource.
+//! every thread keeps a magazine of recently freed blocks for each size class
+//! and touches the upstream resource (under a lock) only in batches.
+//! the upstream resource has to support deallocation in arbitrary order.
+class SHARED_API thread_caching_resource final : public memory_resource
+{
+public:
+    //! size class granularity of the cached blocks
+    inline constexpr static const_size class_granularity = max_align;
+
+    //! number of size classes
+    inline constexpr static const_size class_count = 64;
+
+    //! largest block size served from the magazines
+    inline constexpr static const_size max_cached_size = class_granularity * class_count;
+
+    thread_caching_resource (memory_resource& rc,
+                             size_type        magazine_size = 64,
+                             size_type        batch_size    = 16);
+
+    ~thread_caching_resource ();
+
+    //! return the blocks cached by the calling thread to the upstream resource
+    void flush ();
+
+    constexpr size_type magazine_size () const noexcept { return _M_uMagazineSize; }
+    constexpr size_type batch_size    () const noexcept { return _M_uBatchSize   ; }
+
+    constexpr bool is_thread_safe () const noexcept { return true ; }
+    constexpr bool is_lock_free   () const noexcept { return false; }
+    constexpr bool is_shared      () const noexcept { return _M_gOwner.is_shared (); }
+
+    constexpr size_type max_size () const { return _M_gOwner.max_size (); }
+    constexpr size_type capacity () const { return _M_gOwner.capacity (); }
+
+    constexpr base_reference       owner ()       noexcept { return _M_gOwner; }
+    constexpr base_const_reference owner () const noexcept { return _M_gOwner; }
+
+private:
+    struct magazine;
+    struct thread_cache;
+    struct thread_registry;
+
+    thread_cache& local_cache ();
+    void          refill      (magazine& mag, size_type class_idx);
+    void          release     (magazine& mag, size_type class_idx, size_type count);
+    void          detach      (thread_cache& cache);
+
+    void* do_allocate   (size_type size, align_type align);
+    void  do_deallocate (pointer p, size_type size, align_type align);
+
+    constexpr bool do_is_equal (abs_base_type const& gObj) const noexcept
+    { return this == &gObj; }
+
+    constexpr static size_type size_class (size_type size) noexcept
+    { return (size + class_granularity - 1) / class_granularity - 1; }
+
+    constexpr static size_type class_size (size_type class_idx) noexcept
+    { return (class_idx + 1) * class_granularity; }
+
+private:
+    memory_resource& _M_gOwner       ;
+    std::mutex       _M_gMutex       ;
+    thread_cache*    _M_pCaches      ;
+    const_size       _M_uMagazineSize;
+    const_size       _M_uBatchSize   ;
+    cbool            _M_bLockOwner   ;
+};
+
+// =========================================================
+
+} // namespace Memory
+
+// =========================================================
+
+#endif // __cplusplus
+#endif // CPPUAL_MEMORY_CACHING_H_
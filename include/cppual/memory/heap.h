@@ -32,13 +32,25 @@ namespace cppual::memory {
 
 // =========================================================
 
+//! heap_resource free block management strategy
+typedef enum class heap_strategy : u8
+{
+    //! single address ordered free list (first fit)
+    first_fit,
+    //! two-level segregated fit with bounded O(1) allocate & deallocate
+    tlsf
+}
+const const_heap_strategy;
+
+// =========================================================
+
 class SHARED_API heap_resource final : public memory_resource
 {
 public:
-    heap_resource   (size_type size);
-    heap_resource   (pointer buffer, size_type size);
-    heap_resource   (memory_resource& rc, size_type size);
-    heap_resource   (shared_memory& shared_name, size_type size);
+    heap_resource   (size_type size, heap_strategy strategy = heap_strategy::first_fit);
+    heap_resource   (pointer buffer, size_type size, heap_strategy strategy = heap_strategy::first_fit);
+    heap_resource   (memory_resource& rc, size_type size, heap_strategy strategy = heap_strategy::first_fit);
+    heap_resource   (shared_memory& shared_name, size_type size, heap_strategy strategy = heap_strategy::first_fit);
     ~heap_resource  ();
 
     void      clear    ()       noexcept;
@@ -52,6 +64,7 @@ public:
         return size > sizeof (free_block) ? size - sizeof (free_block) : size_type ();
     }
 
+    constexpr heap_strategy         strategy () const noexcept { return _M_eStrategy   ; }
     constexpr bool             is_shared () const noexcept { return _M_bIsMemShared; }
     constexpr base_reference       owner ()       noexcept { return _M_gOwner      ; }
     constexpr base_const_reference owner () const noexcept { return _M_gOwner      ; }
@@ -59,21 +72,30 @@ public:
 private:
     struct header     { size_type size, adjust;           };
     struct free_block { size_type size; free_block* next; };
+    struct tlsf_control;
 
     static_assert (sizeof (header) >= sizeof (free_block), "header is NOT big enough!");
 
-    void* do_allocate   (size_type size, align_type align);
-    void  do_deallocate (pointer p, size_type size, align_type align);
+    void  initialize       ();
+    void  initialize_owned ();
+    void  release_owned    () noexcept;
+    void  release_block    (math_pointer block, size_type size) noexcept;
+    bool  resize_block     (pointer p, size_type size) noexcept;
+    void* do_allocate      (size_type size, align_type align);
+    void* do_reallocate    (pointer p, size_type old_size, size_type size, align_type align);
+    void  do_deallocate    (pointer p, size_type size, align_type align);
 
     constexpr bool do_is_equal (abs_base_type const& gObj) const noexcept
     { return this == &gObj; }
 
 private:
-    memory_resource& _M_gOwner      ;
-    pointer const    _M_pBegin      ;
-    pointer const    _M_pEnd        ;
-    free_block*      _M_pFreeBlocks ;
-    cbool            _M_bIsMemShared;
+    memory_resource&    _M_gOwner      ;
+    pointer const       _M_pBegin      ;
+    pointer const       _M_pEnd        ;
+    free_block*         _M_pFreeBlocks ;
+    cbool               _M_bIsMemShared;
+    const_heap_strategy _M_eStrategy   ;
+    tlsf_control*       _M_pControl    ;
 };
 
 // =========================================================
@@ -106,7 +128,10 @@ public:
     constexpr base_const_reference owner () const noexcept { return _M_gOwner      ; }
 
 private:
+    void  release_block (header* block) noexcept;
+    bool  resize_block  (pointer p, size_type size) noexcept;
     void* do_allocate   (size_type size, align_type align);
+    void* do_reallocate (pointer p, size_type old_size, size_type size, align_type align);
     void  do_deallocate (pointer p, size_type size, size_type align);
 
     constexpr bool do_is_equal (abs_base_type const& gObj) const noexcept
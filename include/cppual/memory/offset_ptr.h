@@ -0,0 +1,218 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPUAL_MEMORY_OFFSET_PTR_H_
+#define CPPUAL_MEMORY_OFFSET_PTR_H_
+#ifdef __cplusplus
+
+#include <cppual/types>
+
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+// =========================================================
+
+namespace cppual::memory {
+
+// =========================================================
+
+//! self-relative pointer for data shared between processes.
+//! it stores the distance from its own address to the pointee instead of the
+//! virtual address, so a structure that lives entirely in one shared segment
+//! stays valid wherever each process maps the segment.
+//! an offset of 0 points to the offset_ptr itself (ex. a self linked list sentinel),
+//! so null is an offset of 1 where nothing but a byte can start
+template <typename T>
+class offset_ptr
+{
+public:
+    typedef offset_ptr<T>                   self_type        ;
+    typedef T                               element_type     ;
+    typedef std::remove_cv_t<T>             value_type       ;
+    typedef T *                             pointer          ;
+    typedef ptrdiff                         difference_type  ;
+    typedef std::random_access_iterator_tag iterator_category;
+
+    template <typename U>
+    using rebind = offset_ptr<U>;
+
+    inline offset_ptr () noexcept : _M_iOffset (null_offset) { }
+    inline offset_ptr (std::nullptr_t) noexcept : _M_iOffset (null_offset) { }
+    inline offset_ptr (pointer p) noexcept { set (p); }
+    inline offset_ptr (self_type const& gObj) noexcept { set (gObj.get ()); }
+
+    template <typename U> requires (std::is_convertible_v<U*, pointer>)
+    inline offset_ptr (offset_ptr<U> const& gObj) noexcept { set (gObj.get ()); }
+
+    //! static_cast from void & base pointers as required by allocator_traits
+    template <typename U> requires (!std::is_convertible_v<U*, pointer> &&
+                                    requires (U* p) { static_cast<pointer> (p); })
+    inline explicit offset_ptr (offset_ptr<U> const& gObj) noexcept
+    { set (static_cast<pointer> (gObj.get ())); }
+
+    inline self_type& operator = (self_type const& gObj) noexcept
+    {
+        set (gObj.get ());
+        return *this;
+    }
+
+    inline self_type& operator = (pointer p) noexcept
+    {
+        set (p);
+        return *this;
+    }
+
+    inline self_type& operator = (std::nullptr_t) noexcept
+    {
+        _M_iOffset = null_offset;
+        return *this;
+    }
+
+    inline pointer get () const noexcept
+    {
+        return _M_iOffset != null_offset ?
+                    reinterpret_cast<pointer> (reinterpret_cast<uptr> (this) +
+                                               static_cast<uptr> (_M_iOffset)) :
+                    nullptr;
+    }
+
+    inline pointer operator -> () const noexcept { return get (); }
+
+    template <typename U = T> requires (!std::is_void_v<U>)
+    inline U& operator * () const noexcept { return *get (); }
+
+    template <typename U = T> requires (!std::is_void_v<U>)
+    inline U& operator [] (difference_type n) const noexcept { return get ()[n]; }
+
+    inline explicit operator bool () const noexcept { return _M_iOffset != null_offset; }
+
+    template <typename U = T> requires (!std::is_void_v<U>)
+    inline static self_type pointer_to (U& gObj) noexcept { return self_type (std::addressof (gObj)); }
+
+    //! the pointee keeps its address so only the offset has to be adjusted
+    inline self_type& operator += (difference_type n) noexcept
+    {
+        _M_iOffset += n * static_cast<difference_type> (sizeof (T));
+        return *this;
+    }
+
+    inline self_type& operator -= (difference_type n) noexcept
+    {
+        _M_iOffset -= n * static_cast<difference_type> (sizeof (T));
+        return *this;
+    }
+
+    inline self_type& operator ++ () noexcept { return *this += 1; }
+    inline self_type& operator -- () noexcept { return *this -= 1; }
+
+    inline self_type operator ++ (int) noexcept
+    {
+        self_type gObj (*this);
+        ++*this;
+        return gObj;
+    }
+
+    inline self_type operator -- (int) noexcept
+    {
+        self_type gObj (*this);
+        --*this;
+        return gObj;
+    }
+
+    friend inline self_type operator + (self_type const& gObj, difference_type n) noexcept
+    { return self_type (gObj.get () + n); }
+
+    friend inline self_type operator + (difference_type n, self_type const& gObj) noexcept
+    { return self_type (gObj.get () + n); }
+
+    friend inline self_type operator - (self_type const& gObj, difference_type n) noexcept
+    { return self_type (gObj.get () - n); }
+
+    friend inline difference_type operator - (self_type const& lh, self_type const& rh) noexcept
+    { return lh.get () - rh.get (); }
+
+    friend inline bool operator == (self_type const& lh, self_type const& rh) noexcept
+    { return lh.get () == rh.get (); }
+
+    friend inline bool operator == (self_type const& lh, std::nullptr_t) noexcept
+    { return lh._M_iOffset == null_offset; }
+
+    friend inline std::strong_ordering operator <=> (self_type const& lh, self_type const& rh) noexcept
+    { return std::compare_three_way () (lh.get (), rh.get ()); }
+
+    friend inline void swap (self_type& lh, self_type& rh) noexcept
+    {
+        pointer const p = lh.get ();
+
+        lh = rh.get ();
+        rh = p;
+    }
+
+private:
+    inline void set (pointer p) noexcept
+    {
+        _M_iOffset = p ? static_cast<difference_type> (reinterpret_cast<uptr> (p) -
+                                                       reinterpret_cast<uptr> (this)) :
+                         null_offset;
+    }
+
+private:
+    inline constexpr static const difference_type null_offset = 1;
+
+    difference_type _M_iOffset;
+};
+
+// =========================================================
+
+} // namespace Memory
+
+// =========================================================
+
+namespace std {
+
+//! std::to_address support
+template <typename T>
+struct pointer_traits <cppual::memory::offset_ptr<T>>
+{
+    typedef cppual::memory::offset_ptr<T> pointer        ;
+    typedef T                             element_type   ;
+    typedef cppual::ptrdiff               difference_type;
+
+    template <typename U>
+    using rebind = cppual::memory::offset_ptr<U>;
+
+    template <typename U = T> requires (!std::is_void_v<U>)
+    inline static pointer pointer_to (U& gObj) noexcept
+    { return pointer::pointer_to (gObj); }
+
+    inline static element_type* to_address (pointer const& p) noexcept
+    { return p.get (); }
+};
+
+} // namespace std
+
+// =========================================================
+
+#endif // __cplusplus
+#endif // CPPUAL_MEMORY_OFFSET_PTR_H_
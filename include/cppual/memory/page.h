@@ -31,23 +31,84 @@ namespace cppual::memory {
 
 // =========================================================
 
-class page_resource final : public memory_resource
+//! virtual memory resource.
+//! the whole address range is reserved up front without any physical backing,
+//! every allocation is rounded up to whole pages that are committed on demand
+//! and decommitted (returned to the os) when released. when guard pages are
+//! enabled every allocation is followed by an inaccessible page and the first
+//! one is preceded by one, so any overrun faults immediately. the top allocation
+//! grows and shrinks in place which makes it suitable for huge growable buffers.
+class SHARED_API page_resource final : public memory_resource
 {
 public:
-    page_resource (size_type size);
+    page_resource  (size_type reserve_size, bool guard_pages = false);
+    ~page_resource ();
 
+    page_resource (page_resource const&) = delete;
+    page_resource& operator = (page_resource const&) = delete;
+
+    //! decommit all pages -> all allocations are invalidated
     void clear () noexcept;
 
-    constexpr size_type count    () const noexcept { return 0; }
-    constexpr size_type capacity () const noexcept { return 0; }
-    constexpr size_type max_size () const noexcept { return 0; }
+    //! size of a virtual memory page in bytes
+    static size_type page_size () noexcept;
+
+    //! number of live allocations
+    constexpr size_type count () const noexcept { return _M_uCount; }
+
+    //! reserved address space in bytes
+    constexpr size_type capacity () const noexcept { return _M_uPages * _M_uPageSize; }
+
+    //! bytes currently backed by committed pages
+    constexpr size_type committed () const noexcept { return _M_uCommitted * _M_uPageSize; }
+
+    constexpr bool has_guard_pages () const noexcept { return _M_bGuardPages; }
+
+    //! largest allocation that can currently be satisfied
+    size_type max_size () const noexcept;
 
 private:
+    //! descriptor of a released run of pages in the side table
+    struct free_run { size_type pages, next; };
+
+    inline constexpr static const_size npos = static_cast<size_type> (-1);
+
+    constexpr size_type run_pages (size_type uBytes) const noexcept
+    {
+        return (uBytes + _M_uPageSize - 1) / _M_uPageSize + (_M_bGuardPages ? 1U : 0U);
+    }
+
+    constexpr math_pointer page_address (size_type uPage) const noexcept
+    { return _M_pBase + uPage * _M_uPageSize; }
+
+    constexpr size_type page_index (const_pointer p) const noexcept
+    {
+        return static_cast<size_type> (static_cast<math_const_pointer> (p) - _M_pBase) /
+               _M_uPageSize;
+    }
+
+    void commit      (size_type uPage, size_type uCount);
+    void decommit    (size_type uPage, size_type uCount) noexcept;
+    void release_run (size_type uPage, size_type uCount) noexcept;
+    bool take_run    (size_type uPage, size_type uCount) noexcept;
+
     pointer do_allocate   (size_type size, align_type align);
     void    do_deallocate (pointer p, size_type size, align_type align);
+    pointer do_reallocate (pointer p, size_type old_size, size_type size, align_type align);
 
     constexpr bool do_is_equal (abs_base_type const& gObj) const noexcept
     { return &gObj == this; }
+
+private:
+    math_pointer const _M_pBase      ;
+    free_run*    const _M_pRuns      ;
+    const_size         _M_uPageSize  ;
+    const_size         _M_uPages     ;
+    size_type          _M_uTop       ;
+    size_type          _M_uFreeRuns  ;
+    size_type          _M_uCount     ;
+    size_type          _M_uCommitted ;
+    cbool              _M_bGuardPages;
 };
 
 // =========================================================
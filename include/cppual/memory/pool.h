@@ -28,6 +28,8 @@
 
 #include <cppual/memory/mop.h>
 
+#include <atomic>
+
 // =========================================================
 
 namespace cppual::memory {
@@ -105,6 +107,94 @@ private:
 
 // =========================================================
 
+//! lock-free uniform pool (multiple producers / multiple consumers).
+//! the free list is a Treiber stack of block indices with the head
+//! tagged by a modification counter (ABA safe).
+class SHARED_API atomic_uniform_pool_resource final : public memory_resource
+{
+public:
+    typedef u32               index_type ;
+    typedef u64               head_type  ;
+    typedef std::atomic<head_type> atomic_head;
+    typedef std::atomic<size_type> atomic_size;
+
+    /// local memory
+    atomic_uniform_pool_resource (size_type  blk_count,
+                                  size_type  blk_size,
+                                  align_type blk_align = max_align);
+
+    /// local memory from allocated buffer (stack or heap)
+    atomic_uniform_pool_resource (pointer    buffer,
+                                  size_type  blk_count,
+                                  size_type  blk_size,
+                                  align_type blk_align = max_align);
+
+    /// nested allocators
+    atomic_uniform_pool_resource (memory_resource& rc,
+                                  size_type        blk_count,
+                                  size_type        blk_size,
+                                  align_type       blk_align = max_align);
+
+    ~atomic_uniform_pool_resource ();
+
+    //! NOT thread safe -> all blocks have to be released
+    void clear () noexcept;
+
+    constexpr size_type block_size  () const noexcept { return _M_uBlkSize ; }
+    constexpr size_type block_align () const noexcept { return _M_uBlkAlign; }
+    constexpr size_type block_count () const noexcept { return _M_uBlkNum  ; }
+
+    inline size_type max_size () const noexcept
+    {
+        return (_M_uBlkNum - _M_uUsedBlocks.load (std::memory_order_relaxed)) * _M_uBlkSize;
+    }
+
+    constexpr size_type capacity () const noexcept
+    {
+        return _M_uBlkNum * _M_uBlkSize;
+    }
+
+    constexpr bool is_thread_safe () const noexcept { return true; }
+    constexpr bool is_lock_free   () const noexcept { return atomic_head::is_always_lock_free; }
+
+    constexpr bool             is_shared () const noexcept { return _M_bIsMemShared; }
+    constexpr base_reference       owner ()       noexcept { return _M_gOwner      ; }
+    constexpr base_const_reference owner () const noexcept { return _M_gOwner      ; }
+
+private:
+    void  initialize    () noexcept;
+    void* do_allocate   (size_type size, align_type align);
+    void  do_deallocate (pointer p, size_type size, align_type align);
+
+    constexpr bool do_is_equal (abs_base_type const& gObj) const noexcept
+    { return this == &gObj; }
+
+    //! block index (1 based, 0 is the end of the list) & tag packed in one word
+    constexpr static index_type head_index (head_type head) noexcept
+    { return static_cast<index_type> (head); }
+
+    constexpr static head_type make_head (head_type prev, index_type idx) noexcept
+    { return (((prev >> 32) + 1) << 32) | idx; }
+
+    constexpr pointer block_at (index_type idx) const noexcept
+    { return static_cast<math_pointer> (_M_pFirst) + (idx - 1) * _M_uBlkSize; }
+
+private:
+    memory_resource& _M_gOwner      ;
+    pointer const    _M_pBegin      ;
+    pointer const    _M_pEnd        ;
+    pointer          _M_pFirst      ;
+    const_size       _M_uBlkSize    ;
+    const_align      _M_uBlkAlign   ;
+    size_type        _M_uBlkNum     ;
+    cbool            _M_bIsMemShared;
+
+    alignas (64) atomic_head _M_pHead      ;
+    alignas (64) atomic_size _M_uUsedBlocks;
+};
+
+// =========================================================
+
 } // namespace Memory
 
 // =========================================================
@@ -0,0 +1,144 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPUAL_MEMORY_PROFILING_H_
+#define CPPUAL_MEMORY_PROFILING_H_
+#ifdef __cplusplus
+
+#include <cppual/memory_allocator>
+
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+#include <mutex>
+
+// =========================================================
+
+namespace cppual::memory {
+
+// =========================================================
+
+//! sampling heap profiler in front of any memory_resource.
+//! allocations are sampled as a poisson process over the allocated bytes
+//! (on average one sample every sample_period bytes) so an allocation that
+//! isn't sampled costs a thread local countdown and a deallocation that isn't
+//! sampled costs a single relaxed load. every sample records its call stack,
+//! size and lifetime and is weighted by the inverse of its sampling probability
+//! so the profiles stay unbiased for small and large allocations alike.
+class SHARED_API profiling_resource final : public memory_resource
+{
+public:
+    typedef std::chrono::steady_clock clock_type;
+    typedef clock_type::duration      duration  ;
+
+    enum class profile_type : u8
+    {
+        live     , //! estimated bytes currently allocated per call stack
+        allocated, //! estimated bytes allocated since the last reset per call stack
+        lifetime   //! microseconds the objects freed since the last reset lived per call stack
+    };
+
+    //! deepest recorded call stack
+    inline constexpr static const_size max_frames = 32;
+
+    //! tcmalloc default -> negligible overhead for production usage
+    inline constexpr static const_size default_sample_period = 512 * 1024;
+
+    //! a sample_period of 0 records every allocation
+    profiling_resource (memory_resource& rc, size_type sample_period = default_sample_period);
+    ~profiling_resource ();
+
+    profiling_resource (profiling_resource const&) = delete;
+    profiling_resource& operator = (profiling_resource const&) = delete;
+
+    //! write the live & allocated samples as a gperftools heap profile
+    //! (heap_v2 text format) that can be read by pprof
+    void write_pprof (std::ostream& os) const;
+
+    //! write one "frame;frame;frame value" line per call stack, root first,
+    //! the format expected by flamegraph.pl & speedscope
+    void write_collapsed (std::ostream& os, profile_type type = profile_type::live) const;
+
+    //! clear the allocated & lifetime counters, the live samples are kept
+    void reset ();
+
+    //! number of sampled allocations that are still alive
+    size_type sample_count () const;
+
+    //! time since construction or the last reset -> allocated / elapsed is the allocation rate
+    duration elapsed () const;
+
+    constexpr size_type sample_period () const noexcept { return _M_uSamplePeriod; }
+
+    //! the samples are guarded, the calls to the owner are not
+    constexpr bool is_thread_safe () const noexcept { return _M_gOwner.is_thread_safe (); }
+    constexpr bool is_lock_free   () const noexcept { return false                      ; }
+    constexpr bool is_shared      () const noexcept { return _M_gOwner.is_shared (); }
+
+    constexpr size_type max_size () const { return _M_gOwner.max_size (); }
+    constexpr size_type capacity () const { return _M_gOwner.capacity (); }
+
+    constexpr base_reference       owner ()       noexcept { return _M_gOwner; }
+    constexpr base_const_reference owner () const noexcept { return _M_gOwner; }
+
+private:
+    struct call_site;
+    struct profile;
+
+    //! size of the counting filter of sampled addresses
+    inline constexpr static const_size filter_size = 4096;
+
+    inline static size_type filter_index (const_pointer p) noexcept
+    {
+        auto const uAddr = reinterpret_cast<uptr> (p) / max_align;
+        return (uAddr ^ (uAddr >> 12)) % filter_size;
+    }
+
+    bool should_sample (size_type size) const noexcept;
+    void forget_locked (const_pointer p);
+    void record        (pointer p, size_type size);
+    void forget        (const_pointer p);
+
+    void* do_allocate   (size_type size, align_type align);
+    void* do_reallocate (pointer p, size_type old_size, size_type size, align_type align);
+    void  do_deallocate (pointer p, size_type size, align_type align);
+
+    constexpr bool do_is_equal (abs_base_type const& gObj) const noexcept
+    { return this == &gObj; }
+
+private:
+    typedef std::atomic<u16> atomic_counter;
+
+    memory_resource&   _M_gOwner                ;
+    mutable std::mutex _M_gMutex                ;
+    profile*           _M_pProfile              ;
+    atomic_counter     _M_gFilter[filter_size]  ;
+    const_size         _M_uSamplePeriod         ;
+};
+
+// =========================================================
+
+} // namespace Memory
+
+// =========================================================
+
+#endif // __cplusplus
+#endif // CPPUAL_MEMORY_PROFILING_H_
@@ -108,13 +108,13 @@ public:
     shared_memory  (object_type& obj, size_type size, bool writable = true);
     ~shared_memory () noexcept;
 
-    consteval bool writable () const noexcept
+    constexpr bool writable () const noexcept
     { return _M_bWritable; }
 
-    consteval pointer address () const noexcept
+    constexpr pointer address () const noexcept
     { return handle<pointer>  (); }
 
-    consteval size_type size () const noexcept
+    constexpr size_type size () const noexcept
     { return _M_uSize; }
 
     constexpr object_type const& object () const noexcept
@@ -0,0 +1,265 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPUAL_MEMORY_SHARED_HEAP_H_
+#define CPPUAL_MEMORY_SHARED_HEAP_H_
+#ifdef __cplusplus
+
+#include <cppual/memory/offset_ptr.h>
+#include <cppual/memory/shared.h>
+#include <cppual/concepts>
+
+#include <atomic>
+#include <new>
+#include <string_view>
+#include <utility>
+
+// =========================================================
+
+namespace cppual::memory {
+
+// =========================================================
+
+//! position independent heap living inside a shared memory segment.
+//! the control block is placed at the start of the segment and every link
+//! is stored as an offset from it, so each process can map the segment at a
+//! different address. a spin lock on an address-free atomic (NOT a futex or
+//! a process local mutex) serializes the processes.
+//! named objects let the processes find the shared containers:
+//! shared_heap::create_or_open (shm).find_or_construct<queue> ("queue", ator)
+class SHARED_API shared_heap
+{
+public:
+    typedef shared_heap      self_type      ;
+    typedef std::size_t      size_type      ;
+    typedef size_type const  const_size     ;
+    typedef size_type        align_type     ;
+    typedef ptrdiff          difference_type;
+    typedef void *           pointer        ;
+    typedef cvoid*           const_pointer  ;
+    typedef byte *           math_pointer   ;
+    typedef std::string_view string_view    ;
+
+    //! maximum alignment depending on memory width
+    inline constexpr static const_size max_align = alignof (std::max_align_t);
+
+    //! number of named objects
+    inline constexpr static const_size max_names = 32;
+
+    //! maximum length of an object name
+    inline constexpr static const_size max_name_length = 47;
+
+    shared_heap (shared_heap const&) = delete;
+    shared_heap& operator = (shared_heap const&) = delete;
+
+    //! format [p, p + size) as a new heap or wait for the process that formats it.
+    //! the memory has to be zero filled when it's created (ex. a new shm object)
+    static shared_heap& create_or_open (pointer p, size_type size);
+
+    static shared_heap& create_or_open (shared_memory& shm)
+    { return create_or_open (shm.address (), shm.size ()); }
+
+    pointer allocate   (size_type size, align_type align = max_align);
+    pointer reallocate (pointer p, size_type old_size, size_type size, align_type align = max_align);
+    void    deallocate (pointer p, size_type size, align_type align = max_align);
+
+    //! the named object or a new one constructed with args
+    template <non_void T, typename... Args>
+    T& find_or_construct (string_view name, Args&&... args)
+    {
+        auto const uIdx = reserve_name (name);
+
+        if (uIdx == npos) return *static_cast<T*> (find_name (name));
+
+        //! construct outside of the lock as the object can allocate from the heap
+        try
+        {
+            auto const p = allocate (sizeof (T), alignof (T));
+
+            try
+            {
+                auto& gObj = *new (p) T (std::forward<Args> (args)...);
+
+                publish_name (uIdx, p);
+                return gObj;
+            }
+            catch (...)
+            {
+                deallocate (p, sizeof (T), alignof (T));
+                throw;
+            }
+        }
+        catch (...)
+        {
+            release_name (uIdx);
+            throw;
+        }
+    }
+
+    //! the named object or null
+    template <non_void T>
+    T* find (string_view name) const
+    { return static_cast<T*> (find_name (name)); }
+
+    //! destroy & deallocate the named object
+    template <non_void T>
+    bool destroy (string_view name)
+    {
+        auto const p = static_cast<T*> (unlink_name (name));
+
+        if (!p) return false;
+
+        p->~T ();
+        deallocate (p, sizeof (T), alignof (T));
+        return true;
+    }
+
+    //! size of the whole segment in bytes
+    constexpr size_type size () const noexcept { return _M_uSize; }
+
+    //! bytes currently in the free list
+    size_type free_size () const noexcept;
+
+    //! largest block that can be allocated at once
+    size_type max_size () const noexcept;
+
+private:
+    struct free_block ;
+    struct used_header;
+
+    struct named_object
+    {
+        difference_type offset;
+        u32             state ;
+        char            name[max_name_length + 1];
+    };
+
+    inline constexpr static const_size npos = static_cast<size_type> (-1);
+
+    shared_heap () = delete;
+
+    void initialize (size_type size) noexcept;
+    void lock       () const noexcept;
+    void unlock     () const noexcept;
+
+    free_block* block_at  (difference_type offset) const noexcept;
+    void        release   (math_pointer block, size_type size) noexcept;
+
+    size_type reserve_name (string_view name);
+    void      publish_name (size_type idx, pointer p) noexcept;
+    void      release_name (size_type idx) noexcept;
+    pointer   find_name    (string_view name) const;
+    pointer   unlink_name  (string_view name) noexcept;
+
+private:
+    typedef std::atomic<u32> atomic_state;
+
+    static_assert (atomic_state::is_always_lock_free, "the lock has to be address-free!");
+
+    atomic_state mutable _M_gState            ;
+    atomic_state mutable _M_gLock             ;
+    u64                  _M_uMagic            ;
+    size_type            _M_uSize             ;
+    size_type            _M_uFree             ;
+    difference_type      _M_iFreeList         ;
+    named_object         _M_gNames[max_names] ;
+};
+
+// =========================================================
+
+//! allocator handing out offset pointers from a shared_heap.
+//! the allocator itself holds an offset_ptr to the heap, so a container
+//! constructed inside the segment can be used by every process mapping it
+template <non_void T>
+class SHARED_API shared_allocator
+{
+public:
+    typedef shared_allocator<T>          self_type                             ;
+    typedef std::remove_const_t<T>       value_type                            ;
+    typedef offset_ptr<value_type>       pointer                               ;
+    typedef offset_ptr<value_type const> const_pointer                         ;
+    typedef offset_ptr<void>             void_pointer                          ;
+    typedef offset_ptr<cvoid>            const_void_pointer                    ;
+    typedef value_type &                 reference                             ;
+    typedef value_type const&            const_reference                       ;
+    typedef shared_heap                  heap_type                             ;
+    typedef std::size_t                  size_type                             ;
+    typedef ptrdiff                      difference_type                       ;
+    typedef std::true_type               propagate_on_container_copy_assignment;
+    typedef std::true_type               propagate_on_container_move_assignment;
+    typedef std::true_type               propagate_on_container_swap           ;
+
+    template <non_void U>
+    struct rebind { typedef shared_allocator<U> other; };
+
+    inline shared_allocator () noexcept = default;
+
+    inline shared_allocator (heap_type& heap) noexcept
+    : _M_pHeap (&heap)
+    { }
+
+    template <non_void U>
+    inline shared_allocator (shared_allocator<U> const& gObj) noexcept
+    : _M_pHeap (gObj._M_pHeap)
+    { }
+
+    inline pointer allocate (size_type n = 1)
+    { return static_cast<value_type*> (_M_pHeap->allocate (n * sizeof (value_type), alignof (value_type))); }
+
+    inline pointer reallocate (pointer p, size_type old_n, size_type n)
+    {
+        return static_cast<value_type*> (_M_pHeap->reallocate (p.get (),
+                                                               old_n * sizeof (value_type),
+                                                                   n * sizeof (value_type),
+                                                               alignof (value_type)));
+    }
+
+    inline void deallocate (pointer p, size_type n = 1)
+    { _M_pHeap->deallocate (p.get (), n * sizeof (value_type), alignof (value_type)); }
+
+    inline size_type max_size () const noexcept
+    { return _M_pHeap ? _M_pHeap->max_size () / sizeof (value_type) : size_type (); }
+
+    inline heap_type& heap () const noexcept
+    { return *_M_pHeap; }
+
+    inline self_type select_on_container_copy_construction () const noexcept
+    { return *this; }
+
+    template <non_void U>
+    friend inline bool operator == (self_type const& lh, shared_allocator<U> const& rh) noexcept
+    { return lh._M_pHeap.get () == rh._M_pHeap.get (); }
+
+    template <non_void>
+    friend class shared_allocator;
+
+private:
+    offset_ptr<heap_type> _M_pHeap;
+};
+
+// =========================================================
+
+} // namespace Memory
+
+// =========================================================
+
+#endif // __cplusplus
+#endif // CPPUAL_MEMORY_SHARED_HEAP_H_
@@ -0,0 +1,126 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPUAL_MEMORY_SLAB_H_
+#define CPPUAL_MEMORY_SLAB_H_
+#ifdef __cplusplus
+
+#include <cppual/memory/pool.h>
+
+#include <algorithm>
+#include <bit>
+
+// =========================================================
+
+namespace cppual::memory {
+
+// =========================================================
+
+//! segregated size class allocator.
+//! every power of two size class from min_class_size to max_class_size
+//! is served by a chain of uniform pools (slabs) acquired from the upstream
+//! resource with geometric growth. larger or over-aligned requests go upstream.
+class SHARED_API slab_resource final : public memory_resource
+{
+public:
+    //! smallest block that can hold a free list link
+    inline constexpr static const_size min_class_size = sizeof (pointer);
+
+    //! largest block served from the slabs
+    inline constexpr static const_size max_class_size = 4096;
+
+    //! number of size classes
+    inline constexpr static const_size class_count =
+            static_cast<size_type> (std::countr_zero (max_class_size) -
+                                    std::countr_zero (min_class_size)) + 1;
+
+    //! largest slab that geometric growth can reach
+    inline constexpr static const_size max_slab_size = 256 * 1024;
+
+    slab_resource (size_type slab_blocks = 64);
+    slab_resource (memory_resource& rc, size_type slab_blocks = 64);
+    ~slab_resource ();
+
+    //! return all slabs to the upstream resource -> all blocks are invalidated
+    void release () noexcept;
+
+    constexpr size_type slab_blocks () const noexcept { return _M_uSlabBlocks; }
+
+    //! bytes acquired from the upstream resource for slabs
+    constexpr size_type capacity () const noexcept { return _M_uCapacity; }
+
+    constexpr size_type max_size  () const { return _M_gOwner.max_size  (); }
+    constexpr bool      is_shared () const noexcept { return _M_gOwner.is_shared (); }
+
+    constexpr base_reference       owner ()       noexcept { return _M_gOwner; }
+    constexpr base_const_reference owner () const noexcept { return _M_gOwner; }
+
+    //! size class index of a request or class_count if it goes upstream
+    constexpr static size_type size_class (size_type size, align_type align) noexcept
+    {
+        if (align > max_align) return class_count;
+
+        auto const uSize = std::max ({ size, align, min_class_size });
+
+        return uSize > max_class_size ? class_count :
+                                        static_cast<size_type> (std::bit_width (uSize - 1) -
+                                                                std::countr_zero (min_class_size));
+    }
+
+    constexpr static size_type class_size (size_type class_idx) noexcept
+    { return min_class_size << class_idx; }
+
+private:
+    struct slab;
+
+    struct size_class_list
+    {
+        slab*     slabs      ;
+        size_type next_blocks;
+    };
+
+    slab* grow         (size_type class_idx);
+    void  release_slab (slab* pSlab) noexcept;
+
+    void* do_allocate   (size_type size, align_type align);
+    void  do_deallocate (pointer p, size_type size, align_type align);
+
+    constexpr bool do_is_equal (abs_base_type const& gObj) const noexcept
+    { return this == &gObj; }
+
+    constexpr static align_type class_align (size_type class_idx) noexcept
+    { return std::min (class_size (class_idx), max_align); }
+
+private:
+    memory_resource& _M_gOwner               ;
+    size_class_list  _M_gClasses[class_count];
+    const_size       _M_uSlabBlocks          ;
+    size_type        _M_uCapacity            ;
+};
+
+// =========================================================
+
+} // namespace Memory
+
+// =========================================================
+
+#endif // __cplusplus
+#endif // CPPUAL_MEMORY_SLAB_H_
@@ -35,25 +35,40 @@ namespace cppual::memory {
 class SHARED_API stacked_resource final : public memory_resource
 {
 public:
-    stacked_resource  (size_type capacity);
+    struct checkpoint;
+    class  scoped_checkpoint;
+
+    //! growable resources chain additional blocks from the owner
+    //! with geometric growth when the current block is exhausted
+    stacked_resource  (size_type capacity, bool growable = false);
     stacked_resource  (pointer buffer, size_type capacity);
-    stacked_resource  (memory_resource& rc, size_type capacity);
+    stacked_resource  (memory_resource& rc, size_type capacity, bool growable = false);
     stacked_resource  (shared_memory& shared_name, size_type size);
     ~stacked_resource ();
 
-    constexpr void   clear  ()       noexcept {        _M_pMarker = _M_pBegin; }
-    constexpr cvoid* marker () const noexcept { return _M_pMarker            ; }
+    //! release all chained blocks and reset the marker
+    void clear () noexcept;
+
+    //! current position -> everything allocated after it is released by rewind
+    checkpoint mark () const noexcept;
+
+    //! release everything allocated after the checkpoint in O(1) per chained block
+    void rewind (checkpoint const& point) noexcept;
+
+    constexpr cvoid* marker      () const noexcept { return _M_pMarker       ; }
+    constexpr bool   is_growable () const noexcept { return _M_uGrowSize != 0; }
 
     constexpr size_type max_size () const noexcept
     {
-        return static_cast<size_type> (static_cast<math_pointer> (_M_pEnd) -
-                                       static_cast<math_pointer> (_M_pMarker));
+        return is_growable () ? _M_gOwner.max_size () :
+                                static_cast<size_type> (static_cast<math_pointer> (_M_pEnd) -
+                                                        static_cast<math_pointer> (_M_pMarker));
     }
 
     constexpr size_type capacity () const noexcept
     {
         return static_cast<size_type> (static_cast<math_pointer> (_M_pEnd) -
-                                       static_cast<math_pointer> (_M_pBegin));
+                                       static_cast<math_pointer> (_M_pBegin)) + _M_uChainSize;
     }
 
     constexpr base_reference       owner ()       noexcept { return _M_gOwner      ; }
@@ -61,6 +76,11 @@ public:
     constexpr bool             is_shared () const noexcept { return _M_bIsMemShared; }
 
 private:
+    struct block;
+
+    void  grow      (size_type bytes);
+    void  pop_block () noexcept;
+
     void* do_allocate   (size_type capacity, align_type align);
     void* do_reallocate (void* p, size_type old_size, size_type size, align_type align_size);
     void  do_deallocate (void* p, size_type capacity, align_type align);
@@ -71,13 +91,49 @@ private:
 private:
     memory_resource& _M_gOwner      ;
     pointer          _M_pMarker     ;
-    pointer const    _M_pBegin      ;
-    pointer const    _M_pEnd        ;
+    pointer          _M_pBegin      ;
+    pointer          _M_pEnd        ;
+    block*           _M_pChain      ;
+    block*           _M_pSpare      ;
+    size_type        _M_uChainSize  ;
+    size_type        _M_uGrowSize   ;
     cbool            _M_bIsMemShared;
 };
 
 // =========================================================
 
+//! position of a stacked_resource
+struct stacked_resource::checkpoint
+{
+    block*  chain ;
+    pointer marker;
+};
+
+// =========================================================
+
+//! rewinds the stacked_resource to the position at construction on scope exit
+class stacked_resource::scoped_checkpoint
+{
+public:
+    inline explicit scoped_checkpoint (stacked_resource& rc) noexcept
+    : _M_gResource (rc), _M_gPoint (rc.mark ())
+    { }
+
+    inline ~scoped_checkpoint ()
+    { _M_gResource.rewind (_M_gPoint); }
+
+    scoped_checkpoint (scoped_checkpoint const&) = delete;
+    scoped_checkpoint& operator = (scoped_checkpoint const&) = delete;
+
+    constexpr checkpoint const& point () const noexcept { return _M_gPoint; }
+
+private:
+    stacked_resource& _M_gResource;
+    checkpoint const  _M_gPoint   ;
+};
+
+// =========================================================
+
 class SHARED_API dstacked_resource final : public memory_resource
 {
 public:
@@ -74,25 +74,50 @@ namespace model {
 //! Flag to aligned_realloc to not preserve content in reallocation
 #define NO_PRESERVE 1
 
+//! Number of allocation histogram classes (small & medium, large and oversized blocks)
+constexpr std::size_t const statistics_class_count = 79;
+
 struct global_statistics
 {
-    //! Current amount of virtual memory mapped (only if ENABLE_STATISTICS=1)
+    //! Current amount of memory mapped in segments and huge page mappings
     std::size_t mapped;
     //! Current amount of memory in global caches for small and medium sizes (<64KiB)
     std::size_t cached;
     //! Current amount of memory in global caches for large sizes (>=64KiB)
     std::size_t cached_large;
-    //! Total amount of memory mapped (only if ENABLE_STATISTICS=1)
+    //! Total amount of memory mapped
     std::size_t mapped_total;
-    //! Total amount of memory unmapped (only if ENABLE_STATISTICS=1)
+    //! Total amount of memory unmapped
     std::size_t unmapped_total;
+    //! Amount of memory currently allocated in memory blocks of all heaps
+    std::size_t allocated;
+    //! Total number of spans taken from thread caches
+    std::size_t thread_cache_hits;
+    //! Total number of span lists taken from global caches
+    std::size_t global_cache_hits;
+    //! Total number of spans mapped because all caches were empty
+    std::size_t cache_misses;
+    //! Total number of bytes transitioned from thread caches to global caches
+    std::size_t thread_to_global;
+    //! Total number of bytes transitioned from global caches to thread caches
+    std::size_t global_to_thread;
+    //! Current amount of memory mapped with huge page backing (explicit or transparent)
+    std::size_t huge_mapped;
+    //! Current amount of memory mapped with explicit (MAP_HUGETLB) huge pages
+    std::size_t huge_explicit;
+    //! Current amount of memory in the global cache for huge page spans
+    std::size_t cached_huge;
+    //! Total number of bytes in spans handed out from the NUMA node of the thread CPU
+    std::size_t node_local;
+    //! Total number of bytes in spans handed out from other NUMA nodes
+    std::size_t node_remote;
 };
 
 struct thread_statistics
 {
     //! Amount of memory currently requested in allocations (only if ENABLE_STATISTICS=1)
     std::size_t requested;
-    //! Amount of memory actually allocated in memory blocks (only if ENABLE_STATISTICS=1)
+    //! Amount of memory actually allocated in memory blocks
     std::size_t allocated;
     //! Current number of bytes available for allocation from active spans
     std::size_t active;
@@ -106,6 +131,34 @@ struct thread_statistics
     std::size_t thread_to_global;
     //! Total number of bytes transitioned from global cache to thread cache
     std::size_t global_to_thread;
+    //! Total number of bytes in spans handed out from the NUMA node of the thread CPU
+    std::size_t node_local;
+    //! Total number of bytes in spans handed out from other NUMA nodes
+    std::size_t node_remote;
+    //! Total number of spans taken from the thread cache
+    std::size_t thread_cache_hits;
+    //! Total number of span lists taken from the global cache
+    std::size_t global_cache_hits;
+    //! Total number of spans mapped because all caches were empty
+    std::size_t cache_misses;
+};
+
+struct size_class_statistics
+{
+    //! Block size of the class (0 for oversized blocks)
+    std::size_t size;
+    //! Total number of allocations
+    std::size_t allocations;
+    //! Total number of deallocations
+    std::size_t deallocations;
+};
+
+struct statistics_snapshot
+{
+    //! Global statistics
+    global_statistics     global;
+    //! Allocation histogram of all heaps, merged size classes stay empty
+    size_class_statistics classes[statistics_class_count];
 };
 
 // =========================================================
@@ -134,6 +187,47 @@ get_thread_statistics(thread_statistics* stats);
 extern void
 get_global_statistics(global_statistics* stats);
 
+//! Aggregate the global statistics and the allocation histogram of all heaps.
+//! The counters are always collected, sharded per heap and only summed here
+extern void
+get_statistics_snapshot(statistics_snapshot* snapshot);
+
+//! Give cold cached spans back to the system while the resident size is above the target
+//! (0 for no target). Every call releases the older half of the global caches and makes the
+//! thread caches move their older half to the global caches on their next deallocation,
+//! so repeated calls decay the caches instead of dropping them at once.
+//! Returns the number of bytes released from the global caches
+extern std::size_t
+trim(std::size_t rss_target);
+
+//! Start a background thread calling trim every interval
+extern bool
+start_scavenger(std::size_t rss_target, u32 interval_ms);
+
+extern void
+stop_scavenger(void);
+
+//! Back new segments with 2MiB huge pages, explicit (MAP_HUGETLB) ones if reserved
+//! and transparent ones otherwise. Already mapped segments keep their backing
+extern void
+set_huge_pages(bool enable);
+
+extern bool
+huge_pages(void);
+
+//! Number of NUMA nodes with their own heaps and node local memory (1 on single node machines)
+extern u32
+numa_node_count(void);
+
+//! NUMA node of the calling thread heap
+extern u32
+thread_numa_node(void);
+
+//! Bind the calling thread to the heaps and memory of a NUMA node instead of the node
+//! it happens to run on. Pinning the thread to the node CPUs is up to the caller
+extern bool
+bind_thread_numa_node(u32 node);
+
 void*
 allocate(std::size_t bytes);
 
@@ -30,6 +30,7 @@
 #include <cppual/string>
 #include <cppual/concepts>
 #include <cppual/resource>
+#include <cppual/interned_string>
 #include <cppual/interface>
 #include <cppual/containers>
 #include <cppual/functional>
@@ -200,7 +201,7 @@ typedef std::pair<loader_type const, plugin_vars> plugin_pair;
 
 template <structure Interface,
           allocator_like A = memory::allocator
-          <std::pair<loader_type::string_type const, plugin_pair>>
+          <std::pair<interned_string const, plugin_pair>>
           >
 class SHARED_API plugin_manager : public non_copyable
 {
@@ -211,7 +212,7 @@ public:
     typedef traits_type::size_type            size_type     ;
     typedef loader_type::string_type          string_type   ;
     typedef loader_type::string_view          string_view   ;
-    typedef string_type                       key_type      ;
+    typedef interned_string                   key_type      ;
     typedef key_type const                    const_key     ;
     typedef plugin_pair                       mapped_type   ;
     typedef mapped_type const                 const_mapped  ;
@@ -242,13 +243,19 @@ public:
         { return &_M_ptr->second; }
 
         constexpr shared_iface iface () const
-        { return std::static_pointer_cast<iface_type> (_M_ptr->second.iface); }
+        { return _M_ptr ? std::static_pointer_cast<iface_type> (_M_ptr->second.iface) : nullptr; }
+
+        constexpr explicit operator bool () const noexcept
+        { return _M_ptr != nullptr; }
 
     private:
         constexpr plugin_pointer (const_reference ref) noexcept
         : _M_ptr (&ref)
         { }
 
+        constexpr plugin_pointer (null_ptr) noexcept
+        { }
+
         plugin_pointer () = delete;
 
         template <structure, allocator_like>
@@ -272,11 +279,34 @@ public:
     constexpr allocator_type get_allocator () const noexcept
     { return _M_gPluginMap.get_allocator (); }
 
-    constexpr loader_type const* loader (const_key& path) const
-    { return &_M_gPluginMap[path].first; }
+    //! nullptr if the plugin isn't loaded
+    template <are_same<key_type> K>
+    constexpr loader_type const* loader (K const& path) const
+    {
+        auto it = _M_gPluginMap.find (path);
+        return it != _M_gPluginMap.end () ? &it->second.first : nullptr;
+    }
+
+    //! a path that was never interned can't be loaded, so it's looked up without interning
+    constexpr loader_type const* loader (string_view const& path) const
+    {
+        auto const key = intern_pool::global ().find (path);
+        return key.empty () ? nullptr : loader (key);
+    }
 
-    constexpr plugin_pointer plugin (const_key& path) const
-    { return _M_gPluginMap[path]; }
+    //! a null plugin_pointer if the plugin isn't loaded
+    template <are_same<key_type> K>
+    constexpr plugin_pointer plugin (K const& path) const
+    {
+        auto it = _M_gPluginMap.find (path);
+        return it != _M_gPluginMap.end () ? plugin_pointer (it->second) : plugin_pointer (nullptr);
+    }
+
+    constexpr plugin_pointer plugin (string_view const& path) const
+    {
+        auto const key = intern_pool::global ().find (path);
+        return key.empty () ? plugin_pointer (nullptr) : plugin (key);
+    }
 
     constexpr plugin_manager (allocator_type const& ator = allocator_type ())
     : _M_gPluginMap (ator)
@@ -307,19 +337,33 @@ public:
         return true;
     }
 
-    constexpr bool is_registered (const_key& path) const noexcept
+    template <are_same<key_type> K>
+    constexpr bool is_registered (K const& path) const noexcept
     {
         return _M_gPluginMap.find (path) != _M_gPluginMap.end ();
     }
 
-    constexpr void release_plugin (const_key& path)
+    constexpr bool is_registered (string_view const& path) const
+    {
+        auto const key = intern_pool::global ().find (path);
+        return !key.empty () && is_registered (key);
+    }
+
+    template <are_same<key_type> K>
+    constexpr void release_plugin (K const& path)
     {
         auto it  = _M_gPluginMap.find (path);
         if  (it != _M_gPluginMap.end ()) _M_gPluginMap.erase (it);
     }
 
+    constexpr void release_plugin (string_view const& path)
+    {
+        auto const key = intern_pool::global ().find (path);
+        if  (!key.empty ()) release_plugin (key);
+    }
+
 private:
-    map_type mutable _M_gPluginMap;
+    map_type _M_gPluginMap;
 };
 
 // =========================================================
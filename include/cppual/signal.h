@@ -26,7 +26,7 @@
 #include <cppual/concepts>
 #include <cppual/meta_type>
 #include <cppual/functional>
-#include <cppual/circular_queue>
+#include <cppual/small_vector>
 #include <cppual/memory_allocator>
 
 #include <iterator>
@@ -57,9 +57,16 @@ class scoped_connection;
 
 // =========================================================
 
-/// how many slots to be reserved at construction
+/// how many slots are stored inside of the signal before the allocator is used
 inline constexpr static const std::size_t reserve_slot_count_v = 5;
 
+/// the slots of one to reserve_slot_count_v connections need no allocation
+template <typename T, typename A>
+using slot_container = small_vector<T, reserve_slot_count_v, A>;
+
+/// connection handle; unlike an iterator it stays valid while the slots grow or move
+enum class slot_id : std::size_t { none };
+
 // =========================================================
 
 template <non_void R, typename... Args, slot_allocator A>
@@ -74,29 +81,32 @@ public:
     typedef function<R(Args...)>                       value_type            ;
     typedef value_type &                               reference             ;
     typedef value_type const&                          const_reference       ;
-    typedef circular_queue<value_type, allocator_type> container_type        ;
+    typedef slot_container<value_type, allocator_type> container_type        ;
     typedef container_type &                           container_ref         ;
     typedef container_type const&                      container_const_ref   ;
     typedef container_type::iterator                   iterator              ;
     typedef container_type::const_iterator             const_iterator        ;
     typedef std::reverse_iterator<iterator>            reverse_iterator      ;
     typedef std::reverse_iterator<const_iterator>      const_reverse_iterator;
-    typedef const_iterator                             slot_type             ;
+    typedef slot_id                                    slot_type             ;
     typedef R                                          return_type           ;
     typedef allocator_type::template rebind_t<R>       return_allocator      ;
     typedef std::vector<R, return_allocator>           collector_type        ;
+    typedef allocator_type::template rebind_t<slot_id> id_allocator          ;
+    typedef slot_container<slot_type, id_allocator>    id_container          ;
 
     using scoped_connection_type = scoped_connection<R(Args...), allocator_type>;
     using static_fn_ref          = R(&)(Args...);
 
-    constexpr container_ref get_slots () noexcept
-    { return _M_slots; }
-
+    //! read only, connect & disconnect keep the slots & their ids in sync
     constexpr container_const_ref get_slots () const noexcept
     { return _M_slots; }
 
     constexpr void clear () noexcept
-    {  _M_slots.clear (); }
+    {
+        _M_slots.clear ();
+        _M_ids  .clear ();
+    }
 
     constexpr bool empty () const noexcept
     { return _M_slots.empty (); }
@@ -154,9 +164,54 @@ public:
 
     constexpr signal (allocator_type const& ator      = allocator_type (),
                       size_type             reserve_n = reserve_slot_count_v) noexcept
-    : _M_slots (ator)
+    : _M_slots (ator),
+      _M_ids   (ator)
+    {
+        if (reserve_n)
+        {
+            _M_slots.reserve (reserve_n);
+            _M_ids  .reserve (reserve_n);
+        }
+    }
+
+    //! id of the connected slot at it
+    constexpr slot_type get_slot_id (const_iterator it) const noexcept
+    { return _M_ids[static_cast<size_type> (it - _M_slots.cbegin ())]; }
+
+    //! position of a connected slot or end () if it was disconnected
+    constexpr const_iterator find (slot_type id) const noexcept
+    {
+        return _M_slots.cbegin () + (std::find (_M_ids.cbegin (), _M_ids.cend (), id) -
+                                     _M_ids.cbegin ());
+    }
+
+    //! connect a slot either at the top or at the bottom
+    template <typename... Ts>
+    constexpr slot_type emplace_slot (bool bTop, Ts&&... args)
+    {
+        auto const id = static_cast<slot_type> (++_M_uLastId);
+
+        if (bTop) _M_slots.emplace (_M_slots.cbegin (), std::forward<Ts> (args)...);
+        else      _M_slots.emplace_back (std::forward<Ts> (args)...);
+
+        try
+        {
+            _M_ids.insert (bTop ? _M_ids.cbegin () : _M_ids.cend (), id);
+        }
+        catch (...)
+        {
+            _M_slots.erase (bTop ? _M_slots.cbegin () : std::prev (_M_slots.cend ()));
+            throw;
+        }
+
+        return id;
+    }
+
+    //! disconnect the slot at it
+    constexpr void erase_slot (const_iterator it)
     {
-        if (reserve_n) _M_slots.reserve (reserve_n);
+        _M_ids  .erase (_M_ids.cbegin () + (it - _M_slots.cbegin ()));
+        _M_slots.erase (it);
     }
 
     //! emit signal to connected slots
@@ -222,7 +277,9 @@ public:
     friend class signal;
 
 private:
-    container_type _M_slots;
+    container_type _M_slots   ;
+    id_container   _M_ids     ;
+    std::size_t    _M_uLastId { };
 };
 
 // =========================================================
@@ -239,27 +296,30 @@ public:
     typedef function<void(Args...)>                    value_type            ;
     typedef value_type &                               reference             ;
     typedef value_type const&                          const_reference       ;
-    typedef circular_queue<value_type, allocator_type> container_type        ;
+    typedef slot_container<value_type, allocator_type> container_type        ;
     typedef container_type&                            container_ref         ;
     typedef container_type const&                      container_const_ref   ;
     typedef container_type::iterator                   iterator              ;
     typedef container_type::const_iterator             const_iterator        ;
     typedef std::reverse_iterator<iterator>            reverse_iterator      ;
     typedef std::reverse_iterator<const_iterator>      const_reverse_iterator;
-    typedef container_type::const_iterator             slot_type             ;
+    typedef slot_id                                    slot_type             ;
     typedef void                                       return_type           ;
+    typedef allocator_type::template rebind_t<slot_id> id_allocator          ;
+    typedef slot_container<slot_type, id_allocator>    id_container          ;
 
     using scoped_connection_type = scoped_connection<void(Args...), allocator_type>;
     using static_fn_ref          = void(&)(Args...);
 
-    constexpr container_ref get_slots () noexcept
-    { return _M_slots; }
-
+    //! read only, connect & disconnect keep the slots & their ids in sync
     constexpr container_const_ref get_slots () const noexcept
     { return _M_slots; }
 
     constexpr void clear () noexcept
-    {  _M_slots.clear (); }
+    {
+        _M_slots.clear ();
+        _M_ids  .clear ();
+    }
 
     constexpr bool empty () const noexcept
     { return _M_slots.empty (); }
@@ -317,9 +377,54 @@ public:
 
     constexpr signal (allocator_type const& ator      = allocator_type (),
                       size_type             reserve_n = reserve_slot_count_v) noexcept
-    : _M_slots (ator)
+    : _M_slots (ator),
+      _M_ids   (ator)
+    {
+        if (reserve_n)
+        {
+            _M_slots.reserve (reserve_n);
+            _M_ids  .reserve (reserve_n);
+        }
+    }
+
+    //! id of the connected slot at it
+    constexpr slot_type get_slot_id (const_iterator it) const noexcept
+    { return _M_ids[static_cast<size_type> (it - _M_slots.cbegin ())]; }
+
+    //! position of a connected slot or end () if it was disconnected
+    constexpr const_iterator find (slot_type id) const noexcept
+    {
+        return _M_slots.cbegin () + (std::find (_M_ids.cbegin (), _M_ids.cend (), id) -
+                                     _M_ids.cbegin ());
+    }
+
+    //! connect a slot either at the top or at the bottom
+    template <typename... Ts>
+    constexpr slot_type emplace_slot (bool bTop, Ts&&... args)
+    {
+        auto const id = static_cast<slot_type> (++_M_uLastId);
+
+        if (bTop) _M_slots.emplace (_M_slots.cbegin (), std::forward<Ts> (args)...);
+        else      _M_slots.emplace_back (std::forward<Ts> (args)...);
+
+        try
+        {
+            _M_ids.insert (bTop ? _M_ids.cbegin () : _M_ids.cend (), id);
+        }
+        catch (...)
+        {
+            _M_slots.erase (bTop ? _M_slots.cbegin () : std::prev (_M_slots.cend ()));
+            throw;
+        }
+
+        return id;
+    }
+
+    //! disconnect the slot at it
+    constexpr void erase_slot (const_iterator it)
     {
-        if (reserve_n) _M_slots.reserve (reserve_n);
+        _M_ids  .erase (_M_ids.cbegin () + (it - _M_slots.cbegin ()));
+        _M_slots.erase (it);
     }
 
     //! emit signal to connected slots
@@ -383,7 +488,9 @@ public:
     friend class signal;
 
 private:
-    container_type _M_slots;
+    container_type _M_slots   ;
+    id_container   _M_ids     ;
+    std::size_t    _M_uLastId { };
 };
 
 // =========================================================
@@ -400,27 +507,30 @@ public:
     typedef function<void(Args...)>                    value_type            ;
     typedef value_type &                               reference             ;
     typedef value_type const&                          const_reference       ;
-    typedef circular_queue<value_type, allocator_type> container_type        ;
+    typedef slot_container<value_type, allocator_type> container_type        ;
     typedef container_type&                            container_ref         ;
     typedef container_type const&                      container_const_ref   ;
     typedef container_type::iterator                   iterator              ;
     typedef container_type::const_iterator             const_iterator        ;
     typedef std::reverse_iterator<iterator>            reverse_iterator      ;
     typedef std::reverse_iterator<const_iterator>      const_reverse_iterator;
-    typedef container_type::const_iterator             slot_type             ;
+    typedef slot_id                                    slot_type             ;
     typedef bool                                       return_type           ;
+    typedef allocator_type::template rebind_t<slot_id> id_allocator          ;
+    typedef slot_container<slot_type, id_allocator>    id_container          ;
 
     using scoped_connection_type = scoped_connection<void(Args...), allocator_type>;
     using static_fn_ref          = bool(&)(Args...);
 
-    constexpr container_ref get_slots () noexcept
-    { return _M_slots; }
-
+    //! read only, connect & disconnect keep the slots & their ids in sync
     constexpr container_const_ref get_slots () const noexcept
     { return _M_slots; }
 
     constexpr void clear () noexcept
-    {  _M_slots.clear (); }
+    {
+        _M_slots.clear ();
+        _M_ids  .clear ();
+    }
 
     constexpr bool empty () const noexcept
     { return _M_slots.empty (); }
@@ -478,9 +588,54 @@ public:
 
     constexpr signal (allocator_type const& ator      = allocator_type (),
                       size_type             reserve_n = reserve_slot_count_v) noexcept
-    : _M_slots (ator)
+    : _M_slots (ator),
+      _M_ids   (ator)
+    {
+        if (reserve_n)
+        {
+            _M_slots.reserve (reserve_n);
+            _M_ids  .reserve (reserve_n);
+        }
+    }
+
+    //! id of the connected slot at it
+    constexpr slot_type get_slot_id (const_iterator it) const noexcept
+    { return _M_ids[static_cast<size_type> (it - _M_slots.cbegin ())]; }
+
+    //! position of a connected slot or end () if it was disconnected
+    constexpr const_iterator find (slot_type id) const noexcept
+    {
+        return _M_slots.cbegin () + (std::find (_M_ids.cbegin (), _M_ids.cend (), id) -
+                                     _M_ids.cbegin ());
+    }
+
+    //! connect a slot either at the top or at the bottom
+    template <typename... Ts>
+    constexpr slot_type emplace_slot (bool bTop, Ts&&... args)
+    {
+        auto const id = static_cast<slot_type> (++_M_uLastId);
+
+        if (bTop) _M_slots.emplace (_M_slots.cbegin (), std::forward<Ts> (args)...);
+        else      _M_slots.emplace_back (std::forward<Ts> (args)...);
+
+        try
+        {
+            _M_ids.insert (bTop ? _M_ids.cbegin () : _M_ids.cend (), id);
+        }
+        catch (...)
+        {
+            _M_slots.erase (bTop ? _M_slots.cbegin () : std::prev (_M_slots.cend ()));
+            throw;
+        }
+
+        return id;
+    }
+
+    //! disconnect the slot at it
+    constexpr void erase_slot (const_iterator it)
     {
-        if (reserve_n) _M_slots.reserve (reserve_n);
+        _M_ids  .erase (_M_ids.cbegin () + (it - _M_slots.cbegin ()));
+        _M_slots.erase (it);
     }
 
     //! emit signal to connected slots
@@ -542,7 +697,9 @@ public:
     friend class signal;
 
 private:
-    container_type _M_slots;
+    container_type _M_slots   ;
+    id_container   _M_ids     ;
+    std::size_t    _M_uLastId { };
 };
 
 // =========================================================
@@ -557,22 +714,12 @@ inline
              typename signal<R(Args...), A>::value_type&& val,
              bool bTop = false)
 {
-    for (auto it = gSignal.get_slots ().begin (); it != gSignal.get_slots ().end (); ++it)
+    for (auto it = gSignal.cbegin (); it != gSignal.cend (); ++it)
     {
-        if (*it == val)
-        {
-            if (bTop)
-            {
-                gSignal.get_slots ().push_front (std::move (val));
-                return gSignal.get_slots ().begin ();
-            }
-
-            gSignal.get_slots ().push_back (std::move (val));
-            return --gSignal.get_slots ().end ();
-        }
+        if (*it == val) return gSignal.get_slot_id (it);
     }
 
-    return --gSignal.get_slots ().end ();
+    return gSignal.emplace_slot (bTop, std::move (val));
 }
 
 template <typename    R,
@@ -585,22 +732,12 @@ connect (signal<R(Args...), A>& gSignal,
          typename signal<R(Args...), A>::const_reference val,
          bool bTop = false)
 {
-    for (auto it = gSignal.get_slots ().begin (); it != gSignal.get_slots ().end (); ++it)
+    for (auto it = gSignal.cbegin (); it != gSignal.cend (); ++it)
     {
-        if (*it == val)
-        {
-            if (bTop)
-            {
-                gSignal.get_slots ().push_front (val);
-                return gSignal.get_slots ().begin ();
-            }
-
-            gSignal.get_slots ().push_back (val);
-            return --gSignal.get_slots ().end ();
-        }
+        if (*it == val) return gSignal.get_slot_id (it);
     }
 
-    return --gSignal.get_slots ().end ();
+    return gSignal.emplace_slot (bTop, val);
 }
 
 template <lambda_non_capture Call,
@@ -615,22 +752,13 @@ connect (signal<R(Args...), A>& gSignal,
          bool bTop = false,
          LambdaNonCaptureType<Call>* = nullptr)
 {
-    for (auto it = gSignal.get_slots ().begin (); it != gSignal.get_slots ().end (); ++it)
+    for (auto it = gSignal.cbegin (); it != gSignal.cend (); ++it)
     {
         if (*it == typename signal<R(Args...), A>::value_type (gFunc))
-        {
-            if (bTop)
-            {
-                gSignal.get_slots ().emplace_front (std::move (gFunc));
-                return gSignal.get_slots ().begin ();
-            }
-
-            gSignal.get_slots ().emplace_back (std::move (gFunc));
-            return --gSignal.get_slots ().end ();
-        }
+            return gSignal.get_slot_id (it);
     }
 
-    return --gSignal.get_slots ().end ();
+    return gSignal.emplace_slot (bTop, std::move (gFunc));
 }
 
 template <lambda_capture Call,
@@ -645,22 +773,13 @@ connect (signal<R(Args...), A>& gSignal,
          bool bTop = false,
          LambdaCaptureType<Call>* = nullptr)
 {
-    for (auto it = gSignal.get_slots ().begin (); it != gSignal.get_slots ().end (); ++it)
+    for (auto it = gSignal.cbegin (); it != gSignal.cend (); ++it)
     {
         if (*it == typename signal<R(Args...), A>::value_type (gFunc))
-        {
-            if (bTop)
-            {
-                gSignal.get_slots ().emplace_front (std::move (gFunc));
-                return gSignal.get_slots ().begin ();
-            }
-
-            gSignal.get_slots ().emplace_back (std::move (gFunc));
-            return --gSignal.get_slots ().end ();
-        }
+            return gSignal.get_slot_id (it);
     }
 
-    return --gSignal.get_slots ().end ();
+    return gSignal.emplace_slot (bTop, std::move (gFunc));
 }
 
 template <structure   C,
@@ -674,22 +793,12 @@ connect (signal<R(Args...), A>& gSignal,
          R(C::* fn)(Args...),
          bool bTop = false)
 {
-    for (auto it = gSignal.get_slots ().begin (); it != gSignal.get_slots ().end (); ++it)
+    for (auto it = gSignal.cbegin (); it != gSignal.cend (); ++it)
     {
-        if (*it == make_fn (pObj, fn))
-        {
-            if (bTop)
-            {
-                gSignal.get_slots ().emplace_front (pObj, fn);
-                return gSignal.get_slots ().begin ();
-            }
-
-            gSignal.get_slots ().emplace_back (pObj, fn);
-            return --gSignal.get_slots ().end ();
-        }
+        if (*it == make_fn (pObj, fn)) return gSignal.get_slot_id (it);
     }
 
-    return --gSignal.get_slots ().end ();
+    return gSignal.emplace_slot (bTop, pObj, fn);
 }
 
 template <structure   C,
@@ -704,22 +813,12 @@ connect (signal<R(Args...), A>& gSignal,
          R(C::* fn)(Args...) const,
          bool bTop = false)
 {
-    for (auto it = gSignal.get_slots ().begin (); it != gSignal.get_slots ().end (); ++it)
+    for (auto it = gSignal.cbegin (); it != gSignal.cend (); ++it)
     {
-        if (*it == make_fn (pObj, fn))
-        {
-            if (bTop)
-            {
-                gSignal.get_slots ().emplace_front (pObj, fn);
-                return gSignal.get_slots ().begin ();
-            }
-
-            gSignal.get_slots ().emplace_back (pObj, fn);
-            return --gSignal.get_slots ().end ();
-        }
+        if (*it == make_fn (pObj, fn)) return gSignal.get_slot_id (it);
     }
 
-    return --gSignal.get_slots ().end ();
+    return gSignal.emplace_slot (bTop, pObj, fn);
 }
 
 template <callable_class C,
@@ -731,22 +830,12 @@ inline
 typename signal<R(Args...), A>::slot_type
 connect (signal<R(Args...), A>& gSignal, C& pObj, bool bTop = false)
 {
-    for (auto it = gSignal.get_slots ().begin (); it != gSignal.get_slots ().end (); ++it)
+    for (auto it = gSignal.cbegin (); it != gSignal.cend (); ++it)
     {
-        if (*it == make_fn (pObj))
-        {
-            if (bTop)
-            {
-                gSignal.get_slots ().emplace_front (pObj);
-                return gSignal.get_slots ().begin ();
-            }
-
-            gSignal.get_slots ().emplace_back (pObj);
-            return --gSignal.get_slots ().end ();
-        }
+        if (*it == make_fn (pObj)) return gSignal.get_slot_id (it);
     }
 
-    return --gSignal.get_slots ().end ();
+    return gSignal.emplace_slot (bTop, pObj);
 }
 
 template <typename    R,
@@ -757,22 +846,13 @@ inline
 typename signal<R(Args...), A>::slot_type
 connect (signal<R(Args...), A>& gSignal, R(& fn)(Args...), bool bTop = false)
 {
-    for (auto it = gSignal.get_slots ().begin (); it != gSignal.get_slots ().end (); ++it)
+    for (auto it = gSignal.cbegin (); it != gSignal.cend (); ++it)
     {
-        if (*it == fn)
-        {
-            if (bTop)
-            {
-                gSignal.get_slots ().emplace_front (fn);
-                return gSignal.get_slots ().begin ();
-            }
-
-            gSignal.get_slots ().emplace_back (fn);
-            return --gSignal.get_slots ().end ();
-        }
+        if (*it == typename signal<R(Args...), A>::value_type (fn))
+            return gSignal.get_slot_id (it);
     }
 
-    return --gSignal.get_slots ().end ();
+    return gSignal.emplace_slot (bTop, fn);
 }
 
 // =========================================================
@@ -784,9 +864,12 @@ template <typename    R,
 inline
 void
 disconnect (signal<R(Args...), A>& gSignal,
-            typename signal<R(Args...), A>::slot_type& it)
+            typename signal<R(Args...), A>::slot_type& id)
 {
-    if (it != gSignal.end ()) gSignal.get_slots ().erase (it);
+    auto const it = gSignal.find (id);
+
+    if (it != gSignal.cend ()) gSignal.erase_slot (it);
+    id = slot_id::none;
 }
 
 template <typename    R,
@@ -800,7 +883,7 @@ disconnect (signal<R(Args...), A>& gSignal,
 {
     auto it = std::find (gSignal.begin (), gSignal.end (), fn);
 
-    if (it != gSignal.end ()) gSignal.get_slots ().erase (it);
+    if (it != gSignal.end ()) gSignal.erase_slot (it);
 }
 
 template <structure   C,
@@ -816,7 +899,7 @@ disconnect (signal<R(Args...), A>& gSignal, remove_const_t<C>& pObj, R(C::* fn)(
 
     auto it = std::find (gSignal.begin (), gSignal.end (), value_type (pObj, fn));
 
-    if (it != gSignal.end ()) gSignal.get_slots ().erase (it);
+    if (it != gSignal.end ()) gSignal.erase_slot (it);
 }
 
 
@@ -834,7 +917,7 @@ disconnect (signal<R(Args...), A>& gSignal, remove_const_t<C>& pObj, R(C::* fn)(
 
     auto it = std::find (gSignal.begin (), gSignal.end (), value_type (pObj, fn));
 
-    if (it != gSignal.end ()) gSignal.get_slots ().erase (it);
+    if (it != gSignal.end ()) gSignal.erase_slot (it);
 }
 
 template <callable_class C,
@@ -850,7 +933,7 @@ disconnect (signal<R(Args...), A>& gSignal, C& pObj)
 
     auto it = std::find (gSignal.begin (), gSignal.end (), value_type (pObj));
 
-    if (it != gSignal.end ()) gSignal.get_slots ().erase (it);
+    if (it != gSignal.end ()) gSignal.erase_slot (it);
 }
 
 template <typename    R,
@@ -865,7 +948,7 @@ disconnect (signal<R(Args...), A>& gSignal, R(& fn)(Args...))
 
     auto it = std::find (gSignal.begin (), gSignal.end (), value_type (fn));
 
-    if (it != gSignal.end ()) gSignal.get_slots ().erase (it);
+    if (it != gSignal.end ()) gSignal.erase_slot (it);
 }
 
 // =========================================================
@@ -0,0 +1,526 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPUAL_SMALL_VECTOR_H_
+#define CPPUAL_SMALL_VECTOR_H_
+#ifdef __cplusplus
+
+#include <cppual/memory_allocator>
+#include <cppual/concepts>
+#include <cppual/types>
+
+#include <initializer_list>
+#include <type_traits>
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+#include <utility>
+#include <memory>
+
+// ====================================================
+
+namespace cppual {
+
+// ====================================================
+
+/**
+ ** @brief vector keeping the first N elements inside of the object. nothing is
+ ** allocated until the size goes past N, then the elements move to a buffer
+ ** of the allocator & stay there (shrink_to_fit brings them back when they fit).
+ ** the iterators are plain pointers & are invalidated by moving the container
+ **/
+template <non_void T, std::size_t N, allocator_like A = memory::allocator<T>>
+class SHARED_API small_vector : private A
+{
+public:
+    static_assert (N > 0, "the inline capacity must be at least 1!");
+    static_assert (move_constructible<T>, "T is not move constructible!");
+
+    typedef small_vector<T, N, A>                 self_type             ;
+    typedef memory::allocator_traits<A>           traits_type           ;
+    typedef traits_type::allocator_type           allocator_type        ;
+    typedef T                                     value_type            ;
+    typedef value_type *                          pointer               ;
+    typedef value_type const*                     const_pointer         ;
+    typedef value_type &                          reference             ;
+    typedef value_type const&                     const_reference       ;
+    typedef traits_type::size_type                size_type             ;
+    typedef size_type const                       const_size            ;
+    typedef traits_type::difference_type          difference_type       ;
+    typedef pointer                               iterator              ;
+    typedef const_pointer                         const_iterator        ;
+    typedef std::reverse_iterator<iterator>       reverse_iterator      ;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    inline constexpr static size_type const inline_capacity = N;
+
+    // ====================================================
+
+    constexpr small_vector () noexcept (std::is_nothrow_default_constructible_v<allocator_type>)
+    : allocator_type ()
+    , _M_pBegin      (inline_data ())
+    , _M_uSize       ()
+    , _M_uCapacity   (N)
+    { }
+
+    constexpr explicit small_vector (allocator_type const& gAtor) noexcept
+    : allocator_type (gAtor)
+    , _M_pBegin      (inline_data ())
+    , _M_uSize       ()
+    , _M_uCapacity   (N)
+    { }
+
+    constexpr small_vector (size_type n, const_reference val, allocator_type const& gAtor = allocator_type ())
+    : small_vector (gAtor)
+    { assign (n, val); }
+
+    constexpr explicit small_vector (size_type n, allocator_type const& gAtor = allocator_type ())
+    : small_vector (gAtor)
+    { resize (n); }
+
+    template <std::input_iterator Iterator>
+    constexpr small_vector (Iterator gFirst, Iterator gLast, allocator_type const& gAtor = allocator_type ())
+    : small_vector (gAtor)
+    { assign (gFirst, gLast); }
+
+    constexpr small_vector (std::initializer_list<value_type> list, allocator_type const& gAtor = allocator_type ())
+    : small_vector (gAtor)
+    { assign (list.begin (), list.end ()); }
+
+    constexpr small_vector (self_type const& gObj)
+    : small_vector (traits_type::select_on_container_copy_construction (gObj))
+    { assign (gObj.begin (), gObj.end ()); }
+
+    //! a spilled buffer is taken over, inline elements are moved one by one
+    constexpr small_vector (self_type&& gObj) noexcept (std::is_nothrow_move_constructible_v<value_type>)
+    : small_vector (static_cast<allocator_type const&> (gObj))
+    { take (gObj); }
+
+    constexpr ~small_vector ()
+    { dispose (); }
+
+    constexpr self_type& operator = (self_type const& gObj)
+    {
+        if (this != &gObj) assign (gObj.begin (), gObj.end ());
+        return *this;
+    }
+
+    constexpr self_type& operator = (self_type&& gObj) noexcept (std::is_nothrow_move_constructible_v<value_type>)
+    {
+        if (this == &gObj) return *this;
+
+        dispose ();
+
+        static_cast<allocator_type&> (*this) = std::move (static_cast<allocator_type&> (gObj));
+        take (gObj);
+
+        return *this;
+    }
+
+    constexpr self_type& operator = (std::initializer_list<value_type> list)
+    {
+        assign (list.begin (), list.end ());
+        return *this;
+    }
+
+    // ====================================================
+
+    constexpr iterator begin () noexcept
+    { return _M_pBegin; }
+
+    constexpr const_iterator begin () const noexcept
+    { return _M_pBegin; }
+
+    constexpr const_iterator cbegin () const noexcept
+    { return _M_pBegin; }
+
+    constexpr iterator end () noexcept
+    { return _M_pBegin + _M_uSize; }
+
+    constexpr const_iterator end () const noexcept
+    { return _M_pBegin + _M_uSize; }
+
+    constexpr const_iterator cend () const noexcept
+    { return _M_pBegin + _M_uSize; }
+
+    constexpr reverse_iterator rbegin () noexcept
+    { return reverse_iterator (end ()); }
+
+    constexpr const_reverse_iterator rbegin () const noexcept
+    { return const_reverse_iterator (end ()); }
+
+    constexpr const_reverse_iterator crbegin () const noexcept
+    { return const_reverse_iterator (end ()); }
+
+    constexpr reverse_iterator rend () noexcept
+    { return reverse_iterator (begin ()); }
+
+    constexpr const_reverse_iterator rend () const noexcept
+    { return const_reverse_iterator (begin ()); }
+
+    constexpr const_reverse_iterator crend () const noexcept
+    { return const_reverse_iterator (begin ()); }
+
+    // ====================================================
+
+    constexpr size_type size () const noexcept
+    { return _M_uSize; }
+
+    constexpr bool empty () const noexcept
+    { return !_M_uSize; }
+
+    constexpr size_type capacity () const noexcept
+    { return _M_uCapacity; }
+
+    constexpr size_type max_size () const noexcept
+    { return traits_type::max_size (*this); }
+
+    //! true while no memory of the allocator is used
+    constexpr bool is_inline () const noexcept
+    { return _M_pBegin == inline_data (); }
+
+    constexpr allocator_type get_allocator () const noexcept
+    { return *this; }
+
+    constexpr pointer data () noexcept
+    { return _M_pBegin; }
+
+    constexpr const_pointer data () const noexcept
+    { return _M_pBegin; }
+
+    constexpr reference operator [] (size_type n) noexcept
+    { return _M_pBegin[n]; }
+
+    constexpr const_reference operator [] (size_type n) const noexcept
+    { return _M_pBegin[n]; }
+
+    constexpr reference at (size_type n)
+    {
+        if (n >= _M_uSize) throw std::out_of_range ("small_vector index out of range!");
+        return _M_pBegin[n];
+    }
+
+    constexpr const_reference at (size_type n) const
+    {
+        if (n >= _M_uSize) throw std::out_of_range ("small_vector index out of range!");
+        return _M_pBegin[n];
+    }
+
+    constexpr reference front () noexcept
+    { return *_M_pBegin; }
+
+    constexpr const_reference front () const noexcept
+    { return *_M_pBegin; }
+
+    constexpr reference back () noexcept
+    { return _M_pBegin[_M_uSize - 1]; }
+
+    constexpr const_reference back () const noexcept
+    { return _M_pBegin[_M_uSize - 1]; }
+
+    // ====================================================
+
+    constexpr void reserve (size_type n)
+    { if (n > _M_uCapacity) reallocate (n); }
+
+    //! moves the elements back inside of the object when they fit
+    constexpr void shrink_to_fit ()
+    {
+        if (is_inline () || _M_uSize == _M_uCapacity) return;
+
+        if (_M_uSize > N) reallocate (_M_uSize);
+        else
+        {
+            auto const pOld      = _M_pBegin   ;
+            auto const uCapacity = _M_uCapacity;
+
+            relocate (pOld, _M_uSize, inline_data ());
+            traits_type::deallocate (*this, pOld, uCapacity);
+
+            _M_pBegin    = inline_data ();
+            _M_uCapacity = N;
+        }
+    }
+
+    constexpr void clear () noexcept
+    {
+        std::destroy_n (_M_pBegin, _M_uSize);
+        _M_uSize = size_type ();
+    }
+
+    constexpr void assign (size_type n, const_reference val)
+    {
+        clear   ();
+        reserve (n);
+
+        std::uninitialized_fill_n (_M_pBegin, n, val);
+        _M_uSize = n;
+    }
+
+    template <std::input_iterator Iterator>
+    constexpr void assign (Iterator gFirst, Iterator gLast)
+    {
+        clear ();
+
+        if constexpr (std::forward_iterator<Iterator>)
+        {
+            auto const n = static_cast<size_type> (std::distance (gFirst, gLast));
+
+            reserve (n);
+
+            std::uninitialized_copy (gFirst, gLast, _M_pBegin);
+            _M_uSize = n;
+        }
+        else for (; gFirst != gLast; ++gFirst) emplace_back (*gFirst);
+    }
+
+    // ====================================================
+
+    template <typename... Args>
+    constexpr reference emplace_back (Args&&... args)
+    {
+        if (_M_uSize < _M_uCapacity)
+        {
+            traits_type::construct (*this, _M_pBegin + _M_uSize, std::forward<Args> (args)...);
+            return _M_pBegin[_M_uSize++];
+        }
+
+        //! the new element is built before the old ones move, args may refer to them
+        auto const uCapacity = grown_capacity (_M_uSize + 1);
+        auto const pNew      = std::to_address (traits_type::allocate (*this, uCapacity));
+
+        try
+        {
+            traits_type::construct (*this, pNew + _M_uSize, std::forward<Args> (args)...);
+        }
+        catch (...)
+        {
+            traits_type::deallocate (*this, pNew, uCapacity);
+            throw;
+        }
+
+        adopt (pNew, uCapacity);
+        return _M_pBegin[_M_uSize++];
+    }
+
+    constexpr void push_back (const_reference val)
+    { emplace_back (val); }
+
+    constexpr void push_back (value_type&& val)
+    { emplace_back (std::move (val)); }
+
+    constexpr void pop_back () noexcept
+    { traits_type::destroy (*this, _M_pBegin + --_M_uSize); }
+
+    template <typename... Args>
+    constexpr iterator emplace (const_iterator pos, Args&&... args)
+    {
+        auto const uIdx = static_cast<size_type> (pos - _M_pBegin);
+
+        if (uIdx == _M_uSize)
+        {
+            emplace_back (std::forward<Args> (args)...);
+            return _M_pBegin + uIdx;
+        }
+
+        value_type gTmp (std::forward<Args> (args)...);
+
+        emplace_back (std::move (back ()));
+        std::move_backward (_M_pBegin + uIdx, _M_pBegin + _M_uSize - 2, _M_pBegin + _M_uSize - 1);
+        _M_pBegin[uIdx] = std::move (gTmp);
+
+        return _M_pBegin + uIdx;
+    }
+
+    constexpr iterator insert (const_iterator pos, const_reference val)
+    { return emplace (pos, val); }
+
+    constexpr iterator insert (const_iterator pos, value_type&& val)
+    { return emplace (pos, std::move (val)); }
+
+    template <std::input_iterator Iterator>
+    constexpr iterator insert (const_iterator pos, Iterator gFirst, Iterator gLast)
+    {
+        auto const uIdx  = static_cast<size_type> (pos - _M_pBegin);
+        auto const uSize = _M_uSize;
+
+        for (; gFirst != gLast; ++gFirst) emplace_back (*gFirst);
+
+        std::rotate (_M_pBegin + uIdx, _M_pBegin + uSize, _M_pBegin + _M_uSize);
+        return _M_pBegin + uIdx;
+    }
+
+    constexpr iterator erase (const_iterator pos)
+    { return erase (pos, pos + 1); }
+
+    constexpr iterator erase (const_iterator gFirst, const_iterator gLast)
+    {
+        auto const pFirst = _M_pBegin + (gFirst - _M_pBegin);
+        auto const pLast  = _M_pBegin + (gLast  - _M_pBegin);
+
+        if (pFirst == pLast) return pFirst;
+
+        auto const pEnd = std::move (pLast, end (), pFirst);
+
+        std::destroy (pEnd, end ());
+        _M_uSize = static_cast<size_type> (pEnd - _M_pBegin);
+
+        return pFirst;
+    }
+
+    constexpr void resize (size_type n)
+    {
+        if (n < _M_uSize) erase (_M_pBegin + n, end ());
+        else
+        {
+            reserve (n);
+
+            std::uninitialized_value_construct (end (), _M_pBegin + n);
+            _M_uSize = n;
+        }
+    }
+
+    constexpr void resize (size_type n, const_reference val)
+    {
+        if (n < _M_uSize) erase (_M_pBegin + n, end ());
+        else
+        {
+            if (n > _M_uCapacity)
+            {
+                value_type const gCopy (val);
+
+                reserve (n);
+                std::uninitialized_fill (end (), _M_pBegin + n, gCopy);
+            }
+            else std::uninitialized_fill (end (), _M_pBegin + n, val);
+
+            _M_uSize = n;
+        }
+    }
+
+    constexpr void swap (self_type& gObj)
+    {
+        if (this == &gObj) return;
+
+        self_type gTmp (std::move (gObj));
+
+        gObj  = std::move (*this);
+        *this = std::move (gTmp);
+    }
+
+    // ====================================================
+
+    friend constexpr bool operator == (self_type const& lh, self_type const& rh)
+    { return std::equal (lh.begin (), lh.end (), rh.begin (), rh.end ()); }
+
+    friend constexpr bool operator != (self_type const& lh, self_type const& rh)
+    { return !(lh == rh); }
+
+private:
+    inline constexpr static cbool is_trivial_move = std::is_trivially_copyable_v<value_type>;
+
+    constexpr pointer inline_data () noexcept
+    { return reinterpret_cast<pointer> (_M_Inline); }
+
+    constexpr const_pointer inline_data () const noexcept
+    { return reinterpret_cast<const_pointer> (_M_Inline); }
+
+    constexpr size_type grown_capacity (size_type n) const noexcept
+    { return std::max (n, _M_uCapacity * 2); }
+
+    //! moves n elements to uninitialized memory & destroys the sources
+    constexpr static void relocate (pointer pSrc, size_type n, pointer pDst) noexcept
+    {
+        if constexpr (is_trivial_move)
+        {
+            if (n) std::memcpy (static_cast<void*> (pDst), pSrc, n * sizeof (value_type));
+        }
+        else
+        {
+            std::uninitialized_move_n (pSrc, n, pDst);
+            std::destroy_n (pSrc, n);
+        }
+    }
+
+    //! the elements move to a new buffer of the allocator that already holds the new ones
+    constexpr void adopt (pointer pNew, size_type uCapacity) noexcept
+    {
+        relocate (_M_pBegin, _M_uSize, pNew);
+
+        if (!is_inline ()) traits_type::deallocate (*this, _M_pBegin, _M_uCapacity);
+
+        _M_pBegin    = pNew     ;
+        _M_uCapacity = uCapacity;
+    }
+
+    constexpr void reallocate (size_type uCapacity)
+    { adopt (std::to_address (traits_type::allocate (*this, uCapacity)), uCapacity); }
+
+    constexpr void take (self_type& gObj) noexcept (std::is_nothrow_move_constructible_v<value_type>)
+    {
+        if (gObj.is_inline ())
+        {
+            std::uninitialized_move_n (gObj._M_pBegin, gObj._M_uSize, inline_data ());
+
+            _M_pBegin    = inline_data ();
+            _M_uSize     = gObj._M_uSize;
+            _M_uCapacity = N;
+
+            gObj.clear ();
+        }
+        else
+        {
+            _M_pBegin    = gObj._M_pBegin   ;
+            _M_uSize     = gObj._M_uSize    ;
+            _M_uCapacity = gObj._M_uCapacity;
+
+            gObj._M_pBegin    = gObj.inline_data ();
+            gObj._M_uSize     = size_type ();
+            gObj._M_uCapacity = N;
+        }
+    }
+
+    constexpr void dispose () noexcept
+    {
+        clear ();
+
+        if (!is_inline ()) traits_type::deallocate (*this, _M_pBegin, _M_uCapacity);
+
+        _M_pBegin    = inline_data ();
+        _M_uCapacity = N;
+    }
+
+private:
+    pointer   _M_pBegin   ;
+    size_type _M_uSize    ;
+    size_type _M_uCapacity;
+    alignas (value_type) byte _M_Inline[N * sizeof (value_type)];
+};
+
+// ====================================================
+
+} // namespace cppual
+
+// ====================================================
+
+#endif // __cplusplus
+#endif // CPPUAL_SMALL_VECTOR_H_
@@ -30,10 +30,14 @@
 #include <cppual/noncopyable>
 #include <cppual/meta_string>
 #include <cppual/memory_allocator>
+#include <cppual/string_search>
 
 #include <string_view>
 #include <type_traits>
+#include <stdexcept>
+#include <algorithm>
 #include <iterator>
+#include <atomic>
 #include <sstream>
 #include <cstddef>
 #include <memory>
@@ -96,12 +100,132 @@ locale_traits<remove_cvptr_t<decltype (C_STR)>>::length (C_STR);
 
 // ====================================================
 
+/**
+ ** @brief the searches & comparisons of cow_string & its views. at run time the
+ ** 1 byte characters of the default traits go through the vectorized kernels
+ ** of string_search.h, everything else & constant evaluation through the traits
+ **/
+template <symbolic_char T, structure E>
+struct string_ops
+{
+    typedef T const*    const_pointer;
+    typedef std::size_t size_type    ;
+
+    inline constexpr static size_type const npos = size_type (-1);
+
+    //! other traits may not compare as plain bytes
+    inline constexpr static cbool is_bytes_v = sizeof (T) == 1 &&
+                                               (std::is_same_v<E, locale_traits<T>> ||
+                                                std::is_same_v<E, std::char_traits<T>>);
+
+    constexpr static size_type find (const_pointer str, size_type len, T ch, size_type pos) noexcept
+    {
+        if (pos >= len) return npos;
+
+        if constexpr (is_bytes_v)
+        {
+            if !consteval
+            {
+                auto const uPos = simd::find_byte (str + pos, len - pos, static_cast<u8> (ch));
+
+                return uPos != simd::npos ? pos + uPos : npos;
+            }
+        }
+
+        auto const pFound = E::find (str + pos, len - pos, ch);
+
+        return pFound ? static_cast<size_type> (pFound - str) : npos;
+    }
+
+    constexpr static size_type find (const_pointer str, size_type len,
+                                     const_pointer s  , size_type count, size_type pos) noexcept
+    {
+        if (pos > len || count > len - pos) return npos;
+        if (!count) return pos;
+
+        if constexpr (is_bytes_v)
+        {
+            if !consteval
+            {
+                auto const uPos = simd::find_bytes (str + pos, len - pos, s, count);
+
+                return uPos != simd::npos ? pos + uPos : npos;
+            }
+        }
+
+        for (auto i = pos; len - i >= count; ++i)
+        {
+            auto const pFound = E::find (str + i, len - count + 1 - i, *s);
+
+            if (!pFound) return npos;
+
+            i = static_cast<size_type> (pFound - str);
+
+            if (!E::compare (str + i + 1, s + 1, count - 1)) return i;
+        }
+
+        return npos;
+    }
+
+    constexpr static size_type find_first_of (const_pointer str, size_type len,
+                                              const_pointer s  , size_type count, size_type pos) noexcept
+    {
+        if (pos >= len || !count) return npos;
+
+        if constexpr (is_bytes_v)
+        {
+            if !consteval
+            {
+                auto const uPos = simd::find_any_byte (str + pos, len - pos, s, count);
+
+                return uPos != simd::npos ? pos + uPos : npos;
+            }
+        }
+
+        for (auto i = pos; i < len; ++i) if (E::find (s, count, str[i])) return i;
+
+        return npos;
+    }
+
+    //! the first n characters only, the sign of the first difference
+    constexpr static int compare_n (const_pointer lh, const_pointer rh, size_type n) noexcept
+    {
+        if constexpr (is_bytes_v)
+        {
+            if !consteval
+            {
+                return simd::compare_bytes (lh, rh, n);
+            }
+        }
+
+        return E::compare (lh, rh, n);
+    }
+
+    constexpr static int compare (const_pointer lh, size_type lh_len,
+                                  const_pointer rh, size_type rh_len) noexcept
+    {
+        auto const nRet = compare_n (lh, rh, std::min (lh_len, rh_len));
+
+        if (nRet) return nRet < 0 ? -1 : 1;
+        return lh_len < rh_len ? -1 : lh_len > rh_len ? 1 : 0;
+    }
+
+    constexpr static bool equal (const_pointer lh, const_pointer rh, size_type n) noexcept
+    { return !compare_n (lh, rh, n); }
+};
+
+// ====================================================
+
 /**
  ** @brief cow_string (fast string) is a string implementation with locale traits and
  ** small string optimization (SSO) for better performance with small strings.
  ** for SSO it allocates memory on the stack. for char & char8_t -> 15 chars,
  ** for char16_t -> 7 chars and for char32_t -> 3 chars.
  ** the last character is always '\0'.
+ ** longer strings live in a heap block with an atomic reference count in front
+ ** of the characters. copies share the block & the first mutation of a shared
+ ** block copies it (copy-on-write). non-const element access & iterators hand out
+ ** references, so such a block is never shared again.
  ** It can be used as a drop-in replacement for std::string_view
  **/
 template <symbolic_char T, structure E, allocator_or_void A>
@@ -128,10 +252,32 @@ public:
     typedef cow_string<value_type, locale_type, void> string_view           ;
     typedef string                                    std_string            ;
     typedef std::basic_string_view<value_type>        std_string_view       ;
+    typedef string_ops<value_type, locale_type>       ops_type              ;
 
     inline constexpr static const_size npos = size_type (-1);
     inline constexpr static cbool  is_cow_v = are_same<A, void>;
 
+    //! where the characters live
+    enum class storage : u8
+    {
+        //! small strings inside the object
+        stack   ,
+        //! heap block shared by the copies
+        shared  ,
+        //! heap block that handed out references & is not shared anymore
+        owned   ,
+        //! characters that are not owned (copy = false), copied by the first mutation
+        borrowed
+    };
+
+    //! the header in front of the characters of every heap block
+    struct shared_block
+    {
+        std::atomic<size_type> refs;
+    };
+
+    typedef alloc_traits::template rebind_alloc<shared_block> block_allocator;
+
     union buffer
     {
         typedef buffer self_type;
@@ -202,72 +348,39 @@ public:
 
     consteval cow_string () noexcept = default;
 
+    //! borrows the characters, the first mutation copies them
     constexpr cow_string (const_pointer pText, const_size len = npos) noexcept
     : allocator_type ()
-    , _M_uLength     (len == npos ? size (pText) : len)
-    , _M_gBuffer     (pText, _M_uLength)
+    , _M_gBuffer     (pText, len == npos ? size (pText) : len)
+    , _M_uLength     (_M_gBuffer.heap.capacity)
+    , _M_eStorage    (storage::borrowed)
     { }
 
     constexpr cow_string (allocator_type const& ator) noexcept
     : allocator_type (ator)
-    , _M_uLength     (    )
-    , _M_gBuffer     (    )
     { }
 
     constexpr cow_string (string_view const& sv, bool copy = !is_cow_v) noexcept
     : allocator_type ()
-    , _M_uLength (sv.length ())
-    , _M_gBuffer (copy ? is_on_stack () ? buffer () : buffer (length ()) : buffer (sv.data (), length ()))
     {
-        if (!copy) return;
-
-        if (is_on_stack ())
-        {
-            std::copy (sv.begin (), sv.end (), _M_gBuffer.stack.data);
-            *(_M_gBuffer.stack.data + length ()) = value_type ();
-        }
-        else
-        {
-            copy_to_string (*this, sv.data (), length ());
-        }
+        if (copy) init_copy (sv.data (), sv.length ());
+        else      borrow    (sv.data (), sv.length ());
     }
 
     constexpr cow_string (std_string const& str, bool copy = !is_cow_v) noexcept
     : allocator_type ()
-    , _M_uLength (str.length ())
-    , _M_gBuffer (copy ? is_on_stack () ? buffer () : buffer (length ()) : buffer (str.data (), length ()))
     {
-        if (!copy) return;
-
-        if (is_on_stack ())
-        {
-            std::copy (str.begin (), str.end (), _M_gBuffer.stack.data);
-            *(_M_gBuffer.stack.data + length ()) = value_type ();
-        }
-        else
-        {
-            copy_to_string (*this, str.data (), length ());
-        }
+        if (copy) init_copy (str.data (), str.length ());
+        else      borrow    (str.data (), str.length ());
     }
 
     constexpr explicit cow_string (const_pointer pText,
                                    allocator_type const& ator,
                                    bool copy = !is_cow_v)
     : allocator_type (ator)
-    , _M_uLength     (size (pText))
-    , _M_gBuffer     (copy ? is_on_stack () ? buffer () : buffer (length ()) : buffer (pText, _M_uLength))
     {
-        if (!copy) return;
-
-        if (is_on_stack ())
-        {
-            std::copy (pText, pText + _M_uLength, _M_gBuffer.stack.data);
-            *(_M_gBuffer.stack.data + length ()) = value_type ();
-        }
-        else
-        {
-            copy_to_string (*this, pText, length ());
-        }
+        if (copy) init_copy (pText, size (pText));
+        else      borrow    (pText, size (pText));
     }
 
     template <generic_iterator Iterator>
@@ -275,111 +388,89 @@ public:
                           allocator_type const& ator = allocator_type (),
                           bool copy = !is_cow_v)
     : allocator_type (ator)
-    , _M_gBuffer     (copy ? is_on_stack () ? buffer () : buffer (length ()) : buffer (first, _M_uLength))
-    , _M_uLength     (last - first)
     {
-        if (!copy) return;
-
-        if (is_on_stack ())
-        {
-            std::copy (first, last, _M_gBuffer.stack.data);
-            *(_M_gBuffer.stack.data + length ()) = value_type ();
-        }
-        else
+        if constexpr (std::is_convertible_v<Iterator, const_pointer>)
         {
-            copy_to_string (*this, first, length ());
+            if (!copy)
+            {
+                borrow (first, static_cast<size_type> (last - first));
+                return;
+            }
         }
+
+        init_copy (first, static_cast<size_type> (last - first));
     }
 
     constexpr cow_string (std::initializer_list<value_type> list,
                           allocator_type const& ator = allocator_type ())
     : allocator_type (ator)
-    , _M_gBuffer     ()
-    , _M_uLength     (list.size ())
     {
-        if (is_on_stack ())
-        {
-            std::copy (list.begin (), list.end (), _M_gBuffer.stack.data);
-            *(_M_gBuffer.stack.data + length ()) = value_type ();
-        }
-        else
-        {
-            copy_to_string (*this, list.begin (), length ());
-        }
+        init_copy (list.begin (), list.size ());
     }
 
+    //! O(1) for heap & borrowed characters, only the reference count is raised
     constexpr cow_string (self_type const& rh)
     : allocator_type (rh.select_on_container_copy_construction ())
-    , _M_gBuffer     (!is_cow_v ? rh.is_on_stack () ? buffer () : buffer (rh.length ()) :
-                                                      buffer (rh.data (), _M_uLength))
-    , _M_uLength     (rh.length ())
     {
-        if (is_on_stack ())
-        {
-            std::copy (rh.begin (), rh.end (), _M_gBuffer.stack.data);
-            *(_M_gBuffer.stack.data + length ()) = value_type ();
-        }
-        else
-        {
-            copy_to_string (*this, rh.begin (), length ());
-        }
+        share (rh);
     }
 
     constexpr cow_string (self_type&& rh) noexcept
-    : allocator_type (rh           )
-    , _M_gBuffer     (rh._M_gBuffer)
-    , _M_uLength     (rh._M_uLength)
+    : allocator_type (rh            )
+    , _M_gBuffer     (rh._M_gBuffer )
+    , _M_uLength     (rh._M_uLength )
+    , _M_eStorage    (rh._M_eStorage)
     {
-        rh._M_uLength = size_type ();
-        rh._M_gBuffer = buffer    ();
+        rh.reset ();
     }
 
     constexpr cow_string (size_type uCapacity, allocator_type const& ator = allocator_type ())
     : allocator_type (ator)
-    , _M_gBuffer     (uCapacity > buffer::sso_capacity ?
-                      buffer (allocator_type::allocate (uCapacity + 1),
-                              data () ? uCapacity : size_type ()) :
-                      buffer ())
-    , _M_uLength     ()
-    { }
+    {
+        if (uCapacity > buffer::sso_capacity) install (make_block (uCapacity), uCapacity);
+    }
 
     constexpr ~cow_string ()
     {
-        if (!is_on_stack () && size () > buffer::sso_capacity && !is_cow_v)
-            allocator_type::deallocate (data (), capacity () + 1);
+        release ();
     }
 
     inline self_type& operator = (self_type&& rh) noexcept
     {
         if (this == &rh) return *this;
 
-        if (is_cow_v)
+        if constexpr (!alloc_traits::propagate_on_container_move_assignment::value)
         {
-            _M_gBuffer = buffer (rh.data (), rh.length ());
-            return *this;
+            //! the block would be released through the wrong allocator
+            if (!(get_allocator () == rh.get_allocator ()))
+                return assign_to_string (*this, rh.data (), rh.length ());
         }
 
-        if (!is_on_stack () && length () > buffer::sso_capacity)
-            allocator_type::deallocate (data (), capacity () + 1);
+        release ();
+
+        if constexpr (alloc_traits::propagate_on_container_move_assignment::value)
+            static_cast<allocator_type&> (*this) = static_cast<allocator_type&> (rh);
 
-        _M_uLength = rh._M_uLength;
-        _M_gBuffer = rh._M_gBuffer;
+        _M_gBuffer  = rh._M_gBuffer ;
+        _M_uLength  = rh._M_uLength ;
+        _M_eStorage = rh._M_eStorage;
 
-        rh = self_type ();
+        rh.reset ();
         return *this;
     }
 
-    constexpr self_type& operator = (self_type const& rh) noexcept
+    constexpr self_type& operator = (self_type const& rh)
     {
         if (this == &rh) return *this;
 
-        if (is_cow_v)
-        {
-            _M_gBuffer = buffer (rh.data (), rh.size ());
-            return *this;
-        }
+        release ();
+        reset   ();
 
-        return assign_to_string (*this, rh.data (), rh.size ());
+        if constexpr (alloc_traits::propagate_on_container_copy_assignment::value)
+            static_cast<allocator_type&> (*this) = static_cast<allocator_type const&> (rh);
+
+        share (rh);
+        return *this;
     }
 
     constexpr self_type& operator = (std_string const& rh) noexcept
@@ -397,12 +488,6 @@ public:
 
     constexpr self_type& operator = (const_pointer pText) noexcept
     {
-        if (is_cow_v)
-        {
-            _M_gBuffer = buffer (pText, size (pText));
-            return *this;
-        }
-
         return assign_to_string (*this, pText, size (pText));
     }
 
@@ -424,12 +509,12 @@ public:
      */
     constexpr operator std_string () const noexcept
     {
-        return std_string (_M_gBuffer.heap.c_str, length ());
+        return std_string (data (), length ());
     }
 
     constexpr operator std_string_view () const noexcept
     {
-        return std_string_view (_M_gBuffer.heap.c_str, length ());
+        return std_string_view (data (), length ());
     }
 
     /**
@@ -438,12 +523,12 @@ public:
      **/
     constexpr std_string str () const noexcept
     {
-        return std_string (_M_gBuffer.heap.c_str, length ());
+        return std_string (data (), length ());
     }
 
     constexpr string_view view () const noexcept
     {
-        return string_view (_M_gBuffer.heap.c_str, length ());
+        return string_view (data (), length ());
     }
 
     self_type& assign (self_type const& str);
@@ -485,10 +570,23 @@ public:
     void      clear       () noexcept;
 
     template <str_view_like U>
-    size_type  find (U const& sv, size_type pos = 0, size_type count = 0) const;
-    size_type  find (self_type const& str, size_type pos = 0, size_type count = 0) const;
-    size_type  find (value_type const& str, size_type pos = 0, size_type count = 0) const;
-    size_type  find (value_type ch, size_type pos = 0) const;
+    constexpr size_type find (U const& sv, size_type pos = 0) const noexcept
+    { return ops_type::find (data (), length (), sv.data (), sv.size (), pos); }
+
+    constexpr size_type find (self_type const& str, size_type pos = 0) const noexcept
+    { return ops_type::find (data (), length (), str.data (), str.length (), pos); }
+
+    constexpr size_type find (string_view const& str, size_type pos = 0) const noexcept
+    { return ops_type::find (data (), length (), str.data (), str.length (), pos); }
+
+    constexpr size_type find (const_pointer str, size_type pos, size_type count) const noexcept
+    { return ops_type::find (data (), length (), str, count, pos); }
+
+    constexpr size_type find (const_pointer str, size_type pos = 0) const noexcept
+    { return ops_type::find (data (), length (), str, locale_type::length (str), pos); }
+
+    constexpr size_type find (value_type ch, size_type pos = 0) const noexcept
+    { return ops_type::find (data (), length (), ch, pos); }
 
     template <str_view_like U>
     size_type rfind (U const& sv, size_type pos = npos, size_type count = 0) const;
@@ -497,23 +595,51 @@ public:
     size_type rfind (value_type ch, size_type pos = npos) const;
 
     template <str_view_like U>
-    constexpr int compare (U const& sv) const noexcept;
+    constexpr int compare (U const& sv) const noexcept
+    { return ops_type::compare (data (), length (), sv.data (), sv.size ()); }
+
+    constexpr int compare (self_type const& str) const noexcept
+    { return ops_type::compare (data (), length (), str.data (), str.length ()); }
+
+    constexpr int compare (string_view const& str) const noexcept
+    { return ops_type::compare (data (), length (), str.data (), str.length ()); }
 
     template <str_view_like U>
-    constexpr int compare (size_type pos1, size_type count1, U const& sv) const;
+    constexpr int compare (size_type pos1, size_type count1, U const& sv) const
+    { return compare (pos1, count1, sv.data (), sv.size ()); }
 
     template <str_view_like U>
     constexpr int compare (size_type pos1, size_type count1, U const& sv,
-                           size_type pos2, size_type count2 ) const;
-    constexpr int compare (const_pointer str) const;
-    constexpr int compare (size_type pos1, size_type count1, const_pointer str) const;
-    constexpr int compare (size_type pos1, size_type count1, const_pointer str, size_type count2) const;
+                           size_type pos2, size_type count2 ) const
+    {
+        if (pos2 > sv.size ()) throw std::out_of_range ("compare position out of range!");
+        return compare (pos1, count1, sv.data () + pos2, std::min (count2, sv.size () - pos2));
+    }
+
+    constexpr int compare (const_pointer str) const
+    { return ops_type::compare (data (), length (), str, locale_type::length (str)); }
+
+    constexpr int compare (size_type pos1, size_type count1, const_pointer str) const
+    { return compare (pos1, count1, str, locale_type::length (str)); }
+
+    constexpr int compare (size_type pos1, size_type count1, const_pointer str, size_type count2) const
+    {
+        if (pos1 > length ()) throw std::out_of_range ("compare position out of range!");
+        return ops_type::compare (data () + pos1, std::min (count1, length () - pos1), str, count2);
+    }
 
     template <str_view_like U>
-    constexpr size_type find_first_of (U const& sv, size_type pos = 0) const noexcept;
-    constexpr size_type find_first_of (value_type ch, size_type pos = 0) const noexcept;
-    constexpr size_type find_first_of (const_pointer s, size_type pos, size_type count) const;
-    constexpr size_type find_first_of (const_pointer s, size_type pos = 0 ) const;
+    constexpr size_type find_first_of (U const& sv, size_type pos = 0) const noexcept
+    { return ops_type::find_first_of (data (), length (), sv.data (), sv.size (), pos); }
+
+    constexpr size_type find_first_of (value_type ch, size_type pos = 0) const noexcept
+    { return ops_type::find (data (), length (), ch, pos); }
+
+    constexpr size_type find_first_of (const_pointer s, size_type pos, size_type count) const
+    { return ops_type::find_first_of (data (), length (), s, count, pos); }
+
+    constexpr size_type find_first_of (const_pointer s, size_type pos = 0 ) const
+    { return ops_type::find_first_of (data (), length (), s, locale_type::length (s), pos); }
 
     template <str_view_like U>
     constexpr size_type find_first_not_of (U const& sv, size_type pos = 0) const noexcept;
@@ -533,13 +659,22 @@ public:
     constexpr size_type find_last_not_of (const_pointer s, size_type pos, size_type count) const;
     constexpr size_type find_last_not_of (const_pointer s, size_type pos = npos) const;
 
-    inline    const_pointer  data          () const noexcept { return  _M_gBuffer.heap.c_str; }
     constexpr const_pointer  c_str         () const noexcept { return  data ()              ; }
     constexpr size_type      length        () const noexcept { return  _M_uLength           ; }
     constexpr size_type      size          () const noexcept { return  length ()            ; }
     constexpr bool           empty         () const noexcept { return !length ()            ; }
     constexpr allocator_type get_allocator () const noexcept { return *this                 ; }
 
+    inline const_pointer data () const noexcept
+    { return is_on_stack () ? _M_gBuffer.stack.data : _M_gBuffer.heap.c_str; }
+
+    //! how many strings share the characters, 0 for borrowed ones
+    inline size_type use_count () const noexcept
+    {
+        return _M_eStorage == storage::shared   ? block (data ())->refs.load (std::memory_order_acquire) :
+               _M_eStorage == storage::borrowed ? size_type () : size_type (1);
+    }
+
     constexpr static size_type size (const_pointer str) noexcept
     { return locale_type::length (str); }
 
@@ -608,90 +743,85 @@ public:
     constexpr const_reverse_iterator crend () const noexcept
     {  return const_reverse_iterator (*this, npos); }
 
-    constexpr reference front () noexcept
-    { return *_M_gBuffer.heap.c_str; }
+    constexpr reference front ()
+    { return *unshare (); }
 
     constexpr const_reference front () const noexcept
-    { return *_M_gBuffer.heap.c_str; }
+    { return *data (); }
 
-    constexpr reference back () noexcept
-    { return *(_M_gBuffer.heap.c_str + (length () - 1)); }
+    constexpr reference back ()
+    { return *(unshare () + (length () - 1)); }
 
     constexpr const_reference back () const noexcept
-    { return *(_M_gBuffer.heap.c_str + (length () - 1)); }
+    { return *(data () + (length () - 1)); }
 
-    constexpr reference at (size_type uPos) noexcept
+    constexpr reference at (size_type uPos)
     {
         assert  (uPos < size () && "pos out of range (equal or larger than the size)!");
-        return *(_M_gBuffer.heap.c_str + uPos);
+        return *(unshare () + uPos);
     }
 
     constexpr const_reference at (size_type uPos) const noexcept
     {
         assert  (uPos < length () && "pos out of range (equal or larger than the size)!");
-        return *(_M_gBuffer.heap.c_str + uPos);
+        return *(data () + uPos);
     }
 
-    constexpr reference operator [] (size_type uPos) noexcept
-    { return *(_M_gBuffer.heap.c_str + uPos); }
+    constexpr reference operator [] (size_type uPos)
+    { return *(unshare () + uPos); }
 
     constexpr const_reference operator [] (size_type uPos) const noexcept
-    { return *(_M_gBuffer.heap.c_str + uPos); }
+    { return *(data () + uPos); }
 
-    constexpr void pop_back () noexcept
+    constexpr void pop_back ()
     {
-        back () = value_type ();
-        --_M_uLength;
+        make_unique (length ());
+        storage_data ()[--_M_uLength] = value_type ();
     }
 
     constexpr void reserve (size_type new_cap)
     {
-        if (new_cap <= capacity ()) return;
-
-        pointer pNewData = allocator_type::allocate (new_cap + 1);
-
-        std::copy (begin (), end (), pNewData);
-        if (!is_on_stack ()) allocator_type::deallocate (data (), capacity () + 1);
-
-        _M_gBuffer.heap.c_str    = pNewData;
-        _M_gBuffer.heap.capacity = new_cap ;
+        if (new_cap > capacity ()) reallocate (new_cap);
     }
 
+    //! a block shared with other strings stays as it is
     constexpr void shrink_to_fit ()
     {
-        if (is_on_stack () || full ()) return;
-
-        const_size new_cap = size ();
-        pointer   pNewData = allocator_type::allocate (new_cap + 1);
-
-        std::copy (begin (), end (), pNewData);
-        allocator_type::deallocate (data (), capacity () + 1);
+        if (is_on_stack () || full () || !is_unique (length ())) return;
 
-        _M_gBuffer.heap.c_str    = pNewData;
-        _M_gBuffer.heap.capacity = _M_uLength = new_cap;
+        reallocate (length ());
     }
 
     constexpr void erase () noexcept
     {
-        if (!_M_uLength || !_M_gBuffer.heap.data) return;
-        _M_gBuffer.heap.c_str[0] = value_type ();
-        _M_uLength               = size_type  ();
+        if (!_M_uLength) return;
+
+        if (is_unique (size_type ()))
+        {
+            storage_data ()[0] = value_type ();
+            _M_uLength         = size_type  ();
+        }
+        else
+        {
+            release ();
+            reset   ();
+        }
     }
 
     template <symbolic_char U, structure _E, allocator_like _A, generic_iterator Iterator>
     friend cow_string<U, _E, _A>& copy_to_string (cow_string<U, _E, _A>& copy_to,
                                                   Iterator            copy_from,
-                                                  size_type           length);
+                                                  typename cow_string<U, _E, _A>::size_type length);
 
     template <symbolic_char U, structure _E, allocator_like _A, generic_iterator Iterator>
     friend cow_string<U, _E, _A>& assign_to_string (cow_string<U, _E, _A>& assign_to,
                                                     Iterator            assign_from,
-                                                    size_type           length);
+                                                    typename cow_string<U, _E, _A>::size_type length);
 
     template <symbolic_char U, structure _E, allocator_like _A, generic_iterator Iterator>
     friend cow_string<U, _E, _A>& add_to_string (cow_string<U, _E, _A>& add_to,
                                                  Iterator            add_from,
-                                                 size_type           add_length);
+                                                 typename cow_string<U, _E, _A>::size_type add_length);
 
     template <symbolic_char U, structure _E, allocator_or_void _A>
     friend constexpr cow_string<U, _E> operator + (cow_string<U, _E, _A> const& obj1,
@@ -715,11 +845,144 @@ public:
 
 protected:
     constexpr bool is_on_stack () const noexcept
-    { return _M_uLength <= buffer::sso_capacity; }
+    { return _M_eStorage == storage::stack; }
+
+private:
+    //! whole headers, the characters start right after the first one
+    constexpr static size_type block_count (size_type uCapacity) noexcept
+    { return 1 + ((uCapacity + 1) * sizeof (value_type) + sizeof (shared_block) - 1) / sizeof (shared_block); }
+
+    inline static shared_block* block (const_pointer pData) noexcept
+    { return reinterpret_cast<shared_block*> (const_cast<pointer> (pData)) - 1; }
+
+    //! a heap block referenced once, holding an empty string
+    inline pointer make_block (size_type uCapacity)
+    {
+        auto const pBlock = block_allocator (get_allocator ()).allocate (block_count (uCapacity));
+        auto const pData  = reinterpret_cast<pointer> (::new (pBlock) shared_block { 1 } + 1);
+
+        *pData = value_type ();
+        return pData;
+    }
+
+    inline void release_block (const_pointer pData, size_type uCapacity, storage eStorage) noexcept
+    {
+        if (eStorage == storage::owned ||
+           (eStorage == storage::shared &&
+            block (pData)->refs.fetch_sub (1, std::memory_order_acq_rel) == 1))
+            block_allocator (get_allocator ()).deallocate (block (pData), block_count (uCapacity));
+    }
+
+    constexpr void release () noexcept
+    {
+        if (!is_on_stack ()) release_block (_M_gBuffer.heap.c_str, _M_gBuffer.heap.capacity, _M_eStorage);
+    }
+
+    constexpr void reset () noexcept
+    {
+        _M_gBuffer  = buffer    ();
+        _M_uLength  = size_type ();
+        _M_eStorage = storage::stack;
+    }
+
+    constexpr void install (pointer pData, size_type uCapacity) noexcept
+    {
+        _M_gBuffer  = buffer (pData, uCapacity);
+        _M_eStorage = storage::shared;
+    }
+
+    constexpr void borrow (const_pointer pText, size_type uLength) noexcept
+    {
+        _M_gBuffer  = buffer (pText, uLength);
+        _M_uLength  = uLength;
+        _M_eStorage = storage::borrowed;
+    }
+
+    constexpr pointer storage_data () noexcept
+    { return is_on_stack () ? _M_gBuffer.stack.data : _M_gBuffer.heap.c_str; }
+
+    //! fills an empty string
+    template <typename Iterator>
+    constexpr void init_copy (Iterator pText, size_type uLength)
+    {
+        if (uLength > buffer::sso_capacity) install (make_block (uLength), uLength);
+
+        auto const pData = storage_data ();
+
+        std::copy_n (pText, uLength, pData);
+        pData[uLength] = value_type ();
+        _M_uLength     = uLength;
+    }
+
+    //! O(1) for shared & borrowed characters of an equal allocator
+    constexpr void share (self_type const& rh)
+    {
+        if (rh._M_eStorage == storage::borrowed ||
+           (rh._M_eStorage == storage::shared && get_allocator () == rh.get_allocator ()))
+        {
+            if (rh._M_eStorage == storage::shared)
+                block (rh.data ())->refs.fetch_add (1, std::memory_order_relaxed);
+
+            _M_gBuffer  = rh._M_gBuffer ;
+            _M_uLength  = rh._M_uLength ;
+            _M_eStorage = rh._M_eStorage;
+        }
+        else
+        {
+            init_copy (rh.data (), rh.length ());
+        }
+    }
+
+    //! the characters can be written in place & fit in the capacity
+    constexpr bool is_unique (size_type uCapacity) const noexcept
+    {
+        switch (_M_eStorage)
+        {
+        case storage::stack : return uCapacity <= buffer::sso_capacity;
+        case storage::owned : return uCapacity <= _M_gBuffer.heap.capacity;
+        case storage::shared: return uCapacity <= _M_gBuffer.heap.capacity &&
+                                     block (data ())->refs.load (std::memory_order_acquire) == 1;
+        default             : return false;
+        }
+    }
+
+    //! moves the characters to a buffer of their own
+    constexpr void reallocate (size_type uCapacity)
+    {
+        auto const pOld     = data ();
+        auto const uOldCap  = _M_gBuffer.heap.capacity;
+        auto const eOld     = _M_eStorage;
+        auto const bHeap    = uCapacity > buffer::sso_capacity;
+        auto const pData    = bHeap ? make_block (uCapacity) : _M_gBuffer.stack.data;
+
+        std::copy_n (pOld, length (), pData);
+        pData[length ()] = value_type ();
+
+        if (bHeap) install (pData, uCapacity);
+        else       _M_eStorage = storage::stack;
+
+        if (eOld != storage::stack) release_block (pOld, uOldCap, eOld);
+    }
+
+    //! detaches from the other strings when the characters are shared
+    constexpr void make_unique (size_type uCapacity)
+    {
+        if (!is_unique (uCapacity)) reallocate (std::max (uCapacity, length ()));
+    }
+
+    //! references to the characters are handed out -> the block is never shared again
+    constexpr pointer unshare ()
+    {
+        make_unique (length ());
+
+        if (_M_eStorage == storage::shared) _M_eStorage = storage::owned;
+        return storage_data ();
+    }
 
 private:
-    buffer    _M_gBuffer { };
-    size_type _M_uLength { };
+    buffer    _M_gBuffer  { };
+    size_type _M_uLength  { };
+    storage   _M_eStorage { };
 };
 
 // ====================================================
@@ -745,6 +1008,7 @@ public:
     typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
     typedef cow_string<value_type, locale_type>   string_type           ;
     typedef std::basic_string_view<value_type>    std_string_view       ;
+    typedef string_ops<value_type, locale_type>   ops_type              ;
 
     typedef std::basic_string<value_type, std::char_traits<value_type>, memory::allocator<value_type>>
     std_string;
@@ -823,11 +1087,20 @@ public:
     size_type copy        (pointer dest, size_type count, size_type pos = size_type ()) const;
 
     template <str_view_like U>
-    size_type  find (U const& sv, size_type pos = 0, size_type count = 0) const;
-    size_type  find (self_type const& str, size_type pos = 0, size_type count = 0) const;
-    size_type  find (value_type const& str, size_type pos = 0, size_type count = 0) const;
-    size_type  find (value_type ch, size_type pos = 0) const;
-    size_type  find (const_pointer str, size_type pos = 0) const;
+    constexpr size_type find (U const& sv, size_type pos = 0) const noexcept
+    { return ops_type::find (data (), length (), sv.data (), sv.size (), pos); }
+
+    constexpr size_type find (self_type const& str, size_type pos = 0) const noexcept
+    { return ops_type::find (data (), length (), str.data (), str.length (), pos); }
+
+    constexpr size_type find (const_pointer str, size_type pos, size_type count) const noexcept
+    { return ops_type::find (data (), length (), str, count, pos); }
+
+    constexpr size_type find (const_pointer str, size_type pos = 0) const noexcept
+    { return ops_type::find (data (), length (), str, locale_type::length (str), pos); }
+
+    constexpr size_type find (value_type ch, size_type pos = 0) const noexcept
+    { return ops_type::find (data (), length (), ch, pos); }
 
     template <str_view_like U>
     size_type rfind (U const& sv, size_type pos = npos, size_type count = 0) const;
@@ -837,23 +1110,48 @@ public:
     size_type rfind (const_pointer str, size_type pos = npos) const;
 
     template <str_view_like U>
-    constexpr int compare (U const& sv) const noexcept;
+    constexpr int compare (U const& sv) const noexcept
+    { return ops_type::compare (data (), length (), sv.data (), sv.size ()); }
+
+    constexpr int compare (self_type const& str) const noexcept
+    { return ops_type::compare (data (), length (), str.data (), str.length ()); }
 
     template <str_view_like U>
-    constexpr int compare (size_type pos1, size_type count1, U const& sv) const;
+    constexpr int compare (size_type pos1, size_type count1, U const& sv) const
+    { return compare (pos1, count1, sv.data (), sv.size ()); }
 
     template <str_view_like U>
     constexpr int compare (size_type pos1, size_type count1, U const& sv,
-                           size_type pos2, size_type count2 ) const;
-    constexpr int compare (const_pointer str) const;
-    constexpr int compare (size_type pos1, size_type count1,  const_pointer str) const;
-    constexpr int compare (size_type pos1, size_type count1, const_pointer str, size_type count2) const;
+                           size_type pos2, size_type count2 ) const
+    {
+        if (pos2 > sv.size ()) throw std::out_of_range ("compare position out of range!");
+        return compare (pos1, count1, sv.data () + pos2, std::min (count2, sv.size () - pos2));
+    }
+
+    constexpr int compare (const_pointer str) const
+    { return ops_type::compare (data (), length (), str, locale_type::length (str)); }
+
+    constexpr int compare (size_type pos1, size_type count1, const_pointer str) const
+    { return compare (pos1, count1, str, locale_type::length (str)); }
+
+    constexpr int compare (size_type pos1, size_type count1, const_pointer str, size_type count2) const
+    {
+        if (pos1 > length ()) throw std::out_of_range ("compare position out of range!");
+        return ops_type::compare (data () + pos1, std::min (count1, length () - pos1), str, count2);
+    }
 
     template <str_view_like U>
-    constexpr size_type find_first_of (U const& sv, size_type pos = 0) const noexcept;
-    constexpr size_type find_first_of (value_type ch, size_type pos = 0) const noexcept;
-    constexpr size_type find_first_of (const_pointer s, size_type pos, size_type count) const;
-    constexpr size_type find_first_of (const_pointer s, size_type pos = 0 ) const;
+    constexpr size_type find_first_of (U const& sv, size_type pos = 0) const noexcept
+    { return ops_type::find_first_of (data (), length (), sv.data (), sv.size (), pos); }
+
+    constexpr size_type find_first_of (value_type ch, size_type pos = 0) const noexcept
+    { return ops_type::find (data (), length (), ch, pos); }
+
+    constexpr size_type find_first_of (const_pointer s, size_type pos, size_type count) const
+    { return ops_type::find_first_of (data (), length (), s, count, pos); }
+
+    constexpr size_type find_first_of (const_pointer s, size_type pos = 0 ) const
+    { return ops_type::find_first_of (data (), length (), s, locale_type::length (s), pos); }
 
     template <str_view_like U>
     constexpr size_type find_first_not_of (U const& sv, size_type pos = 0) const noexcept;
@@ -998,21 +1296,11 @@ public:
 template <symbolic_char T, structure E, allocator_or_void A>
 cow_string<T, E, A> cow_string<T, E, A>::substr (size_type uBeginPos, size_type uEndPos)
 {
-    if (empty () || static_cast<difference_type> (uEndPos - uBeginPos) <= 0 || uBeginPos >= length ())
-        return self_type ();
+    uEndPos = std::min (uEndPos, length ());
 
-    self_type gSubStr (uEndPos - uBeginPos);
-    //size_type i = 0;
+    if (uBeginPos >= uEndPos) return self_type (get_allocator ());
 
-    std::copy (begin () + uBeginPos,
-               begin () + uBeginPos + gSubStr.capacity (), gSubStr.begin ());
-
-    //while (uBeginPos <= uEndPos && i < _M_uLength)
-    //    gSubStr._M_gBuffer.heap.data[i++] = _M_gBuffer.heap.data[uBeginPos++];
-
-    *gSubStr.end () = value_type ();
-
-    return std::move (gSubStr);
+    return self_type (data () + uBeginPos, data () + uEndPos, get_allocator ());
 }
 
 // ====================================================
@@ -1022,29 +1310,7 @@ cow_string<T, E, A>& copy_to_string (cow_string<T, E, A>&                    rh,
                                      Iterator                                pFromText,
                                      typename cow_string<T, E, A>::size_type uLength)
 {
-    if (!pFromText) return rh;
-
-    if (uLength > rh.capacity ())
-    {
-        if (!rh.is_on_stack () && !rh.is_cow_v)
-             rh.deallocate (rh.data (), rh.capacity () + 1);
-
-        if (!(rh._M_gBuffer.heap.c_str = rh.allocate (uLength + 1)))
-        {
-            rh._M_uLength    = 0;
-            rh._M_gBuffer.stack.data[0] = typename cow_string<T, E, A>::value_type ();
-            return rh;
-        }
-
-        rh._M_gBuffer.heap.capacity = uLength;
-    }
-
-    std::copy (pFromText, pFromText + uLength, rh._M_gBuffer.heap.c_str);
-    rh._M_uLength = uLength;
-    //rh._M_gBuffer.heap.is_copied = true;
-
-    rh._M_gBuffer.heap.c_str[uLength] = typename cow_string<T, E, A>::value_type ();
-    return rh;
+    return assign_to_string (rh, pFromText, uLength);
 }
 
 // ====================================================
@@ -1056,52 +1322,59 @@ cow_string<T, E, A>& assign_to_string (cow_string<T, E, A>&                    r
 {
     if (!pFromText) return rh;
 
-    if (uLength > rh.capacity ())
+    //! the old characters may be the source, they are released after the copy
+    if (!rh.is_unique (uLength))
     {
-        if (!rh.is_cow_v) rh.deallocate (rh.data (), rh.capacity () + 1);
+        cow_string<T, E, A> gStr (rh.get_allocator ());
 
-        if (!(rh._M_gBuffer.heap.c_str = rh.allocate (uLength + 1)))
-        {
-            rh._M_uLength    = 0;
-            rh._M_gBuffer.stack.data[0] = typename cow_string<T, E, A>::value_type ();
-            return rh;
-        }
+        gStr.init_copy (pFromText, uLength);
+        swap (rh, gStr);
 
-        rh._M_gBuffer.heap.capacity = uLength;
+        return rh;
     }
 
-    std::copy (pFromText, pFromText + uLength, rh._M_gBuffer.heap.c_str);
-    rh._M_uLength = uLength;
+    auto const pData = rh.storage_data ();
+
+    std::copy (pFromText, pFromText + uLength, pData);
+    pData[uLength] = typename cow_string<T, E, A>::value_type ();
+    rh._M_uLength  = uLength;
 
-    rh._M_gBuffer.heap.c_str[uLength] = typename cow_string<T, E, A>::value_type ();
     return rh;
 }
 
 // ====================================================
 
 template <symbolic_char T, structure E, allocator_like A, generic_iterator Iterator>
-cow_string<T, E, A>& add_to_string (cow_string<T, E, A>& rh,
-                                    Iterator const       pFromText,
-                                    std::size_t          uAddLength)
+cow_string<T, E, A>& add_to_string (cow_string<T, E, A>&                    rh,
+                                    Iterator const                          pFromText,
+                                    typename cow_string<T, E, A>::size_type uAddLength)
 {
     auto const uLength = rh.size () + uAddLength;
 
-    if (uLength > rh.capacity ())
+    //! the old characters may be the source, they are released after the copy
+    if (!rh.is_unique (uLength))
     {
-        auto const pOldBuffer   = rh.data     ();
-        auto const uOldCapacity = rh.capacity ();
+        cow_string<T, E, A> gStr (std::max (uLength, rh.capacity () * 2), rh.get_allocator ());
+
+        auto const pData = gStr.storage_data ();
 
-        if (!(rh._M_gBuffer.heap.c_str = rh.allocate (uLength + 1))) return rh;
+        std::copy (rh.data (), rh.data () + rh.size (), pData);
+        std::copy (pFromText, pFromText + uAddLength, pData + rh.size ());
 
-        std::copy (pOldBuffer, pOldBuffer + rh.length (), &rh[0]);
+        pData[uLength]  = typename cow_string<T, E, A>::value_type ();
+        gStr._M_uLength = uLength;
 
-        rh._M_gBuffer.heap.capacity = uLength;
-        if (!rh.is_cow_v) rh.deallocate (pOldBuffer, uOldCapacity + 1);
+        swap (rh, gStr);
+        return rh;
     }
 
-    std::copy (pFromText, pFromText + ++uAddLength, &rh[0] + rh.size ());
+    auto const pData = rh.storage_data ();
+
+    std::copy (pFromText, pFromText + uAddLength, pData + rh.size ());
+
+    pData[uLength] = typename cow_string<T, E, A>::value_type ();
+    rh._M_uLength  = uLength;
 
-    rh._M_uLength = uLength;
     return rh;
 }
 
@@ -1146,7 +1419,7 @@ constexpr bool operator == (cow_string<T, E, A> const& lhs, cow_string<T, E, A>
 {
     return lhs.data   () == rhs.data   () ||
           (lhs.length () == rhs.length () &&
-           cow_string<T, E, A>::locale_type::compare (lhs.data (), rhs.data (), lhs.length ()) == 0);
+           cow_string<T, E, A>::ops_type::equal (lhs.data (), rhs.data (), lhs.length ()));
 }
 
 template <symbolic_char T, structure E, allocator_or_void A>
@@ -1212,7 +1485,7 @@ constexpr cow_string<T, E, A2>& operator += (cow_string<T, E, A2>& lhs,
     return add_to_string (lhs, rhs.data (), rhs.length ());
 }
 
-template <symbolic_char T, structure E, allocator_like A>
+template <symbolic_char T, structure E, allocator_or_void A>
 constexpr cow_string<T, E, A>& operator += (cow_string<T, E, A>& lhs, T const* str) noexcept
 {
     return add_to_string (lhs, str, str_size (str));
@@ -1251,8 +1524,15 @@ constexpr cow_string<T, E> operator + (T const* str, cow_string<T, E, A> const&
 template <symbolic_char T, structure E, allocator_or_void A>
 constexpr void swap (cow_string<T, E, A>& lhs, cow_string<T, E, A>& rhs) noexcept
 {
-    std::swap (lhs._M_gBuffer, rhs._M_gBuffer);
-    std::swap (lhs._M_uLength, rhs._M_uLength);
+    //! the blocks are released through the allocator that owns them
+    if constexpr (cow_string<T, E, A>::alloc_traits::propagate_on_container_swap::value)
+        std::swap (static_cast<A&> (lhs), static_cast<A&> (rhs));
+    else
+        assert (lhs.get_allocator () == rhs.get_allocator () && "swapping strings with unequal allocators!");
+
+    std::swap (lhs._M_gBuffer , rhs._M_gBuffer );
+    std::swap (lhs._M_uLength , rhs._M_uLength );
+    std::swap (lhs._M_eStorage, rhs._M_eStorage);
 }
 
 // ====================================================
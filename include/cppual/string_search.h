@@ -0,0 +1,87 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPUAL_STRING_SEARCH_H_
+#define CPPUAL_STRING_SEARCH_H_
+#ifdef __cplusplus
+
+#include <cppual/decl>
+#include <cppual/types>
+
+#include <cstddef>
+
+// ====================================================
+
+/**
+ ** vectorized byte string kernels behind the searches & comparisons of
+ ** cow_string with 1 byte characters. the widest instruction set the cpu
+ ** runs (AVX2, SSE2 or plain C) is picked on the first call.
+ ** the searches return npos when nothing is found
+ **/
+namespace cppual::simd {
+
+// ====================================================
+
+enum class isa : u8
+{
+    scalar,
+    sse2  ,
+    avx2
+};
+
+inline constexpr const std::size_t npos = std::size_t (-1);
+
+// ====================================================
+
+//! the widest instruction set of the cpu
+SHARED_API isa supported_isa () noexcept;
+
+//! the instruction set of the kernels in use
+SHARED_API isa active_isa () noexcept;
+
+//! switches the kernels (benchmarks & tests), clamped to the supported set
+SHARED_API void select_isa (isa eIsa) noexcept;
+
+// ====================================================
+
+//! first position of ch
+SHARED_API std::size_t find_byte (void const* pStr, std::size_t uLen, u8 ch) noexcept;
+
+//! first position of the count bytes of s (first/last byte filter)
+SHARED_API std::size_t find_bytes (void const* pStr, std::size_t uLen,
+                                   void const* s   , std::size_t uCount) noexcept;
+
+//! first position of any of the count bytes of the set, up to 16 bytes are
+//! compared a whole vector at a time, larger sets use a 256 bit table
+SHARED_API std::size_t find_any_byte (void const* pStr, std::size_t uLen,
+                                      void const* pSet, std::size_t uCount) noexcept;
+
+//! the sign of the first differing byte (unsigned) as memcmp
+SHARED_API int compare_bytes (void const* pLh, void const* pRh, std::size_t uLen) noexcept;
+
+// ====================================================
+
+} // namespace simd
+
+// ====================================================
+
+#endif // __cplusplus
+#endif // CPPUAL_STRING_SEARCH_H_
@@ -0,0 +1,202 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cppual/memory/adaptor.h>
+
+#include <algorithm>
+#include <cstring>
+
+// =========================================================
+
+namespace cppual::memory {
+
+// =========================================================
+
+memory_resource_adaptor::memory_resource_adaptor () noexcept
+: memory_resource_adaptor (get_default_resource ())
+{ }
+
+memory_resource_adaptor::memory_resource_adaptor (memory_resource& rc) noexcept
+: _M_gOwner   (rc),
+  _M_gArenas  (),
+  _M_uOrder   (),
+  _M_uCount   (),
+  _M_uCurrent ()
+{ }
+
+memory_resource_adaptor::~memory_resource_adaptor ()
+{
+    for (auto i = _M_uCount; i-- > 0; )
+    {
+        auto const& gRange = _M_gArenas[i];
+
+        if (!gRange.owned_size) continue;
+
+        gRange.rc->~memory_resource ();
+
+        _M_gOwner.deallocate (gRange.rc, gRange.owned_size, gRange.owned_align);
+        _M_gOwner.deallocate (gRange.begin,
+                              static_cast<size_type> (gRange.end - gRange.begin),
+                              max_align);
+    }
+}
+
+void memory_resource_adaptor::attach (memory_resource& rc, pointer pBegin, size_type uSize)
+{
+    if (_M_uCount == max_arenas) throw std::length_error ("too many arenas!");
+
+    insert ({ &rc, static_cast<math_pointer> (pBegin),
+              static_cast<math_pointer> (pBegin) + uSize, size_type (), align_type () });
+}
+
+//! append the arena & keep the lookup order sorted by address
+void memory_resource_adaptor::insert (arena_range const& gRange)
+{
+    auto const pOrderEnd = _M_uOrder + _M_uCount;
+
+    auto const pPos = std::upper_bound (_M_uOrder, pOrderEnd, gRange.begin,
+                                        [this](math_pointer pBegin, u8 uIdx)
+    { return pBegin < _M_gArenas[uIdx].begin; });
+
+    if (pPos != _M_uOrder && _M_gArenas[*(pPos - 1)].end > gRange.begin)
+        throw std::invalid_argument ("arena address ranges overlap!");
+
+    if (pPos != pOrderEnd && _M_gArenas[*pPos].begin < gRange.end)
+        throw std::invalid_argument ("arena address ranges overlap!");
+
+    std::copy_backward (pPos, pOrderEnd, pOrderEnd + 1);
+
+    *pPos                  = static_cast<u8> (_M_uCount);
+    _M_gArenas[_M_uCount++] = gRange;
+}
+
+memory_resource* memory_resource_adaptor::find (const_pointer p) const noexcept
+{
+    auto const pBytes = static_cast<math_const_pointer> (p);
+
+    // the arena serving the allocations is the most likely owner
+    if (_M_uCount && _M_gArenas[_M_uCurrent].begin <= pBytes && pBytes < _M_gArenas[_M_uCurrent].end)
+        return _M_gArenas[_M_uCurrent].rc;
+
+    auto uFirst = size_type ();
+    auto uCount = _M_uCount;
+
+    // the last range starting at or before the pointer
+    while (uCount > 0)
+    {
+        auto const uHalf = uCount / 2;
+
+        if (_M_gArenas[_M_uOrder[uFirst + uHalf]].begin <= pBytes)
+        {
+            uFirst += uHalf + 1;
+            uCount -= uHalf + 1;
+        }
+        else
+        {
+            uCount = uHalf;
+        }
+    }
+
+    if (!uFirst) return nullptr;
+
+    auto const& gRange = _M_gArenas[_M_uOrder[uFirst - 1]];
+
+    return pBytes < gRange.end ? gRange.rc : nullptr;
+}
+
+memory_resource::size_type memory_resource_adaptor::max_size () const
+{
+    auto uMaxSize = size_type ();
+
+    for (auto i = 0U; i < _M_uCount; ++i)
+        uMaxSize = std::max (uMaxSize, _M_gArenas[i].rc->max_size ());
+
+    return uMaxSize;
+}
+
+memory_resource::size_type memory_resource_adaptor::capacity () const
+{
+    auto uCapacity = size_type ();
+
+    for (auto i = 0U; i < _M_uCount; ++i) uCapacity += _M_gArenas[i].rc->capacity ();
+
+    return uCapacity;
+}
+
+void* memory_resource_adaptor::do_allocate (size_type uSize, align_type uAlign)
+{
+    // start with the current arena and spill over to the next ones in order
+    for (auto i = 0U; i < _M_uCount; ++i)
+    {
+        auto const uIdx = (_M_uCurrent + i) % _M_uCount;
+
+        try
+        {
+            auto const p = _M_gArenas[uIdx].rc->allocate (uSize, uAlign);
+
+            _M_uCurrent = uIdx;
+            return p;
+        }
+        catch (std::bad_alloc&)
+        { }
+    }
+
+    throw std::bad_alloc ();
+}
+
+void* memory_resource_adaptor::do_reallocate (pointer p, size_type uOldSize, size_type uSize, align_type uAlign)
+{
+    if (!p) return do_allocate (uSize, uAlign);
+
+    auto const pArena = find (p);
+
+    if (!pArena) throw std::out_of_range ("pointer doesn't belong to any arena!");
+
+    // resize within the arena first & move to another one only when it is full
+    try
+    {
+        return pArena->reallocate (p, uOldSize, uSize, uAlign);
+    }
+    catch (std::bad_alloc&)
+    { }
+
+    auto const pNew = do_allocate (uSize, uAlign);
+
+    std::memcpy (pNew, p, std::min (uOldSize, uSize));
+    pArena->deallocate (p, uOldSize, uAlign);
+
+    return pNew;
+}
+
+void memory_resource_adaptor::do_deallocate (pointer p, size_type uSize, align_type uAlign)
+{
+    auto const pArena = find (p);
+
+    if (!pArena) throw std::out_of_range ("pointer doesn't belong to any arena!");
+
+    pArena->deallocate (p, uSize, uAlign);
+}
+
+// =========================================================
+
+} // namespace Memory
+
+// =========================================================
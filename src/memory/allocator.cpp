@@ -196,6 +196,10 @@ memory_resource::base_reference get_default_thread_resource () noexcept
 
 void set_default_resource (memory_resource& res) noexcept
 {
+    //! the thread resource follows the process one unless it was set explicitly
+    if (internal_default_thread_resource () == internal_default_resource ())
+        internal_default_thread_resource () = &res;
+
     internal_default_resource () =  &res ;
     std::pmr::set_default_resource (&res);
 }
@@ -0,0 +1,286 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cppual/memory/caching.h>
+
+#include <algorithm>
+#include <atomic>
+
+// =========================================================
+
+namespace cppual::memory {
+
+// =========================================================
+
+namespace { //! optimize for internal usage - anonymous namespace
+
+//! guards attaching & detaching thread caches to & from their resources
+inline std::mutex& registry_mutex () noexcept
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+} //! anonymous namespace
+
+// =========================================================
+
+struct thread_caching_resource::magazine
+{
+    size_type count ;
+    pointer*  blocks;
+};
+
+struct thread_caching_resource::thread_cache
+{
+    typedef std::atomic<thread_caching_resource*> atomic_owner;
+
+    //! null once the owning resource is destroyed
+    atomic_owner  owner      ;
+    //! siblings in the list of caches attached to the same resource
+    thread_cache* prev       ;
+    thread_cache* next       ;
+    //! next cache owned by the same thread
+    thread_cache* thread_next;
+    size_type     capacity   ;
+    magazine      mags[class_count];
+
+    constexpr static size_type byte_size (size_type uCapacity) noexcept
+    { return sizeof (thread_cache) + class_count * uCapacity * sizeof (pointer); }
+
+    static thread_cache* create (size_type uCapacity)
+    {
+        auto const pCache = static_cast<thread_cache*> (malloc_resource ().allocate (byte_size (uCapacity),
+                                                                                    alignof (thread_cache)));
+        auto const pSlots = reinterpret_cast<pointer*> (pCache + 1);
+
+        new (pCache) thread_cache { { }, { }, { }, { }, uCapacity, { } };
+
+        for (size_type i = 0; i < class_count; ++i)
+        {
+            pCache->mags[i].count  = 0;
+            pCache->mags[i].blocks = pSlots + i * uCapacity;
+        }
+
+        return pCache;
+    }
+
+    static void destroy (thread_cache* pCache) noexcept
+    {
+        auto const uCapacity = pCache->capacity;
+
+        pCache->~thread_cache ();
+        malloc_resource ().deallocate (pCache, byte_size (uCapacity), alignof (thread_cache));
+    }
+};
+
+//! thread local list of caches, one per thread_caching_resource used by the thread
+struct thread_caching_resource::thread_registry
+{
+    thread_cache* head { };
+    thread_cache* last { };
+
+    ~thread_registry ()
+    {
+        std::lock_guard<std::mutex> lock (registry_mutex ());
+
+        for (thread_cache* pCache = head; pCache; )
+        {
+            thread_cache* const pNext  = pCache->thread_next;
+            auto          const pOwner = pCache->owner.load (std::memory_order_relaxed);
+
+            if (pOwner) pOwner->detach (*pCache);
+
+            thread_cache::destroy (pCache);
+            pCache = pNext;
+        }
+    }
+};
+
+// =========================================================
+
+thread_caching_resource::thread_caching_resource (memory_resource& pOwner,
+                                                  size_type        uMagazineSize,
+                                                  size_type        uBatchSize)
+: _M_gOwner        (pOwner),
+  _M_gMutex        (),
+  _M_pCaches       (),
+  _M_uMagazineSize (uMagazineSize ? uMagazineSize : 1),
+  _M_uBatchSize    (std::clamp (uBatchSize, size_type (1), _M_uMagazineSize)),
+  _M_bLockOwner    (!pOwner.is_thread_safe ())
+{ }
+
+thread_caching_resource::~thread_caching_resource ()
+{
+    std::lock_guard<std::mutex> lock (registry_mutex ());
+
+    while (_M_pCaches) detach (*_M_pCaches);
+}
+
+thread_caching_resource::thread_cache& thread_caching_resource::local_cache ()
+{
+    static thread_local thread_registry registry;
+
+    //! fast path -> the same resource as the last call on this thread
+    if (registry.last && registry.last->owner.load (std::memory_order_relaxed) == this)
+        return *registry.last;
+
+    thread_cache* pFree = nullptr;
+
+    for (thread_cache* pCache = registry.head; pCache; pCache = pCache->thread_next)
+    {
+        auto const pOwner = pCache->owner.load (std::memory_order_relaxed);
+
+        if (pOwner == this) return *(registry.last = pCache);
+        if (!pOwner && !pFree && pCache->capacity == _M_uMagazineSize) pFree = pCache;
+    }
+
+    //! reuse a cache detached from a destroyed resource or create a new one
+    if (!pFree)
+    {
+        pFree              = thread_cache::create (_M_uMagazineSize);
+        pFree->thread_next = registry.head;
+        registry.head      = pFree;
+    }
+
+    std::lock_guard<std::mutex> lock (registry_mutex ());
+
+    pFree->prev = nullptr;
+    pFree->next = _M_pCaches;
+
+    if (_M_pCaches) _M_pCaches->prev = pFree;
+
+    _M_pCaches = pFree;
+    pFree->owner.store (this, std::memory_order_relaxed);
+
+    return *(registry.last = pFree);
+}
+
+void thread_caching_resource::refill (magazine& mag, size_type uClassIdx)
+{
+    std::unique_lock<std::mutex> lock (_M_gMutex, std::defer_lock);
+
+    if (_M_bLockOwner) lock.lock ();
+
+    auto const uSize = class_size (uClassIdx);
+
+    for (size_type n = 0; n < _M_uBatchSize; ++n)
+    {
+        pointer p;
+
+        try
+        {
+            p = _M_gOwner.allocate (uSize, max_align);
+        }
+        catch (std::bad_alloc&)
+        {
+            //! keep a partial batch, fail only if nothing could be allocated
+            if (mag.count) break;
+            throw;
+        }
+
+        mag.blocks[mag.count++] = p;
+    }
+}
+
+void thread_caching_resource::release (magazine& mag, size_type uClassIdx, size_type uCount)
+{
+    if (!uCount) return;
+
+    {
+        std::unique_lock<std::mutex> lock (_M_gMutex, std::defer_lock);
+
+        if (_M_bLockOwner) lock.lock ();
+
+        auto const uSize = class_size (uClassIdx);
+
+        //! the oldest (coldest) blocks go back first
+        for (size_type n = 0; n < uCount; ++n) _M_gOwner.deallocate (mag.blocks[n], uSize, max_align);
+    }
+
+    std::move (mag.blocks + uCount, mag.blocks + mag.count, mag.blocks);
+    mag.count -= uCount;
+}
+
+void thread_caching_resource::detach (thread_cache& cache)
+{
+    for (size_type i = 0; i < class_count; ++i) release (cache.mags[i], i, cache.mags[i].count);
+
+    if (cache.prev) cache.prev->next = cache.next;
+    else _M_pCaches = cache.next;
+
+    if (cache.next) cache.next->prev = cache.prev;
+
+    cache.prev = cache.next = nullptr;
+    cache.owner.store (nullptr, std::memory_order_relaxed);
+}
+
+void thread_caching_resource::flush ()
+{
+    thread_cache& cache = local_cache ();
+
+    for (size_type i = 0; i < class_count; ++i) release (cache.mags[i], i, cache.mags[i].count);
+}
+
+void* thread_caching_resource::do_allocate (size_type uSize, align_type uAlign)
+{
+    if (uSize > max_cached_size || uAlign > max_align)
+    {
+        std::unique_lock<std::mutex> lock (_M_gMutex, std::defer_lock);
+
+        if (_M_bLockOwner) lock.lock ();
+        return _M_gOwner.allocate (uSize, uAlign);
+    }
+
+    auto const uClassIdx = size_class (uSize ? uSize : 1);
+    magazine&  mag       = local_cache ().mags[uClassIdx];
+
+    if (!mag.count) refill (mag, uClassIdx);
+
+    return mag.blocks[--mag.count];
+}
+
+void thread_caching_resource::do_deallocate (pointer p, size_type uSize, align_type uAlign)
+{
+    if (!p) return;
+
+    if (uSize > max_cached_size || uAlign > max_align)
+    {
+        std::unique_lock<std::mutex> lock (_M_gMutex, std::defer_lock);
+
+        if (_M_bLockOwner) lock.lock ();
+        return _M_gOwner.deallocate (p, uSize, uAlign);
+    }
+
+    auto const uClassIdx = size_class (uSize ? uSize : 1);
+    magazine&  mag       = local_cache ().mags[uClassIdx];
+
+    //! magazine is full -> hand half of it back to the upstream resource in one batch
+    if (mag.count == _M_uMagazineSize) release (mag, uClassIdx, std::max (mag.count / 2, size_type (1)));
+
+    mag.blocks[mag.count++] = p;
+}
+
+// =========================================================
+
+} // namespace Memory
+
+// =========================================================
@@ -24,6 +24,7 @@
 #include <cppual/casts>
 
 #include <iostream>
+#include <bit>
 
 namespace cppual { namespace memory {
 
@@ -36,9 +37,465 @@ constexpr H* shift_to_header (void* p, std::size_t /*uAlign*/) noexcept
                                  align_adjustment_header (p, uAlign, sizeof (H))*/);
 }
 
+// =========================================================
+// TLSF (Two-Level Segregated Fit) definitions
+// =========================================================
+
+//! block granularity -> header size, so that every payload keeps the block alignment
+constexpr std::size_t tlsf_align_log2 = sizeof (uptr) == 8 ? 4 : 3;
+constexpr std::size_t tlsf_align_size = std::size_t (1) << tlsf_align_log2;
+
+//! number of second level subdivisions per first level class (log2)
+constexpr std::size_t tlsf_sl_log2    = 5;
+constexpr std::size_t tlsf_sl_count   = std::size_t (1) << tlsf_sl_log2;
+
+//! largest first level class (log2 of the maximum block size)
+constexpr std::size_t tlsf_fl_max     = sizeof (uptr) == 8 ? 38 : 30;
+constexpr std::size_t tlsf_fl_shift   = tlsf_sl_log2 + tlsf_align_log2;
+constexpr std::size_t tlsf_fl_count   = tlsf_fl_max - tlsf_fl_shift + 1;
+constexpr std::size_t tlsf_small_size = std::size_t (1) << tlsf_fl_shift;
+
+static_assert (tlsf_fl_count <= 32, "first level bitmap doesn't fit in 32 bits!");
+static_assert (tlsf_sl_count <= 32, "second level bitmap doesn't fit in 32 bits!");
+
+//! physical block header; next_free & prev_free are only valid while the block is free
+struct tlsf_block
+{
+    //! size flags stored in the lower bits of the size
+    inline constexpr static std::size_t free_bit      = 1U << 0;
+    inline constexpr static std::size_t prev_free_bit = 1U << 1;
+
+    tlsf_block* prev_phys;
+    std::size_t size     ;
+    tlsf_block* next_free;
+    tlsf_block* prev_free;
+
+    constexpr std::size_t bytes () const noexcept
+    { return size & ~(free_bit | prev_free_bit); }
+
+    constexpr void set_bytes (std::size_t uSize) noexcept
+    { size = uSize | (size & (free_bit | prev_free_bit)); }
+
+    constexpr bool is_free      () const noexcept { return size & free_bit     ; }
+    constexpr bool is_prev_free () const noexcept { return size & prev_free_bit; }
+
+    constexpr void set_free      () noexcept { size |=  free_bit     ; }
+    constexpr void set_used      () noexcept { size &= ~free_bit     ; }
+    constexpr void set_prev_free () noexcept { size |=  prev_free_bit; }
+    constexpr void set_prev_used () noexcept { size &= ~prev_free_bit; }
+};
+
+//! bytes between the block header and its payload
+constexpr std::size_t tlsf_overhead  = sizeof (tlsf_block*) + sizeof (std::size_t);
+
+//! a free block must at least fit its free list links
+constexpr std::size_t tlsf_block_min = sizeof (tlsf_block) - tlsf_overhead;
+constexpr std::size_t tlsf_block_max = std::size_t (1) << tlsf_fl_max;
+
+static_assert (tlsf_overhead % tlsf_align_size == 0, "header breaks the payload alignment!");
+
+inline void* tlsf_to_ptr (tlsf_block* pBlock) noexcept
+{ return reinterpret_cast<memory_resource::math_pointer> (pBlock) + tlsf_overhead; }
+
+inline tlsf_block* tlsf_from_ptr (void* p) noexcept
+{ return reinterpret_cast<tlsf_block*> (static_cast<memory_resource::math_pointer> (p) - tlsf_overhead); }
+
+inline tlsf_block* tlsf_next (tlsf_block* pBlock) noexcept
+{
+    return reinterpret_cast<tlsf_block*> (static_cast<memory_resource::math_pointer> (tlsf_to_ptr (pBlock)) +
+                                          pBlock->bytes ());
+}
+
+inline tlsf_block* tlsf_link_next (tlsf_block* pBlock) noexcept
+{
+    tlsf_block* pNext = tlsf_next (pBlock);
+    pNext->prev_phys  = pBlock;
+    return pNext;
+}
+
+constexpr std::size_t tlsf_adjust_request (std::size_t uSize, std::size_t uAlign) noexcept
+{
+    if (!uSize) return std::size_t ();
+
+    auto const uAligned = aligned_size (uSize, uAlign);
+
+    return uAligned < tlsf_block_max ? std::max (uAligned, tlsf_block_min) : std::size_t ();
+}
+
+//! first & second level indices of a block size
+constexpr void tlsf_mapping_insert (std::size_t uSize, std::size_t& fl, std::size_t& sl) noexcept
+{
+    if (uSize < tlsf_small_size)
+    {
+        fl = 0;
+        sl = uSize / (tlsf_small_size / tlsf_sl_count);
+    }
+    else
+    {
+        auto const uLog2 = static_cast<std::size_t> (std::bit_width (uSize)) - 1;
+
+        sl = (uSize >> (uLog2 - tlsf_sl_log2)) ^ tlsf_sl_count;
+        fl = uLog2 - (tlsf_fl_shift - 1);
+    }
+}
+
+//! round the request up to the next list, so that any block found in it is large enough
+constexpr void tlsf_mapping_search (std::size_t uSize, std::size_t& fl, std::size_t& sl) noexcept
+{
+    if (uSize >= tlsf_small_size)
+    {
+        auto const uLog2 = static_cast<std::size_t> (std::bit_width (uSize)) - 1;
+
+        uSize += (std::size_t (1) << (uLog2 - tlsf_sl_log2)) - 1;
+    }
+
+    tlsf_mapping_insert (uSize, fl, sl);
+}
+
 } // anonymous
 
-heap_resource::heap_resource (size_type uSize)
+// =========================================================
+
+//! TLSF control structure; placed at the start of the managed buffer
+struct heap_resource::tlsf_control
+{
+    u32         fl_bitmap;
+    u32         sl_bitmap[tlsf_fl_count];
+    tlsf_block* blocks   [tlsf_fl_count][tlsf_sl_count];
+
+    void remove_free (tlsf_block* pBlock, std::size_t fl, std::size_t sl) noexcept
+    {
+        tlsf_block* const pPrev = pBlock->prev_free;
+        tlsf_block* const pNext = pBlock->next_free;
+
+        if (pNext) pNext->prev_free = pPrev;
+        if (pPrev) pPrev->next_free = pNext;
+
+        //! if this block is the head of the free list, set new head
+        if (blocks[fl][sl] == pBlock)
+        {
+            blocks[fl][sl] = pNext;
+
+            //! if the new head is null, clear the bitmaps
+            if (!pNext)
+            {
+                sl_bitmap[fl] &= ~(u32 (1) << sl);
+                if (!sl_bitmap[fl]) fl_bitmap &= ~(u32 (1) << fl);
+            }
+        }
+    }
+
+    void insert_free (tlsf_block* pBlock, std::size_t fl, std::size_t sl) noexcept
+    {
+        tlsf_block* const pHead = blocks[fl][sl];
+
+        pBlock->next_free = pHead;
+        pBlock->prev_free = nullptr;
+
+        if (pHead) pHead->prev_free = pBlock;
+
+        blocks[fl][sl]  = pBlock;
+        fl_bitmap      |= u32 (1) << fl;
+        sl_bitmap[fl]  |= u32 (1) << sl;
+    }
+
+    void remove (tlsf_block* pBlock) noexcept
+    {
+        std::size_t fl, sl;
+
+        tlsf_mapping_insert (pBlock->bytes (), fl, sl);
+        remove_free (pBlock, fl, sl);
+    }
+
+    void insert (tlsf_block* pBlock) noexcept
+    {
+        std::size_t fl, sl;
+
+        tlsf_mapping_insert (pBlock->bytes (), fl, sl);
+        insert_free (pBlock, fl, sl);
+    }
+
+    static void mark_as_free (tlsf_block* pBlock) noexcept
+    {
+        tlsf_link_next (pBlock)->set_prev_free ();
+        pBlock->set_free ();
+    }
+
+    static void mark_as_used (tlsf_block* pBlock) noexcept
+    {
+        tlsf_next (pBlock)->set_prev_used ();
+        pBlock->set_used ();
+    }
+
+    static bool can_split (tlsf_block* pBlock, std::size_t uSize) noexcept
+    { return pBlock->bytes () >= sizeof (tlsf_block) + uSize; }
+
+    //! split the block so that it keeps uSize bytes & return the free remainder
+    static tlsf_block* split (tlsf_block* pBlock, std::size_t uSize) noexcept
+    {
+        auto const pRemaining =
+                reinterpret_cast<tlsf_block*> (static_cast<math_pointer> (tlsf_to_ptr (pBlock)) + uSize);
+
+        pRemaining->size = pBlock->bytes () - (uSize + tlsf_overhead);
+        pBlock->set_bytes (uSize);
+        mark_as_free (pRemaining);
+
+        return pRemaining;
+    }
+
+    //! absorb a free block into its physical predecessor
+    static tlsf_block* absorb (tlsf_block* pPrev, tlsf_block* pBlock) noexcept
+    {
+        pPrev->set_bytes (pPrev->bytes () + pBlock->bytes () + tlsf_overhead);
+        tlsf_link_next (pPrev);
+        return pPrev;
+    }
+
+    tlsf_block* merge_prev (tlsf_block* pBlock) noexcept
+    {
+        if (pBlock->is_prev_free ())
+        {
+            tlsf_block* const pPrev = pBlock->prev_phys;
+
+            remove (pPrev);
+            pBlock = absorb (pPrev, pBlock);
+        }
+
+        return pBlock;
+    }
+
+    tlsf_block* merge_next (tlsf_block* pBlock) noexcept
+    {
+        tlsf_block* const pNext = tlsf_next (pBlock);
+
+        if (pNext->is_free ())
+        {
+            remove (pNext);
+            pBlock = absorb (pBlock, pNext);
+        }
+
+        return pBlock;
+    }
+
+    //! trim the trailing block space & return it to the pool
+    void trim_free (tlsf_block* pBlock, std::size_t uSize) noexcept
+    {
+        if (can_split (pBlock, uSize))
+        {
+            tlsf_block* const pRemaining = split (pBlock, uSize);
+
+            tlsf_link_next (pBlock);
+            pRemaining->set_prev_free ();
+            insert (pRemaining);
+        }
+    }
+
+    //! trim the leading block space & return it to the pool
+    tlsf_block* trim_free_leading (tlsf_block* pBlock, std::size_t uSize) noexcept
+    {
+        tlsf_block* pRemaining = pBlock;
+
+        if (can_split (pBlock, uSize))
+        {
+            pRemaining = split (pBlock, uSize - tlsf_overhead);
+            pRemaining->set_prev_free ();
+
+            tlsf_link_next (pBlock);
+            insert (pBlock);
+        }
+
+        return pRemaining;
+    }
+
+    //! trim the trailing space of a used block & merge it with the following free block
+    void trim_used (tlsf_block* pBlock, std::size_t uSize) noexcept
+    {
+        if (can_split (pBlock, uSize))
+        {
+            tlsf_block* pRemaining = split (pBlock, uSize);
+
+            tlsf_link_next (pBlock);
+            pRemaining = merge_next (pRemaining);
+            insert (pRemaining);
+        }
+    }
+
+    //! grow into the following free block or shrink in place
+    bool resize (void* p, std::size_t uSize) noexcept
+    {
+        tlsf_block* const pBlock  = tlsf_from_ptr (p);
+        auto const        uAdjust = tlsf_adjust_request (uSize, tlsf_align_size);
+
+        if (!uAdjust) return false;
+
+        if (uAdjust > pBlock->bytes ())
+        {
+            tlsf_block* const pNext = tlsf_next (pBlock);
+
+            if (!pNext->is_free () || pBlock->bytes () + pNext->bytes () + tlsf_overhead < uAdjust)
+                return false;
+
+            remove (pNext);
+            absorb (pBlock, pNext);
+            mark_as_used (pBlock);
+        }
+
+        trim_used (pBlock, uAdjust);
+        return true;
+    }
+
+    tlsf_block* search_suitable (std::size_t& fl, std::size_t& sl) const noexcept
+    {
+        //! first, search for a free block in the current first level list
+        u32 sl_map = sl_bitmap[fl] & (~u32 () << sl);
+
+        if (!sl_map)
+        {
+            //! no block exists, search in the next largest first level list
+            u32 const fl_map = fl + 1 < tlsf_fl_count ? fl_bitmap & (~u32 () << (fl + 1)) : u32 ();
+
+            if (!fl_map) return nullptr;
+
+            fl     = static_cast<std::size_t> (std::countr_zero (fl_map));
+            sl_map = sl_bitmap[fl];
+        }
+
+        sl = static_cast<std::size_t> (std::countr_zero (sl_map));
+        return blocks[fl][sl];
+    }
+
+    tlsf_block* locate_free (std::size_t uSize) noexcept
+    {
+        std::size_t fl = 0, sl = 0;
+        tlsf_block* pBlock = nullptr;
+
+        if (uSize)
+        {
+            tlsf_mapping_search (uSize, fl, sl);
+
+            if (fl < tlsf_fl_count)
+            {
+                pBlock = search_suitable (fl, sl);
+                if (pBlock) remove_free (pBlock, fl, sl);
+            }
+        }
+
+        return pBlock;
+    }
+
+    void* prepare_used (tlsf_block* pBlock, std::size_t uSize) noexcept
+    {
+        trim_free    (pBlock, uSize);
+        mark_as_used (pBlock);
+        return tlsf_to_ptr (pBlock);
+    }
+
+    void* allocate (std::size_t uSize, std::size_t uAlign) noexcept
+    {
+        auto const uAdjust = tlsf_adjust_request (uSize, tlsf_align_size);
+
+        if (!uAdjust) return nullptr;
+
+        if (uAlign <= tlsf_align_size)
+        {
+            tlsf_block* const pBlock = locate_free (uAdjust);
+            return pBlock ? prepare_used (pBlock, uAdjust) : nullptr;
+        }
+
+        //! over-allocate so that the leading gap can always form a free block
+        constexpr auto const uGapMin = sizeof (tlsf_block);
+
+        auto const uSizeWithGap = tlsf_adjust_request (uAdjust + uAlign + uGapMin, uAlign);
+        tlsf_block*    pBlock   = locate_free (uSizeWithGap);
+
+        if (!pBlock) return nullptr;
+
+        auto const   ptr      = static_cast<math_pointer> (tlsf_to_ptr (pBlock));
+        math_pointer aligned  = static_cast<math_pointer> (next_aligned_addr (ptr, uAlign));
+        auto         uGap     = static_cast<std::size_t> (aligned - ptr);
+
+        //! the gap is too small to hold a free block -> move to the next aligned address
+        if (uGap && uGap < uGapMin)
+        {
+            auto const uOffset = std::max (uGapMin - uGap, uAlign);
+
+            aligned = static_cast<math_pointer> (next_aligned_addr (aligned + uOffset, uAlign));
+            uGap    = static_cast<std::size_t>  (aligned - ptr);
+        }
+
+        if (uGap) pBlock = trim_free_leading (pBlock, uGap);
+
+        return prepare_used (pBlock, uAdjust);
+    }
+
+    void deallocate (void* p) noexcept
+    {
+        tlsf_block* pBlock = tlsf_from_ptr (p);
+
+        mark_as_free (pBlock);
+
+        pBlock = merge_prev (pBlock);
+        pBlock = merge_next (pBlock);
+
+        insert (pBlock);
+    }
+
+    std::size_t max_size () const noexcept
+    {
+        if (!fl_bitmap) return std::size_t ();
+
+        //! the largest free block is in the highest non-empty list
+        auto const fl = static_cast<std::size_t> (std::bit_width (fl_bitmap)) - 1;
+        auto const sl = static_cast<std::size_t> (std::bit_width (sl_bitmap[fl])) - 1;
+
+        std::size_t uMaxSize = 0;
+
+        for (tlsf_block* pBlock = blocks[fl][sl]; pBlock; pBlock = pBlock->next_free)
+            if (pBlock->bytes () > uMaxSize) uMaxSize = pBlock->bytes ();
+
+        return uMaxSize;
+    }
+
+    //! create the control structure at the beginning of the buffer followed by the pool
+    static tlsf_control* create (pointer pBegin, pointer pEnd) noexcept
+    {
+        auto const pControl = static_cast<tlsf_control*> (next_aligned_addr (pBegin, alignof (tlsf_control)));
+        auto const pPool    = static_cast<math_pointer>  (next_aligned_addr (pControl + 1, tlsf_align_size));
+
+        //! the pool has to fit a block header, the minimum block & the sentinel header
+        if (pPool + 2 * tlsf_overhead + tlsf_block_min > static_cast<math_pointer> (pEnd)) return nullptr;
+
+        auto const uAvail    = static_cast<std::size_t> (static_cast<math_pointer> (pEnd) - pPool);
+        auto const uPoolSize = std::min ((uAvail - 2 * tlsf_overhead) & ~(tlsf_align_size - 1),
+                                         tlsf_block_max - tlsf_align_size);
+
+        pControl->fl_bitmap = 0;
+
+        for (std::size_t fl = 0; fl < tlsf_fl_count; ++fl)
+        {
+            pControl->sl_bitmap[fl] = 0;
+            for (std::size_t sl = 0; sl < tlsf_sl_count; ++sl) pControl->blocks[fl][sl] = nullptr;
+        }
+
+        //! the whole pool is one free block followed by a zero sized used sentinel
+        auto const pBlock = reinterpret_cast<tlsf_block*> (pPool);
+
+        pBlock->prev_phys = nullptr;
+        pBlock->size      = uPoolSize;
+        pBlock->set_free ();
+        pControl->insert (pBlock);
+
+        tlsf_block* const pSentinel = tlsf_link_next (pBlock);
+
+        pSentinel->size = 0;
+        pSentinel->set_used ();
+        pSentinel->set_prev_free ();
+
+        return pControl;
+    }
+};
+
+heap_resource::heap_resource (size_type uSize, heap_strategy eStrategy)
 : _M_gOwner (uSize > sizeof (free_block) ? get_default_resource().max_size() >= uSize + max_adjust ?
                                            get_default_resource() : new_delete_resource() : *this),
   _M_pBegin (&_M_gOwner != this ?
@@ -46,9 +503,15 @@ heap_resource::heap_resource (size_type uSize)
   _M_pEnd (_M_pBegin != nullptr ?
             static_cast<math_pointer> (_M_pBegin) + uSize + max_adjust : nullptr),
   _M_pFreeBlocks (reinterpret_cast<free_block*> (_M_pBegin)),
-  _M_bIsMemShared (&_M_gOwner != this ? _M_gOwner.is_shared () : false)
+  _M_bIsMemShared (&_M_gOwner != this ? _M_gOwner.is_shared () : false),
+  _M_eStrategy (eStrategy),
+  _M_pControl ()
 {
-    if (_M_pFreeBlocks != nullptr)
+    if (_M_pFreeBlocks != nullptr && _M_eStrategy == heap_strategy::tlsf)
+    {
+        initialize_owned ();
+    }
+    else if (_M_pFreeBlocks != nullptr)
     {
         _M_pFreeBlocks->size = uSize + max_adjust - sizeof (free_block) - sizeof (header);
         _M_pFreeBlocks->next = nullptr;
@@ -59,14 +522,20 @@ heap_resource::heap_resource (size_type uSize)
     }
 }
 
-heap_resource::heap_resource (pointer buffer, size_type uSize)
+heap_resource::heap_resource (pointer buffer, size_type uSize, heap_strategy eStrategy)
 : _M_gOwner (*this),
   _M_pBegin (buffer && uSize > sizeof (free_block) ? buffer : nullptr),
   _M_pEnd (_M_pBegin != nullptr ? static_cast<math_pointer> (buffer) + uSize : nullptr),
   _M_pFreeBlocks (reinterpret_cast<free_block*> (_M_pBegin)),
-  _M_bIsMemShared ()
+  _M_bIsMemShared (),
+  _M_eStrategy (eStrategy),
+  _M_pControl ()
 {
-    if (_M_pFreeBlocks != nullptr)
+    if (_M_pFreeBlocks != nullptr && _M_eStrategy == heap_strategy::tlsf)
+    {
+        initialize ();
+    }
+    else if (_M_pFreeBlocks != nullptr)
     {
         _M_pFreeBlocks->size = uSize - sizeof (free_block) - sizeof (header);
         _M_pFreeBlocks->next = nullptr;
@@ -77,7 +546,7 @@ heap_resource::heap_resource (pointer buffer, size_type uSize)
     }
 }
 
-heap_resource::heap_resource (memory_resource& pOwner, size_type uSize)
+heap_resource::heap_resource (memory_resource& pOwner, size_type uSize, heap_strategy eStrategy)
 : _M_gOwner (uSize > sizeof(free_block) ? uSize > pOwner.max_size () ?
                                           uSize > get_default_resource ().max_size () ?
                              new_delete_resource () : get_default_resource () : pOwner : *this),
@@ -86,9 +555,15 @@ heap_resource::heap_resource (memory_resource& pOwner, size_type uSize)
   _M_pEnd (_M_pBegin != nullptr ?
             static_cast<math_pointer> (_M_pBegin) + uSize + max_adjust : nullptr),
   _M_pFreeBlocks (static_cast<free_block*> (_M_pBegin)),
-  _M_bIsMemShared (&_M_gOwner != this ? _M_gOwner.is_shared () : false)
+  _M_bIsMemShared (&_M_gOwner != this ? _M_gOwner.is_shared () : false),
+  _M_eStrategy (eStrategy),
+  _M_pControl ()
 {
-    if (_M_pFreeBlocks != nullptr)
+    if (_M_pFreeBlocks != nullptr && _M_eStrategy == heap_strategy::tlsf)
+    {
+        initialize_owned ();
+    }
+    else if (_M_pFreeBlocks != nullptr)
     {
         auto const occupied_space = sizeof (free_block) + sizeof (header);
 
@@ -110,13 +585,56 @@ heap_resource::heap_resource (memory_resource& pOwner, size_type uSize)
 
 heap_resource::~heap_resource ()
 {
-    if (_M_pBegin && &_M_gOwner != this) _M_gOwner.deallocate (_M_pBegin, capacity ());
+    if (_M_pBegin && &_M_gOwner != this) release_owned ();
+}
+
+void heap_resource::initialize ()
+{
+    _M_pFreeBlocks = nullptr;
+    _M_pControl    = tlsf_control::create (_M_pBegin, _M_pEnd);
+
+    if (!_M_pControl) throw std::bad_alloc ();
+}
+
+void heap_resource::initialize_owned ()
+{
+    //! the destructor doesn't run for a partly constructed object
+    try
+    {
+        initialize ();
+    }
+    catch (...)
+    {
+        release_owned ();
+        throw;
+    }
+}
+
+//! capacity () excludes the first block, the owner gets back the whole buffer
+void heap_resource::release_owned () noexcept
+{
+    _M_gOwner.deallocate (_M_pBegin,
+                          static_cast<size_type> (static_cast<math_pointer> (_M_pEnd  ) -
+                                                  static_cast<math_pointer> (_M_pBegin)),
+                          alignof (uptr));
 }
 
 void* heap_resource::do_allocate (size_type uSize, align_type uAlign)
 {
     if (!_M_pBegin || !uSize) throw std::bad_alloc ();
 
+    if (_M_pControl)
+    {
+        void* const p = _M_pControl->allocate (uSize, uAlign);
+
+        if (!p) throw std::bad_alloc ();
+        return p;
+    }
+
+    //! keep the free blocks that follow aligned for their header
+    uAlign = std::max (uAlign, alignof (free_block));
+    uSize  = aligned_size (uSize, alignof (free_block));
+
     //! check free blocks
     free_block* pPrevFreeBlock = nullptr;
     free_block* pFreeBlock     = _M_pFreeBlocks;
@@ -124,10 +642,11 @@ void* heap_resource::do_allocate (size_type uSize, align_type uAlign)
     while (pFreeBlock)
     {
         //! calculate uAdjust needed to keep object correctly aligned
-        size_type uAdjust = align_adjustment_header (pFreeBlock, uAlign, sizeof (header));
+        size_type uAdjust    = align_adjustment_header (pFreeBlock, uAlign, sizeof (header));
+        size_type uBlockSize = uSize + uAdjust;
 
         //! if allocation doesn't fit in this FreeBlock, try the next
-        if(pFreeBlock->size < (uSize + uAdjust))
+        if(pFreeBlock->size < uBlockSize)
         {
             pPrevFreeBlock = pFreeBlock;
             pFreeBlock     = pFreeBlock->next;
@@ -135,10 +654,10 @@ void* heap_resource::do_allocate (size_type uSize, align_type uAlign)
         }
 
         //! if allocations in the remaining memory will be impossible
-        if((pFreeBlock->size - uSize - uAdjust) <= sizeof (header))
+        if((pFreeBlock->size - uBlockSize) <= sizeof (header))
         {
             //! increase allocation size instead of creating a new FreeBlock
-            uSize = pFreeBlock->size;
+            uBlockSize = pFreeBlock->size;
 
             if(pPrevFreeBlock != nullptr) pPrevFreeBlock->next = pFreeBlock->next;
             else _M_pFreeBlocks = pFreeBlock->next;
@@ -146,8 +665,9 @@ void* heap_resource::do_allocate (size_type uSize, align_type uAlign)
         else
         {
             //! else create a new FreeBlock containing remaining memory
-            free_block* pNextBlock = pFreeBlock + uSize + uAdjust;
-            pNextBlock->size       = pFreeBlock->size - uSize - uAdjust;
+            free_block* pNextBlock = reinterpret_cast<free_block*> (direct_cast<math_pointer> (pFreeBlock) +
+                                                                    uBlockSize);
+            pNextBlock->size       = pFreeBlock->size - uBlockSize;
             pNextBlock->next       = pFreeBlock->next;
 
             if(pPrevFreeBlock != nullptr)
@@ -159,7 +679,7 @@ void* heap_resource::do_allocate (size_type uSize, align_type uAlign)
         auto uAlignedAddr = reinterpret_cast<uptr> (pFreeBlock) + uAdjust;
 
         header* pHeader = reinterpret_cast<header*> (uAlignedAddr - sizeof (header));
-        pHeader->size   = uSize + uAdjust;
+        pHeader->size   = uBlockSize;
         pHeader->adjust = uAdjust;
 
         return reinterpret_cast<pointer> (uAlignedAddr);
@@ -170,78 +690,129 @@ void* heap_resource::do_allocate (size_type uSize, align_type uAlign)
     return nullptr;
 }
 
-void heap_resource::do_deallocate (pointer p, size_type uSize, align_type uAlign)
+void heap_resource::do_deallocate (pointer p, size_type, align_type uAlign)
 {
     if (p < _M_pBegin || _M_pEnd <= p) throw std::out_of_range ("pointer is outside the buffer!");
 
+    if (_M_pControl) return _M_pControl->deallocate (p);
+
     header* pHeader = shift_to_header<header> (p, uAlign);
 
-    //if (pHeader->size != uSize) throw std::length_error ("deallocate size doesn't match!");
+    release_block (direct_cast<math_pointer> (p) - pHeader->adjust, pHeader->size);
+}
+
+//! insert the block in the address ordered free list & merge it with its free neighbours
+void heap_resource::release_block (math_pointer pBlockStart, size_type uBlockSize) noexcept
+{
+    free_block* pBlock         = reinterpret_cast<free_block*> (pBlockStart);
+    free_block* pPrevFreeBlock = nullptr;
+    free_block* pFreeBlock     = _M_pFreeBlocks;
 
-    size_type uBlockStart = reinterpret_cast<size_type> (p) - pHeader->adjust;
-    size_type uBlockEnd   = uBlockStart + uSize;
-    size_type uBlockSize  = uSize;
+    while (pFreeBlock != nullptr && pFreeBlock < pBlock)
+    {
+        pPrevFreeBlock = pFreeBlock;
+        pFreeBlock     = pFreeBlock->next;
+    }
 
-    bool blockMerged = false;
-    bool bSearch     = true ;
+    pBlock->size = uBlockSize;
+    pBlock->next = pFreeBlock;
 
-    while (bSearch)
+    if (pFreeBlock != nullptr && pBlockStart + uBlockSize == direct_cast<math_pointer> (pFreeBlock))
     {
-        bSearch = false;
+        pBlock->size += pFreeBlock->size;
+        pBlock->next  = pFreeBlock->next;
+    }
 
-        free_block* pPrevFreeBlock = nullptr;
-        free_block* pFreeBlock     = _M_pFreeBlocks;
+    if (pPrevFreeBlock != nullptr &&
+        direct_cast<math_pointer> (pPrevFreeBlock) + pPrevFreeBlock->size == pBlockStart)
+    {
+        pPrevFreeBlock->size += pBlock->size;
+        pPrevFreeBlock->next  = pBlock->next;
+    }
+    else if (pPrevFreeBlock != nullptr)
+    {
+        pPrevFreeBlock->next = pBlock;
+    }
+    else
+    {
+        _M_pFreeBlocks = pBlock;
+    }
+}
 
-        while (pFreeBlock != nullptr)
+//! grow into the free block that follows or give the trailing space back
+bool heap_resource::resize_block (pointer p, size_type uSize) noexcept
+{
+    header* const pHeader     = shift_to_header<header> (p, alignof (free_block));
+    auto const    pBlockStart = direct_cast<math_pointer> (p) - pHeader->adjust;
+    auto const    pBlockEnd   = pBlockStart + pHeader->size;
+    auto const    uBlockSize  = aligned_size (uSize, alignof (free_block)) + pHeader->adjust;
+
+    if (uBlockSize <= pHeader->size)
+    {
+        if (pHeader->size - uBlockSize > sizeof (header))
         {
-            if (direct_cast<size_type> (pFreeBlock) + pFreeBlock->size == uBlockStart)
-            {
-                pFreeBlock->size += uBlockSize;
+            release_block (pBlockStart + uBlockSize, pHeader->size - uBlockSize);
+            pHeader->size = uBlockSize;
+        }
 
-                uBlockStart = reinterpret_cast<size_type> (pFreeBlock);
-                uBlockEnd   = uBlockStart + pFreeBlock->size;
-                uBlockSize  = pFreeBlock->size;
+        return true;
+    }
 
-                bSearch     = true;
-                blockMerged = true;
-                break;
-            }
-            else if (uBlockEnd == direct_cast<size_type> (pFreeBlock))
-            {
-                free_block* pNewFreeBlock = direct_cast<free_block*> (uBlockStart);
-                pNewFreeBlock->next       = pFreeBlock->next;
-                pNewFreeBlock->size       = uBlockSize + pFreeBlock->size;
-
-                if(pFreeBlock == _M_pFreeBlocks)
-                    _M_pFreeBlocks = pNewFreeBlock;
-                else if(pPrevFreeBlock != pNewFreeBlock)
-                    pPrevFreeBlock->next = pNewFreeBlock;
-
-                uBlockStart = direct_cast<size_type> (pNewFreeBlock);
-                uBlockEnd   = uBlockStart + pNewFreeBlock->size;
-                uBlockSize  = pNewFreeBlock->size;
-
-                bSearch     = true;
-                blockMerged = true;
-                break;
-            }
+    free_block* pPrevFreeBlock = nullptr;
+    free_block* pFreeBlock     = _M_pFreeBlocks;
 
-            pPrevFreeBlock = pFreeBlock;
-            pFreeBlock     = pFreeBlock->next;
-        }
+    while (pFreeBlock != nullptr && direct_cast<math_pointer> (pFreeBlock) < pBlockEnd)
+    {
+        pPrevFreeBlock = pFreeBlock;
+        pFreeBlock     = pFreeBlock->next;
     }
 
-    if (!blockMerged)
+    if (direct_cast<math_pointer> (pFreeBlock) != pBlockEnd ||
+        pHeader->size + pFreeBlock->size < uBlockSize)
+        return false;
+
+    auto const  uRemaining = pHeader->size + pFreeBlock->size - uBlockSize;
+    free_block* pNextBlock = pFreeBlock->next;
+
+    if (uRemaining > sizeof (header))
     {
-        free_block* pBlock = direct_cast<free_block*> (direct_cast<math_pointer> (p) - pHeader->adjust);
-        pBlock->size       = uBlockSize;
-        pBlock->next       = _M_pFreeBlocks;
-        _M_pFreeBlocks     = pBlock;
+        free_block* pSplitBlock = reinterpret_cast<free_block*> (pBlockStart + uBlockSize);
+
+        pSplitBlock->size = uRemaining;
+        pSplitBlock->next = pNextBlock;
+        pNextBlock        = pSplitBlock;
+        pHeader->size     = uBlockSize;
     }
+    else
+    {
+        pHeader->size += pFreeBlock->size;
+    }
+
+    if (pPrevFreeBlock != nullptr) pPrevFreeBlock->next = pNextBlock;
+    else _M_pFreeBlocks = pNextBlock;
+
+    return true;
+}
+
+void* heap_resource::do_reallocate (pointer p, size_type uOldSize, size_type uSize, align_type uAlign)
+{
+    if (!p) return do_allocate (uSize, uAlign);
+
+    if (p < _M_pBegin || _M_pEnd <= p) throw std::out_of_range ("pointer is outside the buffer!");
+
+    if (uSize && (_M_pControl ? _M_pControl->resize (p, uSize) : resize_block (p, uSize))) return p;
+
+    return memory_resource::do_reallocate (p, uOldSize, uSize, uAlign);
 }
 
 void heap_resource::clear () noexcept
 {
+    if (_M_pControl)
+    {
+        _M_pControl = tlsf_control::create (_M_pBegin, _M_pEnd);
+        return;
+    }
+
     _M_pFreeBlocks       = direct_cast<free_block*> (_M_pBegin);
     _M_pFreeBlocks->size = capacity ();
     _M_pFreeBlocks->next = nullptr;
@@ -249,6 +820,7 @@ void heap_resource::clear () noexcept
 
 memory_resource::size_type heap_resource::max_size () const noexcept
 {
+    if (_M_pControl) return _M_pControl->max_size ();
     if (_M_pFreeBlocks == nullptr) return size_type ();
 
     auto size        = _M_pFreeBlocks->size;
@@ -257,7 +829,7 @@ memory_resource::size_type heap_resource::max_size () const noexcept
     while (pFreeBlocks && _M_pBegin <= pFreeBlocks && (pFreeBlocks  + 1) < _M_pEnd)
     {
         if (pFreeBlocks->size > size) size = pFreeBlocks->size;
-        pFreeBlocks = _M_pFreeBlocks->next;
+        pFreeBlocks = pFreeBlocks->next;
     }
 
     return size;
@@ -267,44 +839,11 @@ memory_resource::size_type heap_resource::max_size () const noexcept
 // List Allocator
 // =========================================================
 
-constexpr void* forward_alloc (list_resource::header*    const hdr,
-                            list_resource::header*    const prev_hdr,
-                            list_resource::size_type  const size,
-                            list_resource::align_type const align) noexcept
+//! free blocks start with a header of the whole block size & the next free block,
+//! used blocks keep a header right before the payload with the block size & the block start
+constexpr list_resource::header* used_header (void* p) noexcept
 {
-    typedef list_resource::header header;
-
-    // get aligned address from header pointer
-    void* ptr = next_aligned_addr (hdr, align);
-
-    // determine the location of the new forwarding header
-    header* split_hdr = static_cast<header*> (ptr) + size;
-
-    split_hdr->size = hdr->size - size;
-    split_hdr->next = hdr->next;
-
-    if (prev_hdr) prev_hdr->next = split_hdr;
-    return ptr;
-}
-
-constexpr list_resource::header* find (list_resource::header*          hdr,
-                                    list_resource::header*&         prev_hdr,
-                                    list_resource::size_type  const size,
-                                    list_resource::align_type const align) noexcept
-{
-    typedef list_resource::header       header ;
-    typedef list_resource::math_pointer pointer;
-
-    for (header* pCurHeader = hdr; pCurHeader; prev_hdr = pCurHeader, pCurHeader = pCurHeader->next)
-    {
-        if (pCurHeader->size >= size &&
-                (static_cast<pointer> (next_aligned_addr (pCurHeader, align)) + pCurHeader->size)
-                 <= static_cast<pointer> (static_cast<void*> (pCurHeader + pCurHeader->size)))
-            return pCurHeader;
-    }
-
-    // couldn't find free block large enough!
-    return nullptr;
+    return static_cast<list_resource::header*> (p) - 1;
 }
 
 // =========================================================
@@ -319,11 +858,7 @@ list_resource::list_resource (size_type uSize)
   _M_pFirstFreeBlock (static_cast<header*> (_M_pBegin)),
   _M_bIsMemShared (&_M_gOwner != this ? _M_gOwner.is_shared () : false)
 {
-    if (_M_pFirstFreeBlock != nullptr)
-    {
-        _M_pFirstFreeBlock->size = capacity () - sizeof (header);
-        _M_pFirstFreeBlock->next = nullptr;
-    }
+    if (_M_pFirstFreeBlock != nullptr) clear ();
 }
 
 list_resource::list_resource (pointer buffer, size_type uSize)
@@ -333,15 +868,8 @@ list_resource::list_resource (pointer buffer, size_type uSize)
   _M_pFirstFreeBlock (static_cast<header*> (_M_pBegin)),
   _M_bIsMemShared ()
 {
-    if (_M_pFirstFreeBlock != nullptr)
-    {
-        _M_pFirstFreeBlock->size = capacity () - sizeof (header);
-        _M_pFirstFreeBlock->next = nullptr;
-    }
-    else
-    {
-        throw std::bad_alloc ();
-    }
+    if (_M_pFirstFreeBlock != nullptr) clear ();
+    else throw std::bad_alloc ();
 }
 
 list_resource::list_resource (memory_resource& pOwner, size_type uSize)
@@ -355,11 +883,7 @@ list_resource::list_resource (memory_resource& pOwner, size_type uSize)
   _M_pFirstFreeBlock (static_cast<header*> (_M_pBegin)),
   _M_bIsMemShared (&_M_gOwner != this ? _M_gOwner.is_shared () : false)
 {
-    if (_M_pFirstFreeBlock != nullptr)
-    {
-        _M_pFirstFreeBlock->size = distance (_M_pEnd, _M_pBegin);
-        _M_pFirstFreeBlock->next = nullptr;
-    }
+    if (_M_pFirstFreeBlock != nullptr) clear ();
 
     if (&_M_gOwner != &pOwner)
     {
@@ -376,29 +900,96 @@ list_resource::~list_resource ()
 
 void list_resource::defragment () noexcept
 {
-    for (header* pCurHeader = _M_pFirstFreeBlock; pCurHeader;
-         pCurHeader = pCurHeader->next)
+    for (header* pCurHeader = _M_pFirstFreeBlock; pCurHeader; pCurHeader = pCurHeader->next)
     {
-        for (header* pItHeader = _M_pFirstFreeBlock->next; pItHeader;
-             pItHeader = pItHeader->next)
+        while (pCurHeader->next &&
+               direct_cast<math_pointer> (pCurHeader) + pCurHeader->size ==
+               direct_cast<math_pointer> (pCurHeader->next))
         {
-            if ((pCurHeader + pCurHeader->size) == pItHeader)
-            {
-                pCurHeader->size = pItHeader->size + pCurHeader->size;
-                pCurHeader->next = pItHeader->next;
-            }
+            pCurHeader->size += pCurHeader->next->size;
+            pCurHeader->next  = pCurHeader->next->next;
         }
     }
 }
 
+//! insert the block in the address ordered free list & merge it with its free neighbours
+void list_resource::release_block (header* pBlock) noexcept
+{
+    header* pPrevHdr = nullptr;
+    header* pNextHdr = _M_pFirstFreeBlock;
+
+    while (pNextHdr && pNextHdr < pBlock)
+    {
+        pPrevHdr = pNextHdr;
+        pNextHdr = pNextHdr->next;
+    }
+
+    pBlock->next = pNextHdr;
+
+    if (pNextHdr && direct_cast<math_pointer> (pBlock) + pBlock->size == direct_cast<math_pointer> (pNextHdr))
+    {
+        pBlock->size += pNextHdr->size;
+        pBlock->next  = pNextHdr->next;
+    }
+
+    if (pPrevHdr && direct_cast<math_pointer> (pPrevHdr) + pPrevHdr->size == direct_cast<math_pointer> (pBlock))
+    {
+        pPrevHdr->size += pBlock->size;
+        pPrevHdr->next  = pBlock->next;
+    }
+    else if (pPrevHdr)
+    {
+        pPrevHdr->next = pBlock;
+    }
+    else
+    {
+        _M_pFirstFreeBlock = pBlock;
+    }
+}
+
 void* list_resource::do_allocate (size_type uSize, align_type uAlign)
 {
-    if (_M_pFirstFreeBlock and uSize)
+    if (!_M_pFirstFreeBlock || !uSize) throw std::bad_alloc ();
+
+    uAlign = std::max (uAlign, alignof (header));
+    uSize  = aligned_size (uSize, alignof (header));
+
+    header* pPrevHdr = nullptr;
+
+    //! first fit
+    for (header* pCurHdr = _M_pFirstFreeBlock; pCurHdr; pPrevHdr = pCurHdr, pCurHdr = pCurHdr->next)
     {
-        header* pPrevHeader   = nullptr;
-        header* pTargetHeader = find (_M_pFirstFreeBlock, pPrevHeader, uSize, uAlign);
+        auto const pBlock = direct_cast<math_pointer> (pCurHdr);
+        auto const p      = static_cast<math_pointer> (next_aligned_addr (pCurHdr + 1, uAlign));
+        auto       uBytes = static_cast<size_type> (p - pBlock) + uSize;
+
+        if (pCurHdr->size < uBytes) continue;
+
+        header* pNextHdr = pCurHdr->next;
+
+        //! split when the remaining memory can hold another block
+        if (pCurHdr->size - uBytes >= 2 * sizeof (header))
+        {
+            auto const pSplitHdr = reinterpret_cast<header*> (pBlock + uBytes);
+
+            pSplitHdr->size = pCurHdr->size - uBytes;
+            pSplitHdr->next = pNextHdr;
+            pNextHdr        = pSplitHdr;
+        }
+        else
+        {
+            uBytes = pCurHdr->size;
+        }
 
-        if (pTargetHeader) return forward_alloc (pTargetHeader, pPrevHeader, uSize, uAlign);
+        if (pPrevHdr) pPrevHdr->next = pNextHdr;
+        else _M_pFirstFreeBlock = pNextHdr;
+
+        auto const pHeader = used_header (p);
+
+        pHeader->size = uBytes;
+        pHeader->next = pCurHdr;
+
+        return p;
     }
 
     // couldn't find free block large enough!
@@ -406,37 +997,90 @@ void* list_resource::do_allocate (size_type uSize, align_type uAlign)
     return nullptr;
 }
 
-void list_resource::do_deallocate (pointer p, size_type uSize, align_type uAlign)
+//! grow into the free block that follows or give the trailing space back
+bool list_resource::resize_block (pointer p, size_type uSize) noexcept
 {
-    if (!_M_pFirstFreeBlock || p < _M_pBegin || _M_pEnd <= p)
-        throw std::out_of_range ("pointer is outside the buffer!");
+    auto const pHeader = used_header (p);
+    auto const pBlock  = direct_cast<math_pointer> (pHeader->next);
+    auto const pEnd    = pBlock + pHeader->size;
+    auto const uBytes  = static_cast<size_type> (static_cast<math_pointer> (p) - pBlock) +
+                         aligned_size (uSize, alignof (header));
+
+    if (uBytes <= pHeader->size)
+    {
+        if (pHeader->size - uBytes >= 2 * sizeof (header))
+        {
+            auto const pTailHdr = reinterpret_cast<header*> (pBlock + uBytes);
+
+            pTailHdr->size = pHeader->size - uBytes;
+            pHeader->size  = uBytes;
+            release_block (pTailHdr);
+        }
+
+        return true;
+    }
 
-    auto pHeader = shift_to_header<header> (p, uAlign);
-    auto bFound  = false;
+    header* pPrevHdr = nullptr;
+    header* pNextHdr = _M_pFirstFreeBlock;
 
-    if (pHeader->size != uSize)
+    while (pNextHdr && direct_cast<math_pointer> (pNextHdr) < pEnd)
     {
-        uSize = pHeader->size;
-        //throw std::length_error ("deallocate size doesn't match!");
+        pPrevHdr = pNextHdr;
+        pNextHdr = pNextHdr->next;
     }
 
-    header* pPrevHdr = _M_pFirstFreeBlock;
+    if (direct_cast<math_pointer> (pNextHdr) != pEnd || pHeader->size + pNextHdr->size < uBytes)
+        return false;
 
-    for (header* pCurHdr = pPrevHdr; pCurHdr; pPrevHdr = pCurHdr, pCurHdr = pCurHdr->next)
+    auto const uRemaining = pHeader->size + pNextHdr->size - uBytes;
+    header*    pFollowing = pNextHdr->next;
+
+    if (uRemaining >= 2 * sizeof (header))
     {
-        if (pCurHdr == pHeader)
-        {
-            pPrevHdr->next = pHeader->next;
-            bFound = true;
-        }
+        auto const pSplitHdr = reinterpret_cast<header*> (pBlock + uBytes);
+
+        pSplitHdr->size = uRemaining;
+        pSplitHdr->next = pFollowing;
+        pFollowing      = pSplitHdr;
+        pHeader->size   = uBytes;
     }
+    else
+    {
+        pHeader->size += pNextHdr->size;
+    }
+
+    if (pPrevHdr) pPrevHdr->next = pFollowing;
+    else _M_pFirstFreeBlock = pFollowing;
+
+    return true;
+}
+
+void* list_resource::do_reallocate (pointer p, size_type uOldSize, size_type uSize, align_type uAlign)
+{
+    if (!p) return do_allocate (uSize, uAlign);
+
+    if (p < _M_pBegin || _M_pEnd <= p) throw std::out_of_range ("pointer is outside the buffer!");
 
-    if (bFound) pPrevHdr->next = pHeader;
-    else throw std::logic_error ("pointer NOT found!");
+    if (uSize && resize_block (p, uSize)) return p;
+
+    return memory_resource::do_reallocate (p, uOldSize, uSize, uAlign);
+}
+
+void list_resource::do_deallocate (pointer p, size_type, align_type)
+{
+    if (!_M_pBegin || p < _M_pBegin || _M_pEnd <= p)
+        throw std::out_of_range ("pointer is outside the buffer!");
+
+    auto const pHeader = used_header (p);
+    auto const pBlock  = pHeader->next;
+
+    pBlock->size = pHeader->size;
+    release_block (pBlock);
 }
 
 void list_resource::clear () noexcept
 {
+    _M_pFirstFreeBlock       = static_cast<header*> (_M_pBegin);
     _M_pFirstFreeBlock->size = distance (_M_pEnd, _M_pBegin);
     _M_pFirstFreeBlock->next = nullptr;
 }
@@ -447,7 +1091,8 @@ list_resource::size_type list_resource::max_size () const noexcept
 
     for (header* pCurHeader = _M_pFirstFreeBlock; pCurHeader; pCurHeader = pCurHeader->next)
         if (uMaxSize < pCurHeader->size) uMaxSize = pCurHeader->size;
-    return uMaxSize;
+
+    return uMaxSize > 2 * sizeof (header) ? uMaxSize - 2 * sizeof (header) : size_type ();
 }
 
 } } // namespace Memory
@@ -34,6 +34,9 @@
 #    ifdef OS_GNU_LINUX
 #        include <fcntl.h>
 #        include <stdio.h>
+#        include <sched.h>
+#        include <sys/syscall.h>
+#        include <malloc.h>
 #    endif
 #endif
 
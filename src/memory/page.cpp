@@ -21,13 +21,379 @@
 
 #include <cppual/memory/page.h>
 
+#ifdef OS_GNU_LINUX
+#   include "os/linux.h"
+#elif defined (OS_MACX)
+#   include "os/mac.h"
+#elif defined (OS_AIX)
+#   include "os/aix.h"
+#elif defined (OS_SOLARIS)
+#   include "os/solaris.h"
+#elif defined (OS_BSD)
+#   include "os/bsd.h"
+#elif defined (OS_WINDOWS)
+#   include "os/win.h"
+#elif defined (OS_ANDROID)
+#   include "os/android.h"
+#elif defined (OS_IOS)
+#   include "os/ios.h"
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+// =========================================================
+
+namespace cppual::memory { namespace { /// optimized for internal usage
+
+// =========================================================
+
+typedef memory_resource::size_type size_type;
+typedef memory_resource::pointer   pointer  ;
+
 // =========================================================
 
-namespace cppual::memory {
+#if defined (OS_STD_UNIX) && defined (MAP_NORESERVE)
+inline constexpr int reserve_flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+#elif defined (OS_STD_UNIX)
+inline constexpr int reserve_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#endif
+
+//! map address space without physical backing
+pointer os_reserve (size_type uBytes, bool bWritable) noexcept
+{
+#   if defined (OS_STD_UNIX)
+    auto const p = ::mmap (nullptr, uBytes,
+                           bWritable ? PROT_READ | PROT_WRITE : PROT_NONE,
+                           reserve_flags, -1, 0);
+
+    return p != MAP_FAILED ? p : nullptr;
+#   elif defined (OS_WINDOWS)
+    return ::VirtualAlloc (nullptr, uBytes,
+                           bWritable ? MEM_RESERVE | MEM_COMMIT : MEM_RESERVE,
+                           bWritable ? PAGE_READWRITE : PAGE_NOACCESS);
+#   else
+    return nullptr;
+#   endif
+}
+
+void os_release (pointer p, size_type uBytes) noexcept
+{
+#   if defined (OS_STD_UNIX)
+    ::munmap (p, uBytes);
+#   elif defined (OS_WINDOWS)
+    ::VirtualFree (p, 0, MEM_RELEASE);
+    static_cast<void> (uBytes);
+#   else
+    static_cast<void> (p); static_cast<void> (uBytes);
+#   endif
+}
+
+bool os_commit (pointer p, size_type uBytes) noexcept
+{
+#   if defined (OS_STD_UNIX)
+    return ::mprotect (p, uBytes, PROT_READ | PROT_WRITE) == 0;
+#   elif defined (OS_WINDOWS)
+    return ::VirtualAlloc (p, uBytes, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#   else
+    static_cast<void> (p); static_cast<void> (uBytes);
+    return false;
+#   endif
+}
+
+//! drop the physical pages and make the range inaccessible again
+void os_decommit (pointer p, size_type uBytes) noexcept
+{
+#   if defined (OS_STD_UNIX)
+    ::madvise  (p, uBytes, MADV_DONTNEED);
+    ::mprotect (p, uBytes, PROT_NONE);
+#   elif defined (OS_WINDOWS)
+    ::VirtualFree (p, uBytes, MEM_DECOMMIT);
+#   else
+    static_cast<void> (p); static_cast<void> (uBytes);
+#   endif
+}
+
+//! drop the physical pages of a writable range that stays accessible
+void os_discard (pointer p, size_type uBytes) noexcept
+{
+#   if defined (OS_STD_UNIX)
+    ::madvise (p, uBytes, MADV_DONTNEED);
+#   elif defined (OS_WINDOWS)
+    ::VirtualFree (p, uBytes, MEM_DECOMMIT);
+    ::VirtualAlloc (p, uBytes, MEM_COMMIT, PAGE_READWRITE);
+#   else
+    static_cast<void> (p); static_cast<void> (uBytes);
+#   endif
+}
+
+inline size_type reserve_page_count (size_type uBytes) noexcept
+{
+    return std::max ((uBytes + page_resource::page_size () - 1) / page_resource::page_size (),
+                     size_type (1));
+}
+
+} // anonymous namespace
 
 // =========================================================
 
+page_resource::page_resource (size_type uReserveSize, bool bGuardPages)
+: _M_pBase       (static_cast<math_pointer> (os_reserve (reserve_page_count (uReserveSize) *
+                                                         page_size (), false))),
+  _M_pRuns       (static_cast<free_run*> (os_reserve (reserve_page_count (uReserveSize) *
+                                                      sizeof (free_run), true))),
+  _M_uPageSize   (page_size ()),
+  _M_uPages      (reserve_page_count (uReserveSize)),
+  _M_uTop        (bGuardPages ? 1U : 0U),
+  _M_uFreeRuns   (npos),
+  _M_uCount      (),
+  _M_uCommitted  (),
+  _M_bGuardPages (bGuardPages)
+{
+    if (!_M_pBase || !_M_pRuns)
+    {
+        if (_M_pBase) os_release (_M_pBase, _M_uPages * _M_uPageSize   );
+        if (_M_pRuns) os_release (_M_pRuns, _M_uPages * sizeof (free_run));
+
+        throw std::bad_alloc ();
+    }
+}
+
+page_resource::~page_resource ()
+{
+    os_release (_M_pBase, _M_uPages * _M_uPageSize   );
+    os_release (_M_pRuns, _M_uPages * sizeof (free_run));
+}
+
+page_resource::size_type page_resource::page_size () noexcept
+{
+    static const size_type uPageSize = []
+    {
+#       if defined (OS_STD_UNIX)
+        return static_cast<size_type> (::sysconf (_SC_PAGESIZE));
+#       elif defined (OS_WINDOWS)
+        SYSTEM_INFO gInfo;
+        ::GetSystemInfo (&gInfo);
+        return static_cast<size_type> (gInfo.dwPageSize);
+#       else
+        return size_type (4096);
+#       endif
+    }();
+
+    return uPageSize;
+}
+
+void page_resource::clear () noexcept
+{
+    if (_M_uCommitted) os_decommit (_M_pBase, _M_uPages * _M_uPageSize);
+
+    os_discard (_M_pRuns, _M_uPages * sizeof (free_run));
+
+    _M_uTop       = _M_bGuardPages ? 1U : 0U;
+    _M_uFreeRuns  = npos;
+    _M_uCount     = 0;
+    _M_uCommitted = 0;
+}
+
+page_resource::size_type page_resource::max_size () const noexcept
+{
+    auto uPages = _M_uPages - _M_uTop;
+
+    for (auto uRun = _M_uFreeRuns; uRun != npos; uRun = _M_pRuns[uRun].next)
+        uPages = std::max (uPages, _M_pRuns[uRun].pages);
+
+    auto const uGuard = _M_bGuardPages ? 1U : 0U;
+
+    return uPages > uGuard ? (uPages - uGuard) * _M_uPageSize : size_type ();
+}
+
+void page_resource::commit (size_type uPage, size_type uCount)
+{
+    if (!os_commit (page_address (uPage), uCount * _M_uPageSize)) throw std::bad_alloc ();
+
+    _M_uCommitted += uCount;
+}
+
+void page_resource::decommit (size_type uPage, size_type uCount) noexcept
+{
+    os_decommit (page_address (uPage), uCount * _M_uPageSize);
+
+    _M_uCommitted -= uCount;
+}
+
+//! return a decommitted run either to the top or to the address ordered free list
+void page_resource::release_run (size_type uPage, size_type uCount) noexcept
+{
+    auto uPrevPrev = npos;
+    auto uPrev     = npos;
+    auto uNext     = _M_uFreeRuns;
+
+    while (uNext != npos && uNext < uPage)
+    {
+        uPrevPrev = uPrev;
+        uPrev     = uNext;
+        uNext     = _M_pRuns[uNext].next;
+    }
+
+    // merge with the following free run
+    if (uNext == uPage + uCount)
+    {
+        uCount += _M_pRuns[uNext].pages;
+        uNext   = _M_pRuns[uNext].next;
+    }
+
+    // merge with the preceding free run
+    if (uPrev != npos && uPrev + _M_pRuns[uPrev].pages == uPage)
+    {
+        uPage   = uPrev;
+        uCount += _M_pRuns[uPrev].pages;
+        uPrev   = uPrevPrev;
+    }
+
+    if (uPage + uCount == _M_uTop)
+    {
+        _M_uTop = uPage;
+        uPrev == npos ? _M_uFreeRuns = uNext : _M_pRuns[uPrev].next = uNext;
+        return;
+    }
+
+    _M_pRuns[uPage] = free_run { uCount, uNext };
+    uPrev == npos ? _M_uFreeRuns = uPage : _M_pRuns[uPrev].next = uPage;
+}
+
+//! take the first pages of the free run starting at the given page
+bool page_resource::take_run (size_type uPage, size_type uCount) noexcept
+{
+    auto uPrev = npos;
+    auto uRun  = _M_uFreeRuns;
+
+    while (uRun != npos && uRun < uPage)
+    {
+        uPrev = uRun;
+        uRun  = _M_pRuns[uRun].next;
+    }
+
+    if (uRun != uPage || _M_pRuns[uRun].pages < uCount) return false;
+
+    auto uNext = _M_pRuns[uRun].next;
+
+    if (_M_pRuns[uRun].pages > uCount)
+    {
+        _M_pRuns[uRun + uCount] = free_run { _M_pRuns[uRun].pages - uCount, uNext };
+        uNext = uRun + uCount;
+    }
+
+    uPrev == npos ? _M_uFreeRuns = uNext : _M_pRuns[uPrev].next = uNext;
+    return true;
+}
+
+page_resource::pointer page_resource::do_allocate (size_type uBytes, align_type uAlign)
+{
+    // runs start on a page boundary
+    if (uAlign > _M_uPageSize) throw std::bad_alloc ();
+
+    auto const uCount = run_pages (std::max (uBytes, size_type (1)));
+    auto const uGuard = _M_bGuardPages ? 1U : 0U;
+    auto       uPage  = npos;
+
+    // first fit over the released runs before growing the top
+    for (auto uRun = _M_uFreeRuns; uRun != npos; uRun = _M_pRuns[uRun].next)
+    {
+        if (_M_pRuns[uRun].pages >= uCount)
+        {
+            uPage = uRun;
+            take_run (uPage, uCount);
+            break;
+        }
+    }
+
+    if (uPage == npos)
+    {
+        if (_M_uPages - _M_uTop < uCount) throw std::bad_alloc ();
+
+        uPage    = _M_uTop;
+        _M_uTop += uCount;
+    }
+
+    try
+    {
+        commit (uPage, uCount - uGuard);
+    }
+    catch (std::bad_alloc&)
+    {
+        release_run (uPage, uCount);
+        throw;
+    }
+
+    ++_M_uCount;
+    return page_address (uPage);
+}
+
+void page_resource::do_deallocate (pointer p, size_type uBytes, align_type)
+{
+    auto const pBytes = static_cast<math_pointer> (p);
+
+    if (pBytes < _M_pBase || page_address (_M_uTop) <= pBytes)
+        throw std::out_of_range ("pointer is outside the reserved range!");
+
+    auto const uPage  = page_index (p);
+    auto const uCount = run_pages (std::max (uBytes, size_type (1)));
+
+    decommit    (uPage, uCount - (_M_bGuardPages ? 1U : 0U));
+    release_run (uPage, uCount);
+
+    --_M_uCount;
+}
+
+//! grow or shrink in place by committing or decommitting the pages at the end,
+//! the data is only copied when the following pages are taken
+page_resource::pointer page_resource::do_reallocate (pointer   p       ,
+                                                     size_type uOldSize,
+                                                     size_type uSize   ,
+                                                     align_type uAlign )
+{
+    if (!p) return do_allocate (uSize, uAlign);
+
+    auto const uPage     = page_index (p);
+    auto const uOldCount = run_pages (std::max (uOldSize, size_type (1)));
+    auto const uCount    = run_pages (std::max (uSize   , size_type (1)));
+    auto const uGuard    = _M_bGuardPages ? 1U : 0U;
+
+    if (uCount == uOldCount) return p;
+
+    // the new guard page is the first decommitted one
+    if (uCount < uOldCount)
+    {
+        decommit    (uPage + uCount - uGuard, uOldCount - uCount);
+        release_run (uPage + uCount, uOldCount - uCount);
+        return p;
+    }
+
+    auto const uEnd   = uPage + uOldCount;
+    auto const uExtra = uCount - uOldCount;
+
+    if (uEnd == _M_uTop && _M_uPages - _M_uTop >= uExtra)
+    {
+        _M_uTop += uExtra;
+    }
+    else if (!take_run (uEnd, uExtra))
+    {
+        return memory_resource::do_reallocate (p, uOldSize, uSize, uAlign);
+    }
+
+    try
+    {
+        commit (uEnd - uGuard, uExtra);
+    }
+    catch (std::bad_alloc&)
+    {
+        release_run (uEnd, uExtra);
+        throw;
+    }
 
+    return p;
+}
 
 // =========================================================
 
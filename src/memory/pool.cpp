@@ -23,6 +23,7 @@
 #include <cppual/casts>
 
 #include <cassert>
+#include <atomic>
 #include <iostream>
 
 // =========================================================
@@ -163,6 +164,180 @@ void uniform_pool_resource::clear () noexcept
 
 // =========================================================
 
+atomic_uniform_pool_resource::atomic_uniform_pool_resource (size_type  uBlkCount,
+                                                            size_type  uBlkSize,
+                                                            align_type uBlkAlign)
+: _M_gOwner (uBlkCount && uBlkSize ?
+                 get_default_resource().max_size() >= (uBlkCount * uBlkSize + max_adjust) ?
+                 get_default_resource() : new_delete_resource() : *this),
+  _M_pBegin (uBlkCount && uBlkSize ?
+                    _M_gOwner.allocate (uBlkCount * uBlkSize + max_adjust, uBlkAlign) : nullptr),
+  _M_pEnd (_M_pBegin != nullptr ?
+            static_cast<math_pointer> (_M_pBegin) + (uBlkCount * uBlkSize + max_adjust) : nullptr),
+  _M_pFirst    (),
+  _M_uBlkSize  (uBlkSize),
+  _M_uBlkAlign (uBlkAlign),
+  _M_uBlkNum   (),
+  _M_bIsMemShared (&_M_gOwner != this ? _M_gOwner.is_shared () : false),
+  _M_pHead       (),
+  _M_uUsedBlocks ()
+{
+    initialize ();
+}
+
+atomic_uniform_pool_resource::atomic_uniform_pool_resource (pointer    buffer,
+                                                            size_type  uBlkCount,
+                                                            size_type  uBlkSize,
+                                                            align_type uBlkAlign)
+: _M_gOwner (*this),
+  _M_pBegin (buffer && uBlkCount && uBlkSize ? buffer : nullptr),
+  _M_pEnd (_M_pBegin ? static_cast<math_pointer> (_M_pBegin) + (uBlkCount * uBlkSize) : nullptr),
+  _M_pFirst    (),
+  _M_uBlkSize  (uBlkSize),
+  _M_uBlkAlign (uBlkAlign),
+  _M_uBlkNum   (),
+  _M_bIsMemShared (),
+  _M_pHead       (),
+  _M_uUsedBlocks ()
+{
+    initialize ();
+}
+
+atomic_uniform_pool_resource::atomic_uniform_pool_resource (memory_resource& pOwner,
+                                                            size_type        uBlkCount,
+                                                            size_type        uBlkSize,
+                                                            align_type       uBlkAlign)
+: _M_gOwner (uBlkCount && uBlkSize ?
+            (uBlkCount * uBlkSize + max_adjust) > pOwner.max_size () ?
+            (uBlkCount * uBlkSize + max_adjust) > get_default_resource().max_size () ?
+                         new_delete_resource () : get_default_resource () : pOwner : *this),
+  _M_pBegin (uBlkCount && uBlkSize ?
+                 _M_gOwner.allocate (uBlkCount * uBlkSize + max_adjust, uBlkAlign) : nullptr),
+  _M_pEnd (_M_pBegin != nullptr ?
+            static_cast<math_pointer> (_M_pBegin) + (uBlkCount * uBlkSize + max_adjust) : nullptr),
+  _M_pFirst    (),
+  _M_uBlkSize  (uBlkSize),
+  _M_uBlkAlign (uBlkAlign),
+  _M_uBlkNum   (),
+  _M_bIsMemShared (&_M_gOwner != this ? _M_gOwner.is_shared () : false),
+  _M_pHead       (),
+  _M_uUsedBlocks ()
+{
+    if (&_M_gOwner != &pOwner)
+    {
+        std::cerr << __func__
+                  << " :: Specified owner cannot be assigned -> 'max_size' exceeded. "
+                     "Using default memory resource instead." << std::endl;
+    }
+
+    initialize ();
+}
+
+atomic_uniform_pool_resource::~atomic_uniform_pool_resource ()
+{
+    if (_M_pBegin && &_M_gOwner != this)
+        _M_gOwner.deallocate (_M_pBegin,
+                              static_cast<size_type> (static_cast<math_pointer> (_M_pEnd) -
+                                                      static_cast<math_pointer> (_M_pBegin)),
+                              _M_uBlkAlign);
+}
+
+void atomic_uniform_pool_resource::initialize () noexcept
+{
+    // every free block stores the index of the next free block
+    // so it must be able to hold one and be aligned for it
+    if (!_M_pBegin || _M_uBlkSize < sizeof (index_type) || _M_uBlkSize % alignof (index_type))
+        return;
+
+    auto const uAdjust = align_adjust (_M_pBegin, _M_uBlkAlign);
+    auto const uSize   = static_cast<size_type> (static_cast<math_pointer> (_M_pEnd) -
+                                                 static_cast<math_pointer> (_M_pBegin));
+
+    if (uSize <= uAdjust) return;
+
+    _M_pFirst  = static_cast<math_pointer> (_M_pBegin) + uAdjust;
+    _M_uBlkNum = (uSize - uAdjust) / _M_uBlkSize;
+
+    if (_M_uBlkNum > static_cast<size_type> (static_cast<index_type> (-1) - 1U))
+        _M_uBlkNum = static_cast<size_type> (static_cast<index_type> (-1) - 1U);
+
+    clear ();
+}
+
+void* atomic_uniform_pool_resource::do_allocate (size_type uSize, align_type uAlign)
+{
+    // check if size and alignment match with the ones from
+    // the current pool instance
+    if (uSize  != _M_uBlkSize ) throw std::length_error ("not equal to block size");
+    if (uAlign != _M_uBlkAlign) throw std::length_error ("wrong alignment");
+
+    head_type uHead = _M_pHead.load (std::memory_order_acquire);
+    pointer   p;
+
+    do
+    {
+        if (!head_index (uHead)) throw std::bad_alloc ();
+
+        p = block_at (head_index (uHead));
+
+        // the block may be popped and overwritten by another thread at any time,
+        // in which case the tag changes and the exchange below fails
+        auto const uNext = std::atomic_ref<index_type> (*static_cast<index_type*> (p))
+                           .load (std::memory_order_relaxed);
+
+        if (_M_pHead.compare_exchange_weak (uHead, make_head (uHead, uNext),
+                                            std::memory_order_acquire,
+                                            std::memory_order_acquire))
+            break;
+    }
+    while (true);
+
+    _M_uUsedBlocks.fetch_add (1, std::memory_order_relaxed);
+    return p;
+}
+
+void atomic_uniform_pool_resource::do_deallocate (void* p, size_type uSize, align_type uAlign)
+{
+    if (uSize  != _M_uBlkSize ) throw std::length_error ("not equal to block size");
+    if (uAlign != _M_uBlkAlign) throw std::length_error ("wrong alignment");
+
+    auto const uOffset = static_cast<size_type> (static_cast<math_pointer> (p) -
+                                                 static_cast<math_pointer> (_M_pFirst));
+
+    if (p < _M_pFirst || uOffset >= _M_uBlkNum * _M_uBlkSize || uOffset % _M_uBlkSize)
+        throw std::out_of_range ("pointer is outside the buffer");
+
+    auto const uIdx  = static_cast<index_type> (uOffset / _M_uBlkSize + 1U);
+    head_type  uHead = _M_pHead.load (std::memory_order_relaxed);
+
+    do
+    {
+        std::atomic_ref<index_type> (*static_cast<index_type*> (p))
+                .store (head_index (uHead), std::memory_order_relaxed);
+    }
+    while (!_M_pHead.compare_exchange_weak (uHead, make_head (uHead, uIdx),
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed));
+
+    _M_uUsedBlocks.fetch_sub (1, std::memory_order_relaxed);
+}
+
+void atomic_uniform_pool_resource::clear () noexcept
+{
+    if (!_M_uBlkNum) return;
+
+    for (index_type i = 1; i < _M_uBlkNum; ++i)
+        *static_cast<index_type*> (block_at (i)) = i + 1U;
+
+    *static_cast<index_type*> (block_at (static_cast<index_type> (_M_uBlkNum))) = 0;
+
+    _M_pHead.store (make_head (_M_pHead.load (std::memory_order_relaxed), 1U),
+                    std::memory_order_release);
+    _M_uUsedBlocks.store (0, std::memory_order_relaxed);
+}
+
+// =========================================================
+
 } // namespace Memory
 
 // =========================================================
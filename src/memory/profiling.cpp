@@ -0,0 +1,478 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cppual/memory/profiling.h>
+
+#if defined (OS_GNU_LINUX) || defined (OS_MACX)
+#   include <execinfo.h>
+#   include <dlfcn.h>
+#elif defined (OS_WINDOWS)
+#   include "os/win.h"
+#endif
+
+#ifdef __GNUG__
+#   include <cxxabi.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// =========================================================
+
+namespace cppual::memory {
+
+// =========================================================
+
+namespace { //! optimize for internal usage - anonymous namespace
+
+typedef memory_resource::size_type size_type;
+typedef memory_resource::pointer   pointer  ;
+
+//! frames of the profiler itself that are dropped from every call stack
+inline constexpr size_type skip_frames = 2;
+
+struct call_stack
+{
+    pointer   frames[profiling_resource::max_frames];
+    size_type depth;
+
+    inline bool operator == (call_stack const& gObj) const noexcept
+    {
+        return depth == gObj.depth &&
+               std::equal (frames, frames + depth, gObj.frames);
+    }
+};
+
+struct call_stack_hash
+{
+    inline std::size_t operator () (call_stack const& gStack) const noexcept
+    {
+        //! fnv-1a over the return addresses
+        auto uHash = static_cast<u64> (14695981039346656037ULL);
+
+        for (auto i = 0U; i < gStack.depth; ++i)
+        {
+            uHash ^= reinterpret_cast<uptr> (gStack.frames[i]);
+            uHash *= 1099511628211ULL;
+        }
+
+        return static_cast<std::size_t> (uHash);
+    }
+};
+
+//! per-thread poisson process over the allocated bytes
+struct sampler
+{
+    u64       state     ;
+    size_type bytes_left;
+
+    //! exponentially distributed interval with a mean of uPeriod bytes
+    size_type next_interval (size_type uPeriod) noexcept
+    {
+        if (!state) state = reinterpret_cast<uptr> (this) ^
+                            static_cast<u64> (std::chrono::steady_clock::now ().time_since_epoch ().count ()) ^
+                            0x9E3779B97F4A7C15ULL;
+
+        //! xorshift64*
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+
+        auto const dUniform = static_cast<double> (((state * 2685821657736338717ULL) >> 11) + 1) * 0x1.0p-53;
+
+        return static_cast<size_type> (-std::log (dUniform) * static_cast<double> (uPeriod)) + 1;
+    }
+};
+
+inline sampler& local_sampler () noexcept
+{
+    static thread_local sampler gSampler { };
+    return gSampler;
+}
+
+//! inverse of the probability that an allocation of uSize bytes is sampled
+inline double sample_weight (size_type uSize, size_type uPeriod) noexcept
+{
+    if (!uPeriod || !uSize) return 1.0;
+
+    return 1.0 / -std::expm1 (-static_cast<double> (uSize) / static_cast<double> (uPeriod));
+}
+
+#if defined (__GNUC__) || defined (__clang__)
+__attribute__ ((noinline))
+#elif defined (_MSC_VER)
+__declspec (noinline)
+#endif
+size_type capture_stack (pointer* pFrames) noexcept
+{
+#   if defined (OS_GNU_LINUX) || defined (OS_MACX)
+    pointer gFrames[profiling_resource::max_frames + skip_frames];
+
+    auto const nDepth = ::backtrace (gFrames, static_cast<int> (profiling_resource::max_frames + skip_frames));
+
+    if (nDepth <= static_cast<int> (skip_frames)) return 0;
+
+    auto const uDepth = static_cast<size_type> (nDepth) - skip_frames;
+
+    std::copy (gFrames + skip_frames, gFrames + skip_frames + uDepth, pFrames);
+    return uDepth;
+#   elif defined (OS_WINDOWS)
+    return ::RtlCaptureStackBackTrace (static_cast<DWORD> (skip_frames),
+                                       static_cast<DWORD> (profiling_resource::max_frames),
+                                       pFrames, nullptr);
+#   else
+    static_cast<void> (pFrames);
+    return 0;
+#   endif
+}
+
+//! demangled function name of a return address or its hex value
+std::string symbol_name (memory_resource::const_pointer pAddr)
+{
+#   if defined (OS_GNU_LINUX) || defined (OS_MACX)
+    ::Dl_info gInfo;
+
+    if (::dladdr (pAddr, &gInfo) && gInfo.dli_sname)
+    {
+#       ifdef __GNUG__
+        int  nStatus = 0;
+        auto pName   = abi::__cxa_demangle (gInfo.dli_sname, nullptr, nullptr, &nStatus);
+
+        if (pName)
+        {
+            std::string gName (pName);
+
+            std::free (pName);
+
+            //! ';' separates the frames of the collapsed format
+            std::replace (gName.begin (), gName.end (), ';', ',');
+            return gName;
+        }
+#       endif
+
+        return gInfo.dli_sname;
+    }
+#   endif
+
+    std::ostringstream gStream;
+
+    gStream << pAddr;
+    return gStream.str ();
+}
+
+} //! anonymous namespace
+
+// =========================================================
+
+struct profiling_resource::call_site
+{
+    //! raw sampled counters -> pprof reverses the sampling itself
+    size_type live_count ;
+    size_type live_bytes ;
+    size_type alloc_count;
+    size_type alloc_bytes;
+
+    //! estimated totals
+    double    live_weight ;
+    double    alloc_weight;
+    double    lifetime    ;
+};
+
+struct profiling_resource::profile
+{
+    struct sample
+    {
+        call_site*             site  ;
+        size_type              size  ;
+        double                 weight;
+        clock_type::time_point time  ;
+    };
+
+    std::unordered_map<call_stack, call_site, call_stack_hash> sites  ;
+    std::unordered_map<const_pointer, sample>                  samples;
+    clock_type::time_point                                     start  ;
+};
+
+// =========================================================
+
+profiling_resource::profiling_resource (memory_resource& rc, size_type uSamplePeriod)
+: _M_gOwner        (rc),
+  _M_gMutex        (),
+  _M_pProfile      (new profile { { }, { }, clock_type::now () }),
+  _M_gFilter       (),
+  _M_uSamplePeriod (uSamplePeriod)
+{ }
+
+profiling_resource::~profiling_resource ()
+{
+    delete _M_pProfile;
+}
+
+bool profiling_resource::should_sample (size_type uSize) const noexcept
+{
+    if (!_M_uSamplePeriod) return true;
+
+    auto& gSampler = local_sampler ();
+
+    if (!gSampler.state) gSampler.bytes_left = gSampler.next_interval (_M_uSamplePeriod);
+
+    if (gSampler.bytes_left > uSize)
+    {
+        gSampler.bytes_left -= uSize;
+        return false;
+    }
+
+    gSampler.bytes_left = gSampler.next_interval (_M_uSamplePeriod);
+    return true;
+}
+
+void profiling_resource::record (pointer p, size_type uSize)
+{
+    call_stack gStack;
+
+    gStack.depth = capture_stack (gStack.frames);
+
+    auto const dWeight = sample_weight (uSize, _M_uSamplePeriod);
+    auto const gNow    = clock_type::now ();
+
+    std::lock_guard<std::mutex> gLock (_M_gMutex);
+
+    //! the address was released behind the profiler's back (ex. by the owner)
+    if (_M_gFilter[filter_index (p)].load (std::memory_order_relaxed)) forget_locked (p);
+
+    auto& gSite = _M_pProfile->sites.try_emplace (gStack, call_site { }).first->second;
+
+    _M_pProfile->samples.emplace (p, profile::sample { &gSite, uSize, dWeight, gNow });
+
+    ++gSite.live_count ;
+    ++gSite.alloc_count;
+
+    gSite.live_bytes   += uSize;
+    gSite.alloc_bytes  += uSize;
+    gSite.live_weight  += dWeight * static_cast<double> (uSize);
+    gSite.alloc_weight += dWeight * static_cast<double> (uSize);
+
+    _M_gFilter[filter_index (p)].fetch_add (1, std::memory_order_relaxed);
+}
+
+void profiling_resource::forget (const_pointer p)
+{
+    //! no sampled allocation hashes to the slot -> not sampled
+    if (!_M_gFilter[filter_index (p)].load (std::memory_order_relaxed)) return;
+
+    std::lock_guard<std::mutex> gLock (_M_gMutex);
+
+    forget_locked (p);
+}
+
+void profiling_resource::forget_locked (const_pointer p)
+{
+    auto const it = _M_pProfile->samples.find (p);
+
+    if (it == _M_pProfile->samples.end ()) return;
+
+    auto const& gSample = it->second;
+    auto&       gSite   = *gSample.site;
+
+    auto const uLifetime = std::chrono::duration_cast<std::chrono::microseconds>
+                           (clock_type::now () - gSample.time).count ();
+
+    --gSite.live_count;
+
+    gSite.live_bytes  -= gSample.size;
+    gSite.live_weight -= gSample.weight * static_cast<double> (gSample.size);
+    gSite.lifetime    += gSample.weight * static_cast<double> (uLifetime);
+
+    _M_pProfile->samples.erase (it);
+    _M_gFilter[filter_index (p)].fetch_sub (1, std::memory_order_relaxed);
+}
+
+void profiling_resource::reset ()
+{
+    std::lock_guard<std::mutex> gLock (_M_gMutex);
+
+    for (auto it = _M_pProfile->sites.begin (); it != _M_pProfile->sites.end (); )
+    {
+        if (!it->second.live_count)
+        {
+            it = _M_pProfile->sites.erase (it);
+            continue;
+        }
+
+        it->second.alloc_count  = it->second.live_count ;
+        it->second.alloc_bytes  = it->second.live_bytes ;
+        it->second.alloc_weight = it->second.live_weight;
+        it->second.lifetime     = 0.0;
+        ++it;
+    }
+
+    _M_pProfile->start = clock_type::now ();
+}
+
+profiling_resource::size_type profiling_resource::sample_count () const
+{
+    std::lock_guard<std::mutex> gLock (_M_gMutex);
+
+    return _M_pProfile->samples.size ();
+}
+
+profiling_resource::duration profiling_resource::elapsed () const
+{
+    std::lock_guard<std::mutex> gLock (_M_gMutex);
+
+    return clock_type::now () - _M_pProfile->start;
+}
+
+void profiling_resource::write_pprof (std::ostream& os) const
+{
+    std::vector<std::pair<call_stack, call_site>> gSites;
+
+    {
+        std::lock_guard<std::mutex> gLock (_M_gMutex);
+
+        gSites.assign (_M_pProfile->sites.begin (), _M_pProfile->sites.end ());
+    }
+
+    call_site gTotal { };
+
+    for (auto const& gSite : gSites)
+    {
+        gTotal.live_count  += gSite.second.live_count ;
+        gTotal.live_bytes  += gSite.second.live_bytes ;
+        gTotal.alloc_count += gSite.second.alloc_count;
+        gTotal.alloc_bytes += gSite.second.alloc_bytes;
+    }
+
+    os << "heap profile: "
+       << gTotal.live_count  << ": " << gTotal.live_bytes  << " ["
+       << gTotal.alloc_count << ": " << gTotal.alloc_bytes << "] @ heap_v2/"
+       << std::max (_M_uSamplePeriod, size_type (1)) << '\n';
+
+    for (auto const& gSite : gSites)
+    {
+        os << gSite.second.live_count  << ": " << gSite.second.live_bytes  << " ["
+           << gSite.second.alloc_count << ": " << gSite.second.alloc_bytes << "] @";
+
+        for (auto i = 0U; i < gSite.first.depth; ++i)
+        {
+            os << " 0x" << std::hex << reinterpret_cast<uptr> (gSite.first.frames[i]) << std::dec;
+        }
+
+        os << '\n';
+    }
+
+    //! pprof needs the memory map to symbolize the addresses
+    os << "\nMAPPED_LIBRARIES:\n";
+
+#   ifdef OS_GNU_LINUX
+    std::ifstream gMaps ("/proc/self/maps");
+
+    os << gMaps.rdbuf ();
+#   endif
+}
+
+void profiling_resource::write_collapsed (std::ostream& os, profile_type eType) const
+{
+    std::vector<std::pair<call_stack, double>> gSites;
+
+    {
+        std::lock_guard<std::mutex> gLock (_M_gMutex);
+
+        for (auto const& gSite : _M_pProfile->sites)
+        {
+            auto const dValue = eType == profile_type::live      ? gSite.second.live_weight  :
+                                eType == profile_type::allocated ? gSite.second.alloc_weight :
+                                                                   gSite.second.lifetime     ;
+
+            if (dValue >= 0.5) gSites.emplace_back (gSite.first, dValue);
+        }
+    }
+
+    std::unordered_map<const_pointer, std::string> gSymbols;
+
+    for (auto const& gSite : gSites)
+    {
+        if (!gSite.first.depth) os << "[unknown]";
+
+        //! root first
+        for (auto i = gSite.first.depth; i-- > 0; )
+        {
+            auto const pFrame = gSite.first.frames[i];
+            auto       it     = gSymbols.find (pFrame);
+
+            if (it == gSymbols.end ()) it = gSymbols.emplace (pFrame, symbol_name (pFrame)).first;
+
+            os << it->second << (i ? ";" : "");
+        }
+
+        os << ' ' << static_cast<u64> (std::llround (gSite.second)) << '\n';
+    }
+}
+
+void* profiling_resource::do_allocate (size_type uSize, align_type uAlign)
+{
+    auto const p = _M_gOwner.allocate (uSize, uAlign);
+
+    if (should_sample (uSize))
+    {
+        //! the profiler never fails an allocation -> drop the sample instead
+        try { record (p, uSize); }
+        catch (std::bad_alloc&) { }
+    }
+
+    return p;
+}
+
+void* profiling_resource::do_reallocate (pointer p, size_type uOldSize, size_type uSize, align_type uAlign)
+{
+    if (p) forget (p);
+
+    auto const pNew = _M_gOwner.reallocate (p, uOldSize, uSize, uAlign);
+
+    if (should_sample (uSize))
+    {
+        try { record (pNew, uSize); }
+        catch (std::bad_alloc&) { }
+    }
+
+    return pNew;
+}
+
+void profiling_resource::do_deallocate (pointer p, size_type uSize, align_type uAlign)
+{
+    forget (p);
+
+    _M_gOwner.deallocate (p, uSize, uAlign);
+}
+
+// =========================================================
+
+} // namespace Memory
+
+// =========================================================
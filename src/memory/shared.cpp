@@ -50,13 +50,13 @@ namespace cppual::memory { namespace { /// optimized for internal usage
 
 constexpr int convert_state (state_type eState) noexcept
 {
-    return eState == state_type::read_only ?
-                O_RDONLY | O_EXCL : eState == state_type::read_write ? O_RDWR | O_EXCL : O_EXCL;
+    return eState == state_type::read_only ? O_RDONLY : O_RDWR;
 }
 
 constexpr int convert_mode (mode_type eMode) noexcept
 {
-    return eMode == mode_type::create ? O_CREAT : 0;
+    return eMode == mode_type::create         ? O_CREAT | O_EXCL :
+           eMode == mode_type::create_or_open ? O_CREAT          : 0;
 }
 
 #endif
@@ -82,9 +82,15 @@ shared_object::~shared_object () noexcept
 #   endif
 }
 
-bool shared_object::truncate (size_type /*mem_size*/) noexcept
+bool shared_object::truncate (size_type uSize) noexcept
 {
+#   if defined (OS_STD_UNIX) && !defined (OS_ANDROID)
+    //! a new object is zero filled up to the new size
+    return valid () && ::ftruncate (handle<int> (), static_cast<off_t> (uSize)) == 0;
+#   else
+    UNUSED (uSize);
     return false;
+#   endif
 }
 
 // =========================================================
@@ -0,0 +1,473 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cppual/memory/shared_heap.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+// =========================================================
+
+namespace cppual::memory {
+
+// =========================================================
+
+namespace { //! optimize for internal usage - anonymous namespace
+
+typedef shared_heap::size_type       size_type      ;
+typedef shared_heap::difference_type difference_type;
+
+//! "CPPUALSH"
+inline constexpr u64 heap_magic = 0x4850554C41505043ULL;
+
+enum : u32
+{
+    heap_empty       ,
+    heap_initializing,
+    heap_ready
+};
+
+enum : u32
+{
+    name_free        ,
+    name_constructing,
+    name_ready
+};
+
+//! the smallest remainder worth splitting off a block (a header + one granule)
+inline constexpr size_type min_split = shared_heap::max_align * 2;
+
+constexpr size_type align_up (size_type uValue, size_type uAlign) noexcept
+{ return (uValue + uAlign - 1) & ~(uAlign - 1); }
+
+inline void spin_pause (u32 uSpins) noexcept
+{
+    //! the owner can be another process -> no futex, just back off
+    if (uSpins < 64)
+    {
+#       if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+        __builtin_ia32_pause ();
+#       endif
+    }
+    else
+    {
+        std::this_thread::yield ();
+    }
+}
+
+} //! anonymous namespace
+
+// =========================================================
+
+struct shared_heap::free_block
+{
+    size_type       size;
+    difference_type next;
+};
+
+struct shared_heap::used_header
+{
+    size_type size ;
+    size_type shift;
+};
+
+// =========================================================
+
+shared_heap& shared_heap::create_or_open (pointer p, size_type uSize)
+{
+    auto const uFirst = align_up (sizeof (shared_heap), max_align);
+
+    if (!p || reinterpret_cast<uptr> (p) % max_align || uSize < uFirst + min_split)
+        throw std::invalid_argument ("invalid shared heap memory!");
+
+    auto& gHeap  = *static_cast<shared_heap*> (p);
+    auto  uState = u32 (heap_empty);
+
+    if (gHeap._M_gState.compare_exchange_strong (uState, heap_initializing, std::memory_order_acq_rel))
+    {
+        gHeap.initialize (uSize);
+        gHeap._M_gState.store (heap_ready, std::memory_order_release);
+    }
+    else
+    {
+        for (auto uSpins = 0U; gHeap._M_gState.load (std::memory_order_acquire) != heap_ready; ++uSpins)
+            spin_pause (uSpins);
+    }
+
+    if (gHeap._M_uMagic != heap_magic) throw std::runtime_error ("not a shared heap!");
+
+    return gHeap;
+}
+
+void shared_heap::initialize (size_type uSize) noexcept
+{
+    auto const uFirst = align_up (sizeof (shared_heap), max_align);
+    auto const pBlock = reinterpret_cast<free_block*> (reinterpret_cast<math_pointer> (this) + uFirst);
+
+    _M_gLock.store (0, std::memory_order_relaxed);
+
+    _M_uMagic    = heap_magic;
+    _M_uSize     = uSize;
+    _M_uFree     = (uSize - uFirst) & ~(max_align - 1);
+    _M_iFreeList = static_cast<difference_type> (uFirst);
+
+    std::memset (static_cast<void*> (_M_gNames), 0, sizeof (_M_gNames));
+
+    pBlock->size = _M_uFree;
+    pBlock->next = difference_type ();
+}
+
+void shared_heap::lock () const noexcept
+{
+    for (auto uSpins = 0U; _M_gLock.exchange (1, std::memory_order_acquire); )
+    {
+        while (_M_gLock.load (std::memory_order_relaxed)) spin_pause (uSpins++);
+    }
+}
+
+void shared_heap::unlock () const noexcept
+{
+    _M_gLock.store (0, std::memory_order_release);
+}
+
+shared_heap::free_block* shared_heap::block_at (difference_type iOffset) const noexcept
+{
+    return reinterpret_cast<free_block*> (reinterpret_cast<uptr> (this) + static_cast<uptr> (iOffset));
+}
+
+shared_heap::pointer shared_heap::allocate (size_type uSize, align_type uAlign)
+{
+    uAlign = std::max (uAlign, max_align);
+
+    auto const uPayload = align_up (std::max (uSize, size_type (1)), max_align);
+
+    lock ();
+
+    for (auto pLink = &_M_iFreeList; *pLink; pLink = &block_at (*pLink)->next)
+    {
+        auto const pFree   = block_at (*pLink);
+        auto const pBlock  = reinterpret_cast<math_pointer> (pFree);
+        auto const pData   = reinterpret_cast<math_pointer> (align_up (reinterpret_cast<uptr> (pBlock) +
+                                                                       sizeof (used_header), uAlign));
+        auto       uNeeded = static_cast<size_type> (pData - pBlock) + uPayload;
+
+        if (uNeeded > pFree->size) continue;
+
+        if (pFree->size - uNeeded >= min_split)
+        {
+            auto const pRest = reinterpret_cast<free_block*> (pBlock + uNeeded);
+
+            pRest->size = pFree->size - uNeeded;
+            pRest->next = pFree->next;
+            *pLink     += static_cast<difference_type> (uNeeded);
+        }
+        else
+        {
+            uNeeded = pFree->size;
+            *pLink  = pFree->next;
+        }
+
+        _M_uFree -= uNeeded;
+
+        auto const pHeader = reinterpret_cast<used_header*> (pData) - 1;
+
+        pHeader->size  = uNeeded;
+        pHeader->shift = static_cast<size_type> (pData - pBlock);
+
+        unlock ();
+        return pData;
+    }
+
+    unlock ();
+    throw std::bad_alloc ();
+}
+
+//! insert a block into the address ordered free list & merge it with its neighbours
+void shared_heap::release (math_pointer pBlock, size_type uSize) noexcept
+{
+    auto const iOffset = pBlock - reinterpret_cast<math_pointer> (this);
+    auto       pLink   = &_M_iFreeList;
+    free_block* pPrev  = nullptr;
+
+    while (*pLink && *pLink < iOffset)
+    {
+        pPrev = block_at (*pLink);
+        pLink = &pPrev->next;
+    }
+
+    auto const pNew = reinterpret_cast<free_block*> (pBlock);
+
+    pNew->size = uSize;
+    pNew->next = *pLink;
+
+    if (pNew->next && iOffset + static_cast<difference_type> (uSize) == pNew->next)
+    {
+        auto const pNext = block_at (pNew->next);
+
+        pNew->size += pNext->size;
+        pNew->next  = pNext->next;
+    }
+
+    if (pPrev && reinterpret_cast<math_pointer> (pPrev) + pPrev->size == pBlock)
+    {
+        pPrev->size += pNew->size;
+        pPrev->next  = pNew->next;
+    }
+    else
+    {
+        *pLink = iOffset;
+    }
+
+    _M_uFree += uSize;
+}
+
+void shared_heap::deallocate (pointer p, size_type, align_type)
+{
+    if (!p) return;
+
+    auto const pHeader = static_cast<used_header*> (p) - 1;
+    auto const pBlock  = static_cast<math_pointer> (p) - pHeader->shift;
+
+    if (pBlock < reinterpret_cast<math_pointer> (this + 1) ||
+        pBlock + pHeader->size > reinterpret_cast<math_pointer> (this) + _M_uSize)
+        throw std::out_of_range ("pointer doesn't belong to the shared heap!");
+
+    lock ();
+    release (pBlock, pHeader->size);
+    unlock ();
+}
+
+shared_heap::pointer shared_heap::reallocate (pointer p, size_type uOldSize, size_type uSize, align_type uAlign)
+{
+    if (!p) return allocate (uSize, uAlign);
+
+    auto const pHeader    = static_cast<used_header*> (p) - 1;
+    auto const pBlock     = static_cast<math_pointer> (p) - pHeader->shift;
+    auto const uBlockSize = pHeader->size;
+    auto const uNeeded    = pHeader->shift + align_up (std::max (uSize, size_type (1)), max_align);
+
+    lock ();
+
+    //! shrink in place & return the tail to the free list
+    if (uNeeded <= uBlockSize)
+    {
+        if (uBlockSize - uNeeded >= min_split)
+        {
+            pHeader->size = uNeeded;
+            release (pBlock + uNeeded, uBlockSize - uNeeded);
+        }
+
+        unlock ();
+        return p;
+    }
+
+    //! grow in place into the following free block
+    auto const iEnd = (pBlock + uBlockSize) - reinterpret_cast<math_pointer> (this);
+    auto       pLink = &_M_iFreeList;
+
+    while (*pLink && *pLink < iEnd) pLink = &block_at (*pLink)->next;
+
+    if (*pLink == iEnd && uBlockSize + block_at (iEnd)->size >= uNeeded)
+    {
+        auto const pNext  = block_at (iEnd);
+        auto const uTotal = uBlockSize + pNext->size;
+
+        *pLink    = pNext->next;
+        _M_uFree -= pNext->size;
+
+        if (uTotal - uNeeded >= min_split)
+        {
+            pHeader->size = uNeeded;
+            release (pBlock + uNeeded, uTotal - uNeeded);
+        }
+        else
+        {
+            pHeader->size = uTotal;
+        }
+
+        unlock ();
+        return p;
+    }
+
+    unlock ();
+
+    auto const pNew = allocate (uSize, uAlign);
+
+    std::memcpy (pNew, p, std::min (uOldSize, uSize));
+    deallocate (p, uOldSize, uAlign);
+
+    return pNew;
+}
+
+shared_heap::size_type shared_heap::free_size () const noexcept
+{
+    lock ();
+
+    auto const uFree = _M_uFree;
+
+    unlock ();
+    return uFree;
+}
+
+shared_heap::size_type shared_heap::max_size () const noexcept
+{
+    auto uMaxSize = size_type ();
+
+    lock ();
+
+    for (auto iOffset = _M_iFreeList; iOffset; iOffset = block_at (iOffset)->next)
+        uMaxSize = std::max (uMaxSize, block_at (iOffset)->size);
+
+    unlock ();
+
+    return uMaxSize > sizeof (used_header) ? uMaxSize - sizeof (used_header) : size_type ();
+}
+
+// =========================================================
+
+shared_heap::size_type shared_heap::reserve_name (string_view gName)
+{
+    if (gName.empty () || gName.size () > max_name_length)
+        throw std::length_error ("invalid shared object name!");
+
+    for (auto uSpins = 0U; ; spin_pause (uSpins++))
+    {
+        auto uFree  = npos;
+        auto bWait  = false;
+
+        lock ();
+
+        for (auto i = 0U; i < max_names; ++i)
+        {
+            auto const& gObj = _M_gNames[i];
+
+            if (gObj.state == name_free)
+            {
+                if (uFree == npos) uFree = i;
+            }
+            else if (gName == gObj.name)
+            {
+                //! another process is still constructing it
+                bWait = gObj.state == name_constructing;
+
+                if (!bWait)
+                {
+                    unlock ();
+                    return npos;
+                }
+
+                break;
+            }
+        }
+
+        if (bWait)
+        {
+            unlock ();
+            continue;
+        }
+
+        if (uFree == npos)
+        {
+            unlock ();
+            throw std::length_error ("too many shared objects!");
+        }
+
+        auto& gObj = _M_gNames[uFree];
+
+        gObj.state  = name_constructing;
+        gObj.offset = difference_type ();
+
+        std::memcpy (gObj.name, gName.data (), gName.size ());
+        gObj.name[gName.size ()] = '\0';
+
+        unlock ();
+        return uFree;
+    }
+}
+
+void shared_heap::publish_name (size_type uIdx, pointer p) noexcept
+{
+    lock ();
+
+    _M_gNames[uIdx].offset = static_cast<math_pointer> (p) - reinterpret_cast<math_pointer> (this);
+    _M_gNames[uIdx].state  = name_ready;
+
+    unlock ();
+}
+
+void shared_heap::release_name (size_type uIdx) noexcept
+{
+    lock ();
+
+    _M_gNames[uIdx].state   = name_free;
+    _M_gNames[uIdx].name[0] = '\0';
+
+    unlock ();
+}
+
+shared_heap::pointer shared_heap::find_name (string_view gName) const
+{
+    pointer p = nullptr;
+
+    lock ();
+
+    for (auto const& gObj : _M_gNames)
+    {
+        if (gObj.state == name_ready && gName == gObj.name)
+        {
+            p = reinterpret_cast<math_pointer> (const_cast<shared_heap*> (this)) + gObj.offset;
+            break;
+        }
+    }
+
+    unlock ();
+    return p;
+}
+
+shared_heap::pointer shared_heap::unlink_name (string_view gName) noexcept
+{
+    pointer p = nullptr;
+
+    lock ();
+
+    for (auto& gObj : _M_gNames)
+    {
+        if (gObj.state == name_ready && gName == gObj.name)
+        {
+            p = reinterpret_cast<math_pointer> (this) + gObj.offset;
+
+            gObj.state   = name_free;
+            gObj.name[0] = '\0';
+            break;
+        }
+    }
+
+    unlock ();
+    return p;
+}
+
+// =========================================================
+
+} // namespace Memory
+
+// =========================================================
@@ -0,0 +1,197 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cppual/memory/slab.h>
+
+#include <new>
+
+// =========================================================
+
+namespace cppual::memory {
+
+// =========================================================
+
+//! slab header followed by the blocks in the same upstream allocation
+struct slab_resource::slab
+{
+    slab*                 next ;
+    math_pointer          begin;
+    math_pointer          end  ;
+    size_type             bytes;
+    uniform_pool_resource pool ;
+
+    slab (math_pointer pBegin, size_type uBytes, size_type uBlocks, size_type uClass)
+    : next  (),
+      begin (pBegin),
+      end   (pBegin + uBlocks * class_size (uClass)),
+      bytes (uBytes),
+      pool  (pBegin, uBlocks, class_size (uClass), class_align (uClass))
+    { }
+
+    constexpr bool contains (const_pointer p) const noexcept
+    { return p >= begin && p < end; }
+
+    inline bool is_full  () const noexcept { return !pool.max_size ()                  ; }
+    inline bool is_empty () const noexcept { return  pool.max_size () == pool.capacity (); }
+};
+
+// =========================================================
+
+slab_resource::slab_resource (size_type uSlabBlocks)
+: slab_resource (get_default_resource (), uSlabBlocks)
+{ }
+
+slab_resource::slab_resource (memory_resource& rc, size_type uSlabBlocks)
+: _M_gOwner      (rc),
+  _M_gClasses    (),
+  _M_uSlabBlocks (uSlabBlocks ? uSlabBlocks : 1U),
+  _M_uCapacity   ()
+{
+    for (auto& gClass : _M_gClasses) gClass.next_blocks = _M_uSlabBlocks;
+}
+
+slab_resource::~slab_resource ()
+{
+    release ();
+}
+
+void slab_resource::release () noexcept
+{
+    for (auto i = 0U; i < class_count; ++i)
+    {
+        while (_M_gClasses[i].slabs)
+        {
+            auto const pSlab = _M_gClasses[i].slabs;
+
+            _M_gClasses[i].slabs = pSlab->next;
+            release_slab (pSlab);
+        }
+
+        _M_gClasses[i].next_blocks = _M_uSlabBlocks;
+    }
+}
+
+slab_resource::slab* slab_resource::grow (size_type uClass)
+{
+    //! the blocks start right after the header at max_align
+    constexpr static auto slab_header_size = (sizeof (slab) + max_align - 1) & ~(max_align - 1);
+
+    auto& gClass = _M_gClasses[uClass];
+
+    auto const uBlocks = gClass.next_blocks;
+    auto const uBytes  = slab_header_size + uBlocks * class_size (uClass);
+    auto const pBuffer = static_cast<math_pointer> (_M_gOwner.allocate (uBytes, max_align));
+
+    auto const pSlab = new (pBuffer) slab (pBuffer + slab_header_size, uBytes, uBlocks, uClass);
+
+    pSlab->next   = gClass.slabs;
+    gClass.slabs  = pSlab;
+    _M_uCapacity += uBytes;
+
+    // geometric growth up to the maximum slab size
+    if (uBlocks * 2U * class_size (uClass) <= max_slab_size) gClass.next_blocks = uBlocks * 2U;
+
+    return pSlab;
+}
+
+void slab_resource::release_slab (slab* pSlab) noexcept
+{
+    auto const uBytes = pSlab->bytes;
+
+    _M_uCapacity -= uBytes;
+    pSlab->~slab ();
+    _M_gOwner.deallocate (pSlab, uBytes, max_align);
+}
+
+void* slab_resource::do_allocate (size_type uSize, align_type uAlign)
+{
+    auto const uClass = size_class (uSize, uAlign);
+
+    if (uClass == class_count) return _M_gOwner.allocate (uSize, uAlign);
+
+    auto& gClass = _M_gClasses[uClass];
+    auto  pSlab  = gClass.slabs;
+
+    // the head slab is the one with free blocks in the common case
+    if (!pSlab || pSlab->is_full ())
+    {
+        slab* pPrev = pSlab;
+
+        for (pSlab = pSlab ? pSlab->next : nullptr; pSlab && pSlab->is_full (); pSlab = pSlab->next)
+            pPrev = pSlab;
+
+        if (pSlab)
+        {
+            pPrev->next  = pSlab->next;
+            pSlab->next  = gClass.slabs;
+            gClass.slabs = pSlab;
+        }
+        else
+        {
+            pSlab = grow (uClass);
+        }
+    }
+
+    return pSlab->pool.allocate (class_size (uClass), class_align (uClass));
+}
+
+void slab_resource::do_deallocate (pointer p, size_type uSize, align_type uAlign)
+{
+    auto const uClass = size_class (uSize, uAlign);
+
+    if (uClass == class_count) return _M_gOwner.deallocate (p, uSize, uAlign);
+
+    auto& gClass = _M_gClasses[uClass];
+    slab* pPrev  = nullptr;
+    auto  pSlab  = gClass.slabs;
+
+    while (pSlab && !pSlab->contains (p))
+    {
+        pPrev = pSlab;
+        pSlab = pSlab->next;
+    }
+
+    if (!pSlab) throw std::out_of_range ("pointer doesn't belong to any slab");
+
+    pSlab->pool.deallocate (p, class_size (uClass), class_align (uClass));
+
+    if (!pPrev) return;
+
+    // keep the head slab as a reserve and return the other empty ones upstream,
+    // otherwise move the slab with a free block to the front of the chain
+    if (pSlab->is_empty ())
+    {
+        pPrev->next = pSlab->next;
+        release_slab (pSlab);
+    }
+    else if (gClass.slabs->is_full ())
+    {
+        pPrev->next  = pSlab->next;
+        pSlab->next  = gClass.slabs;
+        gClass.slabs = pSlab;
+    }
+}
+
+// =========================================================
+
+} // namespace Memory
+
+// =========================================================
@@ -22,6 +22,7 @@
 #include <cppual/memory/stacked.h>
 #include <cppual/memory/mop.h>
 
+#include <algorithm>
 #include <iostream>
 #include <new>
 
@@ -33,19 +34,29 @@ namespace cppual::memory {
 
 namespace { //! optimize for internal usage - anonymous namespace
 
-constexpr memory_resource::difference_type to_diff (u8 val) noexcept
+constexpr memory_resource::math_pointer to_math_ptr (memory_resource::pointer p) noexcept
 {
-    return static_cast<memory_resource::difference_type> (val);
+    return static_cast<memory_resource::math_pointer> (p);
 }
 
-constexpr u8 to_byte (memory_resource::difference_type val) noexcept
+//! every allocation takes whole max_align granules, so the markers stay aligned
+//! & the last allocation always ends exactly at the marker. the LIFO checks are
+//! then a single compare that never reads the memory of the allocations
+constexpr memory_resource::size_type granule (memory_resource::size_type uBytes) noexcept
 {
-    return static_cast<u8> (val);
+    return (uBytes + memory_resource::max_align - 1) & ~(memory_resource::max_align - 1);
 }
 
-constexpr memory_resource::math_pointer to_math_ptr (memory_resource::pointer p) noexcept
+inline memory_resource::math_pointer align_up (memory_resource::pointer p) noexcept
 {
-    return static_cast<memory_resource::math_pointer> (p);
+    return reinterpret_cast<memory_resource::math_pointer>
+            ((reinterpret_cast<uptr> (p) + memory_resource::max_align - 1) & ~(memory_resource::max_align - 1));
+}
+
+inline memory_resource::math_pointer align_down (memory_resource::pointer p) noexcept
+{
+    return reinterpret_cast<memory_resource::math_pointer>
+            (reinterpret_cast<uptr> (p) & ~(memory_resource::max_align - 1));
 }
 
 // =========================================================
@@ -54,12 +65,29 @@ constexpr memory_resource::math_pointer to_math_ptr (memory_resource::pointer p)
 
 // =========================================================
 
-stacked_resource::stacked_resource (size_type uSize)
+//! chained block header followed by the block memory.
+//! it keeps the state of the previous block to be restored when released
+struct stacked_resource::block
+{
+    block*    prev       ;
+    pointer   prev_begin ;
+    pointer   prev_end   ;
+    pointer   prev_marker;
+    size_type size       ;
+};
+
+// =========================================================
+
+stacked_resource::stacked_resource (size_type uSize, bool bGrowable)
 : _M_gOwner (uSize ? get_default_resource ().max_size () >= (uSize + max_adjust) ?
                      get_default_resource () : new_delete_resource () : *this),
   _M_pMarker (&_M_gOwner != this ? _M_gOwner.allocate (uSize + max_adjust, alignof (uptr)) : nullptr),
   _M_pBegin (_M_pMarker),
   _M_pEnd (_M_pBegin != nullptr ? static_cast<math_pointer> (_M_pBegin) + uSize + max_adjust : nullptr),
+  _M_pChain (),
+  _M_pSpare (),
+  _M_uChainSize (),
+  _M_uGrowSize (bGrowable ? (uSize + max_adjust) * 2U : 0U),
   _M_bIsMemShared (&_M_gOwner != this ? _M_gOwner.is_shared () : false)
 {
     if (!_M_pBegin) throw std::bad_alloc ();
@@ -70,19 +98,26 @@ stacked_resource::stacked_resource (pointer buffer, size_type uSize)
   _M_pMarker (buffer && uSize ? buffer : nullptr),
   _M_pBegin (_M_pMarker),
   _M_pEnd (_M_pBegin != nullptr ? static_cast<math_pointer> (_M_pBegin) + uSize : nullptr),
+  _M_pChain (),
+  _M_pSpare (),
+  _M_uChainSize (),
+  _M_uGrowSize (),
   _M_bIsMemShared ()
 {
     if (!_M_pBegin) throw std::bad_alloc ();
 }
 
-stacked_resource::stacked_resource (memory_resource& pOwner, size_type uSize)
+stacked_resource::stacked_resource (memory_resource& pOwner, size_type uSize, bool bGrowable)
 : _M_gOwner (uSize ? (uSize + max_adjust) > pOwner.max_size () ?
                          (uSize + max_adjust) > get_default_resource().max_size() ?
                              new_delete_resource() : get_default_resource() : pOwner : *this),
   _M_pMarker (&_M_gOwner != this ? _M_gOwner.allocate (uSize + max_adjust, alignof (uptr)) : nullptr),
   _M_pBegin (_M_pMarker),
   _M_pEnd (_M_pBegin != nullptr ? static_cast<math_pointer> (_M_pBegin) + uSize + max_adjust : nullptr),
-
+  _M_pChain (),
+  _M_pSpare (),
+  _M_uChainSize (),
+  _M_uGrowSize (bGrowable ? (uSize + max_adjust) * 2U : 0U),
   _M_bIsMemShared (&_M_gOwner != this ? _M_gOwner.is_shared () : false)
 {
     if (!_M_pBegin) throw std::bad_alloc ();
@@ -97,83 +132,171 @@ stacked_resource::stacked_resource (memory_resource& pOwner, size_type uSize)
 
 stacked_resource::~stacked_resource ()
 {
-    if (_M_pBegin && &_M_gOwner != this) _M_gOwner.deallocate (_M_pBegin, capacity ());
+    clear ();
+
+    if (_M_pSpare) _M_gOwner.deallocate (_M_pSpare, _M_pSpare->size, max_align);
+    if (_M_pBegin && &_M_gOwner != this) _M_gOwner.deallocate (_M_pBegin, capacity (), alignof (uptr));
 }
 
-void* stacked_resource::do_allocate (size_type uBytes, align_type uAlign)
+void stacked_resource::clear () noexcept
 {
-    if (!_M_pBegin or !uBytes) throw std::bad_alloc ();
-    if (!uAlign || uAlign > max_align) uAlign = alignof (uptr);
+    while (_M_pChain) pop_block ();
+
+    _M_pMarker = _M_pBegin;
+}
+
+stacked_resource::checkpoint stacked_resource::mark () const noexcept
+{
+    return { _M_pChain, _M_pMarker };
+}
+
+void stacked_resource::rewind (checkpoint const& gPoint) noexcept
+{
+    while (_M_pChain != gPoint.chain) pop_block ();
+
+    _M_pMarker = gPoint.marker;
+}
 
-    auto max_bytes = max_size ();
-    auto pMarker   = _M_pMarker;
+void stacked_resource::grow (size_type uBytes)
+{
+    //! the block memory starts right after the header at max_align
+    constexpr static auto header_size = (sizeof (block) + max_align - 1) & ~(max_align - 1);
 
-    if (!std::align (uAlign, uBytes, pMarker, max_bytes)) throw std::bad_alloc ();
+    block* pBlock;
 
-    auto const pNewMarker = to_math_ptr (pMarker) + uBytes;
+    if (_M_pSpare && _M_pSpare->size >= uBytes + header_size)
+    {
+        pBlock    = _M_pSpare;
+        _M_pSpare = nullptr;
+    }
+    else
+    {
+        auto const uSize = std::max (_M_uGrowSize, uBytes + header_size);
 
-    if (pNewMarker > _M_pEnd) throw std::bad_alloc ();
+        pBlock        = static_cast<block*> (_M_gOwner.allocate (uSize, max_align));
+        pBlock->size  = uSize;
+        _M_uGrowSize  = uSize * 2U;
+    }
 
-    auto const align_shift = to_byte (to_math_ptr (pMarker) - to_math_ptr (_M_pMarker));
+    pBlock->prev        = _M_pChain ;
+    pBlock->prev_begin  = _M_pBegin ;
+    pBlock->prev_end    = _M_pEnd   ;
+    pBlock->prev_marker = _M_pMarker;
 
-    if (align_shift > 0) *to_math_ptr (_M_pMarker) = align_shift;
+    _M_uChainSize += static_cast<size_type> (to_math_ptr (_M_pEnd) - to_math_ptr (_M_pBegin));
 
-    _M_pMarker = pNewMarker;
-    return       pMarker   ;
+    _M_pChain  = pBlock;
+    _M_pBegin  = to_math_ptr (pBlock) + header_size;
+    _M_pEnd    = to_math_ptr (pBlock) + pBlock->size;
+    _M_pMarker = _M_pBegin;
 }
 
-void* stacked_resource::do_reallocate(void* p, size_type old_size, size_type size, align_type align_size)
+void stacked_resource::pop_block () noexcept
 {
-    if (p)
+    auto pBlock = _M_pChain;
+
+    _M_pChain  = pBlock->prev       ;
+    _M_pBegin  = pBlock->prev_begin ;
+    _M_pEnd    = pBlock->prev_end   ;
+    _M_pMarker = pBlock->prev_marker;
+
+    _M_uChainSize -= static_cast<size_type> (to_math_ptr (_M_pEnd) - to_math_ptr (_M_pBegin));
+
+    // keep the larger block as a spare to avoid upstream
+    // round trips when rewinding around a block boundary
+    if (_M_pSpare)
     {
-        if (old_size && old_size == size) return p;
+        if (pBlock->size > _M_pSpare->size) std::swap (pBlock, _M_pSpare);
+        _M_gOwner.deallocate (pBlock, pBlock->size, max_align);
     }
     else
     {
-        p = _M_pMarker;
-        old_size = 0;
+        _M_pSpare = pBlock;
     }
+}
+
+void* stacked_resource::do_allocate (size_type uBytes, align_type)
+{
+    if (!_M_pBegin or !uBytes) throw std::bad_alloc ();
 
-    if (!align_size || align_size > max_align) align_size = alignof(uptr);
+    auto const uSize = granule (uBytes);
 
-    auto new_p   = p;
-    auto pMarker = to_math_ptr (new_p) + old_size;
+    //! only the beginning of a block can be unaligned
+    auto pMarker = align_up (_M_pMarker);
 
-    if (pMarker == _M_pMarker || (pMarker + *pMarker) == _M_pMarker)
+    if (pMarker > _M_pEnd || uSize > static_cast<size_type> (to_math_ptr (_M_pEnd) - pMarker))
     {
-        auto max = max_size () + old_size;
+        if (!is_growable ()) throw std::bad_alloc ();
 
-        if (std::align (align_size, size, new_p, max)) throw std::bad_alloc ();
+        grow (uSize);
 
-        auto const pNewMarker = static_cast<math_pointer> (new_p) + size;
+        pMarker = to_math_ptr (_M_pMarker);
 
-        if (pNewMarker > _M_pEnd) throw std::bad_alloc ();
+        if (uSize > static_cast<size_type> (to_math_ptr (_M_pEnd) - pMarker)) throw std::bad_alloc ();
+    }
 
-        auto const align_shift = to_byte (to_math_ptr (new_p) - to_math_ptr (p));
+    _M_pMarker = pMarker + uSize;
+    return       pMarker        ;
+}
 
-        if (old_size) std::memmove (new_p, p, old_size <= size ? old_size : size);
+//! the last allocation grows or shrinks in place by moving the marker,
+//! when it doesn't fit in the block anymore it continues in a new chained block
+void* stacked_resource::do_reallocate (void* p, size_type uOldSize, size_type uSize, align_type uAlign)
+{
+    if (!p) return do_allocate (uSize, uAlign);
+    if (uOldSize == uSize) return p;
 
-        if (align_shift > 0)
-        {
-            *to_math_ptr (p) = (pMarker + to_diff (*pMarker)) == _M_pMarker ?
-                               *pMarker + align_shift : align_shift;
-        }
+    auto const pBytes = to_math_ptr (p);
 
-        _M_pMarker = pNewMarker;
-    }
-    else
+    while (_M_pChain && _M_pMarker == _M_pBegin && (p < _M_pBegin || p >= _M_pEnd))
     {
+        pop_block ();
+    }
+
+    if (p < _M_pBegin || p >= _M_pEnd || pBytes + granule (uOldSize) != _M_pMarker)
         throw std::out_of_range ("pointer doesn't match the last element allocated!");
+
+    if (granule (uSize) <= static_cast<size_type> (to_math_ptr (_M_pEnd) - pBytes))
+    {
+        _M_pMarker = pBytes + granule (uSize);
+        return p;
+    }
+
+    if (!is_growable ()) throw std::bad_alloc ();
+
+    //! the released block keeps its data until it's copied
+    auto const pOldMarker = _M_pMarker;
+
+    _M_pMarker = p;
+
+    void* pNew;
+
+    try
+    {
+        pNew = do_allocate (uSize, uAlign);
+    }
+    catch (std::bad_alloc&)
+    {
+        _M_pMarker = pOldMarker;
+        throw;
     }
 
-    return new_p;
+    std::memcpy (pNew, p, uOldSize);
+    return pNew;
 }
 
 void stacked_resource::do_deallocate (pointer p, size_type uSize, align_type)
 {
-    auto const pMarker = to_math_ptr (p) + uSize;
+    auto const pMarker = to_math_ptr (p) + granule (uSize);
+
+    // an exhausted chained block is released lazily once
+    // the deallocations continue into the previous block
+    while (_M_pChain && _M_pMarker == _M_pBegin && (p < _M_pBegin || p >= _M_pEnd))
+    {
+        pop_block ();
+    }
 
-    if (pMarker == _M_pMarker || (pMarker + to_diff (*pMarker)) == _M_pMarker)
+    if (pMarker == _M_pMarker)
     {
         _M_pMarker = p;
     }
@@ -241,155 +364,77 @@ dstacked_resource::~dstacked_resource ()
     if (_M_pBegin && &_M_gOwner != this) _M_gOwner.deallocate (_M_pBegin, capacity ());
 }
 
-void* dstacked_resource::do_allocate (size_type uBytes, align_type uAlign)
+void* dstacked_resource::do_allocate (size_type uBytes, align_type)
 {
-    constexpr static auto align_uptr = static_cast<difference_type> (alignof (uptr));
-
     //! check whether there is enough space to allocate
     if (!_M_pBegin or !uBytes) throw std::bad_alloc ();
-    if (!uAlign || uAlign > max_align) uAlign = alignof (uptr);
-
-    auto max = max_size ();
 
-    if (uBytes < _M_uHint)
-    {
-        auto pMarker = _M_pTopMarker;
-
-        if (!std::align (uAlign, uBytes, pMarker, max)) throw std::bad_alloc ();
+    auto const uSize = granule (uBytes);
 
-        auto const pNewMarker = to_math_ptr (pMarker) + uBytes;
+    //! only the ends of the buffer can be unaligned
+    auto const pTopMarker    = align_up   (_M_pTopMarker   );
+    auto const pBottomMarker = align_down (_M_pBottomMarker);
 
-        if (pNewMarker > _M_pBottomMarker) throw std::bad_alloc ();
+    if (pTopMarker > pBottomMarker || uSize > static_cast<size_type> (pBottomMarker - pTopMarker))
+        throw std::bad_alloc ();
 
-        auto const align_shift = to_byte (to_math_ptr (pMarker) - to_math_ptr (_M_pTopMarker));
-
-        if (align_shift > 0) *to_math_ptr (_M_pTopMarker) = align_shift;
-
-        _M_pTopMarker = pNewMarker;
-        return          pMarker   ;
+    if (uBytes < _M_uHint)
+    {
+        _M_pTopMarker = pTopMarker + uSize;
+        return          pTopMarker        ;
     }
 
-    pointer    pNewBottomMarker          = static_cast<math_pointer> (_M_pBottomMarker) - uBytes;
-    auto const pNewUnalignedBottomMarker = static_cast<math_pointer> (pNewBottomMarker);
-
-    if (!std::align (uAlign, uBytes, pNewBottomMarker, max)) throw std::bad_alloc ();
-
-    auto const align_shift = ((pNewUnalignedBottomMarker - to_math_ptr (pNewBottomMarker)) +
-                               align_uptr) % align_uptr;
-
-    pNewBottomMarker = pNewUnalignedBottomMarker - align_shift;
-
-    if (pNewBottomMarker < _M_pTopMarker) throw std::bad_alloc();
-
-    if (align_shift > 0) *(to_math_ptr (pNewBottomMarker) + uBytes) = to_byte (align_shift);
-
-    return _M_pBottomMarker = pNewBottomMarker;
+    return _M_pBottomMarker = pBottomMarker - uSize;
 }
 
-void* dstacked_resource::do_reallocate (pointer p, size_type old_size, size_type size, align_type align_size)
+//! the last allocation of either side is resized without allocating a new block;
+//! the top side moves its marker, the bottom side moves the data down or up by the difference
+void* dstacked_resource::do_reallocate (pointer p, size_type uOldSize, size_type uSize, align_type uAlign)
 {
-    constexpr static auto align_uptr = static_cast<difference_type> (alignof (uptr));
+    if (!p) return do_allocate (uSize, uAlign);
+    if (uOldSize == uSize) return p;
 
-    auto const old_p = p;
+    auto const pBytes = to_math_ptr (p);
 
-    if (p)
-    {
-        if (old_size && old_size == size) return p;
-    }
-    else
+    // if the pointer belongs to the top side
+    if (pBytes + granule (uOldSize) == _M_pTopMarker)
     {
-        p = old_size < _M_uHint ? _M_pTopMarker : _M_pBottomMarker;
-        old_size = 0;
-    }
+        if (granule (uSize) > static_cast<size_type> (to_math_ptr (_M_pBottomMarker) - pBytes))
+            throw std::bad_alloc ();
 
-    if (!align_size || align_size > max_align) align_size = alignof (uptr);
-
-    auto new_p   = p;
-    auto pMarker = to_math_ptr (new_p) + old_size;
+        _M_pTopMarker = pBytes + granule (uSize);
+        return p;
+    }
 
-    if (pMarker == _M_pTopMarker                       ||
-       (pMarker + to_diff (*pMarker)) == _M_pTopMarker ||
-        p == _M_pBottomMarker                          ||
-       (to_math_ptr (_M_pBottomMarker) + to_diff (*to_math_ptr (_M_pBottomMarker))) == p)
+    // if the pointer belongs to the bottom side
+    if (p == _M_pBottomMarker)
     {
-        auto max = max_size () + old_size;
-
-        u8 align_shift = 0;
-
-        if (old_size < _M_uHint && size >= _M_uHint)
-        {
-            _M_pTopMarker = p;
-            p = new_p = (to_math_ptr (_M_pBottomMarker) - size);
-        }
-        else if (old_size >= _M_uHint && size < _M_uHint)
-        {
-            _M_pBottomMarker = pMarker;
-            p = new_p = _M_pTopMarker;
-        }
-        else if (old_size < _M_uHint && size < _M_uHint)
-        {
-            align_shift = (pMarker + to_diff (*pMarker)) == _M_pTopMarker ? *pMarker : 0;
-        }
-        else if (old_size >= _M_uHint && size >= _M_uHint)
-        {
-            align_shift = (to_math_ptr (_M_pBottomMarker) +
-                           to_diff (*to_math_ptr (_M_pBottomMarker))) == p ? *pMarker : 0;
-        }
-
-        if (std::align (align_size, size, new_p, max)) throw std::bad_alloc ();
+        auto const pEnd = pBytes + granule (uOldSize);
 
-        if (size < _M_uHint)
-        {
-            auto const pNewMarker = static_cast<math_pointer> (new_p) + size;
+        if (granule (uSize) > static_cast<size_type> (pEnd - to_math_ptr (_M_pTopMarker)))
+            throw std::bad_alloc ();
 
-            if (pNewMarker > _M_pBottomMarker) throw std::bad_alloc ();
+        auto const pNew = pEnd - granule (uSize);
 
-            align_shift += to_byte (to_math_ptr (new_p) - to_math_ptr (p));
+        std::memmove (pNew, p, uOldSize < uSize ? uOldSize : uSize);
 
-            if (old_size) std::memmove (new_p, old_p, old_size <= size ? old_size : size);
-
-            if (align_shift > 0) *to_math_ptr(p) = align_shift;
-
-            _M_pTopMarker = pNewMarker;
-        }
-        else
-        {
-            auto const new_align_shift = to_byte (((to_math_ptr (p) - to_math_ptr(new_p)) +
-                                                    align_uptr) % align_uptr);
-
-            align_shift += new_align_shift;
-
-            auto const pNewBottomMarker = to_math_ptr (p) - new_align_shift;
-
-            if (pNewBottomMarker < _M_pTopMarker) throw std::bad_alloc();
-
-            if (old_size) std::memmove (new_p, old_p, old_size <= size ? old_size : size);
-
-            if (align_shift > 0) *(to_math_ptr (pNewBottomMarker) + size) = align_shift;
-
-            _M_pBottomMarker = pNewBottomMarker;
-        }
-    }
-    else
-    {
-        throw std::out_of_range ("pointer doesn't match the last element in both markers");
+        return _M_pBottomMarker = pNew;
     }
 
-    return new_p;
+    throw std::out_of_range ("pointer doesn't match the last element in both markers");
 }
 
 void dstacked_resource::do_deallocate (pointer p, size_type uBytes, align_type)
 {
-    auto const pMarker = to_math_ptr (p) + uBytes;
+    auto const pMarker = to_math_ptr (p) + granule (uBytes);
 
     // if the pointer belongs to the top side
-    if (pMarker == _M_pTopMarker || (pMarker + to_diff (*pMarker)) == _M_pTopMarker)
+    if (pMarker == _M_pTopMarker)
     {
         _M_pTopMarker = p;
     }
     // if the pointer belongs to the bottom side
-    else if (p == _M_pBottomMarker ||
-            (to_math_ptr (_M_pBottomMarker) + to_diff (*to_math_ptr (_M_pBottomMarker))) == p)
+    else if (p == _M_pBottomMarker)
     {
         _M_pBottomMarker = pMarker;
     }
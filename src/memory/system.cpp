@@ -43,8 +43,13 @@
 
 //#include <new>
 #include <atomic>
+#include <limits>
 //#include <memory>
 #include <iostream>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
 
 #include <cstdlib>
 #include <cstring>
@@ -52,13 +57,23 @@
 
 namespace cppual { namespace memory { namespace { //! internal unit optimization
 
+//! hands the heap of the thread back to the free slots when the thread exits
+struct thread_heap
+{
+    thread_heap  () noexcept { memory::model::thread_initialize (); }
+    ~thread_heap () noexcept { memory::model::thread_reset      (); }
+};
+
 constexpr static void initializer ()
 {
     static auto const is_init = memory::model::initialize ();
-    static thread_local auto const is_thread_init = memory::model::thread_initialize ();
+    static thread_local thread_heap const heap;
 
     if (is_init != 0) throw std::runtime_error ("memory model NOT initialized!");
-    if (!is_thread_init) throw std::runtime_error ("thread is NOT initialized!");
+
+    //! blocks released by thread locals destroyed after the heap was handed back
+    if (!memory::model::is_thread_initialized () && !memory::model::thread_initialize ())
+        throw std::runtime_error ("thread is NOT initialized!");
 }
 
 // =========================================================
@@ -453,10 +468,33 @@ std::size_t working_size ()
 #endif
 
 #ifndef ENABLE_STATISTICS
-//! Enable statistics collection
+//! Store the requested size in every block to report thread_statistics::requested
+//! (all other statistics are always collected)
 #define ENABLE_STATISTICS         0
 #endif
 
+#ifndef ENABLE_TRIM_LAZY_FREE
+//! Give trimmed spans back with MADV_FREE (reclaimed under memory pressure only)
+//! instead of MADV_DONTNEED (reclaimed immediately)
+#define ENABLE_TRIM_LAZY_FREE     0
+#endif
+
+#ifndef REMAP_SIZE_THRESHOLD
+//! Oversized segments from this size on are mapped directly,
+//! so that reallocation can grow or shrink them with mremap instead of copying
+#define REMAP_SIZE_THRESHOLD      (256 * 1024)
+#endif
+
+#ifndef NUMA_MAX_NODES
+//! Maximum number of NUMA nodes with their own heaps, segments and global caches
+#define NUMA_MAX_NODES            8
+#endif
+
+#ifndef ENABLE_HUGE_PAGES
+//! Back segments with huge pages by default (can be changed with set_huge_pages)
+#define ENABLE_HUGE_PAGES         0
+#endif
+
 //! Memory page size
 #define MALLOC_PAGE_SIZE        512
 
@@ -472,6 +510,21 @@ std::size_t working_size ()
 #define QUICK_ALLOCATION_PAGES_COUNT SPAN_MAX_PAGE_COUNT
 #define SPANS_PER_SEGMENT 32
 
+//! Huge page size
+#define HUGE_PAGE_SIZE            (2 * 1024 * 1024)
+//! Size of a huge page region that the cachable segments are carved from
+#define HUGE_REGION_SIZE          (4 * HUGE_PAGE_SIZE)
+//! Size of a segment slot in a huge page region (segment header granule + spans)
+#define HUGE_SEGMENT_SLOT_SIZE    (SPAN_ADDRESS_GRANULARITY + (SPAN_MAX_SIZE * SPANS_PER_SEGMENT))
+//! Number of segment slots in a huge page region (the region header takes the first granule)
+#define HUGE_REGION_SLOT_COUNT    ((HUGE_REGION_SIZE - SPAN_ADDRESS_GRANULARITY) / HUGE_SEGMENT_SLOT_SIZE)
+//! Minimum size of an oversized span to be mapped directly with huge pages
+#define HUGE_SPAN_MIN_SIZE        (HUGE_PAGE_SIZE / 2)
+//! Number of huge span cache classes (one per huge page count)
+#define HUGE_CACHE_CLASS_COUNT    16
+//! Maximum number of huge spans kept in each huge span cache class
+#define HUGE_CACHE_LIMIT          4
+
 //! Granularity of a small allocation block
 #define SMALL_GRANULARITY         16
 //! Small granularity shift count
@@ -500,10 +553,27 @@ std::size_t working_size ()
 //! Maximum size of a large block
 #define LARGE_SIZE_LIMIT          ((LARGE_MAX_PAGES * MALLOC_PAGE_SIZE) - SPAN_HEADER_SIZE)
 
+//! Allocation histogram class of oversized blocks (after the small, medium and large classes)
+#define OVERSIZED_CLASS           (SIZE_CLASS_COUNT + LARGE_CLASS_COUNT)
+//! Number of allocation histogram classes
+#define STATISTICS_CLASS_COUNT    (OVERSIZED_CLASS + 1)
+
 #define SPAN_LIST_LOCK_TOKEN      (reinterpret_cast<void*>(1))
 
 #define SINGLE_SEGMENT_MARKER 1
 
+//! Segment is a slot of a huge page region
+#define SEGMENT_HUGE_REGION       1
+//! Segment is a direct huge page mapping
+#define SEGMENT_HUGE_MAPPED       2
+//! Huge page backing uses explicit (MAP_HUGETLB) pages instead of transparent ones
+#define SEGMENT_HUGE_EXPLICIT     4
+//! Segment is a direct mapping (bound to its NUMA node on NUMA machines)
+#define SEGMENT_NODE_MAPPED       8
+
+//! Preferred node memory policy (MPOL_PREFERRED), falls back to other nodes when exhausted
+#define NUMA_POLICY_PREFERRED     1
+
 #define pointer_offset(ptr, ofs) \
     static_cast<void*>(reinterpret_cast<char*>(ptr) + static_cast<ptrdiff>(ofs))
 
@@ -597,6 +667,33 @@ struct SpanCounter
     u32 cache_limit;
 };
 
+//! Heap statistics counters, written by the owner thread only and aggregated on read
+struct HeapStatistics
+{
+    //! Number of allocations for each size class
+    std::atomic<std::size_t> allocations[STATISTICS_CLASS_COUNT];
+    //! Number of deallocations for each size class
+    std::atomic<std::size_t> deallocations[STATISTICS_CLASS_COUNT];
+    //! Number of bytes allocated in oversized blocks
+    std::atomic<std::size_t> oversized_allocated;
+    //! Number of bytes deallocated from oversized blocks
+    std::atomic<std::size_t> oversized_deallocated;
+    //! Number of spans taken from the thread caches
+    std::atomic<std::size_t> thread_cache_hits;
+    //! Number of span lists taken from the global caches
+    std::atomic<std::size_t> global_cache_hits;
+    //! Number of spans mapped because all caches were empty
+    std::atomic<std::size_t> cache_misses;
+    //! Number of bytes transitioned thread -> global
+    std::atomic<std::size_t> thread_to_global;
+    //! Number of bytes transitioned global -> thread
+    std::atomic<std::size_t> global_to_thread;
+    //! Number of bytes in spans handed out from the node of the thread CPU
+    std::atomic<std::size_t> node_local;
+    //! Number of bytes in spans handed out from other nodes
+    std::atomic<std::size_t> node_remote;
+};
+
 struct Heap
 {
     //! Deferred deallocation
@@ -613,19 +710,19 @@ struct Heap
     SpanCounter  span_counter;
     //! Heap ID
     i32 id;
+    //! NUMA node of the heap
+    u32 node;
+    //! Last trim epoch the thread caches were decayed in
+    u32 trim_epoch;
     //! List of free spans for each large class count (single linked list)
     Span*        large_cache[LARGE_CLASS_COUNT];
     //! Allocation counters for large blocks
     SpanCounter  large_counter[LARGE_CLASS_COUNT];
+    //! Statistics counters
+    HeapStatistics stats;
 #if ENABLE_STATISTICS
     //! Number of bytes currently reqeusted in allocations
     std::size_t  requested;
-    //! Number of bytes current allocated
-    std::size_t  allocated;
-    //! Number of bytes transitioned thread -> global
-    std::size_t  thread_to_global;
-    //! Number of bytes transitioned global -> thread
-    std::size_t  global_to_thread;
 #endif
 };
 
@@ -648,28 +745,55 @@ struct Segment
     std::atomic<void*> next_segment;
     Span* first_span;
     std::atomic<u32> free_markers;
+    //! Memory backing (SEGMENT_HUGE_* and SEGMENT_NODE_MAPPED flags)
+    u32 flags;
+    //! NUMA node the segment memory is placed on
+    u32 node;
+    //! Huge page region or mapping the segment memory belongs to
+    void* mapping;
+    //! Size of the mapping
+    std::size_t mapped_size;
+};
+
+//! Huge page region header, placed at the beginning of the region
+struct HugeRegion
+{
+    //! Next region
+    HugeRegion* next_region;
+    //! Bitmap of the segment slots in use
+    u32 used_slots;
+    //! Huge page backing (SEGMENT_HUGE_EXPLICIT)
+    u32 flags;
+    //! NUMA node the region is bound to
+    u32 node;
 };
 
+static_assert(sizeof(HugeRegion) <= SPAN_ADDRESS_GRANULARITY, "HugeRegion size mismatch");
+static_assert(HUGE_REGION_SLOT_COUNT <= 32, "Too many segment slots per huge page region");
+
 //! Global size classes
 static SizeClass _memory_size_class[SIZE_CLASS_COUNT];
 
-//! Heap ID counter
-static std::atomic<i32> _memory_heap_id;
+//! Number of NUMA nodes in use (1 on single node machines)
+static u32 _memory_numa_nodes = 1;
+
+//! Heap ID counter of each node
+static std::atomic<i32> _memory_heap_id[NUMA_MAX_NODES];
 
 //! Heaps array lock
 static std::atomic_flag _heaps_lock = ATOMIC_FLAG_INIT;
 
-//! Free segments
-static std::atomic<void*> _segments_head;
+//! Free segments of each node
+static std::atomic<void*> _segments_head[NUMA_MAX_NODES];
 
 //! Segment RW lock
 static std::atomic<i32> _segments_rw_lock;
 
-//! Global span cache
-static std::atomic<void*> _memory_span_cache;
+//! Global span cache of each node
+static std::atomic<void*> _memory_span_cache[NUMA_MAX_NODES];
 
-//! Global large cache
-static std::atomic<void*> _memory_large_cache[LARGE_CLASS_COUNT];
+//! Global large cache of each node
+static std::atomic<void*> _memory_large_cache[NUMA_MAX_NODES][LARGE_CLASS_COUNT];
 
 //! Current thread heap
 static DEFINE_THREAD_LOCAL(Heap*, _memory_thread_heap);
@@ -677,8 +801,11 @@ static DEFINE_THREAD_LOCAL(Heap*, _memory_thread_heap);
 //! Preferred heap of this thread
 static DEFINE_THREAD_LOCAL(u32, _memory_preferred_heap);
 
-//! All heaps
-static std::atomic<void*> _memory_heaps[HEAP_ARRAY_SIZE];
+//! NUMA node this thread is bound to plus one (0 if not bound)
+static DEFINE_THREAD_LOCAL(u32, _memory_thread_node);
+
+//! All heaps of each node, a heap ID is its node * HEAP_ARRAY_SIZE + slot
+static std::atomic<void*> _memory_heaps[NUMA_MAX_NODES][HEAP_ARRAY_SIZE];
 
 //! Adaptive cache max allocation count
 static u32 _memory_max_allocation;
@@ -686,17 +813,42 @@ static u32 _memory_max_allocation;
 //! Adaptive cache max allocation count
 static u32 _memory_max_allocation_large[LARGE_CLASS_COUNT];
 
-#if ENABLE_STATISTICS
-//! Total number of mapped memory pages
-static std::atomic<i32> _mapped_pages;
-//! Running counter of total number of mapped memory pages since start
-static std::atomic<i32> _mapped_total;
-//! Running counter of total number of unmapped memory pages since start
-static std::atomic<i32> _unmapped_total;
-#endif
+//! Huge page backing of new segments
+static std::atomic<bool> _memory_huge_pages = ENABLE_HUGE_PAGES;
+
+//! Huge page regions & huge span cache lock
+static std::atomic_flag _huge_lock = ATOMIC_FLAG_INIT;
+
+//! Huge page regions for cachable segments
+static HugeRegion* _huge_regions;
+
+//! Huge span cache of each node for each huge page count (single linked list through next_segment)
+static Segment* _huge_cache[NUMA_MAX_NODES][HUGE_CACHE_CLASS_COUNT];
+
+//! Number of huge spans in each huge span cache class
+static u32 _huge_cache_count[NUMA_MAX_NODES][HUGE_CACHE_CLASS_COUNT];
+
+//! Current amount of memory mapped with huge page backing
+static std::atomic<std::size_t> _huge_mapped;
+
+//! Current amount of memory mapped with explicit huge pages
+static std::atomic<std::size_t> _huge_explicit;
+
+//! Current amount of memory in the huge span cache
+static std::atomic<std::size_t> _huge_cached;
+
+//! Trim epoch, the thread caches decay once for every trim
+static std::atomic<u32> _memory_trim_epoch;
+
+//! Current amount of memory mapped in segments and huge page mappings
+static std::atomic<std::size_t> _mapped;
+//! Running counter of total amount of memory mapped since start
+static std::atomic<std::size_t> _mapped_total;
+//! Running counter of total amount of memory unmapped since start
+static std::atomic<std::size_t> _unmapped_total;
 
 static Span*
-_memory_map(std::size_t page_count);
+_memory_map(std::size_t page_count, u32 node);
 
 static void
 _memory_unmap(Span* ptr);
@@ -707,18 +859,74 @@ _memory_allocate_external(std::size_t bytes);
 static void
 _memory_deallocate_external(void* ptr);
 
+static Segment*
+_memory_map_segment(std::size_t bytes, u32 node);
+
+static Segment*
+_memory_huge_region_segment(u32 node);
+
+static Segment*
+_memory_huge_span_map(std::size_t bytes, u32 node);
+
+static void
+_memory_release_segment(Segment* segment);
+
+static Span*
+_memory_remap(Span* span, std::size_t page_count);
+
+static void
+_memory_huge_flush();
+
 static int
 _memory_deallocate_deferred(Heap* heap, std::size_t size_class);
 
+static u32
+_memory_detect_numa_nodes();
+
+static u32
+_memory_current_node();
+
 Heap* _get_heap_ptr(void* heap) {
     return reinterpret_cast<Heap*>(reinterpret_cast<uptr>(heap) & ~1UL);
 }
 
+//! Add to a heap statistics counter. Only the owner thread writes the counters,
+//! so a relaxed load and store is enough and keeps the fast paths free of locked instructions
+static FORCEINLINE void
+_memory_stat_add(std::atomic<std::size_t>& counter, std::size_t value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+//! Register the mapping of memory from the system
+static void
+_memory_stat_map(std::size_t bytes)
+{
+    _mapped.fetch_add(bytes, std::memory_order_relaxed);
+    _mapped_total.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+//! Register the unmapping of memory to the system
+static void
+_memory_stat_unmap(std::size_t bytes)
+{
+    _mapped.fetch_sub(bytes, std::memory_order_relaxed);
+    _unmapped_total.fetch_add(bytes, std::memory_order_relaxed);
+}
+
 //! Lookup a memory heap from heap ID
 static Heap*
 _memory_heap_lookup(i32 id)
 {
-    return _get_heap_ptr(_memory_heaps[id].load());
+    return _get_heap_ptr(_memory_heaps[id / HEAP_ARRAY_SIZE][id % HEAP_ARRAY_SIZE].load());
+}
+
+//! Account a span handed out by the heap as local or remote to the node of the thread CPU
+static void
+_memory_track_span(Heap* heap, Span* span, std::size_t bytes)
+{
+    _memory_stat_add((span->owner_segment->node == _memory_current_node()) ?
+                     heap->stats.node_local : heap->stats.node_remote, bytes);
 }
 
 //! Increase an allocation counter
@@ -738,13 +946,13 @@ _memory_counter_increase(SpanCounter* counter, u32* global_counter)
 
 //! Insert the given list of memory page spans in the global cache for small/medium blocks
 static void
-_memory_global_cache_insert(Span* first_span, std::size_t list_size)
+_memory_global_cache_insert(Span* first_span, std::size_t list_size, u32 node)
 {
     assert((list_size == 1) || (first_span->next_span != 0));
 #if MAX_SPAN_CACHE_DIVISOR > 0
     while (1)
     {
-        void* global_span_ptr = _memory_span_cache.load();
+        void* global_span_ptr = _memory_span_cache[node].load();
         if (global_span_ptr != SPAN_LIST_LOCK_TOKEN)
         {
             uptr global_list_size = reinterpret_cast<uptr>(global_span_ptr) & ~SPAN_MASK;
@@ -769,7 +977,7 @@ _memory_global_cache_insert(Span* first_span, std::size_t list_size)
             global_list_size += list_size;
             void* first_span_ptr = reinterpret_cast<void*>(
                         reinterpret_cast<uptr>(first_span) | global_list_size);
-            if (std::atomic_compare_exchange_strong(&_memory_span_cache, &global_span_ptr, first_span_ptr))
+            if (std::atomic_compare_exchange_strong(&_memory_span_cache[node], &global_span_ptr, first_span_ptr))
                 return;
         }
         else
@@ -791,9 +999,9 @@ _memory_global_cache_insert(Span* first_span, std::size_t list_size)
 
 //! Extract a number of memory page spans from the global cache for small/medium blocks
 static Span*
-_memory_global_cache_extract() {
+_memory_global_cache_extract(u32 node) {
     Span* span = nullptr;
-    std::atomic<void*>* cache = &_memory_span_cache;
+    std::atomic<void*>* cache = &_memory_span_cache[node];
     std::atomic_thread_fence(std::memory_order_acquire);
     void* global_span_ptr = cache->load();
     while (global_span_ptr) {
@@ -830,11 +1038,11 @@ _memory_global_cache_extract() {
 /*! Insert the given list of memory page spans in the global cache for large blocks,
 similar to _memory_global_cache_insert */
 static void
-_memory_global_cache_large_insert(Span* span_list, std::size_t list_size, std::size_t span_count) {
+_memory_global_cache_large_insert(Span* span_list, std::size_t list_size, std::size_t span_count, u32 node) {
     assert((list_size == 1) || (span_list->next_span != 0));
     assert(span_list->size_class == (SIZE_CLASS_COUNT + (span_count - 1)));
 #if MAX_SPAN_CACHE_DIVISOR > 0
-    std::atomic<void*>* cache = &_memory_large_cache[span_count - 1];
+    std::atomic<void*>* cache = &_memory_large_cache[node][span_count - 1];
     while (1) {
         void* global_span_ptr = cache->load();
         if (global_span_ptr != SPAN_LIST_LOCK_TOKEN) {
@@ -877,9 +1085,9 @@ _memory_global_cache_large_insert(Span* span_list, std::size_t list_size, std::s
 /*! Extract a number of memory page spans from the global cache for large blocks,
 similar to _memory_global_cache_extract */
 static Span*
-_memory_global_cache_large_extract(std::size_t span_count) {
+_memory_global_cache_large_extract(std::size_t span_count, u32 node) {
     Span* span = nullptr;
-    std::atomic<void*>* cache = &_memory_large_cache[span_count - 1];
+    std::atomic<void*>* cache = &_memory_large_cache[node][span_count - 1];
     std::atomic_thread_fence(std::memory_order_acquire);
     void* global_span_ptr = cache->load();
     while (global_span_ptr) {
@@ -926,8 +1134,8 @@ _memory_allocate_from_heap(Heap* heap, std::size_t size) {
     SizeClass* size_class = _memory_size_class + class_idx;
     const count_t class_size = size_class->size;
 
+    _memory_stat_add(heap->stats.allocations[class_idx], 1);
 #if ENABLE_STATISTICS
-    heap->allocated += class_size;
     heap->requested += size;
 #endif
 
@@ -991,14 +1199,17 @@ use_active:
 
     //Step 4: No semi-used span available, try grab a span from the thread cache
     Span* span = heap->span_cache;
-    if (!span) {
+    if (span) {
+        _memory_stat_add(heap->stats.thread_cache_hits, 1);
+    }
+    else {
         //Step 5: No span available in the thread cache, try grab a list of spans from the global cache
-        span = _memory_global_cache_extract();
-#if ENABLE_STATISTICS
-        if (span)
-            heap->global_to_thread +=
-                    (std::size_t)span->data.list_size * size_class->page_count * MALLOC_PAGE_SIZE;
-#endif
+        span = _memory_global_cache_extract(heap->node);
+        if (span) {
+            _memory_stat_add(heap->stats.global_cache_hits, 1);
+            _memory_stat_add(heap->stats.global_to_thread,
+                             (std::size_t)span->data.list_size * size_class->page_count * MALLOC_PAGE_SIZE);
+        }
     }
     if (span) {
         if (span->data.list_size > 1) {
@@ -1014,7 +1225,8 @@ use_active:
     }
     else {
         //Step 6: All caches empty, map in new memory pages
-        span = _memory_map(size_class->page_count);
+        span = _memory_map(size_class->page_count, heap->node);
+        _memory_stat_add(heap->stats.cache_misses, 1);
     }
 
     //Mark span as owned by this heap and set base data
@@ -1022,6 +1234,7 @@ use_active:
     std::atomic_thread_fence(std::memory_order_release);
 
     span->size_class = (count_t)class_idx;
+    _memory_track_span(heap, span, size_class->page_count * MALLOC_PAGE_SIZE);
 
     //If we only have one block we will grab it, otherwise
     //set span as new span to use for next allocation
@@ -1065,14 +1278,17 @@ _memory_allocate_large_from_heap(Heap* heap, std::size_t size) {
             _memory_deallocate_deferred(heap, 0);
             span = heap->span_cache;
         }
-        if (!span) {
+        if (span) {
+            _memory_stat_add(heap->stats.thread_cache_hits, 1);
+        }
+        else {
             //Step 5: No span available in the thread cache, try grab a list of spans from the global cache
-            span = _memory_global_cache_extract();
-#if ENABLE_STATISTICS
-            if (span)
-                heap->global_to_thread +=
-                        (std::size_t)span->data.list_size * SPAN_MAX_PAGE_COUNT * MALLOC_PAGE_SIZE;
-#endif
+            span = _memory_global_cache_extract(heap->node);
+            if (span) {
+                _memory_stat_add(heap->stats.global_cache_hits, 1);
+                _memory_stat_add(heap->stats.global_to_thread,
+                                 (std::size_t)span->data.list_size * SPAN_MAX_PAGE_COUNT * MALLOC_PAGE_SIZE);
+            }
         }
         if (span) {
             if (span->data.list_size > 1) {
@@ -1088,7 +1304,8 @@ _memory_allocate_large_from_heap(Heap* heap, std::size_t size) {
         }
         else {
             //Step 6: All caches empty, map in new memory pages
-            span = _memory_map(SPAN_MAX_PAGE_COUNT);
+            span = _memory_map(SPAN_MAX_PAGE_COUNT, heap->node);
+            _memory_stat_add(heap->stats.cache_misses, 1);
         }
 
         //Mark span as owned by this heap and set base data
@@ -1096,6 +1313,8 @@ _memory_allocate_large_from_heap(Heap* heap, std::size_t size) {
         std::atomic_thread_fence(std::memory_order_release);
 
         span->size_class = SIZE_CLASS_COUNT;
+        _memory_track_span(heap, span, SPAN_MAX_SIZE);
+        _memory_stat_add(heap->stats.allocations[SIZE_CLASS_COUNT], 1);
 
         //Track counters
         _memory_counter_increase(&heap->span_counter, &_memory_max_allocation);
@@ -1121,6 +1340,9 @@ use_cache:
         }
 
         span->size_class = SIZE_CLASS_COUNT + (count_t)idx;
+        _memory_track_span(heap, span, (idx + 1) * SPAN_MAX_SIZE);
+        _memory_stat_add(heap->stats.thread_cache_hits, 1);
+        _memory_stat_add(heap->stats.allocations[SIZE_CLASS_COUNT + idx], 1);
 
         // Mark span as owned by this heap
         span->heap_id = heap->id;
@@ -1141,11 +1363,10 @@ use_cache:
     assert(!heap->large_cache[idx]);
 
     //Step 3: Extract a list of spans from global cache
-    span = _memory_global_cache_large_extract(num_spans);
+    span = _memory_global_cache_large_extract(num_spans, heap->node);
     if (span) {
-#if ENABLE_STATISTICS
-        heap->global_to_thread += (std::size_t)span->data.list_size * num_spans * SPAN_MAX_SIZE;
-#endif
+        _memory_stat_add(heap->stats.global_cache_hits, 1);
+        _memory_stat_add(heap->stats.global_to_thread, (std::size_t)span->data.list_size * num_spans * SPAN_MAX_SIZE);
         //We got a list from global cache, store remainder in thread cache
         if (span->data.list_size > 1) {
             Span* new_head = span->next_span;
@@ -1157,13 +1378,16 @@ use_cache:
     }
     else {
         //Step 4: Map in more memory pages
-        span = _memory_map(num_spans * SPAN_MAX_PAGE_COUNT);
+        span = _memory_map(num_spans * SPAN_MAX_PAGE_COUNT, heap->node);
+        _memory_stat_add(heap->stats.cache_misses, 1);
     }
     //Mark span as owned by this heap
     span->heap_id = heap->id;
     std::atomic_thread_fence(std::memory_order_release);
 
     span->size_class = SIZE_CLASS_COUNT + (count_t)idx;
+    _memory_track_span(heap, span, num_spans * SPAN_MAX_SIZE);
+    _memory_stat_add(heap->stats.allocations[SIZE_CLASS_COUNT + idx], 1);
 
     //Increase counter
     _memory_counter_increase(&heap->large_counter[idx], &_memory_max_allocation_large[idx]);
@@ -1171,23 +1395,29 @@ use_cache:
     return pointer_offset(span, SPAN_HEADER_SIZE);
 }
 
-//! Allocate a new heap
+//! Allocate a new heap on the given node, nullptr when every slot of the node holds
+//! a heap of a live thread. Called with the heaps lock held
 static Heap*
-_memory_allocate_heap() {
-    Heap* heap;
-    //Try getting an orphaned heap
+_memory_allocate_heap(u32 node) {
     std::atomic_thread_fence(std::memory_order_acquire);
 
+    //Get a new heap ID from the free slots of the node (slot 0 is never used)
+    i32 id = 0;
+    for (u32 n = 0; n < HEAP_ARRAY_SIZE && !id; ++n) {
+        i32 slot = (++_memory_heap_id[node]) % HEAP_ARRAY_SIZE;
+        id = slot ? static_cast<i32>(node * HEAP_ARRAY_SIZE) + slot : 0;
+        if (id && _memory_heap_lookup(id))
+            id = 0;
+    }
+
+    if (!id)
+        return nullptr;
+
     //Map in pages for a new heap
-    heap = static_cast<Heap*>(_memory_allocate_external(sizeof(Heap)));
+    Heap* heap = static_cast<Heap*>(_memory_allocate_external(sizeof(Heap)));
     new (heap) Heap ();
-
-    //Get a new heap ID
-    do {
-        heap->id = (++_memory_heap_id);
-        if (_memory_heap_lookup(heap->id))
-            heap->id = 0;
-    } while (!heap->id);
+    heap->node = node;
+    heap->id   = id;
     return heap;
 }
 
@@ -1217,12 +1447,60 @@ _memory_list_remove(Span** head, Span* span) {
     }
 }
 
+//! Detach the older half (rounded up) of a thread cache list, the size of the
+//! detached list is stored in its first span
+static Span*
+_memory_heap_cache_split(Span** cache) {
+    Span* head = *cache;
+    const count_t list_size = head->data.list_size;
+    const count_t keep = list_size / 2;
+    if (!keep) {
+        *cache = nullptr;
+        return head;
+    }
+    Span* last = head;
+    for (count_t ispan = 1; ispan < keep; ++ispan)
+        last = last->next_span;
+    Span* tail = last->next_span;
+    last->next_span = nullptr; //Terminate list
+    head->data.list_size = keep;
+    tail->data.list_size = list_size - keep;
+    return tail;
+}
+
+//! Move the older half of the thread caches to the global caches once per trim epoch,
+//! so idle spans reach the global caches where trim gives them back to the system
+static void
+_memory_heap_decay(Heap* heap) {
+    const u32 epoch = _memory_trim_epoch.load(std::memory_order_relaxed);
+    if (heap->trim_epoch == epoch)
+        return;
+    heap->trim_epoch = epoch;
+
+    if (heap->span_cache) {
+        Span* span = _memory_heap_cache_split(&heap->span_cache);
+        const count_t list_size = span->data.list_size;
+        _memory_global_cache_insert(span, list_size, heap->node);
+        _memory_stat_add(heap->stats.thread_to_global, list_size * QUICK_ALLOCATION_PAGES_COUNT * MALLOC_PAGE_SIZE);
+    }
+
+    for (std::size_t idx = 0; idx < LARGE_CLASS_COUNT; ++idx) {
+        if (!heap->large_cache[idx])
+            continue;
+        Span* span = _memory_heap_cache_split(&heap->large_cache[idx]);
+        const count_t list_size = span->data.list_size;
+        _memory_global_cache_large_insert(span, list_size, idx + 1, heap->node);
+        _memory_stat_add(heap->stats.thread_to_global, list_size * (idx + 1) * SPAN_MAX_SIZE);
+    }
+}
+
 //! Insert span into thread cache, releasing to global cache if overflow
 static void
 _memory_heap_cache_insert(Heap* heap, Span* span) {
+    _memory_heap_decay(heap);
+
 #if MAX_SPAN_CACHE_DIVISOR == 0
-    ()sizeof(heap);
-    _memory_global_cache_insert(span, 1);
+    _memory_global_cache_insert(span, 1, heap->node);
 #else
     Span** cache = &heap->span_cache;
     span->next_span = *cache;
@@ -1247,10 +1525,8 @@ _memory_heap_cache_insert(Heap* heap, Span* span) {
         next->data.list_size = span->data.list_size - list_size;
         last->next_span = nullptr; //Terminate list
         *cache = next;
-        _memory_global_cache_insert(span, list_size);
-#if ENABLE_STATISTICS
-        heap->thread_to_global += list_size * QUICK_ALLOCATION_PAGES_COUNT * MALLOC_PAGE_SIZE;
-#endif
+        _memory_global_cache_insert(span, list_size, heap->node);
+        _memory_stat_add(heap->stats.thread_to_global, list_size * QUICK_ALLOCATION_PAGES_COUNT * MALLOC_PAGE_SIZE);
     }
 #endif
 #endif
@@ -1268,8 +1544,8 @@ _memory_deallocate_to_heap(Heap* heap, Span* span, void* p) {
         heap->active_block + class_idx :
         &span->data.block;
 
+    _memory_stat_add(heap->stats.deallocations[class_idx], 1);
 #if ENABLE_STATISTICS
-    heap->allocated -= size_class->size;
     heap->requested -= *(std::size_t*)pointer_offset(p, size_class->size - sizeof(std::size_t));
 #endif
 
@@ -1309,6 +1585,8 @@ _memory_deallocate_to_heap(Heap* heap, Span* span, void* p) {
 //! Deallocate the given large memory block from the given heap
 static void
 _memory_deallocate_large_to_heap(Heap* heap, Span* span) {
+    _memory_stat_add(heap->stats.deallocations[span->size_class], 1);
+
     //Check if aliased with 64KiB small/medium spans
     if (span->size_class == SIZE_CLASS_COUNT) {
         //Track counters
@@ -1318,6 +1596,8 @@ _memory_deallocate_large_to_heap(Heap* heap, Span* span) {
         return;
     }
 
+    _memory_heap_decay(heap);
+
     //Decrease counter
     std::size_t idx = span->size_class - SIZE_CLASS_COUNT;
     SpanCounter* counter = heap->large_counter + idx;
@@ -1325,7 +1605,7 @@ _memory_deallocate_large_to_heap(Heap* heap, Span* span) {
     --counter->current_allocations;
 
 #if MAX_SPAN_CACHE_DIVISOR == 0
-    _memory_global_cache_large_insert(span, 1, idx + 1);
+    _memory_global_cache_large_insert(span, 1, idx + 1, heap->node);
 #else
     //Insert into cache list
     Span** cache = heap->large_cache + idx;
@@ -1352,10 +1632,8 @@ _memory_deallocate_large_to_heap(Heap* heap, Span* span) {
         next->data.list_size = span->data.list_size - list_size;
         last->next_span = nullptr; //Terminate list
         *cache = next;
-        _memory_global_cache_large_insert(span, list_size, idx + 1);
-#if ENABLE_STATISTICS
-        heap->thread_to_global += list_size * (idx + 1) * SPAN_MAX_SIZE;
-#endif
+        _memory_global_cache_large_insert(span, list_size, idx + 1, heap->node);
+        _memory_stat_add(heap->stats.thread_to_global, list_size * (idx + 1) * SPAN_MAX_SIZE);
     }
 #endif
 #endif
@@ -1417,10 +1695,14 @@ _memory_allocate(std::size_t size) {
     std::size_t num_pages = size / MALLOC_PAGE_SIZE;
     if (size % MALLOC_PAGE_SIZE)
         ++num_pages;
-    Span* span = _memory_map(num_pages);
+    Heap* heap = GET_THREAD_LOCAL(Heap*, _memory_thread_heap);
+    Span* span = _memory_map(num_pages, heap->node);
     span->heap_id = 0;
     //Store page count in next_span
     span->next_span = (Span*)((uptr)num_pages);
+    _memory_track_span(heap, span, num_pages * MALLOC_PAGE_SIZE);
+    _memory_stat_add(heap->stats.allocations[OVERSIZED_CLASS], 1);
+    _memory_stat_add(heap->stats.oversized_allocated, num_pages * MALLOC_PAGE_SIZE);
 
     return pointer_offset(span, SPAN_HEADER_SIZE);
 }
@@ -1446,6 +1728,8 @@ _memory_deallocate(void* p) {
         _memory_deallocate_defer(heap_id, p);
     }
     else {
+        _memory_stat_add(heap->stats.deallocations[OVERSIZED_CLASS], 1);
+        _memory_stat_add(heap->stats.oversized_deallocated, (uptr)span->next_span * MALLOC_PAGE_SIZE);
         _memory_unmap(span);
     }
 }
@@ -1489,6 +1773,13 @@ _memory_reallocate(void* p, std::size_t size, std::size_t oldsize, unsigned int
             std::size_t current_pages = (std::size_t)span->next_span;
             if ((current_pages >= num_pages) && (num_pages >= (current_pages / 2)))
                 return p; //Still fits and less than half of memory would be freed
+            //Avoid hysteresis by overallocating if increase is small (below 37%)
+            std::size_t lower_pages = current_pages + (current_pages >> 2) + (current_pages >> 3);
+            if ((num_pages > current_pages) && (num_pages < lower_pages))
+                num_pages = lower_pages;
+            //Directly mapped pages are moved by the kernel without copying
+            if (Span* remapped = _memory_remap(span, num_pages))
+                return pointer_offset(remapped, SPAN_HEADER_SIZE);
             if (!oldsize)
                 oldsize = (current_pages * (std::size_t)MALLOC_PAGE_SIZE) - SPAN_HEADER_SIZE;
         }
@@ -1568,7 +1859,12 @@ int
 initialize() {
     INITIALIZE_THREAD_LOCAL(_memory_thread_heap);
     INITIALIZE_THREAD_LOCAL(_memory_preferred_heap);
-    _memory_heap_id = 0;
+    INITIALIZE_THREAD_LOCAL(_memory_thread_node);
+
+    _memory_numa_nodes = _memory_detect_numa_nodes();
+
+    for (u32 node = 0; node < NUMA_MAX_NODES; ++node)
+        _memory_heap_id[node] = 0;
 
     //Setup all small and medium size classes
     std::size_t iclass;
@@ -1585,7 +1881,8 @@ initialize() {
         _memory_adjust_size_class(SMALL_CLASS_COUNT + iclass);
     }
 
-    _segments_head = nullptr;
+    for (u32 node = 0; node < NUMA_MAX_NODES; ++node)
+        _segments_head[node] = nullptr;
     _segments_rw_lock = 0;
 
     //Initialize this thread
@@ -1596,11 +1893,13 @@ initialize() {
 //! Finalize the allocator
 void
 finalize() {
+    stop_scavenger();
     std::atomic_thread_fence(std::memory_order_acquire);
 
     //Free all thread caches
-    for (std::size_t list_idx = 0; list_idx < HEAP_ARRAY_SIZE; ++list_idx) {
-        Heap* heap = _get_heap_ptr(_memory_heaps[list_idx].load());
+    for (std::size_t list_idx = 0; list_idx < NUMA_MAX_NODES * HEAP_ARRAY_SIZE; ++list_idx) {
+        std::atomic<void*>& heap_slot = _memory_heaps[list_idx / HEAP_ARRAY_SIZE][list_idx % HEAP_ARRAY_SIZE];
+        Heap* heap = _get_heap_ptr(heap_slot.load());
         if (heap) {
             _memory_deallocate_deferred(heap, 0);
 
@@ -1628,12 +1927,12 @@ finalize() {
             _memory_deallocate_external(heap);
         }
 
-        _memory_heaps[list_idx] = nullptr;
+        heap_slot = nullptr;
     }
 
-    {
+    for (u32 node = 0; node < NUMA_MAX_NODES; ++node) {
         //Free global caches
-        void* span_ptr = _memory_span_cache.load();
+        void* span_ptr = _memory_span_cache[node].load();
         std::size_t cache_count = (uptr)span_ptr & ~SPAN_MASK;
         Span* span = (Span*)((void*)((uptr)span_ptr & SPAN_MASK));
         while (cache_count) {
@@ -1647,11 +1946,12 @@ finalize() {
             span = skip_span;
             cache_count -= span_count;
         }
-        _memory_span_cache = nullptr;
+        _memory_span_cache[node] = nullptr;
     }
 
-    for (std::size_t iclass = 0; iclass < LARGE_CLASS_COUNT; ++iclass) {
-        void* span_ptr = _memory_large_cache[iclass].load();
+    for (std::size_t iclass = 0; iclass < NUMA_MAX_NODES * LARGE_CLASS_COUNT; ++iclass) {
+        std::atomic<void*>& cache = _memory_large_cache[iclass / LARGE_CLASS_COUNT][iclass % LARGE_CLASS_COUNT];
+        void* span_ptr = cache.load();
         std::size_t cache_count = (uptr)span_ptr & ~SPAN_MASK;
         Span* span = (Span*)((void*)((uptr)span_ptr & SPAN_MASK));
         while (cache_count) {
@@ -1665,25 +1965,32 @@ finalize() {
             span = skip_span;
             cache_count -= span_count;
         }
-        _memory_large_cache[iclass] = nullptr;
+        cache = nullptr;
     }
 
     // Free all segments
     _acquire_segments_lock_write();
 
-    Segment* head = static_cast<Segment*>(_segments_head.load());
-    Segment* next;
-    while (head)
+    for (u32 node = 0; node < NUMA_MAX_NODES; ++node)
     {
-        next = static_cast<Segment*>(head->next_segment.load());
-        _memory_deallocate_external(head);
-        head = next;
+        Segment* head = static_cast<Segment*>(_segments_head[node].load());
+        Segment* next;
+        while (head)
+        {
+            next = static_cast<Segment*>(head->next_segment.load());
+            _memory_release_segment(head);
+            head = next;
+        }
+        _segments_head[node] = nullptr;
     }
 
     _release_segments_lock_write();
 
+    _memory_huge_flush();
+
     FREE_THREAD_LOCAL(_memory_thread_heap);
     FREE_THREAD_LOCAL(_memory_preferred_heap);
+    FREE_THREAD_LOCAL(_memory_thread_node);
 
     std::atomic_thread_fence(std::memory_order_release);
 }
@@ -1697,7 +2004,7 @@ void* _mark_heap_in_use(void* heap) {
 }
 
 void* _unmark_heap_in_use(void* heap) {
-    return reinterpret_cast<void*>(reinterpret_cast<std::size_t>(heap) & ~1U);
+    return reinterpret_cast<void*>(reinterpret_cast<std::size_t>(heap) & ~static_cast<std::size_t>(1));
 }
 
 void _acquire_heaps_lock()
@@ -1717,20 +2024,26 @@ bool thread_initialize ()
 
     if (!GET_THREAD_LOCAL(Heap*, _memory_thread_heap))
     {
-        _acquire_heaps_lock();
+        //Prefer the heaps of the node the thread is bound to or currently runs on
+        u32 const bound = GET_THREAD_LOCAL_LITERAL_VALUE(u32, _memory_thread_node);
+        u32 const node  = bound ? bound - 1 : _memory_current_node();
+        u32 const pref  = GET_THREAD_LOCAL_LITERAL_VALUE(u32, _memory_preferred_heap);
+        u32 const first = (pref / HEAP_ARRAY_SIZE == node) ? pref % HEAP_ARRAY_SIZE : 0;
+
+        std::atomic<void*>* heaps = _memory_heaps[node];
 
-        void* heap_ptr = _memory_heaps[GET_THREAD_LOCAL_LITERAL_VALUE(uptr, _memory_preferred_heap)].load();
+        _acquire_heaps_lock();
 
-        for (u32 id = GET_THREAD_LOCAL_LITERAL_VALUE(u32, _memory_preferred_heap);
-            id < HEAP_ARRAY_SIZE + GET_THREAD_LOCAL_LITERAL_VALUE(u32, _memory_preferred_heap);
-            ++id)
+        for (u32 slot = first; slot < HEAP_ARRAY_SIZE + first; ++slot)
         {
-            heap_ptr = _memory_heaps[id % HEAP_ARRAY_SIZE].load();
+            void* heap_ptr = heaps[slot % HEAP_ARRAY_SIZE].load();
             if (heap_ptr && !_is_heap_in_use(heap_ptr))
             {
                 SET_THREAD_LOCAL(_memory_thread_heap, _get_heap_ptr(heap_ptr));
-                _memory_heaps[id % HEAP_ARRAY_SIZE] = _mark_heap_in_use(heap_ptr);
-                SET_THREAD_LOCAL(_memory_preferred_heap, (id % HEAP_ARRAY_SIZE));
+                heaps[slot % HEAP_ARRAY_SIZE] = _mark_heap_in_use(heap_ptr);
+                SET_THREAD_LOCAL(_memory_preferred_heap,
+                                 CAST_THREAD_LOCAL(_memory_preferred_heap,
+                                                   node * HEAP_ARRAY_SIZE + slot % HEAP_ARRAY_SIZE));
                 break;
             }
         }
@@ -1738,21 +2051,22 @@ bool thread_initialize ()
         if (!GET_THREAD_LOCAL(Heap*, _memory_thread_heap))
         {
             // We have to allocate a new heap
-            Heap* heap = _memory_allocate_heap();
+            Heap* heap = _memory_allocate_heap(node);
+
+            if (!heap)
+            {
+                _release_heaps_lock();
+                return false;
+            }
 
             auto id = heap->id;
             SET_THREAD_LOCAL(_memory_thread_heap, heap);
-            _memory_heaps[id] = _mark_heap_in_use(heap);
+            heaps[id % HEAP_ARRAY_SIZE] = _mark_heap_in_use(heap);
             SET_THREAD_LOCAL(_memory_preferred_heap,
                              CAST_THREAD_LOCAL(_memory_preferred_heap, id));
         }
 
         _release_heaps_lock();
-
-#if ENABLE_STATISTICS
-        GET_THREAD_LOCAL(heap_t*, _memory_thread_heap)->thread_to_global = 0;
-        GET_THREAD_LOCAL(heap_t*, _memory_thread_heap)->global_to_thread = 0;
-#endif
     }
     assert(GET_THREAD_LOCAL(Heap*, _memory_thread_heap));
 
@@ -1764,10 +2078,13 @@ thread_reset() {
     if (!GET_THREAD_LOCAL(Heap*, _memory_thread_heap))
         return;
 
+    u32 const pref = GET_THREAD_LOCAL_LITERAL_VALUE(u32, _memory_preferred_heap);
+    std::atomic<void*>& heap_slot = _memory_heaps[pref / HEAP_ARRAY_SIZE][pref % HEAP_ARRAY_SIZE];
+
     _acquire_heaps_lock();
-    void* heap_ptr = _memory_heaps[GET_THREAD_LOCAL_LITERAL_VALUE(u32, _memory_preferred_heap)].load();
+    void* heap_ptr = heap_slot.load();
     assert(_is_heap_in_use(heap_ptr));
-    _memory_heaps[GET_THREAD_LOCAL_LITERAL_VALUE(u32, _memory_preferred_heap)] = _unmark_heap_in_use(heap_ptr);
+    heap_slot = _unmark_heap_in_use(heap_ptr);
     _release_heaps_lock();
 
     SET_THREAD_LOCAL(_memory_thread_heap, nullptr);
@@ -1825,9 +2142,9 @@ void _publish_segment_on_global_list(Segment* new_segment)
 {
     _acquire_segments_lock_write();
 
-    Segment* head = static_cast<Segment*>(_segments_head.load());
+    Segment* head = static_cast<Segment*>(_segments_head[new_segment->node].load());
     new_segment->next_segment = head;
-    _segments_head = new_segment;
+    _segments_head[new_segment->node] = new_segment;
 
     _release_segments_lock_write();
 }
@@ -1889,7 +2206,7 @@ void _return_span_to_segment(Segment* segment, Span* span) {
 
         // Find the segment and delete it (if still empty)
         Segment* prev = nullptr;
-        Segment* head = static_cast<Segment*>(_segments_head.load());
+        Segment* head = static_cast<Segment*>(_segments_head[segment->node].load());
         while (head && head != segment)
         {
             prev = head;
@@ -1909,7 +2226,7 @@ void _return_span_to_segment(Segment* segment, Span* span) {
                 // It's the head
                 if (!prev)
                 {
-                    _segments_head = head->next_segment.load();
+                    _segments_head[segment->node] = head->next_segment.load();
                 }
                 else
                 {
@@ -1927,34 +2244,34 @@ void _return_span_to_segment(Segment* segment, Span* span) {
         // Now free if everything went ok - the segment has been unlinked
         if (head)
         {
-#if ENABLE_STATISTICS
-            _mapped_pages -= QUICK_ALLOCATION_PAGES_COUNT;
-            _unmapped_total -= QUICK_ALLOCATION_PAGES_COUNT;
-#endif
-            _memory_deallocate_external(head);
+            _memory_release_segment(head);
         }
     }
 }
 
-//! Map new pages to virtual memory
+//! Map new pages to virtual memory on the given node
 static Span*
-_memory_map(std::size_t page_count) {
+_memory_map(std::size_t page_count, u32 node) {
     Span* span = nullptr;
     if (page_count <= QUICK_ALLOCATION_PAGES_COUNT)
     {
         int should_release = 1;
         _acquire_segments_lock_read();
         // Look for a span of correct size within the cache
-        Segment* global_segment = static_cast<Segment*>(_segments_head.load());
+        Segment* global_segment = static_cast<Segment*>(_segments_head[node].load());
         for (;;)
         {
             if (!global_segment)
             {
                 // Create a new cachable segment and put it on the cache
-                std::size_t size =
-                        (SPAN_MAX_SIZE * SPANS_PER_SEGMENT) + sizeof(Segment) + SPAN_ADDRESS_GRANULARITY;
-                Segment* segment = static_cast<Segment*>(_memory_allocate_external(size));
-                new (segment) Segment ();
+                Segment* segment = _memory_huge_pages.load(std::memory_order_relaxed) ?
+                                   _memory_huge_region_segment(node) : nullptr;
+                if (!segment)
+                {
+                    std::size_t size =
+                            (SPAN_MAX_SIZE * SPANS_PER_SEGMENT) + sizeof(Segment) + SPAN_ADDRESS_GRANULARITY;
+                    segment = _memory_map_segment(size, node);
+                }
                 span = static_cast<Span*>(pointer_offset(segment, sizeof(Segment)));
                 // Align to the required size of the spans
                 if ((uptr)span & (SPAN_ADDRESS_GRANULARITY - 1))
@@ -1996,7 +2313,10 @@ _memory_map(std::size_t page_count) {
     else
     {
         std::size_t size = page_count * MALLOC_PAGE_SIZE + sizeof(Segment) + SPAN_ADDRESS_GRANULARITY;
-        Segment* segment = static_cast<Segment*>(_memory_allocate_external(size));
+        Segment* segment = (size >= HUGE_SPAN_MIN_SIZE) && _memory_huge_pages.load(std::memory_order_relaxed) ?
+                           _memory_huge_span_map(size, node) : nullptr;
+        if (!segment)
+            segment = _memory_map_segment(size, node);
         span = static_cast<Span*>(pointer_offset(segment, sizeof(Segment)));
         // Align to the required size of the spans
         if ((uptr)span & (SPAN_ADDRESS_GRANULARITY - 1))
@@ -2021,12 +2341,7 @@ _memory_unmap(Span* span) {
     Segment* nn = static_cast<Segment*>(segment->next_segment.load());
     if (nn == (void*)SINGLE_SEGMENT_MARKER)
     {
-        _memory_deallocate_external(segment);
-
-#if ENABLE_STATISTICS
-        _mapped_pages -= QUICK_ALLOCATION_PAGES_COUNT;
-        _unmapped_total -= QUICK_ALLOCATION_PAGES_COUNT;
-#endif
+        _memory_release_segment(segment);
     }
     else
     {
@@ -2037,10 +2352,6 @@ _memory_unmap(Span* span) {
 static void*
 _memory_allocate_external(std::size_t bytes)
 {
-#if ENABLE_STATISTICS
-    _mapped_total += (int)(bytes / MALLOC_PAGE_SIZE);
-    _mapped_pages += (int)(bytes / MALLOC_PAGE_SIZE);
-#endif
     return std::malloc (bytes);
 }
 
@@ -2050,6 +2361,727 @@ _memory_deallocate_external(void* ptr)
     std::free (ptr);
 }
 
+//! Detect the number of NUMA nodes from the list of online nodes (e.g. "0-1")
+static u32
+_memory_detect_numa_nodes()
+{
+#ifdef OS_GNU_LINUX
+    FILE* fp = ::fopen("/sys/devices/system/node/online", "re");
+    if (!fp)
+        return 1;
+
+    u32  last  = 0;
+    u32  value = 0;
+    bool digit = false;
+
+    for (int c = ::fgetc(fp); ; c = ::fgetc(fp))
+    {
+        if (c >= '0' && c <= '9')
+        {
+            value = value * 10 + static_cast<u32>(c - '0');
+            digit = true;
+            continue;
+        }
+
+        if (digit && value > last)
+            last = value;
+        value = 0;
+        digit = false;
+
+        if (c == EOF)
+            break;
+    }
+
+    ::fclose(fp);
+    return last < NUMA_MAX_NODES ? last + 1 : NUMA_MAX_NODES;
+#else
+    return 1;
+#endif
+}
+
+//! NUMA node of the CPU the calling thread currently runs on
+static u32
+_memory_current_node()
+{
+    if (_memory_numa_nodes < 2)
+        return 0;
+
+#ifdef OS_GNU_LINUX
+    unsigned cpu  = 0;
+    unsigned node = 0;
+#   if defined(__GLIBC__) && ((__GLIBC__ > 2) || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+    if (::getcpu(&cpu, &node) == 0)
+        return node % _memory_numa_nodes;
+#   elif defined(SYS_getcpu)
+    if (::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+        return node % _memory_numa_nodes;
+#   endif
+#endif
+    return 0;
+}
+
+//! Prefer the given node for the pages of a fresh mapping. Has to be called before the
+//! pages are touched, without mbind the pages are placed on first touch instead
+static void
+_memory_bind_node(void* ptr, std::size_t bytes, u32 node)
+{
+#if defined(OS_GNU_LINUX) && defined(SYS_mbind)
+    if (_memory_numa_nodes < 2)
+        return;
+
+    unsigned long mask = 1UL << node;
+    ::syscall(SYS_mbind, ptr, bytes, NUMA_POLICY_PREFERRED, &mask, sizeof(mask) * 8, 0);
+#else
+    UNUSED(ptr);
+    UNUSED(bytes);
+    UNUSED(node);
+#endif
+}
+
+//! Get the memory of a new segment, mapped directly and bound to the node on NUMA machines
+//! or when it is large enough to be remapped
+static Segment*
+_memory_map_segment(std::size_t bytes, u32 node)
+{
+    Segment* segment;
+
+#if defined(OS_STD_UNIX) && defined(MAP_ANONYMOUS)
+    if (_memory_numa_nodes > 1 || bytes >= REMAP_SIZE_THRESHOLD)
+    {
+        void* ptr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (ptr != MAP_FAILED)
+        {
+            _memory_stat_map(bytes);
+            _memory_bind_node(ptr, bytes, node);
+
+            segment = new (ptr) Segment ();
+            segment->flags = SEGMENT_NODE_MAPPED;
+            segment->node = node;
+            segment->mapping = ptr;
+            segment->mapped_size = bytes;
+            return segment;
+        }
+    }
+#endif
+
+    segment = new (_memory_allocate_external(bytes)) Segment ();
+    segment->node = node;
+    segment->mapped_size = bytes;
+    _memory_stat_map(bytes);
+    return segment;
+}
+
+static void
+_acquire_huge_lock()
+{
+    while (_huge_lock.test_and_set(std::memory_order_acquire))
+        thread_yield();
+}
+
+static void
+_release_huge_lock()
+{
+    _huge_lock.clear(std::memory_order_release);
+}
+
+//! Map huge page aligned memory backed by explicit huge pages (MAP_HUGETLB)
+//! or by transparent huge pages (MADV_HUGEPAGE) as a fallback.
+//! The size has to be a multiple of HUGE_PAGE_SIZE
+static void*
+_memory_map_huge(std::size_t bytes, u32* flags, u32 node)
+{
+#if defined(OS_STD_UNIX) && defined(MAP_ANONYMOUS)
+#   ifdef MAP_HUGETLB
+    void* ptr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    if (ptr != MAP_FAILED)
+    {
+        *flags |= SEGMENT_HUGE_EXPLICIT;
+        _huge_explicit += bytes;
+        _huge_mapped   += bytes;
+        _memory_stat_map(bytes);
+        _memory_bind_node(ptr, bytes, node);
+        return ptr;
+    }
+#   endif
+#   ifdef MADV_HUGEPAGE
+    //No reserved huge pages, over-map to trim the mapping to huge page alignment
+    void* raw = ::mmap(nullptr, bytes + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (raw == MAP_FAILED)
+        return nullptr;
+
+    uptr aligned = ((uptr)raw + (HUGE_PAGE_SIZE - 1)) & ~((uptr)HUGE_PAGE_SIZE - 1);
+    std::size_t head = aligned - (uptr)raw;
+
+    if (head)
+        ::munmap(raw, head);
+    if (HUGE_PAGE_SIZE - head)
+        ::munmap((void*)(aligned + bytes), HUGE_PAGE_SIZE - head);
+
+    ::madvise((void*)aligned, bytes, MADV_HUGEPAGE);
+    _huge_mapped += bytes;
+    _memory_stat_map(bytes);
+    _memory_bind_node((void*)aligned, bytes, node);
+    return (void*)aligned;
+#   endif
+#endif
+    UNUSED(bytes);
+    UNUSED(flags);
+    UNUSED(node);
+    return nullptr;
+}
+
+//! Unmap memory mapped by _memory_map_huge
+static void
+_memory_unmap_huge(void* ptr, std::size_t bytes, u32 flags)
+{
+    if (flags & SEGMENT_HUGE_EXPLICIT)
+        _huge_explicit -= bytes;
+    _huge_mapped -= bytes;
+    _memory_stat_unmap(bytes);
+#if defined(OS_STD_UNIX) && defined(MAP_ANONYMOUS)
+    ::munmap(ptr, bytes);
+#else
+    UNUSED(ptr);
+#endif
+}
+
+//! Get a cachable segment carved from a huge page region of the given node
+static Segment*
+_memory_huge_region_segment(u32 node)
+{
+    constexpr u32 full_mask = (u32)((1ULL << HUGE_REGION_SLOT_COUNT) - 1);
+
+    _acquire_huge_lock();
+
+    HugeRegion* region = _huge_regions;
+    while (region && ((region->used_slots == full_mask) || (region->node != node)))
+        region = region->next_region;
+
+    if (!region)
+    {
+        u32 flags = 0;
+        void* ptr = _memory_map_huge(HUGE_REGION_SIZE, &flags, node);
+        if (!ptr)
+        {
+            _release_huge_lock();
+            return nullptr;
+        }
+
+        region = new (ptr) HugeRegion ();
+        region->flags = flags;
+        region->node = node;
+        region->next_region = _huge_regions;
+        _huge_regions = region;
+    }
+
+    u32 slot = 0;
+    while (region->used_slots & (1U << slot))
+        ++slot;
+    region->used_slots |= (1U << slot);
+
+    _release_huge_lock();
+
+    Segment* segment = new (pointer_offset(region, SPAN_ADDRESS_GRANULARITY + slot * HUGE_SEGMENT_SLOT_SIZE))
+                       Segment ();
+    segment->flags = SEGMENT_HUGE_REGION | region->flags;
+    segment->node = region->node;
+    segment->mapping = region;
+    return segment;
+}
+
+//! Return a segment slot to its huge page region, unmapping the region once it is empty
+static void
+_memory_huge_region_release(Segment* segment)
+{
+    HugeRegion* region = static_cast<HugeRegion*>(segment->mapping);
+    u32 slot = (u32)(pointer_diff(segment, region) - SPAN_ADDRESS_GRANULARITY) / HUGE_SEGMENT_SLOT_SIZE;
+
+    _acquire_huge_lock();
+
+    region->used_slots &= ~(1U << slot);
+
+    //Keep the last region of the node to avoid remapping it on the next segment
+    HugeRegion* other = _huge_regions;
+    while (other && ((other == region) || (other->node != region->node)))
+        other = other->next_region;
+
+    if (region->used_slots || !other)
+    {
+        _release_huge_lock();
+        return;
+    }
+
+    HugeRegion** link = &_huge_regions;
+    while (*link != region)
+        link = &(*link)->next_region;
+    *link = region->next_region;
+
+    _release_huge_lock();
+
+    _memory_unmap_huge(region, HUGE_REGION_SIZE, region->flags);
+}
+
+//! Map an oversized span segment with huge pages on the given node,
+//! reusing a cached one of the node if available
+static Segment*
+_memory_huge_span_map(std::size_t bytes, u32 node)
+{
+    std::size_t huge_count = (bytes + (HUGE_PAGE_SIZE - 1)) / HUGE_PAGE_SIZE;
+    Segment* segment = nullptr;
+
+    //Check the cache for this huge page count (or the following one)
+    if (huge_count <= HUGE_CACHE_CLASS_COUNT)
+    {
+        _acquire_huge_lock();
+        for (std::size_t idx = huge_count - 1; !segment && (idx < HUGE_CACHE_CLASS_COUNT) && (idx <= huge_count); ++idx)
+        {
+            segment = _huge_cache[node][idx];
+            if (segment)
+            {
+                _huge_cache[node][idx] = static_cast<Segment*>(segment->next_segment.load(std::memory_order_relaxed));
+                --_huge_cache_count[node][idx];
+                _huge_cached -= segment->mapped_size;
+            }
+        }
+        _release_huge_lock();
+    }
+
+    if (!segment)
+    {
+        u32 flags = 0;
+        void* ptr = _memory_map_huge(huge_count * HUGE_PAGE_SIZE, &flags, node);
+        if (!ptr)
+            return nullptr;
+
+        segment = new (ptr) Segment ();
+        segment->flags = SEGMENT_HUGE_MAPPED | flags;
+        segment->node = node;
+        segment->mapping = ptr;
+        segment->mapped_size = huge_count * HUGE_PAGE_SIZE;
+    }
+
+    return segment;
+}
+
+//! Release an oversized huge page span segment to the huge span cache or unmap it
+static void
+_memory_huge_span_release(Segment* segment)
+{
+    std::size_t idx = segment->mapped_size / HUGE_PAGE_SIZE - 1;
+    u32 node = segment->node;
+
+    if (idx < HUGE_CACHE_CLASS_COUNT)
+    {
+        _acquire_huge_lock();
+        if (_huge_cache_count[node][idx] < HUGE_CACHE_LIMIT)
+        {
+            segment->next_segment.store(_huge_cache[node][idx], std::memory_order_relaxed);
+            _huge_cache[node][idx] = segment;
+            ++_huge_cache_count[node][idx];
+            _huge_cached += segment->mapped_size;
+            _release_huge_lock();
+            return;
+        }
+        _release_huge_lock();
+    }
+
+    _memory_unmap_huge(segment->mapping, segment->mapped_size, segment->flags);
+}
+
+//! Unmap all spans in the huge span cache and the empty huge page regions
+static void
+_memory_huge_flush()
+{
+    for (std::size_t idx = 0; idx < NUMA_MAX_NODES * HUGE_CACHE_CLASS_COUNT; ++idx)
+    {
+        u32 const node = static_cast<u32>(idx / HUGE_CACHE_CLASS_COUNT);
+
+        _acquire_huge_lock();
+        Segment* segment = _huge_cache[node][idx % HUGE_CACHE_CLASS_COUNT];
+        _huge_cache[node][idx % HUGE_CACHE_CLASS_COUNT] = nullptr;
+        _huge_cache_count[node][idx % HUGE_CACHE_CLASS_COUNT] = 0;
+        _release_huge_lock();
+
+        while (segment)
+        {
+            Segment* next = static_cast<Segment*>(segment->next_segment.load(std::memory_order_relaxed));
+            _huge_cached -= segment->mapped_size;
+            _memory_unmap_huge(segment->mapping, segment->mapped_size, segment->flags);
+            segment = next;
+        }
+    }
+
+    _acquire_huge_lock();
+    HugeRegion** link = &_huge_regions;
+    while (*link)
+    {
+        HugeRegion* region = *link;
+        if (region->used_slots)
+        {
+            link = &region->next_region;
+            continue;
+        }
+        *link = region->next_region;
+        _memory_unmap_huge(region, HUGE_REGION_SIZE, region->flags);
+    }
+    _release_huge_lock();
+}
+
+//! Release the memory of a segment to its origin
+static void
+_memory_release_segment(Segment* segment)
+{
+    if (segment->flags & SEGMENT_HUGE_REGION)
+        _memory_huge_region_release(segment);
+    else if (segment->flags & SEGMENT_HUGE_MAPPED)
+        _memory_huge_span_release(segment);
+    else
+    {
+        _memory_stat_unmap(segment->mapped_size);
+#if defined(OS_STD_UNIX) && defined(MAP_ANONYMOUS)
+        if (segment->flags & SEGMENT_NODE_MAPPED)
+            ::munmap(segment->mapping, segment->mapped_size);
+        else
+#endif
+        _memory_deallocate_external(segment);
+    }
+}
+
+//! Resize the directly mapped segment of an oversized span with mremap.
+//! The new mapping keeps the span address alignment, so the data is never copied;
+//! returns the (possibly moved) span or null if the segment can't be remapped
+static Span*
+_memory_remap(Span* span, std::size_t page_count)
+{
+#if defined(OS_GNU_LINUX) && defined(MREMAP_MAYMOVE) && defined(MREMAP_FIXED)
+    static const std::size_t page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+
+    Segment* segment = span->owner_segment;
+    if (!(segment->flags & SEGMENT_NODE_MAPPED) ||
+        (segment->next_segment.load() != (void*)SINGLE_SEGMENT_MARKER))
+        return nullptr;
+
+    //The segment and the span are unreachable through the old addresses once moved
+    std::size_t const offset = (std::size_t)pointer_diff(span, segment->mapping);
+    std::size_t const old_bytes = segment->mapped_size;
+    std::size_t const old_pages = (std::size_t)span->next_span;
+    u32 const node = segment->node;
+    std::size_t const bytes = (offset + page_count * MALLOC_PAGE_SIZE + (page_size - 1)) & ~(page_size - 1);
+
+    //Shrinking or growing into the following address range never moves the mapping
+    void* mapping = ::mremap(segment->mapping, old_bytes, bytes, 0);
+    if (mapping == MAP_FAILED)
+    {
+        //Reserve a destination where the span keeps its alignment and move the pages there
+        std::size_t const reserved = bytes + SPAN_ADDRESS_GRANULARITY;
+        void* reserve = ::mmap(nullptr, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (reserve == MAP_FAILED)
+            return nullptr;
+
+        uptr const target = ((((uptr)reserve + offset) + (SPAN_ADDRESS_GRANULARITY - 1)) &
+                             ~((uptr)SPAN_ADDRESS_GRANULARITY - 1)) - offset;
+
+        mapping = ::mremap(segment->mapping, old_bytes, bytes, MREMAP_MAYMOVE | MREMAP_FIXED, (void*)target);
+        if (mapping == MAP_FAILED)
+        {
+            ::munmap(reserve, reserved);
+            return nullptr;
+        }
+
+        if (target > (uptr)reserve)
+            ::munmap(reserve, target - (uptr)reserve);
+        if (((uptr)reserve + reserved) > (target + bytes))
+            ::munmap((void*)(target + bytes), ((uptr)reserve + reserved) - (target + bytes));
+    }
+
+    if (bytes > old_bytes)
+    {
+        _memory_stat_map(bytes - old_bytes);
+        _memory_bind_node(mapping, bytes, node);
+    }
+    else
+    {
+        _memory_stat_unmap(old_bytes - bytes);
+    }
+
+    Heap* heap = GET_THREAD_LOCAL(Heap*, _memory_thread_heap);
+    _memory_stat_add(heap->stats.oversized_deallocated, old_pages * MALLOC_PAGE_SIZE);
+    _memory_stat_add(heap->stats.oversized_allocated, page_count * MALLOC_PAGE_SIZE);
+
+    //The segment header is at the start of the mapping
+    segment = static_cast<Segment*>(mapping);
+    span = static_cast<Span*>(pointer_offset(mapping, offset));
+
+    segment->mapping = mapping;
+    segment->mapped_size = bytes;
+    segment->first_span = span;
+    span->owner_segment = segment;
+    span->next_span = (Span*)((uptr)page_count);
+    return span;
+#else
+    UNUSED(span);
+    UNUSED(page_count);
+    return nullptr;
+#endif
+}
+
+//! Give the whole pages of an unused memory range back to the system, keeping the range mapped
+static void
+_memory_purge(void* ptr, std::size_t bytes)
+{
+#if defined(OS_STD_UNIX) && defined(MADV_DONTNEED)
+    static const uptr page_size = static_cast<uptr>(::sysconf(_SC_PAGESIZE));
+
+    uptr first = ((uptr)ptr + (page_size - 1)) & ~(page_size - 1);
+    uptr last  = ((uptr)ptr + bytes) & ~(page_size - 1);
+
+    if (last > first)
+    {
+#   if ENABLE_TRIM_LAZY_FREE && defined(MADV_FREE)
+        ::madvise((void*)first, last - first, MADV_FREE);
+#   else
+        ::madvise((void*)first, last - first, MADV_DONTNEED);
+#   endif
+    }
+#else
+    UNUSED(ptr);
+    UNUSED(bytes);
+#endif
+}
+
+//! Release a cached span to its segment, purging its pages first unless they are
+//! backed by huge pages. The span header is purged too, so the segment is read beforehand
+static void
+_memory_release_span(Span* span, std::size_t bytes)
+{
+    Segment* segment = span->owner_segment;
+
+    if (!(segment->flags & (SEGMENT_HUGE_REGION | SEGMENT_HUGE_MAPPED)))
+        _memory_purge(span, bytes);
+
+    if (segment->next_segment.load() == (void*)SINGLE_SEGMENT_MARKER)
+        _memory_release_segment(segment);
+    else
+        _return_span_to_segment(segment, span);
+}
+
+//! Release the older half (rounded up, whole sublists) of a global cache list,
+//! returns the number of bytes released
+static std::size_t
+_memory_global_cache_trim(std::atomic<void*>* cache, std::size_t span_bytes)
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    void* global_span_ptr = cache->load();
+    while (global_span_ptr) {
+        if ((global_span_ptr != SPAN_LIST_LOCK_TOKEN) &&
+            std::atomic_compare_exchange_strong(cache, &global_span_ptr, SPAN_LIST_LOCK_TOKEN))
+            break;
+
+        thread_yield();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        global_span_ptr = cache->load();
+    }
+    if (!global_span_ptr)
+        return 0;
+
+    uptr global_list_size = (uptr)global_span_ptr & ~SPAN_MASK;
+    Span* span = (Span*)((void*)((uptr)global_span_ptr & SPAN_MASK));
+
+    //Keep the newest sublists, sublists are linked from the newest to the oldest through prev_span
+    const uptr keep = global_list_size / 2;
+    uptr kept = 0;
+    Span* last_kept = nullptr;
+    while (kept + span->data.list_size <= keep) {
+        kept += span->data.list_size;
+        last_kept = span;
+        span = span->prev_span;
+    }
+    if (last_kept)
+        last_kept->prev_span = nullptr;
+
+    *cache = kept ? ((void*)(((uptr)global_span_ptr & SPAN_MASK) | kept)) : nullptr;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    //Release the detached sublists
+    std::size_t released = 0;
+    for (uptr remaining = global_list_size - kept; remaining; ) {
+        Span* skip_span = span->prev_span;
+        const u32 span_count = span->data.list_size;
+        for (u32 ispan = 0; ispan < span_count; ++ispan) {
+            Span* next_span = span->next_span;
+            _memory_release_span(span, span_bytes);
+            span = next_span;
+        }
+        released += span_count * span_bytes;
+        remaining -= span_count;
+        span = skip_span;
+    }
+    return released;
+}
+
+std::size_t
+trim(std::size_t rss_target)
+{
+    //Let the thread caches decay to the global caches on their next deallocation
+    _memory_trim_epoch.fetch_add(1, std::memory_order_relaxed);
+
+    if (rss_target && working_size() <= rss_target)
+        return 0;
+
+    std::size_t released = 0;
+
+    for (u32 node = 0; node < NUMA_MAX_NODES; ++node)
+    {
+        released += _memory_global_cache_trim(&_memory_span_cache[node], SPAN_MAX_SIZE);
+
+        for (std::size_t iclass = 0; iclass < LARGE_CLASS_COUNT; ++iclass)
+            released += _memory_global_cache_trim(&_memory_large_cache[node][iclass],
+                                                  (iclass + 1) * SPAN_MAX_SIZE);
+    }
+
+    if (!rss_target || working_size() > rss_target)
+    {
+        const std::size_t cached_huge = _huge_cached.load(std::memory_order_relaxed);
+        _memory_huge_flush();
+        released += cached_huge - _huge_cached.load(std::memory_order_relaxed);
+
+#ifdef __GLIBC__
+        //Released malloc backed segments stay resident in the malloc arenas
+        ::malloc_trim(0);
+#endif
+    }
+
+    return released;
+}
+
+//! Background scavenger. A stop joins the thread outside the lock, the stopping
+//! state keeps a concurrent start from replacing the thread before it's joined
+enum class ScavengerState
+{
+    stopped,
+    running,
+    stopping
+};
+
+struct Scavenger
+{
+    std::mutex              lock;
+    std::condition_variable wake;
+    std::thread             thread;
+    ScavengerState          state = ScavengerState::stopped;
+
+    ~Scavenger() { stop_scavenger(); }
+};
+
+static Scavenger _scavenger;
+
+bool
+start_scavenger(std::size_t rss_target, u32 interval_ms)
+{
+    std::unique_lock<std::mutex> lock(_scavenger.lock);
+
+    _scavenger.wake.wait(lock, [] { return _scavenger.state != ScavengerState::stopping; });
+
+    if (_scavenger.state == ScavengerState::running)
+        return false;
+
+    _scavenger.state  = ScavengerState::running;
+    _scavenger.thread = std::thread([rss_target, interval_ms]
+    {
+        std::unique_lock<std::mutex> lock(_scavenger.lock);
+
+        while (!_scavenger.wake.wait_for(lock, std::chrono::milliseconds(interval_ms),
+                                         [] { return _scavenger.state != ScavengerState::running; }))
+        {
+            lock.unlock();
+            trim(rss_target);
+            lock.lock();
+        }
+    });
+
+    return true;
+}
+
+void
+stop_scavenger()
+{
+    std::unique_lock<std::mutex> lock(_scavenger.lock);
+
+    if (_scavenger.state == ScavengerState::stopping)
+    {
+        _scavenger.wake.wait(lock, [] { return _scavenger.state != ScavengerState::stopping; });
+        return;
+    }
+
+    if (_scavenger.state == ScavengerState::stopped)
+        return;
+
+    _scavenger.state = ScavengerState::stopping;
+    lock.unlock();
+
+    _scavenger.wake.notify_all();
+    _scavenger.thread.join();
+
+    lock.lock();
+    _scavenger.state = ScavengerState::stopped;
+    lock.unlock();
+
+    _scavenger.wake.notify_all();
+}
+
+void
+set_huge_pages(bool enable)
+{
+    _memory_huge_pages.store(enable, std::memory_order_relaxed);
+}
+
+bool
+huge_pages()
+{
+    return _memory_huge_pages.load(std::memory_order_relaxed);
+}
+
+u32
+numa_node_count()
+{
+    if (!is_thread_initialized ()) initializer ();
+
+    return _memory_numa_nodes;
+}
+
+u32
+thread_numa_node()
+{
+    if (!is_thread_initialized ()) initializer ();
+
+    return GET_THREAD_LOCAL(Heap*, _memory_thread_heap)->node;
+}
+
+bool
+bind_thread_numa_node(u32 node)
+{
+    if (!is_thread_initialized ()) initializer ();
+
+    if (node >= _memory_numa_nodes)
+        return false;
+
+    SET_THREAD_LOCAL(_memory_thread_node, CAST_THREAD_LOCAL(_memory_thread_node, node + 1));
+
+    //Move to a heap of the node, blocks of the previous heap are deferred back to it
+    if (GET_THREAD_LOCAL(Heap*, _memory_thread_heap)->node != node)
+    {
+        thread_reset();
+        thread_initialize();
+    }
+
+    return true;
+}
+
 //! Yield the thread remaining timeslice
 static void
 thread_yield()
@@ -2072,14 +3104,15 @@ void* allocate (std::size_t bytes)
 
 void deallocate (void* ptr)
 {
-    if (!is_thread_initialized ()) throw std::runtime_error ("thread memory model NOT initialized!");
+    //Threads can free blocks of other threads before they allocate (e.g. std::thread state)
+    if (!is_thread_initialized ()) initializer ();
 
     _memory_deallocate (ptr);
 }
 
 void* reallocate (void* ptr, std::size_t old_size, std::size_t new_size)
 {
-    if (!is_thread_initialized ()) throw std::runtime_error ("thread memory model NOT initialized!");
+    if (!is_thread_initialized ()) initializer ();
 
 #if ENABLE_VALIDATE_ARGS
     if (size >= MAX_ALLOC_SIZE) {
@@ -2210,6 +3243,110 @@ void
 thread_collect()
 {
     _memory_deallocate_deferred(GET_THREAD_LOCAL(Heap*, _memory_thread_heap), 0);
+    _memory_heap_decay(GET_THREAD_LOCAL(Heap*, _memory_thread_heap));
+}
+
+static_assert(STATISTICS_CLASS_COUNT == statistics_class_count, "Statistics class count mismatch");
+
+//! Block size of an allocation histogram class (0 for oversized blocks)
+static std::size_t
+_memory_statistics_class_size(std::size_t iclass)
+{
+    if (iclass < SIZE_CLASS_COUNT)
+        return _memory_size_class[iclass].size;
+    if (iclass < OVERSIZED_CLASS)
+        return ((iclass - SIZE_CLASS_COUNT + 1) * (std::size_t)SPAN_MAX_SIZE) - SPAN_HEADER_SIZE;
+    return 0;
+}
+
+//! Add the statistics counters of a heap to the given totals and optional histogram
+static void
+_memory_collect_heap_statistics(Heap* heap, thread_statistics* stats, size_class_statistics* classes)
+{
+    HeapStatistics& counters = heap->stats;
+
+    std::size_t allocated   = counters.oversized_allocated.load(std::memory_order_relaxed);
+    std::size_t deallocated = counters.oversized_deallocated.load(std::memory_order_relaxed);
+
+    for (std::size_t iclass = 0; iclass < STATISTICS_CLASS_COUNT; ++iclass)
+    {
+        std::size_t const allocations   = counters.allocations[iclass].load(std::memory_order_relaxed);
+        std::size_t const deallocations = counters.deallocations[iclass].load(std::memory_order_relaxed);
+        std::size_t const size          = _memory_statistics_class_size(iclass);
+
+        allocated   += allocations   * size;
+        deallocated += deallocations * size;
+
+        if (classes)
+        {
+            classes[iclass].allocations   += allocations;
+            classes[iclass].deallocations += deallocations;
+        }
+    }
+
+    //Wraps for a single heap when it frees oversized blocks of other heaps, the sum of all heaps is exact
+    stats->allocated         += allocated - deallocated;
+    stats->thread_cache_hits += counters.thread_cache_hits.load(std::memory_order_relaxed);
+    stats->global_cache_hits += counters.global_cache_hits.load(std::memory_order_relaxed);
+    stats->cache_misses      += counters.cache_misses.load(std::memory_order_relaxed);
+    stats->thread_to_global  += counters.thread_to_global.load(std::memory_order_relaxed);
+    stats->global_to_thread  += counters.global_to_thread.load(std::memory_order_relaxed);
+    stats->node_local        += counters.node_local.load(std::memory_order_relaxed);
+    stats->node_remote       += counters.node_remote.load(std::memory_order_relaxed);
+}
+
+//! Aggregate the global caches and the counters of all heaps
+static void
+_memory_collect_global_statistics(global_statistics* stats, size_class_statistics* classes)
+{
+    new (stats) global_statistics ();
+
+    stats->mapped = _mapped.load(std::memory_order_relaxed);
+    stats->mapped_total = _mapped_total.load(std::memory_order_relaxed);
+    stats->unmapped_total = _unmapped_total.load(std::memory_order_relaxed);
+    stats->huge_mapped = _huge_mapped.load(std::memory_order_relaxed);
+    stats->huge_explicit = _huge_explicit.load(std::memory_order_relaxed);
+    stats->cached_huge = _huge_cached.load(std::memory_order_relaxed);
+
+    thread_statistics totals = thread_statistics ();
+
+    for (u32 node = 0; node < NUMA_MAX_NODES; ++node)
+    {
+        void* global_span_ptr = _memory_span_cache[node].load();
+        while (global_span_ptr == SPAN_LIST_LOCK_TOKEN) {
+            thread_yield();
+            global_span_ptr = _memory_span_cache[node].load();
+        }
+        uptr global_span_count = reinterpret_cast<uptr>(global_span_ptr) & ~SPAN_MASK;
+        std::size_t list_bytes = global_span_count * QUICK_ALLOCATION_PAGES_COUNT * MALLOC_PAGE_SIZE;
+        stats->cached += list_bytes;
+
+        for (std::size_t iclass = 0; iclass < LARGE_CLASS_COUNT; ++iclass) {
+            global_span_ptr = _memory_large_cache[node][iclass].load();
+            while (global_span_ptr == SPAN_LIST_LOCK_TOKEN) {
+                thread_yield();
+                global_span_ptr = _memory_large_cache[node][iclass].load();
+            }
+            global_span_count = reinterpret_cast<uptr>(global_span_ptr) & ~SPAN_MASK;
+            list_bytes = global_span_count * (iclass + 1) * SPAN_MAX_PAGE_COUNT * MALLOC_PAGE_SIZE;
+            stats->cached_large += list_bytes;
+        }
+
+        for (std::size_t list_idx = 0; list_idx < HEAP_ARRAY_SIZE; ++list_idx) {
+            Heap* heap = _get_heap_ptr(_memory_heaps[node][list_idx].load());
+            if (heap)
+                _memory_collect_heap_statistics(heap, &totals, classes);
+        }
+    }
+
+    stats->allocated         = totals.allocated;
+    stats->thread_cache_hits = totals.thread_cache_hits;
+    stats->global_cache_hits = totals.global_cache_hits;
+    stats->cache_misses      = totals.cache_misses;
+    stats->thread_to_global  = totals.thread_to_global;
+    stats->global_to_thread  = totals.global_to_thread;
+    stats->node_local        = totals.node_local;
+    stats->node_remote       = totals.node_remote;
 }
 
 void
@@ -2217,8 +3354,13 @@ get_thread_statistics(thread_statistics* stats)
 {
     new (stats) thread_statistics ();
     Heap* heap = GET_THREAD_LOCAL(Heap*, _memory_thread_heap);
+
+    _memory_collect_heap_statistics(heap, stats, nullptr);
+
+    //Freed oversized blocks of other threads can make the heap balance negative
+    if (stats->allocated > (std::numeric_limits<std::size_t>::max() >> 1))
+        stats->allocated = 0;
 #if ENABLE_STATISTICS
-    stats->allocated = heap->allocated;
     stats->requested = heap->requested;
 #endif
     void* p = heap->defer_deallocate.load();
@@ -2226,7 +3368,9 @@ get_thread_statistics(thread_statistics* stats)
     {
         void* next = *(void**)p;
         Span* span = static_cast<Span*>((void*)((uptr)p & SPAN_MASK));
-        stats->deferred += _memory_size_class[span->size_class].size;
+        stats->deferred += (span->size_class < SIZE_CLASS_COUNT) ?
+                           _memory_size_class[span->size_class].size :
+                           (span->size_class - SIZE_CLASS_COUNT + 1) * (std::size_t)SPAN_MAX_SIZE;
         p = next;
     }
 
@@ -2240,7 +3384,7 @@ get_thread_statistics(thread_statistics* stats)
 
         while (cache)
         {
-            stats->sizecache = cache->data.block.free_count * _memory_size_class[cache->size_class].size;
+            stats->sizecache += cache->data.block.free_count * _memory_size_class[cache->size_class].size;
             cache = cache->next_span;
         }
     }
@@ -2253,33 +3397,18 @@ get_thread_statistics(thread_statistics* stats)
 void
 get_global_statistics(global_statistics* stats)
 {
-    new (stats) global_statistics ();
-#if ENABLE_STATISTICS
-    stats->mapped = _mapped_pages * MALLOC_PAGE_SIZE;
-    stats->mapped_total = _mapped_total * MALLOC_PAGE_SIZE;
-    stats->unmapped_total = _unmapped_total * MALLOC_PAGE_SIZE;
-#endif
-    {
-        void* global_span_ptr = _memory_span_cache.load();
-        while (global_span_ptr == SPAN_LIST_LOCK_TOKEN) {
-            thread_yield();
-            global_span_ptr = _memory_span_cache.load();
-        }
-        uptr global_span_count = reinterpret_cast<uptr>(global_span_ptr) & ~SPAN_MASK;
-        std::size_t list_bytes = global_span_count * QUICK_ALLOCATION_PAGES_COUNT * MALLOC_PAGE_SIZE;
-        stats->cached += list_bytes;
-    }
+    _memory_collect_global_statistics(stats, nullptr);
+}
 
-    for (std::size_t iclass = 0; iclass < LARGE_CLASS_COUNT; ++iclass) {
-        void* global_span_ptr = _memory_large_cache[iclass].load();
-        while (global_span_ptr == SPAN_LIST_LOCK_TOKEN) {
-            thread_yield();
-            global_span_ptr = _memory_large_cache[iclass].load();
-        }
-        uptr global_span_count = reinterpret_cast<uptr>(global_span_ptr) & ~SPAN_MASK;
-        std::size_t list_bytes = global_span_count * (iclass + 1) * SPAN_MAX_PAGE_COUNT * MALLOC_PAGE_SIZE;
-        stats->cached_large += list_bytes;
-    }
+void
+get_statistics_snapshot(statistics_snapshot* snapshot)
+{
+    new (snapshot) statistics_snapshot ();
+
+    for (std::size_t iclass = 0; iclass < STATISTICS_CLASS_COUNT; ++iclass)
+        snapshot->classes[iclass].size = _memory_statistics_class_size(iclass);
+
+    _memory_collect_global_statistics(&snapshot->global, snapshot->classes);
 }
 
 } } } // namespace Model
@@ -0,0 +1,132 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cppual/interned_string.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+#include <mutex>
+
+// =========================================================
+
+namespace cppual {
+
+// =========================================================
+
+intern_pool::intern_pool (resource_type& rc)
+: _M_pRc    (&rc)
+, _M_gMutex ()
+, _M_gIndex (allocator_type (rc))
+, _M_gAtoms (allocator_type (rc))
+{ }
+
+intern_pool::~intern_pool ()
+{
+    for (auto pEntry : _M_gAtoms)
+        _M_pRc->deallocate (const_cast<entry_type*> (pEntry),
+                            sizeof (entry_type) + pEntry->length + 1,
+                            alignof (entry_type));
+}
+
+intern_pool& intern_pool::global ()
+{
+    static intern_pool pool;
+    return pool;
+}
+
+intern_pool::value_type intern_pool::intern (string_view const& str)
+{
+    if (str.empty ()) return value_type ();
+
+    {
+        read_lock gLock (_M_gMutex);
+
+        auto const it = _M_gIndex.find (str);
+
+        if (it != _M_gIndex.end ()) return value_type (*it);
+    }
+
+    write_lock gLock (_M_gMutex);
+
+    //! another thread could have inserted it between the locks
+    auto const it = _M_gIndex.find (str);
+
+    if (it != _M_gIndex.end ()) return value_type (*it);
+
+    if (_M_gAtoms.size () >= std::numeric_limits<atom_type>::max ())
+        throw std::length_error ("intern_pool is out of atoms!");
+
+    //! the characters follow the entry in the same block
+    auto const pEntry = static_cast<entry_type*> (_M_pRc->allocate (sizeof (entry_type) + str.length () + 1,
+                                                                    alignof (entry_type)));
+    auto const pStr   = reinterpret_cast<char*> (pEntry + 1);
+
+    std::copy_n (str.data (), str.length (), pStr);
+    pStr[str.length ()] = char ();
+
+    ::new (pEntry) entry_type { pStr, str.length (), interned_string::hash_of (str),
+                                static_cast<atom_type> (_M_gAtoms.size () + 1) };
+
+    try
+    {
+        _M_gAtoms.push_back (pEntry);
+        _M_gIndex.insert    (pEntry);
+    }
+    catch (...)
+    {
+        if (!_M_gAtoms.empty () && _M_gAtoms.back () == pEntry) _M_gAtoms.pop_back ();
+
+        _M_pRc->deallocate (pEntry, sizeof (entry_type) + str.length () + 1, alignof (entry_type));
+        throw;
+    }
+
+    return value_type (pEntry);
+}
+
+intern_pool::value_type intern_pool::find (string_view const& str) const
+{
+    if (str.empty ()) return value_type ();
+
+    read_lock gLock (_M_gMutex);
+
+    auto const it = _M_gIndex.find (str);
+
+    return it != _M_gIndex.end () ? value_type (*it) : value_type ();
+}
+
+intern_pool::value_type intern_pool::at (atom_type uAtom) const
+{
+    read_lock gLock (_M_gMutex);
+
+    return uAtom && uAtom <= _M_gAtoms.size () ? value_type (_M_gAtoms[uAtom - 1]) : value_type ();
+}
+
+intern_pool::size_type intern_pool::size () const
+{
+    read_lock gLock (_M_gMutex);
+
+    return _M_gAtoms.size ();
+}
+
+// =========================================================
+
+} // namespace cppual
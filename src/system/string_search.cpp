@@ -0,0 +1,485 @@
+/*
+ * Product: C++ Unified Abstraction Library
+ * Author: K. Petrov
+ * Description: This file is a part of CPPUAL.
+ *
+ * Copyright (C) 2012 - 2024 K. Petrov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cppual/string_search.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <bit>
+
+#if defined (__x86_64__) or defined (__i386__) or defined (_M_X64) or defined (_M_IX86)
+#   include <immintrin.h>
+#   define CPPUAL_STRING_SEARCH_X86
+#   if defined (_MSC_VER) and !defined (__clang__)
+#       include <intrin.h>
+#       define CPPUAL_TARGET(isa)
+#   else
+#       define CPPUAL_TARGET(isa) __attribute__ ((target (isa)))
+#   endif
+#   ifdef __GLIBC__
+//! glibc dispatches memchr & memcmp by cpuid itself & beats our kernels for those
+#       define CPPUAL_VECTOR_KERNEL(scalar, vector) scalar
+#   else
+#       define CPPUAL_VECTOR_KERNEL(scalar, vector) vector
+#   endif
+#endif
+
+// =========================================================
+
+namespace cppual::simd {
+
+// =========================================================
+
+namespace { // optimize for internal unit usage
+
+typedef std::size_t (* find_byte_fn    ) (u8 const*, std::size_t, u8) noexcept;
+typedef std::size_t (* find_bytes_fn   ) (u8 const*, std::size_t, u8 const*, std::size_t) noexcept;
+typedef std::size_t (* find_any_byte_fn) (u8 const*, std::size_t, u8 const*, std::size_t) noexcept;
+typedef int         (* compare_bytes_fn) (u8 const*, u8 const*, std::size_t) noexcept;
+
+//! the set of kernels of one instruction set
+struct kernels
+{
+    isa              eIsa         ;
+    find_byte_fn     find_byte    ;
+    find_bytes_fn    find_bytes   ;
+    find_any_byte_fn find_any_byte;
+    compare_bytes_fn compare_bytes;
+};
+
+// =========================================================
+// plain C, the library functions already are the best scalar code
+// =========================================================
+
+std::size_t scalar_find_byte (u8 const* pStr, std::size_t uLen, u8 ch) noexcept
+{
+    auto const pFound = static_cast<u8 const*> (std::memchr (pStr, ch, uLen));
+
+    return pFound ? static_cast<std::size_t> (pFound - pStr) : npos;
+}
+
+std::size_t scalar_find_bytes (u8 const* pStr, std::size_t uLen, u8 const* s, std::size_t uCount) noexcept
+{
+    for (std::size_t i = 0; uLen - i >= uCount; ++i)
+    {
+        auto const uPos = scalar_find_byte (pStr + i, uLen - uCount + 1 - i, s[0]);
+
+        if (uPos == npos) return npos;
+        if (!std::memcmp (pStr + i + uPos + 1, s + 1, uCount - 1)) return i + uPos;
+
+        i += uPos;
+    }
+
+    return npos;
+}
+
+std::size_t scalar_find_any_byte (u8 const* pStr, std::size_t uLen, u8 const* pSet, std::size_t uCount) noexcept
+{
+    u64 uTable[4] { };
+
+    for (auto i = 0U; i < uCount; ++i) uTable[pSet[i] >> 6] |= u64 (1) << (pSet[i] & 63);
+
+    for (std::size_t i = 0; i < uLen; ++i)
+    {
+        if (uTable[pStr[i] >> 6] & (u64 (1) << (pStr[i] & 63))) return i;
+    }
+
+    return npos;
+}
+
+int scalar_compare_bytes (u8 const* pLh, u8 const* pRh, std::size_t uLen) noexcept
+{
+    return std::memcmp (pLh, pRh, uLen);
+}
+
+//! the byte at the first clear bit of a vector equality mask
+inline int compare_at (u8 const* pLh, u8 const* pRh, u32 uEqualMask) noexcept
+{
+    auto const uIdx = std::countr_zero (~uEqualMask);
+
+    return static_cast<int> (pLh[uIdx]) - static_cast<int> (pRh[uIdx]);
+}
+
+constexpr kernels const scalar_kernels
+{
+    isa::scalar,
+    scalar_find_byte,
+    scalar_find_bytes,
+    scalar_find_any_byte,
+    scalar_compare_bytes
+};
+
+#ifdef CPPUAL_STRING_SEARCH_X86
+
+// =========================================================
+// SSE2, 16 bytes per step
+// =========================================================
+
+[[maybe_unused]] CPPUAL_TARGET ("sse2")
+std::size_t sse2_find_byte (u8 const* pStr, std::size_t uLen, u8 ch) noexcept
+{
+    auto const gCh = _mm_set1_epi8 (static_cast<char> (ch));
+
+    std::size_t i = 0;
+
+    for (; i + 16 <= uLen; i += 16)
+    {
+        auto const gBlock = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (pStr + i));
+        auto const uMask  = static_cast<u32> (_mm_movemask_epi8 (_mm_cmpeq_epi8 (gBlock, gCh)));
+
+        if (uMask) return i + static_cast<std::size_t> (std::countr_zero (uMask));
+    }
+
+    auto const uPos = scalar_find_byte (pStr + i, uLen - i, ch);
+
+    return uPos != npos ? i + uPos : npos;
+}
+
+//! candidates are the positions where both the first & the last byte match,
+//! only those are compared in full
+CPPUAL_TARGET ("sse2")
+std::size_t sse2_find_bytes (u8 const* pStr, std::size_t uLen, u8 const* s, std::size_t uCount) noexcept
+{
+    auto const gFirst = _mm_set1_epi8 (static_cast<char> (s[0]));
+    auto const gLast  = _mm_set1_epi8 (static_cast<char> (s[uCount - 1]));
+
+    std::size_t i = 0;
+
+    for (; i + uCount - 1 + 16 <= uLen; i += 16)
+    {
+        auto const gHead = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (pStr + i));
+        auto const gTail = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (pStr + i + uCount - 1));
+
+        auto uMask = static_cast<u32> (_mm_movemask_epi8 (_mm_and_si128 (_mm_cmpeq_epi8 (gHead, gFirst),
+                                                                         _mm_cmpeq_epi8 (gTail, gLast ))));
+
+        for (; uMask; uMask &= uMask - 1)
+        {
+            auto const uPos = i + static_cast<std::size_t> (std::countr_zero (uMask));
+
+            if (!std::memcmp (pStr + uPos + 1, s + 1, uCount - 2)) return uPos;
+        }
+    }
+
+    auto const uPos = scalar_find_bytes (pStr + i, uLen - i, s, uCount);
+
+    return uPos != npos ? i + uPos : npos;
+}
+
+CPPUAL_TARGET ("sse2")
+std::size_t sse2_find_any_byte (u8 const* pStr, std::size_t uLen, u8 const* pSet, std::size_t uCount) noexcept
+{
+    if (uCount > 16) return scalar_find_any_byte (pStr, uLen, pSet, uCount);
+
+    __m128i gSet[16];
+
+    for (auto n = 0U; n < uCount; ++n) gSet[n] = _mm_set1_epi8 (static_cast<char> (pSet[n]));
+
+    std::size_t i = 0;
+
+    for (; i + 16 <= uLen; i += 16)
+    {
+        auto const gBlock = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (pStr + i));
+        auto       gAny   = _mm_cmpeq_epi8 (gBlock, gSet[0]);
+
+        for (auto n = 1U; n < uCount; ++n) gAny = _mm_or_si128 (gAny, _mm_cmpeq_epi8 (gBlock, gSet[n]));
+
+        auto const uMask = static_cast<u32> (_mm_movemask_epi8 (gAny));
+
+        if (uMask) return i + static_cast<std::size_t> (std::countr_zero (uMask));
+    }
+
+    auto const uPos = scalar_find_any_byte (pStr + i, uLen - i, pSet, uCount);
+
+    return uPos != npos ? i + uPos : npos;
+}
+
+[[maybe_unused]] CPPUAL_TARGET ("sse2")
+int sse2_compare_bytes (u8 const* pLh, u8 const* pRh, std::size_t uLen) noexcept
+{
+    std::size_t i = 0;
+
+    for (; i + 16 <= uLen; i += 16)
+    {
+        auto const gLh   = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (pLh + i));
+        auto const gRh   = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (pRh + i));
+        auto const uMask = static_cast<u32> (_mm_movemask_epi8 (_mm_cmpeq_epi8 (gLh, gRh)));
+
+        if (uMask != 0xffff) return compare_at (pLh + i, pRh + i, uMask);
+    }
+
+    return std::memcmp (pLh + i, pRh + i, uLen - i);
+}
+
+constexpr kernels const sse2_kernels
+{
+    isa::sse2,
+    CPPUAL_VECTOR_KERNEL (scalar_find_byte, sse2_find_byte),
+    sse2_find_bytes,
+    sse2_find_any_byte,
+    CPPUAL_VECTOR_KERNEL (scalar_compare_bytes, sse2_compare_bytes)
+};
+
+// =========================================================
+// AVX2, 32 bytes per step, the shorter tails go through SSE2
+// =========================================================
+
+[[maybe_unused]] CPPUAL_TARGET ("avx2")
+std::size_t avx2_find_byte (u8 const* pStr, std::size_t uLen, u8 ch) noexcept
+{
+    auto const gCh = _mm256_set1_epi8 (static_cast<char> (ch));
+
+    std::size_t i = 0;
+
+    //! two vectors per step, one branch for both
+    for (; i + 64 <= uLen; i += 64)
+    {
+        auto const gOne = _mm256_cmpeq_epi8 (_mm256_loadu_si256 (reinterpret_cast<__m256i const*> (pStr + i     )), gCh);
+        auto const gTwo = _mm256_cmpeq_epi8 (_mm256_loadu_si256 (reinterpret_cast<__m256i const*> (pStr + i + 32)), gCh);
+
+        if (!_mm256_testz_si256 (_mm256_or_si256 (gOne, gTwo), _mm256_or_si256 (gOne, gTwo)))
+        {
+            auto const uOne = static_cast<u32> (_mm256_movemask_epi8 (gOne));
+
+            return uOne ? i + static_cast<std::size_t> (std::countr_zero (uOne)) :
+                          i + 32 + static_cast<std::size_t> (std::countr_zero (static_cast<u32> (_mm256_movemask_epi8 (gTwo))));
+        }
+    }
+
+    for (; i + 32 <= uLen; i += 32)
+    {
+        auto const gBlock = _mm256_loadu_si256 (reinterpret_cast<__m256i const*> (pStr + i));
+        auto const uMask  = static_cast<u32> (_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (gBlock, gCh)));
+
+        if (uMask) return i + static_cast<std::size_t> (std::countr_zero (uMask));
+    }
+
+    auto const uPos = sse2_find_byte (pStr + i, uLen - i, ch);
+
+    return uPos != npos ? i + uPos : npos;
+}
+
+CPPUAL_TARGET ("avx2")
+std::size_t avx2_find_bytes (u8 const* pStr, std::size_t uLen, u8 const* s, std::size_t uCount) noexcept
+{
+    auto const gFirst = _mm256_set1_epi8 (static_cast<char> (s[0]));
+    auto const gLast  = _mm256_set1_epi8 (static_cast<char> (s[uCount - 1]));
+
+    std::size_t i = 0;
+
+    for (; i + uCount - 1 + 32 <= uLen; i += 32)
+    {
+        auto const gHead = _mm256_loadu_si256 (reinterpret_cast<__m256i const*> (pStr + i));
+        auto const gTail = _mm256_loadu_si256 (reinterpret_cast<__m256i const*> (pStr + i + uCount - 1));
+
+        auto uMask = static_cast<u32> (_mm256_movemask_epi8 (_mm256_and_si256 (_mm256_cmpeq_epi8 (gHead, gFirst),
+                                                                               _mm256_cmpeq_epi8 (gTail, gLast ))));
+
+        for (; uMask; uMask &= uMask - 1)
+        {
+            auto const uPos = i + static_cast<std::size_t> (std::countr_zero (uMask));
+
+            if (!std::memcmp (pStr + uPos + 1, s + 1, uCount - 2)) return uPos;
+        }
+    }
+
+    auto const uPos = sse2_find_bytes (pStr + i, uLen - i, s, uCount);
+
+    return uPos != npos ? i + uPos : npos;
+}
+
+CPPUAL_TARGET ("avx2")
+std::size_t avx2_find_any_byte (u8 const* pStr, std::size_t uLen, u8 const* pSet, std::size_t uCount) noexcept
+{
+    if (uCount > 16) return scalar_find_any_byte (pStr, uLen, pSet, uCount);
+
+    __m256i gSet[16];
+
+    for (auto n = 0U; n < uCount; ++n) gSet[n] = _mm256_set1_epi8 (static_cast<char> (pSet[n]));
+
+    std::size_t i = 0;
+
+    for (; i + 32 <= uLen; i += 32)
+    {
+        auto const gBlock = _mm256_loadu_si256 (reinterpret_cast<__m256i const*> (pStr + i));
+        auto       gAny   = _mm256_cmpeq_epi8 (gBlock, gSet[0]);
+
+        for (auto n = 1U; n < uCount; ++n) gAny = _mm256_or_si256 (gAny, _mm256_cmpeq_epi8 (gBlock, gSet[n]));
+
+        auto const uMask = static_cast<u32> (_mm256_movemask_epi8 (gAny));
+
+        if (uMask) return i + static_cast<std::size_t> (std::countr_zero (uMask));
+    }
+
+    auto const uPos = sse2_find_any_byte (pStr + i, uLen - i, pSet, uCount);
+
+    return uPos != npos ? i + uPos : npos;
+}
+
+[[maybe_unused]] CPPUAL_TARGET ("avx2")
+int avx2_compare_bytes (u8 const* pLh, u8 const* pRh, std::size_t uLen) noexcept
+{
+    std::size_t i = 0;
+
+    for (; i + 32 <= uLen; i += 32)
+    {
+        auto const gLh   = _mm256_loadu_si256 (reinterpret_cast<__m256i const*> (pLh + i));
+        auto const gRh   = _mm256_loadu_si256 (reinterpret_cast<__m256i const*> (pRh + i));
+        auto const uMask = static_cast<u32> (_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (gLh, gRh)));
+
+        if (uMask != 0xffffffff) return compare_at (pLh + i, pRh + i, uMask);
+    }
+
+    return sse2_compare_bytes (pLh + i, pRh + i, uLen - i);
+}
+
+constexpr kernels const avx2_kernels
+{
+    isa::avx2,
+    CPPUAL_VECTOR_KERNEL (scalar_find_byte, avx2_find_byte),
+    avx2_find_bytes,
+    avx2_find_any_byte,
+    CPPUAL_VECTOR_KERNEL (scalar_compare_bytes, avx2_compare_bytes)
+};
+
+#endif // CPPUAL_STRING_SEARCH_X86
+
+// =========================================================
+
+isa detect_isa () noexcept
+{
+#ifdef CPPUAL_STRING_SEARCH_X86
+#   if defined (_MSC_VER) and !defined (__clang__)
+    int nRegs[4] { };
+
+    __cpuid (nRegs, 0);
+
+    auto const nMaxLeaf = nRegs[0];
+
+    __cpuid (nRegs, 1);
+
+    auto const bSse2    = (nRegs[3] & (1 << 26)) != 0;
+    auto const bOsSaves = (nRegs[2] & (1 << 27)) != 0 && (_xgetbv (0) & 6) == 6;
+
+    if (bOsSaves && nMaxLeaf >= 7)
+    {
+        __cpuidex (nRegs, 7, 0);
+
+        if (nRegs[1] & (1 << 5)) return isa::avx2;
+    }
+
+    return bSse2 ? isa::sse2 : isa::scalar;
+#   else
+    __builtin_cpu_init ();
+
+    if (__builtin_cpu_supports ("avx2")) return isa::avx2;
+    if (__builtin_cpu_supports ("sse2")) return isa::sse2;
+#   endif
+#endif
+
+    return isa::scalar;
+}
+
+kernels const& kernels_for (isa eIsa) noexcept
+{
+    switch (eIsa)
+    {
+#ifdef CPPUAL_STRING_SEARCH_X86
+    case isa::avx2: return avx2_kernels;
+    case isa::sse2: return sse2_kernels;
+#endif
+    default: return scalar_kernels;
+    }
+}
+
+//! resolved on the first call, every call after that is an indirect jump
+std::atomic<kernels const*> g_pKernels { };
+
+inline kernels const& active_kernels () noexcept
+{
+    auto pKernels = g_pKernels.load (std::memory_order_relaxed);
+
+    if (!pKernels)
+    {
+        pKernels = &kernels_for (supported_isa ());
+        g_pKernels.store (pKernels, std::memory_order_relaxed);
+    }
+
+    return *pKernels;
+}
+
+} // anonymous namespace
+
+// =========================================================
+
+isa supported_isa () noexcept
+{
+    static isa const eIsa = detect_isa ();
+
+    return eIsa;
+}
+
+isa active_isa () noexcept
+{
+    return active_kernels ().eIsa;
+}
+
+void select_isa (isa eIsa) noexcept
+{
+    g_pKernels.store (&kernels_for (std::min (eIsa, supported_isa ())), std::memory_order_relaxed);
+}
+
+// =========================================================
+
+std::size_t find_byte (void const* pStr, std::size_t uLen, u8 ch) noexcept
+{
+    return active_kernels ().find_byte (static_cast<u8 const*> (pStr), uLen, ch);
+}
+
+std::size_t find_bytes (void const* pStr, std::size_t uLen, void const* s, std::size_t uCount) noexcept
+{
+    if (!uCount     ) return 0;
+    if (uCount > uLen) return npos;
+    if (uCount == 1 ) return find_byte (pStr, uLen, *static_cast<u8 const*> (s));
+
+    return active_kernels ().find_bytes (static_cast<u8 const*> (pStr), uLen,
+                                         static_cast<u8 const*> (s   ), uCount);
+}
+
+std::size_t find_any_byte (void const* pStr, std::size_t uLen, void const* pSet, std::size_t uCount) noexcept
+{
+    if (!uCount    ) return npos;
+    if (uCount == 1) return find_byte (pStr, uLen, *static_cast<u8 const*> (pSet));
+
+    return active_kernels ().find_any_byte (static_cast<u8 const*> (pStr), uLen,
+                                            static_cast<u8 const*> (pSet), uCount);
+}
+
+int compare_bytes (void const* pLh, void const* pRh, std::size_t uLen) noexcept
+{
+    return active_kernels ().compare_bytes (static_cast<u8 const*> (pLh),
+                                            static_cast<u8 const*> (pRh), uLen);
+}
+
+// =========================================================
+
+} // namespace simd
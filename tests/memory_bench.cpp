@@ -0,0 +1,319 @@
+#include <cppual/memory_resource>
+#include <cppual/memory/system.h>
+
+#include <memory_resource>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <atomic>
+#include <vector>
+#include <map>
+
+namespace memory = cppual::memory;
+
+typedef std::chrono::steady_clock                  clock_type  ;
+typedef std::shared_ptr<std::pmr::memory_resource> resource_ptr;
+
+constexpr const std::size_t block_size  = 64U;
+constexpr const std::size_t min_size    = 16U;
+constexpr const std::size_t max_size    = 4096U;
+constexpr const std::size_t burst_size  = 32U;
+constexpr const std::size_t arena_size  = 64U << 20;
+constexpr const std::size_t pool_blocks = 1U << 16;
+constexpr const std::size_t ring_size   = 1024U;
+
+//! one line of the report
+struct result
+{
+    std::string workload;
+    std::string resource;
+    unsigned    threads ;
+    std::size_t ops     ;
+    double      mops    ;
+    double      p50     ;
+    double      p90     ;
+    double      p99     ;
+    double      p999    ;
+};
+
+//! every workload gets a fresh instance of the resource
+struct candidate
+{
+    std::string                   name       ;
+    std::function<resource_ptr()> make       ;
+    bool                          thread_safe;
+    //! largest block the resource serves, 0 is unlimited
+    std::size_t                   max_block  ;
+};
+
+template <typename Resource, typename... Args>
+resource_ptr make_owned (Args... args)
+{ return resource_ptr (new Resource (args...)); }
+
+resource_ptr make_shared_ref (std::pmr::memory_resource& rc)
+{ return resource_ptr (&rc, [](std::pmr::memory_resource*) { }); }
+
+std::vector<candidate> candidates ()
+{
+    return
+    {
+        { "system_resource"             , [] { return make_shared_ref (memory::system_resource ()); }, true , 0 },
+        { "heap_resource"               , [] { return make_owned<memory::heap_resource> (arena_size); }, false, 0 },
+        { "heap_resource_tlsf"          , [] { return make_owned<memory::heap_resource> (arena_size, memory::heap_strategy::tlsf); }, false, 0 },
+        { "list_resource"               , [] { return make_owned<memory::list_resource> (arena_size); }, false, 0 },
+        { "uniform_pool_resource"       , [] { return make_owned<memory::uniform_pool_resource> (pool_blocks, block_size); }, false, block_size },
+        { "atomic_uniform_pool_resource", [] { return make_owned<memory::atomic_uniform_pool_resource> (pool_blocks, block_size); }, true, block_size },
+        { "stacked_resource"            , [] { return make_owned<memory::stacked_resource> (arena_size); }, false, 0 },
+        { "dstacked_resource"           , [] { return make_owned<memory::dstacked_resource> (arena_size, arena_size / 2); }, false, 0 },
+        { "std_unsynchronized_pool"     , [] { return make_owned<std::pmr::unsynchronized_pool_resource> (); }, false, 0 },
+        { "std_synchronized_pool"       , [] { return make_owned<std::pmr::synchronized_pool_resource> (); }, true , 0 },
+        { "thread_caching_resource"     , [] { return resource_ptr (new memory::thread_caching_resource (memory::malloc_resource ())); }, true , 0 },
+        { "malloc"                      , [] { return make_shared_ref (memory::malloc_resource ()); }, true , 0 }
+    };
+}
+
+//! per-operation latency percentiles from the per-burst samples
+void fill_percentiles (result& res, std::vector<double>& samples)
+{
+    if (samples.empty ()) return;
+
+    std::sort (samples.begin (), samples.end ());
+
+    auto const at = [&samples] (double q)
+    { return samples[std::min (samples.size () - 1, static_cast<std::size_t> (q * static_cast<double> (samples.size ())))]; };
+
+    res.p50  = at (0.50 );
+    res.p90  = at (0.90 );
+    res.p99  = at (0.99 );
+    res.p999 = at (0.999);
+}
+
+//! bursts of allocations released in reverse order (valid for the stacked resources too)
+result run_bursts (std::string const& workload, candidate const& cand,
+                   std::vector<std::size_t> const& sizes, std::size_t rounds)
+{
+    auto const rc = cand.make ();
+
+    std::vector<void*>  blocks  (burst_size);
+    std::vector<double> samples ;
+
+    samples.reserve (rounds);
+
+    auto const start = clock_type::now ();
+
+    for (auto n = 0U, s = 0U; n < rounds; ++n)
+    {
+        auto const burst_start = clock_type::now ();
+        auto const first       = s;
+
+        for (auto i = 0U; i < burst_size; ++i, s = (s + 1) % sizes.size ())
+            blocks[i] = rc->allocate (sizes[s]);
+
+        for (auto i = burst_size; i-- > 0; )
+            rc->deallocate (blocks[i], sizes[(first + i) % sizes.size ()]);
+
+        auto const burst_time = std::chrono::duration<double, std::nano> (clock_type::now () - burst_start);
+
+        samples.push_back (burst_time.count () / (burst_size * 2U));
+    }
+
+    auto const elapsed = std::chrono::duration<double> (clock_type::now () - start);
+
+    result res { workload, cand.name, 1U, rounds * burst_size * 2U, 0, 0, 0, 0, 0 };
+
+    res.mops = static_cast<double> (res.ops) / elapsed.count () / 1e6;
+    fill_percentiles (res, samples);
+
+    return res;
+}
+
+//! the producer allocates, the consumer frees -> every block crosses threads
+result run_cross_thread (candidate const& cand, std::size_t rounds)
+{
+    auto const rc    = cand.make ();
+    auto const total = rounds * burst_size;
+
+    std::vector<void*>       ring (ring_size);
+    std::atomic<std::size_t> head { };
+    std::atomic<std::size_t> tail { };
+    std::vector<double>      samples;
+
+    samples.reserve (rounds);
+
+    auto const start = clock_type::now ();
+
+    std::thread consumer ([&]
+    {
+        for (std::size_t n = 0; n < total; )
+        {
+            auto const t = tail.load (std::memory_order_relaxed);
+
+            if (t == head.load (std::memory_order_acquire))
+            {
+                std::this_thread::yield ();
+                continue;
+            }
+
+            rc->deallocate (ring[t % ring_size], block_size);
+            tail.store (t + 1, std::memory_order_release);
+            ++n;
+        }
+    });
+
+    for (auto n = 0U; n < rounds; ++n)
+    {
+        auto const burst_start = clock_type::now ();
+
+        for (auto i = 0U; i < burst_size; ++i)
+        {
+            auto const p = rc->allocate (block_size);
+            auto const h = head.load (std::memory_order_relaxed);
+
+            while (h - tail.load (std::memory_order_acquire) == ring_size) std::this_thread::yield ();
+
+            ring[h % ring_size] = p;
+            head.store (h + 1, std::memory_order_release);
+        }
+
+        auto const burst_time = std::chrono::duration<double, std::nano> (clock_type::now () - burst_start);
+
+        samples.push_back (burst_time.count () / burst_size);
+    }
+
+    consumer.join ();
+
+    auto const elapsed = std::chrono::duration<double> (clock_type::now () - start);
+
+    result res { "cross_thread", cand.name, 2U, total * 2U, 0, 0, 0, 0, 0 };
+
+    res.mops = static_cast<double> (res.ops) / elapsed.count () / 1e6;
+    fill_percentiles (res, samples);
+
+    return res;
+}
+
+void write_csv (std::ostream& os, std::vector<result> const& results)
+{
+    os << "workload,resource,threads,ops,mops,p50_ns,p90_ns,p99_ns,p999_ns\n";
+
+    for (auto const& res : results)
+    {
+        os << res.workload << ',' << res.resource << ',' << res.threads << ',' << res.ops << ','
+           << res.mops << ',' << res.p50 << ',' << res.p90 << ',' << res.p99 << ',' << res.p999 << '\n';
+    }
+}
+
+void write_json (std::ostream& os, std::vector<result> const& results)
+{
+    os << "[\n";
+
+    for (auto i = 0U; i < results.size (); ++i)
+    {
+        auto const& res = results[i];
+
+        os << "  { \"workload\": \"" << res.workload << "\", \"resource\": \"" << res.resource
+           << "\", \"threads\": " << res.threads << ", \"ops\": " << res.ops
+           << ", \"mops\": " << res.mops << ", \"p50_ns\": " << res.p50 << ", \"p90_ns\": " << res.p90
+           << ", \"p99_ns\": " << res.p99 << ", \"p999_ns\": " << res.p999 << " }"
+           << (i + 1 < results.size () ? ",\n" : "\n");
+    }
+
+    os << "]\n";
+}
+
+//! throughput per "workload,resource,threads" from a previous csv report
+std::map<std::string, double> read_baseline (std::string const& path)
+{
+    std::map<std::string, double> baseline;
+    std::ifstream                 file (path);
+    std::string                   line;
+
+    std::getline (file, line);
+
+    while (std::getline (file, line))
+    {
+        std::istringstream       stream (line);
+        std::vector<std::string> fields;
+
+        for (std::string field; std::getline (stream, field, ','); ) fields.push_back (field);
+
+        if (fields.size () >= 5) baseline[fields[0] + ',' + fields[1] + ',' + fields[2]] = std::stod (fields[4]);
+    }
+
+    return baseline;
+}
+
+//! usage: cppual-memory-bench [--json] [--rounds=N] [--baseline=report.csv] [--tolerance=0.10]
+//! the exit code is 1 when the throughput of any run dropped below the baseline by more than the tolerance
+int main (int argc, char** argv)
+{
+    auto        json      = false;
+    std::size_t rounds    = 1U << 15;
+    double      tolerance = 0.10;
+    std::string baseline_path;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        std::string const arg (argv[i]);
+
+        if      (arg == "--json"                     ) json          = true;
+        else if (arg.rfind ("--rounds="   , 0) == 0) rounds        = std::stoul (arg.substr (9 ));
+        else if (arg.rfind ("--baseline=" , 0) == 0) baseline_path = arg.substr (11);
+        else if (arg.rfind ("--tolerance=", 0) == 0) tolerance     = std::stod  (arg.substr (12));
+        else
+        {
+            std::cerr << "unknown argument: " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    //! the same pseudo random size sequence for every resource
+    std::mt19937                           gen  (42U);
+    std::uniform_real_distribution<double> dist (std::log2 (min_size), std::log2 (max_size));
+    std::vector<std::size_t>               mixed_sizes (4096U);
+    std::vector<std::size_t>               fixed_sizes (1U, block_size);
+
+    for (auto& size : mixed_sizes) size = static_cast<std::size_t> (std::exp2 (dist (gen)));
+
+    std::vector<result> results;
+
+    for (auto const& cand : candidates ())
+    {
+        results.push_back (run_bursts ("fixed", cand, fixed_sizes, rounds));
+
+        if (!cand.max_block) results.push_back (run_bursts ("mixed", cand, mixed_sizes, rounds));
+        if (cand.thread_safe) results.push_back (run_cross_thread (cand, rounds));
+    }
+
+    if (json) write_json (std::cout, results);
+    else      write_csv  (std::cout, results);
+
+    if (baseline_path.empty ()) return 0;
+
+    auto const baseline    = read_baseline (baseline_path);
+    auto       regressions = 0U;
+
+    for (auto const& res : results)
+    {
+        auto const it = baseline.find (res.workload + ',' + res.resource + ',' + std::to_string (res.threads));
+
+        if (it == baseline.end () || res.mops >= it->second * (1.0 - tolerance)) continue;
+
+        std::cerr << "regression: " << res.workload << ' ' << res.resource << ' '
+                  << res.mops << " Mops/s (baseline " << it->second << ")" << std::endl;
+
+        ++regressions;
+    }
+
+    return regressions ? 1 : 0;
+}
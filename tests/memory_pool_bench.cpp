@@ -0,0 +1,98 @@
+#include <cppual/memory_resource>
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <vector>
+
+using cppual::memory::uniform_pool_resource;
+using cppual::memory::atomic_uniform_pool_resource;
+
+constexpr const std::size_t block_size    = 64U;
+constexpr const std::size_t block_count   = 1U << 16;
+constexpr const std::size_t burst_size    = 32U;
+constexpr const std::size_t bursts        = 1U << 15;
+
+struct locked_pool
+{
+    locked_pool () : pool (block_count, block_size) { }
+
+    void* allocate (std::size_t size)
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        return pool.allocate (size, cppual::memory::memory_resource::max_align);
+    }
+
+    void deallocate (void* p, std::size_t size)
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        pool.deallocate (p, size, cppual::memory::memory_resource::max_align);
+    }
+
+    std::mutex            mutex;
+    uniform_pool_resource pool ;
+};
+
+struct lock_free_pool
+{
+    lock_free_pool () : pool (block_count, block_size) { }
+
+    void* allocate (std::size_t size)
+    { return pool.allocate (size, cppual::memory::memory_resource::max_align); }
+
+    void deallocate (void* p, std::size_t size)
+    { pool.deallocate (p, size, cppual::memory::memory_resource::max_align); }
+
+    atomic_uniform_pool_resource pool;
+};
+
+//! every thread allocates a burst of blocks and then releases them
+template <typename Pool>
+double run (Pool& pool, unsigned threads)
+{
+    std::vector<std::thread> workers;
+
+    auto const start = std::chrono::steady_clock::now ();
+
+    for (auto t = 0U; t < threads; ++t)
+    {
+        workers.emplace_back ([&pool]
+        {
+            void* blocks[burst_size];
+
+            for (auto n = 0U; n < bursts; ++n)
+            {
+                for (auto i = 0U; i < burst_size; ++i) blocks[i] = pool.allocate (block_size);
+                for (auto i = 0U; i < burst_size; ++i) pool.deallocate (blocks[i], block_size);
+            }
+        });
+    }
+
+    for (auto& worker : workers) worker.join ();
+
+    auto const elapsed = std::chrono::duration<double> (std::chrono::steady_clock::now () - start);
+    auto const ops     = static_cast<double> (threads * bursts * burst_size * 2U);
+
+    return ops / elapsed.count () / 1e6;
+}
+
+int main ()
+{
+    auto const max_threads = std::max (2U, std::thread::hardware_concurrency ());
+
+    std::cout << "threads\tmutex (Mops/s)\tlock-free (Mops/s)" << std::endl;
+
+    for (auto threads = 1U; threads <= max_threads; threads *= 2U)
+    {
+        locked_pool    locked   ;
+        lock_free_pool lock_free;
+
+        auto const locked_rate    = run (locked   , threads);
+        auto const lock_free_rate = run (lock_free, threads);
+
+        std::cout << threads << '\t' << locked_rate << '\t' << lock_free_rate << std::endl;
+    }
+
+    return 0;
+}
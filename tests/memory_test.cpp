@@ -1,7 +1,20 @@
 #include <cppual/memory_resource>
+#include <cppual/system_memory>
+#include <cppual/shared_memory>
 #include <cppual/circular_queue>
+#include <cppual/containers>
+#include <cppual/string>
+#include <cppual/interned_string>
+#include <cppual/array_map>
+#include <cppual/signal>
 
+#include <stdexcept>
+#include <algorithm>
 #include <iostream>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <atomic>
 
 void test1 ()
 {
@@ -165,6 +178,1034 @@ void test4 ()
     std::cout << "zero_val < 0: " << (zero_val < 0) << std::endl;
 }
 
+void test5 ()
+{
+    typedef int                                value_type  ;
+    typedef cppual::circular_queue<value_type> value_vector;
+
+    constexpr const value_vector::size_type max_vectors = 400U;
+
+    cppual::memory::set_default_resource (cppual::memory::new_delete_resource ());
+
+    cppual::memory::heap_resource res (max_vectors * max_vectors * sizeof (value_type),
+                                       cppual::memory::heap_strategy::tlsf);
+
+    auto const initial_size = res.max_size ();
+
+    cppual::memory::set_default_resource (res);
+
+    std::cout << "tlsf heap_resource max_size: " << initial_size << " bytes" << std::endl;
+
+    {
+        value_vector vec;
+
+        for (auto i = 0U; i < max_vectors; ++i)
+        {
+            vec.emplace_back (static_cast<value_type>(i));
+        }
+
+        std::cout << "vec size: " << vec.size ()
+                  << " elements\ntlsf heap_resource max_size: " << res.max_size ()
+                  << " bytes" << std::endl;
+    }
+
+    cppual::memory::set_default_resource (cppual::memory::new_delete_resource ());
+
+    std::cout << "tlsf heap_resource coalesced: "
+              << (res.max_size () == initial_size ? "yes" : "no") << std::endl;
+
+    //! a buffer too small for the tlsf control goes back to the owner
+    cppual::memory::stacked_resource arena (cppual::memory::new_delete_resource (), 4096U);
+
+    auto const arena_size = arena.max_size ();
+
+    try
+    {
+        cppual::memory::heap_resource small (arena, 64U, cppual::memory::heap_strategy::tlsf);
+        std::cout << "tlsf heap_resource too small accepted!" << std::endl;
+    }
+    catch (std::bad_alloc const&)
+    {
+        std::cout << "tlsf heap_resource too small rejected, buffer returned: "
+                  << (arena.max_size () == arena_size ? "yes" : "no") << std::endl;
+    }
+}
+
+void test6 ()
+{
+    typedef int                                value_type  ;
+    typedef cppual::circular_queue<value_type> value_vector;
+
+    constexpr const value_vector::size_type max_values = 2000U;
+
+    cppual::memory::set_default_resource (cppual::memory::new_delete_resource ());
+
+    cppual::memory::slab_resource res (cppual::memory::new_delete_resource ());
+
+    cppual::memory::set_default_resource (res);
+
+    {
+        value_vector vec;
+
+        //! grows through every size class and then goes upstream
+        for (auto i = 0U; i < max_values; ++i)
+        {
+            vec.push_back (static_cast<value_type>(i));
+        }
+
+        std::cout << "vec size: " << vec.size ()
+                  << " elements\nslab_resource capacity: " << res.capacity ()
+                  << " bytes" << std::endl;
+    }
+
+    cppual::memory::set_default_resource (cppual::memory::new_delete_resource ());
+
+    res.release ();
+
+    std::cout << "slab_resource capacity after release: " << res.capacity ()
+              << " bytes" << std::endl;
+}
+
+void test7 ()
+{
+    typedef int                                value_type  ;
+    typedef cppual::circular_queue<value_type> value_vector;
+
+    constexpr const value_vector::size_type max_values = 2000U;
+
+    cppual::memory::stacked_resource res (cppual::memory::new_delete_resource (), 256U, true);
+
+    value_vector::allocator_type const ator (res);
+
+    std::cout << "growable stacked_resource capacity: " << res.capacity ()
+              << " bytes" << std::endl;
+
+    {
+        cppual::memory::stacked_resource::scoped_checkpoint checkpoint (res);
+
+        value_vector first  (max_values / 10U, ator);
+        value_vector second (max_values      , ator);
+
+        for (auto i = 0U; i < max_values; ++i)
+        {
+            if (i < max_values / 10U) first.push_back (static_cast<value_type>(i));
+            second.push_back (static_cast<value_type>(i));
+        }
+
+        std::cout << "vecs size: " << first.size () + second.size ()
+                  << " elements\ngrowable stacked_resource capacity: " << res.capacity ()
+                  << " bytes" << std::endl;
+    }
+
+    std::cout << "growable stacked_resource capacity after rewind: " << res.capacity ()
+              << " bytes" << std::endl;
+}
+
+void test8 ()
+{
+    typedef int                                value_type  ;
+    typedef cppual::circular_queue<value_type> value_vector;
+
+    constexpr const value_vector::size_type max_values = 20000U;
+
+    //! reserve 1 GiB of address space with guard pages around every allocation
+    cppual::memory::page_resource res (1U << 30, true);
+
+    value_vector::allocator_type const ator (res);
+
+    std::cout << "page_resource reserved: " << res.capacity ()
+              << " bytes\npage_resource committed: " << res.committed ()
+              << " bytes" << std::endl;
+
+    {
+        value_vector vec (ator);
+
+        for (auto i = 0U; i < max_values; ++i)
+        {
+            vec.push_back (static_cast<value_type>(i));
+        }
+
+        std::cout << "vec size: " << vec.size ()
+                  << " elements\npage_resource committed: " << res.committed ()
+                  << " bytes" << std::endl;
+    }
+
+    std::cout << "page_resource committed after release: " << res.committed ()
+              << " bytes" << std::endl;
+}
+
+void test9 ()
+{
+    typedef int                                value_type  ;
+    typedef cppual::circular_queue<value_type> value_vector;
+
+    constexpr const value_vector::size_type max_values   = 1000U;
+    constexpr const value_vector::size_type max_vectors  = 8U;
+    constexpr const std::size_t             arena_size   = 16U * 1024U;
+
+    //! three fixed arenas merged into one resource, the vectors spill over
+    //! to the next arena as soon as the current one is full
+    cppual::memory::memory_resource_adaptor res;
+
+    res.emplace<cppual::memory::heap_resource> (arena_size, cppual::memory::heap_strategy::tlsf);
+    res.emplace<cppual::memory::heap_resource> (arena_size);
+    res.emplace<cppual::memory::list_resource> (arena_size);
+
+    value_vector::allocator_type const ator (res);
+
+    std::cout << "adaptor arenas: " << res.arena_count ()
+              << "\nadaptor capacity: " << res.capacity () << " bytes" << std::endl;
+
+    {
+        cppual::circular_queue<value_vector> vecs;
+
+        for (auto n = 0U; n < max_vectors; ++n)
+        {
+            vecs.emplace_back (ator);
+            vecs.back ().reserve (max_values);
+
+            for (auto i = 0U; i < max_values; ++i)
+            {
+                vecs.back ().push_back (static_cast<value_type>(i));
+            }
+
+            auto const& arena = *res.find (&vecs.back ().front ());
+
+            for (auto i = 0U; i < res.arena_count (); ++i)
+            {
+                if (&res.arena (i) == &arena)
+                {
+                    std::cout << "vec " << n << " allocated in arena " << i << std::endl;
+                }
+            }
+        }
+    }
+
+    std::cout << "adaptor max_size after release: " << res.max_size ()
+              << " bytes" << std::endl;
+}
+
+void test10 ()
+{
+    typedef int                                value_type  ;
+    typedef cppual::circular_queue<value_type> value_vector;
+
+    constexpr const value_vector::size_type max_values  = 1000U;
+    constexpr const value_vector::size_type max_vectors = 100U;
+
+    //! sample roughly every 16 KiB allocated instead of the production default
+    cppual::memory::profiling_resource res (cppual::memory::get_default_resource (), 16U * 1024U);
+
+    value_vector::allocator_type const ator (res);
+
+    std::cout << "profiling_resource thread safe: " << res.is_thread_safe ()
+              << " (owner: " << res.owner ().is_thread_safe () << ")" << std::endl;
+
+    {
+        cppual::circular_queue<value_vector> vecs;
+
+        for (auto n = 0U; n < max_vectors; ++n)
+        {
+            vecs.emplace_back (ator);
+
+            for (auto i = 0U; i < max_values; ++i)
+            {
+                vecs.back ().push_back (static_cast<value_type>(i));
+            }
+        }
+
+        std::cout << "profiling_resource live samples: " << res.sample_count () << std::endl;
+
+        res.write_collapsed (std::cout, cppual::memory::profiling_resource::profile_type::live);
+    }
+
+    std::cout << "profiling_resource live samples after release: " << res.sample_count ()
+              << std::endl;
+
+    res.write_collapsed (std::cout, cppual::memory::profiling_resource::profile_type::allocated);
+}
+
+void test11 ()
+{
+    typedef int                                                               value_type  ;
+    typedef cppual::memory::shared_allocator<value_type>                      shared_ator ;
+    typedef cppual::circular_queue<value_type, shared_ator>                   value_vector;
+
+    constexpr const value_vector::size_type max_values = 1000U;
+    constexpr const std::size_t             heap_size  = 64U * 1024U;
+
+    //! the same bytes seen at two different addresses as if mapped by two processes
+    alignas (std::max_align_t) static cppual::byte segment[heap_size];
+    alignas (std::max_align_t) static cppual::byte mirror [heap_size];
+
+    auto& heap = cppual::memory::shared_heap::create_or_open (segment, heap_size);
+    auto& vec  = heap.find_or_construct<value_vector> ("values", shared_ator (heap));
+
+    for (auto i = 0U; i < max_values; ++i)
+    {
+        vec.push_back (static_cast<value_type>(i));
+    }
+
+    //! an empty circular list links its sentinel to itself, next is at the sentinel's address
+    struct list_node
+    {
+        cppual::memory::offset_ptr<list_node> next ;
+        int                                   value;
+    };
+
+    auto& sentinel = heap.find_or_construct<list_node> ("sentinel");
+
+    sentinel.next = &sentinel;
+
+    std::copy (segment, segment + heap_size, mirror);
+
+    auto& mirror_heap     = cppual::memory::shared_heap::create_or_open (mirror, heap_size);
+    auto& mirror_vec      = *mirror_heap.find<value_vector> ("values");
+    auto& mirror_sentinel = *mirror_heap.find<list_node> ("sentinel");
+
+    list_node nodes[2];
+
+    nodes[0].next = &nodes[1];
+    --nodes[0].next;
+
+    std::cout << "shared sentinel self linked: "
+              << (mirror_sentinel.next && mirror_sentinel.next.get () == &mirror_sentinel)
+              << "\noffset_ptr decremented to itself: "
+              << (nodes[0].next && nodes[0].next.get () == &nodes[0]) << std::endl;
+
+    std::cout << "shared vec size: " << mirror_vec.size ()
+              << " elements\nshared vec back: " << mirror_vec.back ()
+              << "\nshared heap free: " << mirror_heap.free_size () << " bytes" << std::endl;
+
+    heap.destroy<value_vector> ("values"  );
+    heap.destroy<list_node>    ("sentinel");
+
+    std::cout << "shared heap free after release: " << heap.free_size ()
+              << " bytes" << std::endl;
+}
+
+void test12 ()
+{
+    typedef long                                                                 value_type;
+    typedef cppual::circular_queue<value_type, std::allocator<value_type>, true> queue_type;
+
+    constexpr const unsigned   max_threads = 4U;
+    constexpr const value_type max_values  = 100000;
+
+    queue_type               queue (1000U);
+    std::atomic<value_type>  sum   { };
+    std::vector<std::thread> threads;
+
+    for (auto i = 0U; i < max_threads; ++i)
+    {
+        threads.emplace_back ([&queue]
+        {
+            for (auto n = value_type (1); n <= max_values; ++n) queue.push_back (n);
+        });
+
+        threads.emplace_back ([&queue, &sum]
+        {
+            value_type values[16];
+
+            for (auto n = value_type (); n < max_values; )
+            {
+                auto const count = std::min (value_type (16), max_values - n);
+
+                queue.pop_n (values, static_cast<queue_type::size_type> (count));
+
+                for (auto k = value_type (); k < count; ++k) sum += values[k];
+                n += count;
+            }
+        });
+    }
+
+    for (auto& thread : threads) thread.join ();
+
+    std::cout << "mpmc queue capacity: " << queue.capacity ()
+              << "\nmpmc queue sum: " << sum.load ()
+              << " (expected " << max_threads * max_values * (max_values + 1) / 2 << ")" << std::endl;
+}
+
+void test13 ()
+{
+    typedef int                                                            value_type;
+    typedef cppual::circular_queue<value_type, std::allocator<value_type>> queue_type;
+
+    std::vector<value_type> values (100U);
+    queue_type              queue  (128U);
+
+    for (auto i = 0U; i < values.size (); ++i) values[i] = static_cast<value_type> (i);
+
+    //! wrap the queue around the end of its storage
+    queue.append_range (values);
+    queue.erase_front  (90U);
+    queue.append_range (values);
+
+    auto const spans = queue.as_spans ();
+
+    std::vector<value_type> front (50U);
+
+    queue.pop_front (front.begin (), front.size ());
+
+    std::cout << "bulk queue segments: " << spans.first.size () << " + " << spans.second.size ()
+              << "\nbulk queue size after pop: " << queue.size ()
+              << "\nbulk queue front: " << queue.front () << " (expected 40)" << std::endl;
+}
+
+void test14 ()
+{
+    typedef cppual::flat_hash_map<cppual::string, int> registry_type;
+
+    constexpr const int         max_entries = 1000;
+    constexpr const std::size_t arena_size  = 256U * 1024U;
+
+    //! the slots & the keys of the registry live in a single arena
+    cppual::memory::list_resource res (arena_size);
+
+    registry_type registry { registry_type::allocator_type (res) };
+
+    for (auto i = 0; i < max_entries; ++i)
+    {
+        registry.try_emplace (cppual::string ("entry_" + std::to_string (i), registry.get_allocator ()), i);
+    }
+
+    std::cout << "flat map size: " << registry.size ()
+              << "\nflat map capacity: " << registry.capacity ()
+              << "\nflat map entry_500: " << registry.at (std::string_view ("entry_500"))
+              << "\narena max_size: " << res.max_size () << " bytes" << std::endl;
+
+    //! erasing & inserting at a steady size reclaims the tombstones in place
+    typedef cppual::flat_hash_map<int, int> window_type;
+
+    constexpr const int window_size = 100;
+    constexpr const int window_end  = window_size * 1000;
+
+    cppual::memory::list_resource window_res (arena_size);
+
+    window_type window { window_type::allocator_type (window_res) };
+
+    for (auto i = 0; i < window_size; ++i) window.try_emplace (i, i);
+
+    auto const window_capacity = window.capacity ();
+    auto const window_free     = window_res.max_size ();
+
+    for (auto i = window_size; i < window_end; ++i)
+    {
+        window.erase (i - window_size);
+        window.try_emplace (i, i);
+    }
+
+    auto window_found = window.size () == window_size && !window.contains (window_end - window_size - 1);
+
+    for (auto i = window_end - window_size; i < window_end; ++i)
+        window_found = window_found && window.at (i) == i;
+
+    std::cout << "flat map window entries found: " << window_found
+              << "\nflat map window rehashed in place: "
+              << (window.capacity () == window_capacity && window_res.max_size () == window_free)
+              << std::endl;
+}
+
+void test15 ()
+{
+    typedef cppual::concurrent_hash_map<cppual::string, std::size_t> topic_map;
+
+    constexpr const std::size_t thread_count  = 4;
+    constexpr const std::size_t topic_count   = 64;
+    constexpr const std::size_t message_count = 10000;
+
+    topic_map                topics;
+    std::vector<std::thread> threads;
+
+    for (auto t = 0U; t < thread_count; ++t)
+    {
+        threads.emplace_back ([&topics]
+        {
+            for (auto i = 0U; i < message_count; ++i)
+            {
+                auto const topic = "topic_" + std::to_string (i % topic_count);
+
+                topics.emplace_or_visit (std::string_view (topic),
+                                         [] (auto& val) { ++val.second; },
+                                         std::size_t (1));
+            }
+        });
+    }
+
+    for (auto& th : threads) th.join ();
+
+    std::size_t total = 0;
+
+    topics.for_each ([&total] (auto const& val) { total += val.second; });
+
+    std::cout << "concurrent map topics: " << topics.size ()
+              << "\nconcurrent map messages: " << total << " of " << thread_count * message_count
+              << "\nconcurrent map topic_7: " << topics.find (std::string_view ("topic_7")).value_or (0)
+              << std::endl;
+}
+
+void test16 ()
+{
+    typedef cppual::small_vector<int, 4> vector_type;
+
+    cppual::memory::list_resource res (4096U);
+
+    vector_type values { vector_type::allocator_type (res) };
+
+    for (auto i = 0; i < 4; ++i) values.push_back (i);
+
+    std::cout << "small vector inline: " << values.is_inline ()
+              << "\nsmall vector arena free: " << res.max_size () << " bytes" << std::endl;
+
+    for (auto i = 4; i < 16; ++i) values.push_back (i);
+
+    std::cout << "small vector inline: " << values.is_inline ()
+              << "\nsmall vector size: " << values.size () << " capacity: " << values.capacity ()
+              << "\nsmall vector arena free: " << res.max_size () << " bytes" << std::endl;
+
+    values.resize (3);
+    values.shrink_to_fit ();
+
+    std::cout << "small vector inline after shrink: " << values.is_inline () << std::endl;
+}
+
+void test17 ()
+{
+    cppual::memory::list_resource res (4096U);
+
+    cppual::fstring const payload ("a payload too long for the small string buffer",
+                                   cppual::fstring::allocator_type (res));
+
+    std::vector<cppual::fstring> slots (8U, payload);
+
+    std::cout << "cow string shared by: " << payload.use_count ()
+              << "\ncow string arena free: " << res.max_size () << " bytes" << std::endl;
+
+    slots.front () += " & then some";
+
+    std::cout << "cow string shared after a mutation: " << payload.use_count ()
+              << "\ncow string mutated copy: " << slots.front ().c_str () << std::endl;
+}
+
+void test18 ()
+{
+    cppual::memory::list_resource res (4096U);
+    cppual::intern_pool           pool (res);
+
+    cppual::interned_string const key   ("libcppual-ui-xorg", pool);
+    cppual::interned_string const same  (cppual::fstring ("libcppual-ui-xorg"), pool);
+    cppual::interned_string const other ("libcppual-gfx-gl", pool);
+
+    std::cout << "interned atoms: " << key.atom () << ' ' << same.atom () << ' ' << other.atom ()
+              << "\ninterned same entry: " << (key == same) << ' ' << (key.c_str () == same.c_str ())
+              << "\ninterned pool size: " << pool.size ()
+              << "\ninterned lookup by atom: " << pool.at (other.atom ()).c_str () << std::endl;
+}
+
+void test19 ()
+{
+    constexpr const std::size_t first_size = 32U;
+    constexpr const std::size_t last_size  = 8U ;
+
+    cppual::memory::stacked_resource  res  (cppual::memory::new_delete_resource (), 256U);
+    cppual::memory::dstacked_resource dres (cppual::memory::new_delete_resource (), 256U, 1024U);
+
+    for (cppual::memory::memory_resource* rc : { static_cast<cppual::memory::memory_resource*> (&res),
+                                                 static_cast<cppual::memory::memory_resource*> (&dres) })
+    {
+        auto const first = rc->allocate (first_size);
+        auto const last  = rc->allocate (last_size );
+
+        //! small byte values in the payload of the top block must not be mistaken for padding
+        std::memset (first, 1, first_size);
+        std::memset (last , static_cast<int> (last_size), last_size);
+
+        try
+        {
+            rc->deallocate (first, first_size);
+            std::cout << "non LIFO deallocation accepted!" << std::endl;
+        }
+        catch (std::out_of_range const&)
+        {
+            std::cout << "non LIFO deallocation rejected" << std::endl;
+        }
+
+        rc->deallocate (last , last_size );
+        rc->deallocate (first, first_size);
+    }
+
+    std::cout << "stacked_resource free after LIFO release: " << res.max_size ()
+              << " bytes\ndstacked_resource free after LIFO release: " << dres.max_size ()
+              << " bytes" << std::endl;
+}
+
+void test20 ()
+{
+    typedef cppual::u32                                key_type  ;
+    typedef std::pair<key_type, key_type>              value_type;
+    typedef cppual::dyn_index_map<key_type, key_type, std::allocator<value_type>,
+                                  cppual::index_layout::eytzinger> map_type;
+
+    constexpr const key_type max_keys = 1000U;
+
+    std::vector<value_type> pairs;
+    std::vector<key_type>   queries;
+
+    for (auto i = 0U; i < max_keys; ++i) pairs.emplace_back (i * 3U, i);
+    for (auto i = 0U; i < max_keys * 3U + 2U; ++i) queries.push_back (i);
+
+    map_type map (0U);
+
+    map.build (pairs);
+
+    //! every lookup path against std::lower_bound over the current keys
+    auto const mismatches = [&map, &queries]
+    {
+        std::vector<key_type> keys;
+
+        for (auto it = map.cbegin (); it != map.cend (); ++it) keys.push_back (it->first);
+
+        std::vector<map_type::const_iterator> found (queries.size ());
+
+        map.find_many (std::span<key_type const> (queries), found.begin ());
+
+        auto count = 0U;
+
+        for (auto i = 0U; i < queries.size (); ++i)
+        {
+            auto const pos  = std::lower_bound (keys.begin (), keys.end (), queries[i]) - keys.begin ();
+            auto const it   = std::as_const (map).lower_bound (queries[i]);
+            auto const hit  = pos != static_cast<std::ptrdiff_t> (keys.size ()) && keys[pos] == queries[i];
+
+            if (it - map.cbegin () != pos) ++count;
+            if (found[i] != (hit ? map.cbegin () + pos : map.cend ())) ++count;
+        }
+
+        return count;
+    };
+
+    cppual::eytzinger_index<key_type, std::allocator<key_type>> index;
+    std::vector<key_type>                                       keys;
+
+    for (auto const& pair : pairs) keys.push_back (pair.first);
+
+    index.build (keys.cbegin (), keys.size ());
+
+    auto index_mismatches = 0U;
+
+    for (auto key : queries)
+    {
+        auto const pos = static_cast<std::size_t> (std::lower_bound (keys.begin (), keys.end (), key) - keys.begin ());
+
+        if (index.lower_bound (key) != pos) ++index_mismatches;
+    }
+
+    std::cout << "eytzinger_index mismatches: " << index_mismatches
+              << "\neytzinger map mismatches: " << mismatches () << std::endl;
+
+    //! the usual lookup idiom on a mutable map keeps the search layout
+    auto const found = map.lower_bound (key_type (300U)) != map.end ();
+
+    std::cout << "eytzinger map found: " << found << " indexed after end (): " << map.is_indexed ()
+              << std::endl;
+
+    //! the same size but different keys -> the lookups mustn't use the stale layout
+    for (auto& pair : map) pair.first *= 2U;
+
+    std::cout << "eytzinger map mismatches after a mutation: " << mismatches () << std::endl;
+
+    map.rebuild_index ();
+
+    std::cout << "eytzinger map mismatches after a rebuild: " << mismatches () << std::endl;
+}
+
+struct signal_bits
+{
+    int mask { };
+
+    template <int N>
+    void set (int&) { mask |= 1 << N; }
+};
+
+void test21 ()
+{
+    typedef cppual::signal<void(int&)> signal_type;
+    typedef signal_type::slot_type     slot_type  ;
+
+    signal_type sig ;
+    signal_bits bits;
+
+    //! one more than the inline slots; the last one goes on top and moves every other
+    slot_type const slots[] =
+    {
+        cppual::connect (sig, bits, &signal_bits::set<0>),
+        cppual::connect (sig, bits, &signal_bits::set<1>),
+        cppual::connect (sig, bits, &signal_bits::set<2>),
+        cppual::connect (sig, bits, &signal_bits::set<3>),
+        cppual::connect (sig, bits, &signal_bits::set<4>),
+        cppual::connect (sig, bits, &signal_bits::set<5>, true)
+    };
+
+    auto early = slots[1];
+
+    cppual::disconnect (sig, early);
+
+    auto arg = 0;
+
+    sig (arg);
+
+    std::cout << "signal slots: " << sig.size () << " mask: " << bits.mask
+              << "\nsignal handle of a connected slot: "
+              << (cppual::connect (sig, bits, &signal_bits::set<0>) == slots[0])
+              << "\nsignal disconnected handle found: " << (sig.find (slots[1]) != sig.cend ())
+              << std::endl;
+}
+
+void test22 ()
+{
+    constexpr const std::size_t block_size    = 64U  ;
+    constexpr const std::size_t block_count   = 100U ;
+    constexpr const std::size_t oversize      = 4096U;
+
+    cppual::memory::heap_resource owner (cppual::memory::new_delete_resource (), 256U * 1024U,
+                                         cppual::memory::heap_strategy::tlsf);
+
+    auto const owner_size = owner.max_size ();
+
+    cppual::memory::thread_caching_resource res (owner);
+
+    //! the blocks cached by a thread go back to the owner when the thread exits
+    auto held_by_thread = false;
+
+    std::thread ([&res, &owner, &held_by_thread, owner_size]
+    {
+        std::vector<void*> blocks;
+
+        for (auto i = 0U; i < block_count; ++i) blocks.push_back (res.allocate (block_size));
+        for (auto p : blocks) res.deallocate (p, block_size);
+
+        held_by_thread = owner.max_size () < owner_size;
+    }).join ();
+
+    std::cout << "thread cache held blocks: " << held_by_thread
+              << "\nthread cache flushed on thread exit: " << (owner.max_size () == owner_size)
+              << std::endl;
+
+    //! blocks of an exited thread freed by another one land in the cache of that thread
+    std::vector<void*> foreign;
+
+    std::thread ([&res, &foreign]
+    {
+        for (auto i = 0U; i < block_count; ++i) foreign.push_back (res.allocate (block_size));
+    }).join ();
+
+    for (auto p : foreign) res.deallocate (p, block_size);
+
+    std::cout << "thread cache cross thread free cached: " << (owner.max_size () < owner_size);
+
+    res.flush ();
+
+    std::cout << "\nthread cache cross thread free flushed: " << (owner.max_size () == owner_size)
+              << std::endl;
+
+    //! larger blocks than the size classes bypass the magazines
+    auto const large = res.allocate (oversize);
+
+    std::cout << "thread cache oversized from owner: " << (owner.max_size () + oversize <= owner_size);
+
+    res.deallocate (large, oversize);
+
+    std::cout << "\nthread cache oversized returned: " << (owner.max_size () == owner_size)
+              << std::endl;
+}
+
+void test23 ()
+{
+    namespace model = cppual::memory::model;
+
+    constexpr const std::size_t huge_size  = 4U * 1024U * 1024U;
+    constexpr const std::size_t small_size = 256U;
+    constexpr const std::size_t block_count = 1024U;
+
+    auto const was_enabled = model::huge_pages ();
+
+    //! without reserved huge pages the segments fall back to transparent ones (MADV_HUGEPAGE)
+    model::set_huge_pages (true);
+
+    model::global_statistics before;
+    model::get_global_statistics (&before);
+
+    auto const huge = static_cast<char*> (model::allocate (huge_size));
+    std::vector<void*> blocks;
+
+    for (auto i = 0U; i < block_count; ++i) blocks.push_back (model::allocate (small_size));
+
+    auto const all_allocated = huge != nullptr &&
+                               std::none_of (blocks.cbegin (), blocks.cend (),
+                                             [] (void* p) { return p == nullptr; });
+
+    if (huge != nullptr)
+    {
+        huge[0]             = 1;
+        huge[huge_size - 1] = 1;
+    }
+
+    model::global_statistics after;
+    model::get_global_statistics (&after);
+
+    auto const explicit_pages = after.huge_explicit > before.huge_explicit;
+    auto const huge_backed    = after.huge_mapped   > before.huge_mapped  ;
+
+    std::cout << "huge pages enabled: "           << model::huge_pages ()
+              << "\nhuge pages allocated: "        << all_allocated
+              << "\nhuge pages backed: "           << huge_backed
+              << "\nhuge pages backing: "
+              << (explicit_pages ? "explicit" : "transparent") << std::endl;
+
+    for (auto p : blocks) model::deallocate (p);
+    model::deallocate (huge);
+
+    model::set_huge_pages (was_enabled);
+}
+
+void test24 ()
+{
+    namespace model = cppual::memory::model;
+
+    constexpr const std::size_t block_size   = 512U;
+    constexpr const std::size_t block_count  = 64U ;
+    constexpr const std::size_t thread_count = 256U;
+
+    //! bind a thread to each node, the last node + 1 doesn't exist
+    auto const nodes    = model::numa_node_count ();
+    auto       bound    = 0U;
+    auto const rejected = !model::bind_thread_numa_node (nodes);
+
+    for (auto node = 0U; node < nodes; ++node)
+    {
+        std::thread ([node, &bound]
+        {
+            if (!model::bind_thread_numa_node (node) || model::thread_numa_node () != node) return;
+
+            auto const p = model::allocate (block_size);
+
+            if (p != nullptr) ++bound;
+            model::deallocate (p);
+        }).join ();
+    }
+
+    std::cout << "numa nodes: "                   << nodes
+              << "\nnuma nodes bound: "            << (bound == nodes)
+              << "\nnuma missing node rejected: "  << rejected << std::endl;
+
+    //! a thread heap goes back to the free slots on thread exit with its cached blocks
+    std::thread ([]
+    {
+        std::vector<void*> blocks;
+
+        for (auto i = 0U; i < block_count; ++i) blocks.push_back (model::allocate (block_size));
+        for (auto p : blocks) model::deallocate (p);
+    }).join ();
+
+    model::thread_statistics reused { };
+
+    std::thread ([&reused]
+    {
+        model::thread_numa_node ();
+        model::get_thread_statistics (&reused);
+    }).join ();
+
+    std::cout << "thread heap reused with its cache: "
+              << (reused.active + reused.sizecache + reused.spancache > 0) << std::endl;
+
+    //! far more threads than heap slots of a node
+    std::atomic_size_t served { };
+
+    for (auto i = 0U; i < thread_count; ++i)
+    {
+        std::thread ([&served]
+        {
+            try
+            {
+                auto const p = model::allocate (block_size);
+
+                if (p != nullptr) ++served;
+                model::deallocate (p);
+            }
+            catch (std::runtime_error&)
+            { }
+        }).join ();
+    }
+
+    std::cout << "thread heaps served after thread exits: " << (served == thread_count) << std::endl;
+}
+
+void test25 ()
+{
+    namespace model = cppual::memory::model;
+
+    constexpr const std::size_t sizes[]     = { 64U, 1024U, 8U * 1024U * 1024U };
+    constexpr const std::size_t block_count = 32U;
+
+    //! the histogram class of a size is the smallest one fitting it (the last one of merged classes),
+    //! oversized blocks go to the last one
+    auto const class_of = [] (model::statistics_snapshot const& snapshot, std::size_t size)
+    {
+        auto fit = model::statistics_class_count - 1;
+
+        for (auto i = 0U; i < model::statistics_class_count - 1; ++i)
+        {
+            if (snapshot.classes[i].size >= size &&
+                (fit == model::statistics_class_count - 1 ||
+                 snapshot.classes[i].size <= snapshot.classes[fit].size))
+                fit = i;
+        }
+
+        return fit;
+    };
+
+    auto before    = std::make_unique<model::statistics_snapshot> ();
+    auto allocated = std::make_unique<model::statistics_snapshot> ();
+    auto freed     = std::make_unique<model::statistics_snapshot> ();
+
+    //! the global operator new is served by the model too, so nothing else allocates in between
+    std::vector<void*> blocks;
+
+    blocks.reserve (std::size (sizes) * block_count);
+    model::get_statistics_snapshot (before.get ());
+
+    for (auto size : sizes)
+        for (auto i = 0U; i < block_count; ++i) blocks.push_back (model::allocate (size));
+
+    model::get_statistics_snapshot (allocated.get ());
+
+    for (auto p : blocks) model::deallocate (p);
+
+    model::get_statistics_snapshot (freed.get ());
+
+    auto counts_match = true;
+    auto small_bytes  = std::size_t ();
+
+    for (auto size : sizes)
+    {
+        auto const i = class_of (*before, size);
+
+        counts_match = counts_match &&
+                       allocated->classes[i].allocations   - before->classes[i].allocations   == block_count &&
+                       allocated->classes[i].deallocations - before->classes[i].deallocations == 0U &&
+                       freed->classes[i].deallocations     - before->classes[i].deallocations == block_count;
+
+        if (before->classes[i].size) small_bytes += before->classes[i].size * block_count;
+    }
+
+    //! oversized blocks count their pages, the span header included
+    auto const allocated_delta = allocated->global.allocated - before->global.allocated;
+    auto const oversized_bytes = allocated_delta - small_bytes;
+
+    std::cout << "statistics class counts match: "         << counts_match
+              << "\nstatistics allocated bytes match: "     << (oversized_bytes >= sizes[2] * block_count &&
+                                                                 oversized_bytes <  (sizes[2] + 4096U) * block_count)
+              << "\nstatistics allocated bytes released: "  << (freed->global.allocated == before->global.allocated)
+              << std::endl;
+}
+
+void test26 ()
+{
+    namespace model = cppual::memory::model;
+
+    constexpr const std::size_t large_size  = 16U * 1024U;
+    constexpr const std::size_t small_size  = 4U  * 1024U;
+    constexpr const std::size_t block_count = 256U;
+
+    //! churn the caches so the scavenger is busy trimming when it's stopped
+    auto const churn = []
+    {
+        std::vector<void*> blocks;
+
+        blocks.reserve (block_count * 2);
+
+        for (auto i = 0U; i < block_count; ++i)
+        {
+            blocks.push_back (model::allocate (large_size));
+            blocks.push_back (model::allocate (small_size));
+        }
+
+        for (auto p : blocks) model::deallocate (p);
+    };
+
+    auto const started   = model::start_scavenger (0, 1);
+    auto const restarted = model::start_scavenger (0, 1);
+
+    std::atomic_bool busy { true };
+
+    std::thread worker ([&busy, &churn]
+    {
+        while (busy) churn ();
+    });
+
+    std::this_thread::sleep_for (std::chrono::milliseconds (20));
+    model::stop_scavenger ();
+
+    auto const started_after_stop = model::start_scavenger (0, 1);
+
+    model::stop_scavenger ();
+    busy = false;
+    worker.join ();
+
+    std::cout << "scavenger started: "                    << started
+              << "\nscavenger second start rejected: "     << !restarted
+              << "\nscavenger started after busy stop: "   << started_after_stop << std::endl;
+
+    //! the thread cache hands its older half to the global caches on the first collect of an epoch
+    churn ();
+    model::trim (0);
+    model::thread_collect ();
+
+    model::global_statistics cached;
+    model::global_statistics trimmed;
+
+    model::get_global_statistics (&cached);
+
+    auto const released = model::trim (0);
+
+    model::get_global_statistics (&trimmed);
+
+    auto const cached_bytes  = cached.cached  + cached.cached_large  + cached.cached_huge ;
+    auto const trimmed_bytes = trimmed.cached + trimmed.cached_large + trimmed.cached_huge;
+
+    std::cout << "scavenger trim released cached spans: " << (released > 0)
+              << "\nscavenger trim released bytes match: " << (cached_bytes - trimmed_bytes == released)
+              << std::endl;
+}
+
+void test27 ()
+{
+    typedef cppual::cow_string<char, cppual::locale_traits<char>, cppual::memory::allocator<char>> string_type;
+
+    cppual::memory::heap_resource lhs_res (cppual::memory::new_delete_resource (), 64U * 1024U);
+    cppual::memory::heap_resource rhs_res (cppual::memory::new_delete_resource (), 64U * 1024U);
+
+    auto const lhs_size = lhs_res.max_size ();
+    auto const rhs_size = rhs_res.max_size ();
+
+    //! the allocators are swapped with the blocks, each block goes back to its own heap
+    {
+        string_type lhs ("a string long enough to be allocated on the left heap",
+                         cppual::memory::allocator<char> (lhs_res));
+        string_type rhs ("a string long enough to be allocated on the right heap",
+                         cppual::memory::allocator<char> (rhs_res));
+
+        swap (lhs, rhs);
+
+        std::cout << "cow_string swapped allocators: "
+                  << (&lhs.get_allocator ().resource () == &rhs_res &&
+                      &rhs.get_allocator ().resource () == &lhs_res) << std::endl;
+    }
+
+    std::cout << "cow_string swapped blocks released: "
+              << (lhs_res.max_size () == lhs_size && rhs_res.max_size () == rhs_size) << std::endl;
+}
+
 int main (int /*argc*/, char** /*argv*/)
 {
     std::cout << "\n============ Test 1 ============\n" << std::endl;
@@ -183,5 +1224,97 @@ int main (int /*argc*/, char** /*argv*/)
 
     test4 ();
 
+    std::cout << "\n============ Test 5 ============\n" << std::endl;
+
+    test5 ();
+
+    std::cout << "\n============ Test 6 ============\n" << std::endl;
+
+    test6 ();
+
+    std::cout << "\n============ Test 7 ============\n" << std::endl;
+
+    test7 ();
+
+    std::cout << "\n============ Test 8 ============\n" << std::endl;
+
+    test8 ();
+
+    std::cout << "\n============ Test 9 ============\n" << std::endl;
+
+    test9 ();
+
+    std::cout << "\n============ Test 10 ============\n" << std::endl;
+
+    test10 ();
+
+    std::cout << "\n============ Test 11 ============\n" << std::endl;
+
+    test11 ();
+
+    std::cout << "\n============ Test 12 ============\n" << std::endl;
+
+    test12 ();
+
+    std::cout << "\n============ Test 13 ============\n" << std::endl;
+
+    test13 ();
+
+    std::cout << "\n============ Test 14 ============\n" << std::endl;
+
+    test14 ();
+
+    std::cout << "\n============ Test 15 ============\n" << std::endl;
+
+    test15 ();
+
+    std::cout << "\n============ Test 16 ============\n" << std::endl;
+
+    test16 ();
+
+    std::cout << "\n============ Test 17 ============\n" << std::endl;
+
+    test17 ();
+
+    std::cout << "\n============ Test 18 ============\n" << std::endl;
+
+    test18 ();
+
+    std::cout << "\n============ Test 19 ============\n" << std::endl;
+
+    test19 ();
+
+    std::cout << "\n============ Test 20 ============\n" << std::endl;
+
+    test20 ();
+
+    std::cout << "\n============ Test 21 ============\n" << std::endl;
+
+    test21 ();
+
+    std::cout << "\n============ Test 22 ============\n" << std::endl;
+
+    test22 ();
+
+    std::cout << "\n============ Test 23 ============\n" << std::endl;
+
+    test23 ();
+
+    std::cout << "\n============ Test 24 ============\n" << std::endl;
+
+    test24 ();
+
+    std::cout << "\n============ Test 25 ============\n" << std::endl;
+
+    test25 ();
+
+    std::cout << "\n============ Test 26 ============\n" << std::endl;
+
+    test26 ();
+
+    std::cout << "\n============ Test 27 ============\n" << std::endl;
+
+    test27 ();
+
     return 0;
 }
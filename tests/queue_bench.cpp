@@ -0,0 +1,250 @@
+#include <cppual/circular_queue>
+
+#include <functional>
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <deque>
+
+typedef std::chrono::steady_clock clock_type;
+typedef std::uint64_t             value_type;
+
+constexpr const std::size_t ring_size  = 1024U;
+constexpr const std::size_t batch_size = 64U;
+
+typedef cppual::uniform_queue <value_type, ring_size>                        spsc_queue;
+typedef cppual::circular_queue<value_type, std::allocator<value_type>, true> mpmc_queue;
+
+//! one line of the report
+struct result
+{
+    std::string queue   ;
+    std::string mode    ;
+    std::size_t items   ;
+    double      seconds ;
+    double      mops    ;
+    bool        verified;
+};
+
+//! the producer pushes 1..items, the consumer checks the order & the sum.
+//! both sides yield when the queue is full/empty so that the numbers
+//! stay meaningful on machines with fewer cores than threads
+template <typename Push, typename Pop>
+result run (std::string const& queue, std::string const& mode, std::size_t items, Push&& push, Pop&& pop)
+{
+    value_type sum     = 0;
+    value_type last    = 0;
+    bool       ordered = true;
+
+    auto const start = clock_type::now ();
+
+    std::thread producer ([&]
+    {
+        for (value_type n = 1; n <= items; )
+        {
+            auto const count = push (n, items - n + 1);
+
+            if (count) n += count;
+            else std::this_thread::yield ();
+        }
+    });
+
+    for (std::size_t n = 0; n < items; )
+    {
+        auto const count = pop ([&] (value_type value)
+        {
+            ordered = ordered && value == last + 1;
+            last    = value;
+            sum    += value;
+        });
+
+        if (count) n += count;
+        else std::this_thread::yield ();
+    }
+
+    producer.join ();
+
+    auto const elapsed = std::chrono::duration<double> (clock_type::now () - start);
+
+    return { queue, mode, items, elapsed.count (), static_cast<double> (items) / elapsed.count () / 1e6,
+             ordered && sum == static_cast<value_type> (items) * (items + 1) / 2 };
+}
+
+result run_spsc_single (std::size_t items)
+{
+    auto const queue = std::make_unique<spsc_queue> ();
+
+    return run ("uniform_queue", "single", items,
+                [&queue] (value_type n, std::size_t) -> std::size_t
+                { return queue->try_push_back (n); },
+                [&queue] (auto&& fn) -> std::size_t
+                {
+                    value_type value;
+
+                    if (!queue->pop_front (value)) return 0;
+
+                    fn (value);
+                    return 1;
+                });
+}
+
+//! whole batches without per-element atomics
+result run_spsc_batch (std::size_t items)
+{
+    auto const queue = std::make_unique<spsc_queue> ();
+
+    return run ("uniform_queue", "batch", items,
+                [&queue] (value_type n, std::size_t remaining) -> std::size_t
+                {
+                    auto const span = queue->reserve_write (std::min (batch_size, remaining));
+
+                    for (auto i = 0U; i < span.size (); ++i) span[i] = n + i;
+
+                    queue->commit_write (span.size ());
+                    return span.size ();
+                },
+                [&queue] (auto&& fn) -> std::size_t
+                {
+                    auto const span = queue->read_span ();
+
+                    for (auto value : span) fn (value);
+
+                    queue->release (span.size ());
+                    return span.size ();
+                });
+}
+
+result run_mpmc_single (std::size_t items)
+{
+    mpmc_queue queue (ring_size);
+
+    return run ("circular_queue_mpmc", "single", items,
+                [&queue] (value_type n, std::size_t) -> std::size_t
+                { return queue.try_push_back (n); },
+                [&queue] (auto&& fn) -> std::size_t
+                {
+                    value_type value;
+
+                    if (!queue.try_pop_front (value)) return 0;
+
+                    fn (value);
+                    return 1;
+                });
+}
+
+result run_mpmc_batch (std::size_t items)
+{
+    mpmc_queue queue (ring_size);
+
+    return run ("circular_queue_mpmc", "batch", items,
+                [&queue] (value_type n, std::size_t remaining) -> std::size_t
+                {
+                    value_type values[batch_size];
+                    auto const count = std::min (batch_size, remaining);
+
+                    for (auto i = 0U; i < count; ++i) values[i] = n + i;
+
+                    return queue.try_push_n (values, count);
+                },
+                [&queue] (auto&& fn) -> std::size_t
+                {
+                    value_type values[batch_size];
+                    auto const count = queue.try_pop_n (values, batch_size);
+
+                    for (auto i = 0U; i < count; ++i) fn (values[i]);
+                    return count;
+                });
+}
+
+//! reference point
+result run_mutex_deque (std::size_t items)
+{
+    std::mutex             mutex;
+    std::deque<value_type> queue;
+
+    return run ("mutex_deque", "single", items,
+                [&] (value_type n, std::size_t) -> std::size_t
+                {
+                    std::lock_guard<std::mutex> lock (mutex);
+
+                    if (queue.size () == ring_size) return 0;
+
+                    queue.push_back (n);
+                    return 1;
+                },
+                [&] (auto&& fn) -> std::size_t
+                {
+                    value_type value;
+
+                    {
+                        std::lock_guard<std::mutex> lock (mutex);
+
+                        if (queue.empty ()) return 0;
+
+                        value = queue.front ();
+                        queue.pop_front ();
+                    }
+
+                    fn (value);
+                    return 1;
+                });
+}
+
+//! usage: cppual-queue-bench [--json] [--items=N]
+//! the exit code is 1 when any queue lost, duplicated or reordered an item
+int main (int argc, char** argv)
+{
+    auto        json  = false;
+    std::size_t items = 1U << 24;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        std::string const arg (argv[i]);
+
+        if      (arg == "--json"              ) json  = true;
+        else if (arg.rfind ("--items=", 0) == 0) items = std::stoul (arg.substr (8));
+        else
+        {
+            std::cerr << "unknown argument: " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<std::function<result(std::size_t)>> const runs
+    { run_spsc_single, run_spsc_batch, run_mpmc_single, run_mpmc_batch, run_mutex_deque };
+
+    std::vector<result> results;
+
+    for (auto const& fn : runs) results.push_back (fn (items));
+
+    if (json) std::cout << "[\n";
+    else      std::cout << "queue,mode,items,seconds,mops,verified\n";
+
+    for (auto i = 0U; i < results.size (); ++i)
+    {
+        auto const& res = results[i];
+
+        if (json)
+        {
+            std::cout << "  { \"queue\": \"" << res.queue << "\", \"mode\": \"" << res.mode
+                      << "\", \"items\": " << res.items << ", \"seconds\": " << res.seconds
+                      << ", \"mops\": " << res.mops << ", \"verified\": " << (res.verified ? "true" : "false")
+                      << " }" << (i + 1 < results.size () ? ",\n" : "\n");
+        }
+        else
+        {
+            std::cout << res.queue << ',' << res.mode << ',' << res.items << ',' << res.seconds << ','
+                      << res.mops << ',' << res.verified << '\n';
+        }
+    }
+
+    if (json) std::cout << "]\n";
+
+    for (auto const& res : results) if (!res.verified) return 1;
+    return 0;
+}
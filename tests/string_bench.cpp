@@ -0,0 +1,180 @@
+#include <cppual/string>
+#include <cppual/string_search>
+
+#include <functional>
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <random>
+#include <chrono>
+#include <vector>
+
+namespace simd = cppual::simd;
+
+typedef std::chrono::steady_clock clock_type;
+typedef cppual::fstring_view      view_type ;
+
+//! short strings are dominated by the call overhead, long ones by the loop
+constexpr const std::size_t haystack_sizes[] = { 64U, 1U << 16 };
+
+//! one line of the report
+struct result
+{
+    std::string op      ;
+    std::string isa     ;
+    std::size_t bytes   ;
+    std::size_t rounds  ;
+    double      seconds ;
+    double      gbps    ;
+    bool        verified;
+};
+
+//! a haystack of lowercase text without the needles, which are planted at the end
+struct corpus
+{
+    std::string haystack;
+    std::string other   ;
+
+    explicit corpus (std::size_t size)
+    : haystack (size, ' ')
+    {
+        std::mt19937 gen (42U);
+
+        for (auto& ch : haystack) ch = static_cast<char> ('a' + gen () % 20U);
+
+        haystack.replace (size - 8, 7, "needle!");
+        other = haystack;
+        other.back () = '#';
+    }
+};
+
+char const* isa_name (simd::isa eIsa)
+{
+    switch (eIsa)
+    {
+    case simd::isa::avx2: return "avx2"  ;
+    case simd::isa::sse2: return "sse2"  ;
+    default             : return "scalar";
+    }
+}
+
+//! every op returns a value that has to match std::string, the sum keeps it from being optimized out
+template <typename Fn>
+result run (std::string const& op, std::string const& isa, std::size_t bytes, std::size_t rounds,
+            std::size_t expected, Fn&& fn)
+{
+    std::size_t sum   = 0;
+    auto const  start = clock_type::now ();
+
+    for (auto n = 0U; n < rounds; ++n) sum += fn ();
+
+    auto const elapsed = std::chrono::duration<double> (clock_type::now () - start);
+
+    return { op, isa, bytes, rounds, elapsed.count (),
+             static_cast<double> (bytes * rounds) / elapsed.count () / 1e9,
+             sum == expected * rounds };
+}
+
+void run_all (std::vector<result>& results, corpus const& text, std::size_t rounds, std::string const& isa, bool std_ref)
+{
+    auto const bytes = text.haystack.size ();
+
+    view_type const hay   (text.haystack.data (), text.haystack.size ());
+    view_type const other (text.other.data   (), text.other.size   ());
+
+    std::string_view const std_hay (text.haystack);
+
+    std::vector<std::pair<std::string, std::function<std::size_t()>>> ops;
+
+    if (std_ref)
+    {
+        ops.emplace_back ("find_char"    , [&] { return std_hay.find ('!'); });
+        ops.emplace_back ("find_string"  , [&] { return std_hay.find ("needle"); });
+        ops.emplace_back ("find_first_of", [&] { return std_hay.find_first_of ("xyz!"); });
+        ops.emplace_back ("compare"      , [&] { return static_cast<std::size_t> (text.haystack.compare (text.other) < 0); });
+    }
+    else
+    {
+        ops.emplace_back ("find_char"    , [&] { return hay.find ('!'); });
+        ops.emplace_back ("find_string"  , [&] { return hay.find ("needle"); });
+        ops.emplace_back ("find_first_of", [&] { return hay.find_first_of ("xyz!"); });
+        ops.emplace_back ("compare"      , [&] { return static_cast<std::size_t> (hay.compare (other) < 0); });
+    }
+
+    std::size_t const expected[] =
+    {
+        std_hay.find ('!'),
+        std_hay.find ("needle"),
+        std_hay.find_first_of ("xyz!"),
+        static_cast<std::size_t> (text.haystack.compare (text.other) < 0)
+    };
+
+    for (auto i = 0U; i < ops.size (); ++i)
+        results.push_back (run (ops[i].first, isa, bytes, rounds, expected[i], ops[i].second));
+}
+
+//! usage: cppual-string-bench [--json] [--rounds=N]
+//! the exit code is 1 when any kernel returned something else than std::string
+int main (int argc, char** argv)
+{
+    auto        json   = false;
+    std::size_t rounds = 1U << 14;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        std::string const arg (argv[i]);
+
+        if      (arg == "--json"                ) json   = true;
+        else if (arg.rfind ("--rounds=", 0) == 0) rounds = std::stoul (arg.substr (9));
+        else
+        {
+            std::cerr << "unknown argument: " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<result> results;
+
+    for (auto size : haystack_sizes)
+    {
+        //! the same amount of bytes for every size
+        corpus const text         (size);
+        auto const   size_rounds = rounds * (haystack_sizes[1] / size);
+
+        for (auto eIsa = simd::isa::scalar; eIsa <= simd::supported_isa ();
+             eIsa = static_cast<simd::isa> (static_cast<int> (eIsa) + 1))
+        {
+            simd::select_isa (eIsa);
+            run_all (results, text, size_rounds, isa_name (eIsa), false);
+        }
+
+        run_all (results, text, size_rounds, "std_string", true);
+    }
+
+    if (json) std::cout << "[\n";
+    else      std::cout << "op,isa,bytes,rounds,seconds,gbps,verified\n";
+
+    for (auto i = 0U; i < results.size (); ++i)
+    {
+        auto const& res = results[i];
+
+        if (json)
+        {
+            std::cout << "  { \"op\": \"" << res.op << "\", \"isa\": \"" << res.isa
+                      << "\", \"bytes\": " << res.bytes << ", \"rounds\": " << res.rounds
+                      << ", \"seconds\": " << res.seconds << ", \"gbps\": " << res.gbps
+                      << ", \"verified\": " << (res.verified ? "true" : "false")
+                      << " }" << (i + 1 < results.size () ? ",\n" : "\n");
+        }
+        else
+        {
+            std::cout << res.op << ',' << res.isa << ',' << res.bytes << ',' << res.rounds << ','
+                      << res.seconds << ',' << res.gbps << ',' << res.verified << '\n';
+        }
+    }
+
+    if (json) std::cout << "]\n";
+
+    for (auto const& res : results) if (!res.verified) return 1;
+    return 0;
+}